@@ -0,0 +1,195 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#if !defined(BOOST_UNORDERED_BENCHMARK_HEADER)
+#define BOOST_UNORDERED_BENCHMARK_HEADER
+
+#include <boost/cstdint.hpp>
+#include <boost/functional/hash.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace benchmark {
+  // Stores results that are otherwise unused, so that the compiler can't
+  // optimize away the code that's being timed.
+  inline std::size_t& sink()
+  {
+    static std::size_t x = 0;
+    return x;
+  }
+
+  // Accumulates the time spent in timed sections.
+  class timer
+  {
+    typedef std::chrono::steady_clock clock;
+
+    clock::time_point start_;
+    clock::duration total_;
+
+  public:
+    timer() : start_(), total_(clock::duration::zero()) {}
+
+    void start() { start_ = clock::now(); }
+    void stop() { total_ += clock::now() - start_; }
+
+    double nanoseconds() const
+    {
+      return std::chrono::duration<double, std::nano>(total_).count();
+    }
+  };
+
+  // Keys are generated from a bijective mix of their index, so that they're
+  // all different but not in order. Even indexes are used for the keys
+  // that are inserted, odd ones for keys that aren't found.
+  inline boost::uint64_t mix64(boost::uint64_t x)
+  {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+  }
+
+  inline boost::uint32_t mix32(boost::uint32_t x)
+  {
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    x ^= x >> 16;
+    return x;
+  }
+
+  // A key that's larger than a pointer, and expensive to compare.
+  struct struct32
+  {
+    boost::uint64_t a, b, c, d;
+
+    friend bool operator==(struct32 const& x, struct32 const& y)
+    {
+      return x.a == y.a && x.b == y.b && x.c == y.c && x.d == y.d;
+    }
+
+    friend std::size_t hash_value(struct32 const& x)
+    {
+      std::size_t seed = 0;
+      boost::hash_combine(seed, x.a);
+      boost::hash_combine(seed, x.b);
+      boost::hash_combine(seed, x.c);
+      boost::hash_combine(seed, x.d);
+      return seed;
+    }
+  };
+
+  template <class Key> struct key_traits;
+
+  template <> struct key_traits<int>
+  {
+    static char const* name() { return "int"; }
+    static int make(boost::uint64_t i)
+    {
+      return static_cast<int>(mix32(static_cast<boost::uint32_t>(i)));
+    }
+  };
+
+  template <> struct key_traits<boost::uint32_t>
+  {
+    static char const* name() { return "uint32"; }
+    static boost::uint32_t make(boost::uint64_t i)
+    {
+      return mix32(static_cast<boost::uint32_t>(i));
+    }
+  };
+
+  template <> struct key_traits<boost::uint64_t>
+  {
+    static char const* name() { return "uint64"; }
+    static boost::uint64_t make(boost::uint64_t i) { return mix64(i); }
+  };
+
+  template <> struct key_traits<std::string>
+  {
+    static char const* name() { return "string"; }
+    static std::string make(boost::uint64_t i)
+    {
+      return "key_" + std::to_string(mix64(i));
+    }
+  };
+
+  template <> struct key_traits<struct32>
+  {
+    static char const* name() { return "struct32"; }
+    static struct32 make(boost::uint64_t i)
+    {
+      struct32 x = {mix64(i), i, ~i, 0};
+      return x;
+    }
+  };
+
+  // 'count' keys that will be inserted, with 'repeat' copies of each.
+  template <class Key>
+  std::vector<Key> make_keys(std::size_t count, std::size_t repeat)
+  {
+    std::vector<Key> keys;
+    keys.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      keys.push_back(key_traits<Key>::make(2 * (i / repeat)));
+    }
+    return keys;
+  }
+
+  template <class Key> std::vector<Key> make_missing_keys(std::size_t count)
+  {
+    std::vector<Key> keys;
+    keys.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      keys.push_back(key_traits<Key>::make(2 * i + 1));
+    }
+    return keys;
+  }
+
+  // Writes the results as a JSON array of objects, one per line.
+  class json_writer
+  {
+    std::ostream& out_;
+    bool first_;
+
+  public:
+    explicit json_writer(std::ostream& out) : out_(out), first_(true)
+    {
+      out_ << "[\n";
+    }
+
+    ~json_writer() { out_ << "\n]\n"; }
+
+    void result(char const* container, char const* key, std::size_t size,
+      char const* operation, std::size_t elements, double nanoseconds)
+    {
+      if (!first_) {
+        out_ << ",\n";
+      }
+      first_ = false;
+      out_ << "  {\"container\": \"" << container << "\", \"key\": \"" << key
+           << "\", \"size\": " << size << ", \"operation\": \"" << operation
+           << "\", \"elements\": " << elements
+           << ", \"ns_per_element\": " << nanoseconds / elements << "}";
+      out_.flush();
+    }
+  };
+
+  // The largest size to run, from the first command line argument.
+  inline std::size_t max_size(int argc, char** argv, std::size_t default_size)
+  {
+    return argc > 1 ? static_cast<std::size_t>(std::strtoull(argv[1], 0, 10))
+                    : default_size;
+  }
+}
+
+#endif
@@ -0,0 +1,73 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Times boost::unordered_map with each bucket policy.
+//
+// Usage: bucket_policies [max_size]
+//
+// Runs sizes from 1000 up to max_size (default 1000000), multiplying by 10
+// each time. The results are written to stdout as JSON, the container name
+// is the policy.
+//
+// The integer keys are random, so the power of 2 policy works well for
+// them. It can be much worse for keys with patterns in their low bits.
+
+#include "./node_benchmark.hpp"
+#include <boost/unordered/hash_traits.hpp>
+#include <boost/unordered_map.hpp>
+
+namespace benchmark {
+  // The same hash function, with a different policy for each type.
+  template <class Key, class Policy> struct policy_hash : boost::hash<Key>
+  {
+  };
+}
+
+namespace boost {
+  namespace unordered {
+    template <class Key, class Policy>
+    struct bucket_policy<benchmark::policy_hash<Key, Policy> >
+    {
+      typedef Policy type;
+    };
+  }
+}
+
+namespace benchmark {
+  template <class Key, class Policy>
+  void run_policy(char const* name, json_writer& out, std::size_t size)
+  {
+    run<boost::unordered_map<Key, int, policy_hash<Key, Policy> > >(
+      name, out, size, false);
+  }
+
+  template <class Key> void run_key(json_writer& out, std::size_t size)
+  {
+    run_policy<Key, boost::unordered::default_bucket_policy>(
+      "default_bucket_policy", out, size);
+    run_policy<Key, boost::unordered::prime_bucket_policy>(
+      "prime_bucket_policy", out, size);
+    run_policy<Key, boost::unordered::pow2_bucket_policy>(
+      "pow2_bucket_policy", out, size);
+    run_policy<Key, boost::unordered::fibonacci_bucket_policy>(
+      "fibonacci_bucket_policy", out, size);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t max_size = benchmark::max_size(argc, argv, 1000000);
+
+  {
+    benchmark::json_writer out(std::cout);
+    for (std::size_t size = 1000; size <= max_size; size *= 10) {
+      benchmark::run_key<int>(out, size);
+      benchmark::run_key<boost::uint64_t>(out, size);
+      benchmark::run_key<std::string>(out, size);
+    }
+  }
+
+  std::cerr << "Checksum: " << benchmark::sink() << "\n";
+}
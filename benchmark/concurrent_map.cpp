@@ -0,0 +1,163 @@
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Times how the concurrent maps cope with contention, for 1 up to 64
+// threads. Each thread runs a mix of lookups and writes (half inserts, half
+// erases), first with 10% writes and then with 50%. Compares
+// boost::concurrent_unordered_map, boost::sharded_unordered_map with 16 and
+// 64 shards, and boost::unordered_map protected by a single reader-writer
+// lock (or a mutex when std::shared_timed_mutex isn't available).
+//
+// Usage: concurrent_map [size] [max_threads]
+//
+// The map is filled with 'size' elements first (default 1000000), and each
+// thread then runs 1000000 operations. The thread count doubles each time
+// up to max_threads (default 64). The mix and thread count are written as
+// part of the operation name, e.g. "mixed_90_10/8" for 90% lookups and 10%
+// writes on 8 threads. The results are written to stdout as JSON, with the
+// throughput in millions of operations per second written to stderr.
+
+#include "./benchmark.hpp"
+#include "./locked_map.hpp"
+#include <boost/concurrent_unordered_map.hpp>
+#include <boost/sharded_unordered_map.hpp>
+#include <thread>
+
+namespace benchmark {
+  static std::size_t const operations_per_thread = 1000000;
+
+  // Adapts the visitation interface of the concurrent maps.
+  template <class Map> class visit_map
+  {
+    typedef typename Map::key_type key_type;
+    typedef typename Map::value_type value_type;
+
+    Map map_;
+
+  public:
+    bool find(key_type const& k, int& value) const
+    {
+      return map_.cvisit(
+               k, [&value](value_type const& x) { value = x.second; }) != 0;
+    }
+
+    void insert(key_type const& k, int value) { map_.emplace(k, value); }
+
+    void erase(key_type const& k) { map_.erase(k); }
+  };
+
+  // Each thread looks up the existing keys, and inserts and erases its own
+  // range of the missing keys.
+  template <class Map, class Key>
+  double run_mixed(Map& map, std::vector<Key> const& keys,
+    std::vector<Key> const& missing, std::size_t threads,
+    std::size_t write_percent)
+  {
+    std::vector<std::thread> workers;
+    std::vector<std::size_t> found(threads);
+    std::size_t per_thread = missing.size() / threads;
+
+    timer t;
+    t.start();
+    for (std::size_t i = 0; i < threads; ++i) {
+      workers.push_back(std::thread([&, i] {
+        boost::uint64_t state = mix64(i + 1);
+        std::size_t next_insert = i * per_thread;
+        std::size_t next_erase = next_insert;
+        std::size_t end = next_insert + per_thread;
+        int value = 0;
+
+        for (std::size_t op = 0; op < operations_per_thread; ++op) {
+          state = mix64(state);
+          std::size_t r = static_cast<std::size_t>(state % 100);
+          if (r >= write_percent) {
+            found[i] +=
+              map.find(keys[static_cast<std::size_t>(state >> 8) %
+                            keys.size()],
+                value)
+                ? 1
+                : 0;
+          } else if (r % 2 == 0 && next_insert < end) {
+            map.insert(missing[next_insert++], value);
+          } else if (next_erase < next_insert) {
+            map.erase(missing[next_erase++]);
+          }
+        }
+      }));
+    }
+    for (std::size_t i = 0; i < threads; ++i) {
+      workers[i].join();
+    }
+    t.stop();
+
+    for (std::size_t i = 0; i < threads; ++i) {
+      sink() += found[i];
+    }
+    return t.nanoseconds();
+  }
+
+  template <class Map, class Key>
+  void run(char const* name, json_writer& out, std::vector<Key> const& keys,
+    std::vector<Key> const& missing, std::size_t threads,
+    std::size_t write_percent)
+  {
+    Map map;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      map.insert(keys[i], static_cast<int>(i));
+    }
+
+    double ns = run_mixed(map, keys, missing, threads, write_percent);
+    std::size_t operations = threads * operations_per_thread;
+    std::string operation = "mixed_" + std::to_string(100 - write_percent) +
+                            "_" + std::to_string(write_percent) + "/" +
+                            std::to_string(threads);
+    out.result(name, key_traits<Key>::name(), keys.size(), operation.c_str(),
+      operations, ns);
+    std::cerr << name << ", " << threads
+              << " threads, " << write_percent
+              << "% writes: " << operations * 1000.0 / ns << " Mops/s\n";
+  }
+
+  template <class Key>
+  void run_key(json_writer& out, std::size_t size, std::size_t max_threads)
+  {
+    std::vector<Key> keys = make_keys<Key>(size, 1);
+    std::vector<Key> missing = make_missing_keys<Key>(size);
+
+    typedef boost::hash<Key> hash;
+    typedef std::equal_to<Key> equal;
+    typedef std::allocator<std::pair<const Key, int> > allocator;
+
+    for (std::size_t writes = 10; writes <= 50; writes += 40) {
+      for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+        run<locked_map<Key> >("locked boost::unordered_map", out, keys,
+          missing, threads, writes);
+        run<visit_map<boost::concurrent_unordered_map<Key, int, hash> > >(
+          "boost::concurrent_unordered_map", out, keys, missing, threads,
+          writes);
+        run<visit_map<boost::sharded_unordered_map<Key, int, hash, equal,
+          allocator, 16> > >("boost::sharded_unordered_map<16>", out, keys,
+          missing, threads, writes);
+        run<visit_map<boost::sharded_unordered_map<Key, int, hash, equal,
+          allocator, 64> > >("boost::sharded_unordered_map<64>", out, keys,
+          missing, threads, writes);
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t size = benchmark::max_size(argc, argv, 1000000);
+  std::size_t max_threads =
+    argc > 2 ? static_cast<std::size_t>(std::strtoull(argv[2], 0, 10)) : 64;
+
+  {
+    benchmark::json_writer out(std::cout);
+    benchmark::run_key<boost::uint64_t>(out, size, max_threads);
+    benchmark::run_key<std::string>(out, size, max_threads);
+  }
+
+  std::cerr << "Checksum: " << benchmark::sink() << "\n";
+}
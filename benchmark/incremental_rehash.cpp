@@ -0,0 +1,123 @@
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Measures the latency of each insert into boost::unordered_map, with and
+// without boost::unordered::incremental_rehash, to show how much it reduces
+// the worst case when the container grows.
+//
+// Usage: incremental_rehash [max_size]
+//
+// Runs sizes from 10000 up to max_size (default 10000000), multiplying by 10
+// each time. The results are written to stdout as JSON, one object for each
+// container and size, with:
+//
+// - "histogram": the number of inserts that took less than 100ns, 1us,
+//   10us, 100us and 1ms, and at least 1ms.
+// - "p99_ns", "p999_ns" and "max_ns": the 99th and 99.9th percentiles, and
+//   the slowest insert.
+// - "ns_per_element": the mean.
+//
+// Each insert is timed separately, so the clock's overhead is included.
+
+#include "./benchmark.hpp"
+#include <algorithm>
+#include <boost/unordered/hash_traits.hpp>
+#include <boost/unordered_map.hpp>
+
+namespace benchmark {
+  // The same hash function, rehashing incrementally.
+  template <class Key> struct incremental_hash : boost::hash<Key>
+  {
+  };
+}
+
+namespace boost {
+  namespace unordered {
+    template <class Key>
+    struct incremental_rehash<benchmark::incremental_hash<Key> >
+      : boost::true_type
+    {
+    };
+  }
+}
+
+namespace benchmark {
+  template <class Map>
+  void run(char const* name, std::ostream& out, bool& first,
+    std::vector<typename Map::key_type> const& keys)
+  {
+    typedef std::chrono::steady_clock clock;
+    typedef typename Map::key_type key_type;
+
+    static const double bounds[] = {100, 1000, 10000, 100000, 1000000};
+    static const std::size_t bucket_count =
+      sizeof(bounds) / sizeof(bounds[0]) + 1;
+
+    std::vector<double> times;
+    times.reserve(keys.size());
+
+    Map x;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      clock::time_point start = clock::now();
+      x.emplace(keys[i], static_cast<int>(i));
+      clock::time_point stop = clock::now();
+      times.push_back(
+        std::chrono::duration<double, std::nano>(stop - start).count());
+    }
+    sink() += x.size();
+
+    std::size_t histogram[bucket_count] = {0};
+    double total = 0;
+    for (std::size_t i = 0; i < times.size(); ++i) {
+      total += times[i];
+      ++histogram[std::upper_bound(bounds, bounds + bucket_count - 1,
+                    times[i]) -
+                  bounds];
+    }
+    std::sort(times.begin(), times.end());
+
+    if (!first) {
+      out << ",\n";
+    }
+    first = false;
+    out << "  {\"container\": \"" << name << "\", \"key\": \""
+        << key_traits<key_type>::name() << "\", \"size\": " << keys.size()
+        << ", \"histogram\": [";
+    for (std::size_t i = 0; i < bucket_count; ++i) {
+      out << (i ? ", " : "") << histogram[i];
+    }
+    out << "], \"p99_ns\": " << times[times.size() * 99 / 100]
+        << ", \"p999_ns\": " << times[times.size() * 999 / 1000]
+        << ", \"max_ns\": " << times.back()
+        << ", \"ns_per_element\": " << total / static_cast<double>(keys.size())
+        << "}";
+    out.flush();
+  }
+
+  template <class Key>
+  void run_key(std::ostream& out, bool& first, std::size_t size)
+  {
+    std::vector<Key> keys = make_keys<Key>(size, 1);
+
+    run<boost::unordered_map<Key, int> >(
+      "boost::unordered_map", out, first, keys);
+    run<boost::unordered_map<Key, int, incremental_hash<Key> > >(
+      "incremental_rehash", out, first, keys);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t max_size = benchmark::max_size(argc, argv, 10000000);
+
+  bool first = true;
+  std::cout << "[\n";
+  for (std::size_t size = 10000; size <= max_size; size *= 10) {
+    benchmark::run_key<boost::uint64_t>(std::cout, first, size);
+    benchmark::run_key<std::string>(std::cout, first, size);
+  }
+  std::cout << "\n]\n";
+
+  std::cerr << "Checksum: " << benchmark::sink() << "\n";
+}
@@ -0,0 +1,69 @@
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#if !defined(BOOST_UNORDERED_BENCHMARK_LOCKED_MAP_HEADER)
+#define BOOST_UNORDERED_BENCHMARK_LOCKED_MAP_HEADER
+
+#include "./benchmark.hpp"
+#include <boost/unordered_map.hpp>
+#include <mutex>
+
+#if !defined(BOOST_NO_CXX14_HDR_SHARED_MUTEX)
+#include <shared_mutex>
+#endif
+
+// The baseline for the concurrent benchmarks, boost::unordered_map behind a
+// single reader-writer lock, or a mutex when std::shared_timed_mutex isn't
+// available.
+
+namespace benchmark {
+#if !defined(BOOST_NO_CXX14_HDR_SHARED_MUTEX)
+  typedef std::shared_timed_mutex baseline_mutex;
+  typedef std::shared_lock<baseline_mutex> read_lock;
+#else
+  typedef std::mutex baseline_mutex;
+  typedef std::lock_guard<baseline_mutex> read_lock;
+#endif
+  typedef std::lock_guard<baseline_mutex> write_lock;
+
+  template <class Key> class locked_map
+  {
+    typedef boost::unordered_map<Key, int, boost::hash<Key> > map;
+
+    map map_;
+    mutable baseline_mutex mutex_;
+
+  public:
+    bool find(Key const& k, int& value) const
+    {
+      read_lock lock(mutex_);
+      typename map::const_iterator it = map_.find(k);
+      if (it == map_.end()) {
+        return false;
+      }
+      value = it->second;
+      return true;
+    }
+
+    void insert(Key const& k, int value)
+    {
+      write_lock lock(mutex_);
+      map_.emplace(k, value);
+    }
+
+    void assign(Key const& k, int value)
+    {
+      write_lock lock(mutex_);
+      map_[k] = value;
+    }
+
+    void erase(Key const& k)
+    {
+      write_lock lock(mutex_);
+      map_.erase(k);
+    }
+  };
+}
+
+#endif
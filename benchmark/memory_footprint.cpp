@@ -0,0 +1,171 @@
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Measures how much memory the containers allocate for small elements, using
+// an allocator which counts the bytes requested. Compares
+// boost::unordered_compact_map with boost::unordered_map,
+// std::unordered_map and boost::unordered_flat_map, for maps from uint32 to
+// uint32 and from uint64 to uint32.
+//
+// Usage: memory_footprint [max_size]
+//
+// Runs sizes from 1000 up to max_size (default 10000000), multiplying by 10
+// each time. The results are written to stdout as JSON, one object for each
+// container and size, with:
+//
+// - "bytes": the bytes requested from the allocator.
+// - "allocations": the number of live allocations.
+// - "malloc_bytes": an estimate of the memory used, including malloc's
+//   overhead, assuming each allocation takes the requested size plus 8
+//   bytes, rounded up to a multiple of 16, and at least 32 (as glibc does
+//   on 64-bit platforms).
+// - "bytes_per_element": "malloc_bytes" divided by the size.
+// - "find_ns": nanoseconds per successful lookup, to show what the memory
+//   savings cost.
+
+#include "./benchmark.hpp"
+#include <boost/unordered_compact_map.hpp>
+#include <boost/unordered_flat_map.hpp>
+#include <boost/unordered_map.hpp>
+#include <new>
+#include <unordered_map>
+
+namespace benchmark {
+  struct memory_counter
+  {
+    std::size_t bytes;
+    std::size_t allocations;
+    std::size_t malloc_bytes;
+
+    static std::size_t malloc_size(std::size_t bytes)
+    {
+      std::size_t size = (bytes + 8 + 15) & ~static_cast<std::size_t>(15);
+      return size < 32 ? 32 : size;
+    }
+
+    void add(std::size_t n)
+    {
+      bytes += n;
+      ++allocations;
+      malloc_bytes += malloc_size(n);
+    }
+
+    void remove(std::size_t n)
+    {
+      bytes -= n;
+      --allocations;
+      malloc_bytes -= malloc_size(n);
+    }
+  };
+
+  inline memory_counter& counter()
+  {
+    static memory_counter c = {0, 0, 0};
+    return c;
+  }
+
+  template <class T> struct counting_allocator
+  {
+    typedef T value_type;
+
+    counting_allocator() {}
+
+    template <class U> counting_allocator(counting_allocator<U> const&) {}
+
+    T* allocate(std::size_t n)
+    {
+      counter().add(n * sizeof(T));
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+      counter().remove(n * sizeof(T));
+      ::operator delete(p);
+    }
+
+    template <class U> struct rebind
+    {
+      typedef counting_allocator<U> other;
+    };
+
+    bool operator==(counting_allocator const&) const { return true; }
+    bool operator!=(counting_allocator const&) const { return false; }
+  };
+
+  template <class Map>
+  void run(char const* name, std::ostream& out, bool& first,
+    std::vector<typename Map::key_type> const& keys)
+  {
+    typedef typename Map::key_type key_type;
+
+    Map x;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      x.emplace(keys[i], static_cast<boost::uint32_t>(i));
+    }
+    memory_counter used = counter();
+
+    std::size_t rounds = keys.size() >= 1000000 ? 1 : 1000000 / keys.size();
+    timer t;
+    t.start();
+    for (std::size_t r = 0; r < rounds; ++r) {
+      for (std::size_t i = 0; i < keys.size(); ++i) {
+        sink() += x.find(keys[i])->second;
+      }
+    }
+    t.stop();
+
+    if (!first) {
+      out << ",\n";
+    }
+    first = false;
+    out << "  {\"container\": \"" << name << "\", \"key\": \""
+        << key_traits<key_type>::name() << "\", \"size\": " << keys.size()
+        << ", \"bytes\": " << used.bytes
+        << ", \"allocations\": " << used.allocations
+        << ", \"malloc_bytes\": " << used.malloc_bytes
+        << ", \"bytes_per_element\": "
+        << static_cast<double>(used.malloc_bytes) /
+             static_cast<double>(keys.size())
+        << ", \"find_ns\": "
+        << t.nanoseconds() / static_cast<double>(rounds * keys.size())
+        << "}";
+    out.flush();
+  }
+
+  template <class Key>
+  void run_key(std::ostream& out, bool& first, std::size_t size)
+  {
+    typedef boost::hash<Key> hash;
+    typedef std::equal_to<Key> equal;
+    typedef counting_allocator<std::pair<const Key, boost::uint32_t> >
+      allocator;
+
+    std::vector<Key> keys = make_keys<Key>(size, 1);
+
+    run<boost::unordered_map<Key, boost::uint32_t, hash, equal, allocator> >(
+      "boost::unordered_map", out, first, keys);
+    run<std::unordered_map<Key, boost::uint32_t, hash, equal, allocator> >(
+      "std::unordered_map", out, first, keys);
+    run<boost::unordered_flat_map<Key, boost::uint32_t, hash, equal,
+      allocator> >("boost::unordered_flat_map", out, first, keys);
+    run<boost::unordered_compact_map<Key, boost::uint32_t, hash, equal,
+      allocator> >("boost::unordered_compact_map", out, first, keys);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t max_size = benchmark::max_size(argc, argv, 10000000);
+
+  bool first = true;
+  std::cout << "[\n";
+  for (std::size_t size = 1000; size <= max_size; size *= 10) {
+    benchmark::run_key<boost::uint32_t>(std::cout, first, size);
+    benchmark::run_key<boost::uint64_t>(std::cout, first, size);
+  }
+  std::cout << "\n]\n";
+
+  std::cerr << "Checksum: " << benchmark::sink() << "\n";
+}
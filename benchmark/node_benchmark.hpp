@@ -0,0 +1,226 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#if !defined(BOOST_UNORDERED_BENCHMARK_NODE_BENCHMARK_HEADER)
+#define BOOST_UNORDERED_BENCHMARK_NODE_BENCHMARK_HEADER
+
+#include "./benchmark.hpp"
+#include <algorithm>
+#include <random>
+
+// Times the operations of a map with the node container interface, which
+// includes the multimaps and the standard containers.
+
+namespace benchmark {
+  // Each operation is repeated until it's been called about this many
+  // times, so that the small sizes take long enough to time.
+  static const std::size_t min_operations = 1000000;
+
+  template <class Map> struct node_benchmark
+  {
+    typedef typename Map::key_type key_type;
+    typedef typename Map::value_type value_type;
+
+    char const* name_;
+    json_writer& out_;
+    std::size_t size_;
+    std::size_t repeat_;
+    std::vector<key_type> keys_;
+    std::vector<key_type> missing_;
+    std::vector<key_type> shuffled_;
+
+    // Multimaps have two elements for each key.
+    node_benchmark(char const* name, json_writer& out, std::size_t size,
+      bool multi)
+        : name_(name), out_(out), size_(size), repeat_(multi ? 2 : 1),
+          keys_(make_keys<key_type>(size, repeat_)),
+          missing_(make_missing_keys<key_type>(size)), shuffled_(keys_)
+    {
+      // The nodes are allocated in the order of 'keys_', so looking them up
+      // in that order is unusually cache friendly.
+      std::mt19937 generator(static_cast<std::mt19937::result_type>(size));
+      std::shuffle(shuffled_.begin(), shuffled_.end(), generator);
+    }
+
+    std::size_t rounds() const
+    {
+      return size_ >= min_operations ? 1 : min_operations / size_;
+    }
+
+    void report(char const* operation, std::size_t elements, timer const& t)
+    {
+      out_.result(name_, key_traits<key_type>::name(), size_, operation,
+        elements, t.nanoseconds());
+    }
+
+    void fill(Map& x) const
+    {
+      for (std::size_t i = 0; i < size_; ++i) {
+        x.insert(value_type(keys_[i], static_cast<int>(i)));
+      }
+    }
+
+    void insert()
+    {
+      timer t;
+      for (std::size_t r = rounds(); r; --r) {
+        Map x;
+        t.start();
+        fill(x);
+        t.stop();
+        sink() += x.size();
+      }
+      report("insert", rounds() * size_, t);
+    }
+
+    void emplace()
+    {
+      timer t;
+      for (std::size_t r = rounds(); r; --r) {
+        Map x;
+        t.start();
+        for (std::size_t i = 0; i < size_; ++i) {
+          x.emplace(keys_[i], static_cast<int>(i));
+        }
+        t.stop();
+        sink() += x.size();
+      }
+      report("emplace", rounds() * size_, t);
+    }
+
+    void find(Map const& x, std::vector<key_type> const& keys,
+      char const* operation)
+    {
+      timer t;
+      t.start();
+      for (std::size_t r = rounds(); r; --r) {
+        for (std::size_t i = 0; i < size_; ++i) {
+          sink() += x.find(keys[i]) != x.end();
+        }
+      }
+      t.stop();
+      report(operation, rounds() * size_, t);
+    }
+
+    // For the containers with find_many, look up the keys in batches.
+    void find_many(Map const& x, std::vector<key_type> const& keys,
+      char const* operation)
+    {
+      std::size_t const batch = 1024;
+      std::vector<typename Map::const_iterator> found(batch);
+
+      timer t;
+      t.start();
+      for (std::size_t r = rounds(); r; --r) {
+        for (std::size_t i = 0; i < size_; i += batch) {
+          std::size_t count = (std::min)(batch, size_ - i);
+          x.find_many(keys.begin() + static_cast<std::ptrdiff_t>(i),
+            keys.begin() + static_cast<std::ptrdiff_t>(i + count),
+            found.begin());
+          for (std::size_t j = 0; j < count; ++j) {
+            sink() += found[j] != x.end();
+          }
+        }
+      }
+      t.stop();
+      report(operation, rounds() * size_, t);
+    }
+
+    void erase()
+    {
+      timer t;
+      for (std::size_t r = rounds(); r; --r) {
+        Map x;
+        fill(x);
+        t.start();
+        for (std::size_t i = 0; i < size_; i += repeat_) {
+          sink() += x.erase(keys_[i]);
+        }
+        t.stop();
+      }
+      report("erase", rounds() * size_, t);
+    }
+
+    void iterate(Map const& x)
+    {
+      timer t;
+      t.start();
+      for (std::size_t r = rounds(); r; --r) {
+        for (typename Map::const_iterator it = x.begin(); it != x.end();
+             ++it) {
+          sink() += static_cast<std::size_t>(it->second);
+        }
+      }
+      t.stop();
+      report("iterate", rounds() * size_, t);
+    }
+
+    void copy(Map const& x)
+    {
+      timer t;
+      for (std::size_t r = rounds(); r; --r) {
+        t.start();
+        Map y(x);
+        t.stop();
+        sink() += y.size();
+      }
+      report("copy", rounds() * size_, t);
+    }
+
+    void rehash(Map const& x)
+    {
+      timer t;
+      for (std::size_t r = rounds(); r; --r) {
+        Map y(x);
+        t.start();
+        y.rehash(y.bucket_count() * 2);
+        t.stop();
+        sink() += y.bucket_count();
+      }
+      report("rehash", rounds() * size_, t);
+    }
+
+    void run_find_many()
+    {
+      Map x;
+      fill(x);
+      find_many(x, keys_, "find_many_hit");
+      find_many(x, missing_, "find_many_miss");
+      find_many(x, shuffled_, "find_many_hit_shuffled");
+    }
+
+    void run()
+    {
+      insert();
+      emplace();
+
+      Map x;
+      fill(x);
+      find(x, keys_, "find_hit");
+      find(x, missing_, "find_miss");
+      find(x, shuffled_, "find_hit_shuffled");
+      erase();
+      iterate(x);
+      copy(x);
+      rehash(x);
+    }
+  };
+
+  template <class Map>
+  void run(char const* name, json_writer& out, std::size_t size, bool multi)
+  {
+    node_benchmark<Map>(name, out, size, multi).run();
+  }
+
+  // Times find_many, for the containers that have it.
+  template <class Map>
+  void run_find_many(
+    char const* name, json_writer& out, std::size_t size, bool multi)
+  {
+    node_benchmark<Map>(name, out, size, multi).run_find_many();
+  }
+}
+
+#endif
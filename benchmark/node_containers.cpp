@@ -0,0 +1,58 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Times the basic operations of boost::unordered_map and
+// boost::unordered_multimap, with std::unordered_map and
+// std::unordered_multimap as a baseline. All the containers use boost::hash,
+// so that only the containers are compared. The Boost containers also time
+// find_many, which looks up the keys in batches of 1024, and which is best
+// compared with "find_hit_shuffled" as the keys are found in a random order.
+//
+// Usage: node_containers [max_size]
+//
+// Runs sizes from 1000 up to max_size (default 1000000), multiplying by 10
+// each time. Pass 100000000 for the largest size, which needs several
+// gigabytes of memory. The results are written to stdout as JSON.
+
+#include "./node_benchmark.hpp"
+#include <boost/unordered_map.hpp>
+#include <unordered_map>
+
+namespace benchmark {
+  template <class Key> void run_key(json_writer& out, std::size_t size)
+  {
+    typedef boost::hash<Key> hash;
+
+    run<boost::unordered_map<Key, int, hash> >(
+      "boost::unordered_map", out, size, false);
+    run_find_many<boost::unordered_map<Key, int, hash> >(
+      "boost::unordered_map", out, size, false);
+    run<std::unordered_map<Key, int, hash> >(
+      "std::unordered_map", out, size, false);
+    run<boost::unordered_multimap<Key, int, hash> >(
+      "boost::unordered_multimap", out, size, true);
+    run_find_many<boost::unordered_multimap<Key, int, hash> >(
+      "boost::unordered_multimap", out, size, true);
+    run<std::unordered_multimap<Key, int, hash> >(
+      "std::unordered_multimap", out, size, true);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t max_size = benchmark::max_size(argc, argv, 1000000);
+
+  {
+    benchmark::json_writer out(std::cout);
+    for (std::size_t size = 1000; size <= max_size; size *= 10) {
+      benchmark::run_key<int>(out, size);
+      benchmark::run_key<boost::uint64_t>(out, size);
+      benchmark::run_key<std::string>(out, size);
+      benchmark::run_key<benchmark::struct32>(out, size);
+    }
+  }
+
+  std::cerr << "Checksum: " << benchmark::sink() << "\n";
+}
@@ -0,0 +1,78 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Times building boost::unordered_map from a vector with 'insert_parallel',
+// for an increasing number of threads, along with 'insert' as a baseline.
+//
+// Usage: parallel_build [size] [max_threads]
+//
+// The size defaults to 10000000, and max_threads to the number of cores.
+// The thread count doubles each time, and is written as part of the
+// operation name, e.g. "insert_parallel/8". The results are written to
+// stdout as JSON, with the speedup over 'insert' written to stderr.
+
+#define BOOST_UNORDERED_ENABLE_PARALLEL
+
+#include "./benchmark.hpp"
+#include <boost/unordered_map.hpp>
+#include <thread>
+
+namespace benchmark {
+  template <class Key>
+  void run_key(json_writer& out, std::size_t size, std::size_t max_threads)
+  {
+    typedef boost::unordered_map<Key, int, boost::hash<Key> > map;
+
+    std::vector<Key> keys = make_keys<Key>(size, 1);
+    std::vector<std::pair<Key, int> > values;
+    values.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+      values.push_back(std::pair<Key, int>(keys[i], static_cast<int>(i)));
+    }
+
+    double baseline;
+    {
+      timer t;
+      t.start();
+      map x(values.begin(), values.end());
+      t.stop();
+      sink() += x.size();
+      baseline = t.nanoseconds();
+      out.result("boost::unordered_map", key_traits<Key>::name(), size,
+        "insert", size, baseline);
+    }
+
+    for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+      timer t;
+      t.start();
+      map x;
+      x.insert_parallel(values.begin(), values.end(), threads);
+      t.stop();
+      sink() += x.size();
+
+      std::string operation = "insert_parallel/" + std::to_string(threads);
+      out.result("boost::unordered_map", key_traits<Key>::name(), size,
+        operation.c_str(), size, t.nanoseconds());
+      std::cerr << key_traits<Key>::name() << ", " << threads
+                << " threads: " << baseline / t.nanoseconds() << "x\n";
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t size = benchmark::max_size(argc, argv, 10000000);
+  std::size_t max_threads =
+    argc > 2 ? static_cast<std::size_t>(std::strtoull(argv[2], 0, 10))
+             : std::thread::hardware_concurrency();
+
+  {
+    benchmark::json_writer out(std::cout);
+    benchmark::run_key<boost::uint64_t>(out, size, max_threads);
+    benchmark::run_key<std::string>(out, size, max_threads);
+  }
+
+  std::cerr << "Checksum: " << benchmark::sink() << "\n";
+}
@@ -0,0 +1,166 @@
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Times how lookups scale with the number of reader threads, while another
+// thread assigns to an element every 100 microseconds. Compares
+// boost::read_mostly_unordered_map with boost::concurrent_unordered_map and
+// boost::unordered_map behind a single reader-writer lock, and for integer
+// keys, with boost::seqlock_unordered_map.
+//
+// Usage: read_mostly_map [size] [max_threads]
+//
+// The map is filled with 'size' elements first (default 1000000), and each
+// reader then does 1000000 lookups of existing keys. The reader count
+// doubles each time up to max_threads (default 64), and is written as part
+// of the operation name, e.g. "find/8". The results are written to stdout
+// as JSON, with the lookups per second for all the readers together written
+// to stderr.
+
+#include "./benchmark.hpp"
+#include "./locked_map.hpp"
+#include <boost/concurrent_unordered_map.hpp>
+#include <boost/read_mostly_unordered_map.hpp>
+#include <boost/seqlock_unordered_map.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace benchmark {
+  static std::size_t const lookups_per_thread = 1000000;
+
+  // Adapts the visitation interface of the concurrent maps.
+  template <class Map> class visit_map
+  {
+    typedef typename Map::key_type key_type;
+    typedef typename Map::value_type value_type;
+
+    Map map_;
+
+  public:
+    bool find(key_type const& k, int& value) const
+    {
+      return map_.cvisit(
+               k, [&value](value_type const& x) { value = x.second; }) != 0;
+    }
+
+    void insert(key_type const& k, int value) { map_.emplace(k, value); }
+
+    void assign(key_type const& k, int value)
+    {
+      map_.insert_or_assign(k, value);
+    }
+  };
+
+  template <class Map, class Key>
+  double run_readers(
+    Map& map, std::vector<Key> const& keys, std::size_t threads)
+  {
+    std::atomic<bool> done(false);
+    std::thread writer([&] {
+      boost::uint64_t state = 0;
+      while (!done.load(std::memory_order_relaxed)) {
+        state = mix64(state + 1);
+        map.assign(keys[static_cast<std::size_t>(state % keys.size())],
+          static_cast<int>(state));
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    });
+
+    std::vector<std::thread> readers;
+    std::vector<std::size_t> found(threads);
+
+    timer t;
+    t.start();
+    for (std::size_t i = 0; i < threads; ++i) {
+      readers.push_back(std::thread([&, i] {
+        boost::uint64_t state = mix64(i + 1);
+        int value = 0;
+        for (std::size_t n = 0; n < lookups_per_thread; ++n) {
+          state = mix64(state);
+          found[i] += map.find(
+                        keys[static_cast<std::size_t>(state % keys.size())],
+                        value)
+                        ? 1
+                        : 0;
+        }
+      }));
+    }
+    for (std::size_t i = 0; i < threads; ++i) {
+      readers[i].join();
+    }
+    t.stop();
+
+    done = true;
+    writer.join();
+
+    for (std::size_t i = 0; i < threads; ++i) {
+      sink() += found[i];
+    }
+    return t.nanoseconds();
+  }
+
+  template <class Map, class Key>
+  void run(char const* name, json_writer& out, std::vector<Key> const& keys,
+    std::size_t threads)
+  {
+    Map map;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      map.insert(keys[i], static_cast<int>(i));
+    }
+
+    double ns = run_readers(map, keys, threads);
+    std::size_t lookups = threads * lookups_per_thread;
+    std::string operation = "find/" + std::to_string(threads);
+    out.result(name, key_traits<Key>::name(), keys.size(), operation.c_str(),
+      lookups, ns);
+    std::cerr << name << ", " << threads
+              << " readers: " << lookups * 1000.0 / ns << " Mlookups/s\n";
+  }
+
+  // The seqlock map can only hold trivially copyable keys.
+  inline void run_seqlock(json_writer& out,
+    std::vector<boost::uint64_t> const& keys, std::size_t threads)
+  {
+    run<visit_map<boost::seqlock_unordered_map<boost::uint64_t, int,
+      boost::hash<boost::uint64_t> > > >(
+      "boost::seqlock_unordered_map", out, keys, threads);
+  }
+
+  inline void run_seqlock(
+    json_writer&, std::vector<std::string> const&, std::size_t)
+  {
+  }
+
+  template <class Key>
+  void run_key(json_writer& out, std::size_t size, std::size_t max_threads)
+  {
+    typedef boost::hash<Key> hash;
+    std::vector<Key> keys = make_keys<Key>(size, 1);
+
+    for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+      run<locked_map<Key> >(
+        "locked boost::unordered_map", out, keys, threads);
+      run<visit_map<boost::concurrent_unordered_map<Key, int, hash> > >(
+        "boost::concurrent_unordered_map", out, keys, threads);
+      run<visit_map<boost::read_mostly_unordered_map<Key, int, hash> > >(
+        "boost::read_mostly_unordered_map", out, keys, threads);
+      run_seqlock(out, keys, threads);
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t size = benchmark::max_size(argc, argv, 1000000);
+  std::size_t max_threads =
+    argc > 2 ? static_cast<std::size_t>(std::strtoull(argv[2], 0, 10)) : 64;
+
+  {
+    benchmark::json_writer out(std::cout);
+    benchmark::run_key<boost::uint64_t>(out, size, max_threads);
+    benchmark::run_key<std::string>(out, size, max_threads);
+  }
+
+  std::cerr << "Checksum: " << benchmark::sink() << "\n";
+}
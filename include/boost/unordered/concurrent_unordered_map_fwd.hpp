@@ -0,0 +1,30 @@
+
+// Copyright (C) 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_UNORDERED_CONCURRENT_MAP_FWD_HPP_INCLUDED
+#define BOOST_UNORDERED_CONCURRENT_MAP_FWD_HPP_INCLUDED
+
+#include <boost/config.hpp>
+#if defined(BOOST_HAS_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <boost/functional/hash_fwd.hpp>
+#include <boost/unordered/detail/fwd.hpp>
+#include <functional>
+#include <memory>
+
+namespace boost {
+  namespace unordered {
+    template <class K, class T, class H = boost::hash<K>,
+      class P = std::equal_to<K>,
+      class A = std::allocator<std::pair<const K, T> > >
+    class concurrent_unordered_map;
+  }
+
+  using boost::unordered::concurrent_unordered_map;
+}
+
+#endif
@@ -0,0 +1,54 @@
+
+// Copyright (C) 2017 Daniel James
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/unordered/detail/compact_table.hpp>
+#include <boost/unordered/unordered_compact_map_fwd.hpp>
+
+namespace boost {
+  namespace unordered {
+    namespace detail {
+      template <typename A, typename K, typename M, typename H, typename P>
+      struct compact_map
+      {
+        typedef boost::unordered::detail::compact_map<A, K, M, H, P> types;
+
+        typedef std::pair<K const, M> value_type;
+        typedef H hasher;
+        typedef P key_equal;
+        typedef K const const_key_type;
+
+        typedef typename ::boost::unordered::detail::rebind_wrap<A,
+          value_type>::type value_allocator;
+        typedef boost::unordered::detail::allocator_traits<value_allocator>
+          value_allocator_traits;
+
+        typedef boost::unordered::detail::compact_table<types> table;
+        typedef boost::unordered::detail::map_extractor<value_type> extractor;
+
+        typedef typename boost::unordered::detail::pick_policy<K, H>::type
+          policy;
+
+        typedef boost::unordered::detail::compact_node<value_type> node;
+        typedef boost::unordered::detail::compact_arena<node,
+          typename boost::unordered::detail::allocator_traits<
+            typename ::boost::unordered::detail::rebind_wrap<A,
+              node>::type>::pointer>
+          arena;
+
+        typedef boost::unordered::iterator_detail::compact_iterator<arena>
+          iterator;
+        typedef boost::unordered::iterator_detail::c_compact_iterator<arena>
+          c_iterator;
+      };
+
+      template <typename K, typename M, typename H, typename P, typename A>
+      class instantiate_compact_map
+      {
+        typedef boost::unordered_compact_map<K, M, H, P, A> container;
+        container x;
+      };
+    }
+  }
+}
@@ -0,0 +1,1270 @@
+
+// Copyright (C) 2017 Daniel James
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_UNORDERED_DETAIL_COMPACT_TABLE_HPP
+#define BOOST_UNORDERED_DETAIL_COMPACT_TABLE_HPP
+
+#include <boost/config.hpp>
+#if defined(BOOST_HAS_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <boost/unordered/detail/flat_table.hpp>
+#include <boost/cstdint.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
+
+#if defined(BOOST_MSVC)
+#include <intrin.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Compact table.
+//
+// A chained hash table where the nodes are linked by 32-bit indexes instead
+// of pointers, for containers with fewer than 2^32 - 1 elements. The nodes
+// are stored in an arena, and the buckets hold the index of the first node
+// in their chain. Each node stores the index of the next node in its chain,
+// and the index of its bucket, so a node for a pair of 32-bit integers
+// takes 16 bytes, and a bucket 4 bytes, instead of 24 and 8.
+//
+// The arena is made of segments which double in size, so that it can grow
+// without moving the nodes, and iterators, pointers and references stay
+// valid. Segment 's' holds the 8 << s nodes starting at index
+// 8 * (2^s - 1), so the segment for an index is found from the position of
+// the highest bit of 'index + 8'. As the nodes aren't allocated one at a
+// time, there's no per node allocation overhead, but up to half of the last
+// segment can be unused.
+//
+// Erased nodes are kept on a free list, linked through 'next_', and reused
+// by later inserts. The segments are only deallocated when the container is
+// destroyed. Iterators walk through the arena in index order, skipping the
+// free nodes, whose bucket index is 'compact_null'.
+//
+// The segment pointers are in a separately allocated structure, so that
+// iterators can refer to it and stay valid when the container is swapped or
+// moved.
+
+namespace boost {
+  namespace unordered {
+    namespace detail {
+      template <typename Types> struct compact_table;
+
+      // Marks the end of a chain, an empty bucket, or a free node.
+      static const boost::uint32_t compact_null = 0xFFFFFFFFu;
+
+      // Index of the highest set bit, 'x' must be non-zero.
+      inline unsigned compact_floor_log2(std::size_t x)
+      {
+        BOOST_ASSERT(x);
+#if defined(BOOST_GCC) || defined(__clang__)
+        return static_cast<unsigned>(
+          std::numeric_limits<unsigned long long>::digits - 1 -
+          __builtin_clzll(static_cast<unsigned long long>(x)));
+#elif defined(BOOST_MSVC) && defined(_WIN64)
+        unsigned long r;
+        _BitScanReverse64(&r, x);
+        return static_cast<unsigned>(r);
+#elif defined(BOOST_MSVC)
+        unsigned long r;
+        _BitScanReverse(&r, static_cast<unsigned long>(x));
+        return static_cast<unsigned>(r);
+#else
+        unsigned r = 0;
+        while (x >>= 1) {
+          ++r;
+        }
+        return r;
+#endif
+      }
+
+      template <typename T> struct compact_node
+      {
+        typedef T value_type;
+
+        boost::uint32_t next_;
+        boost::uint32_t bucket_info_;
+        boost::unordered::detail::value_base<T> value_base_;
+
+        compact_node()
+            : next_(compact_null), bucket_info_(compact_null), value_base_()
+        {
+        }
+
+        value_type& value() { return value_base_.value(); }
+        value_type* value_ptr() { return value_base_.value_ptr(); }
+
+      private:
+        compact_node& operator=(compact_node const&);
+      };
+
+      template <typename Node, typename NodePointer> struct compact_arena
+      {
+        typedef Node node;
+        typedef typename Node::value_type value_type;
+
+        static const unsigned first_shift = 3;
+
+        // Enough segments for 2^32 - 1 nodes.
+        static const std::size_t max_segments = 30;
+
+        NodePointer segments_[max_segments];
+        std::size_t segment_count_;
+        // The number of nodes in the allocated segments.
+        std::size_t capacity_;
+        // The number of nodes that have been used, including the free ones.
+        std::size_t used_;
+        // The first node in the free list.
+        boost::uint32_t free_;
+
+        compact_arena()
+            : segments_(), segment_count_(0), capacity_(0), used_(0),
+              free_(compact_null)
+        {
+        }
+
+        static std::size_t segment_size(std::size_t s)
+        {
+          return static_cast<std::size_t>(1) << (s + first_shift);
+        }
+
+        Node* get(std::size_t index) const
+        {
+          std::size_t x = index + (static_cast<std::size_t>(1) << first_shift);
+          unsigned bit = compact_floor_log2(x);
+          return boost::unordered::detail::pointer<Node>::get(
+                   segments_[bit - first_shift]) +
+                 (x - (static_cast<std::size_t>(1) << bit));
+        }
+
+        // Returns the node at 'index', given the node before it.
+        Node* next(Node* n, std::size_t index) const
+        {
+          std::size_t x = index + (static_cast<std::size_t>(1) << first_shift);
+          return (x & (x - 1))
+                   ? n + 1
+                   : boost::unordered::detail::pointer<Node>::get(
+                       segments_[compact_floor_log2(x) - first_shift]);
+        }
+
+      private:
+        compact_arena(compact_arena const&);
+        compact_arena& operator=(compact_arena const&);
+      };
+    }
+
+    namespace iterator_detail {
+      template <typename Arena> struct c_compact_iterator;
+
+      template <typename Arena>
+      struct compact_iterator
+        : public std::iterator<std::forward_iterator_tag,
+            typename Arena::value_type, std::ptrdiff_t,
+            typename Arena::value_type*, typename Arena::value_type&>
+      {
+#if !defined(BOOST_NO_MEMBER_TEMPLATE_FRIENDS)
+        template <typename>
+        friend struct boost::unordered::iterator_detail::c_compact_iterator;
+        template <typename>
+        friend struct boost::unordered::detail::compact_table;
+
+      private:
+#endif
+        typedef typename Arena::node node;
+
+        node* node_;
+        std::size_t index_;
+        Arena const* arena_;
+
+        void increment()
+        {
+          do {
+            if (++index_ == arena_->used_) {
+              node_ = 0;
+              return;
+            }
+            node_ = arena_->next(node_, index_);
+          } while (
+            node_->bucket_info_ == boost::unordered::detail::compact_null);
+        }
+
+      public:
+        typedef typename Arena::value_type value_type;
+
+        compact_iterator() BOOST_NOEXCEPT : node_(), index_(0), arena_() {}
+
+        compact_iterator(node* n, std::size_t i, Arena const* a) BOOST_NOEXCEPT
+          : node_(n),
+            index_(i),
+            arena_(a)
+        {
+        }
+
+        value_type& operator*() const { return node_->value(); }
+
+        value_type* operator->() const { return node_->value_ptr(); }
+
+        compact_iterator& operator++()
+        {
+          increment();
+          return *this;
+        }
+
+        compact_iterator operator++(int)
+        {
+          compact_iterator tmp(*this);
+          increment();
+          return tmp;
+        }
+
+        bool operator==(compact_iterator const& x) const BOOST_NOEXCEPT
+        {
+          return node_ == x.node_;
+        }
+
+        bool operator!=(compact_iterator const& x) const BOOST_NOEXCEPT
+        {
+          return node_ != x.node_;
+        }
+      };
+
+      template <typename Arena>
+      struct c_compact_iterator
+        : public std::iterator<std::forward_iterator_tag,
+            typename Arena::value_type, std::ptrdiff_t,
+            typename Arena::value_type const*,
+            typename Arena::value_type const&>
+      {
+#if !defined(BOOST_NO_MEMBER_TEMPLATE_FRIENDS)
+        template <typename>
+        friend struct boost::unordered::detail::compact_table;
+
+      private:
+#endif
+        typedef typename Arena::node node;
+        typedef boost::unordered::iterator_detail::compact_iterator<Arena>
+          n_iterator;
+
+        node* node_;
+        std::size_t index_;
+        Arena const* arena_;
+
+        void increment()
+        {
+          do {
+            if (++index_ == arena_->used_) {
+              node_ = 0;
+              return;
+            }
+            node_ = arena_->next(node_, index_);
+          } while (
+            node_->bucket_info_ == boost::unordered::detail::compact_null);
+        }
+
+      public:
+        typedef typename Arena::value_type value_type;
+
+        c_compact_iterator() BOOST_NOEXCEPT : node_(), index_(0), arena_() {}
+
+        c_compact_iterator(n_iterator const& x) BOOST_NOEXCEPT
+          : node_(x.node_),
+            index_(x.index_),
+            arena_(x.arena_)
+        {
+        }
+
+        value_type const& operator*() const { return node_->value(); }
+
+        value_type const* operator->() const { return node_->value_ptr(); }
+
+        c_compact_iterator& operator++()
+        {
+          increment();
+          return *this;
+        }
+
+        c_compact_iterator operator++(int)
+        {
+          c_compact_iterator tmp(*this);
+          increment();
+          return tmp;
+        }
+
+        friend bool operator==(c_compact_iterator const& x,
+          c_compact_iterator const& y) BOOST_NOEXCEPT
+        {
+          return x.node_ == y.node_;
+        }
+
+        friend bool operator!=(c_compact_iterator const& x,
+          c_compact_iterator const& y) BOOST_NOEXCEPT
+        {
+          return x.node_ != y.node_;
+        }
+      };
+    }
+
+    namespace detail {
+      template <typename Types>
+      struct compact_table
+        : boost::unordered::detail::functions<typename Types::hasher,
+            typename Types::key_equal>
+      {
+      private:
+        compact_table(compact_table const&);
+        compact_table& operator=(compact_table const&);
+
+      public:
+        typedef typename Types::hasher hasher;
+        typedef typename Types::key_equal key_equal;
+        typedef typename Types::const_key_type const_key_type;
+        typedef typename Types::extractor extractor;
+        typedef typename Types::value_type value_type;
+        typedef typename Types::policy policy;
+        typedef typename Types::node node;
+        typedef typename Types::arena arena;
+        typedef typename Types::iterator iterator;
+        typedef typename Types::c_iterator c_iterator;
+
+        typedef boost::unordered::detail::functions<typename Types::hasher,
+          typename Types::key_equal>
+          functions;
+        typedef typename functions::set_hash_functions set_hash_functions;
+
+        typedef typename Types::value_allocator value_allocator;
+        typedef typename boost::unordered::detail::rebind_wrap<value_allocator,
+          node>::type node_allocator;
+        typedef typename boost::unordered::detail::rebind_wrap<value_allocator,
+          arena>::type arena_allocator;
+        typedef typename boost::unordered::detail::rebind_wrap<value_allocator,
+          boost::uint32_t>::type bucket_allocator;
+        typedef boost::unordered::detail::allocator_traits<value_allocator>
+          value_allocator_traits;
+        typedef boost::unordered::detail::allocator_traits<node_allocator>
+          node_allocator_traits;
+        typedef boost::unordered::detail::allocator_traits<arena_allocator>
+          arena_allocator_traits;
+        typedef boost::unordered::detail::allocator_traits<bucket_allocator>
+          bucket_allocator_traits;
+        typedef typename node_allocator_traits::pointer node_pointer;
+        typedef typename arena_allocator_traits::pointer arena_pointer;
+        typedef typename bucket_allocator_traits::pointer bucket_pointer;
+        typedef boost::unordered::detail::flat_value_tmp<value_allocator>
+          value_tmp;
+
+        typedef std::pair<iterator, bool> emplace_return;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Members
+
+        boost::unordered::detail::compressed<value_allocator, bucket_allocator>
+          allocators_;
+        std::size_t bucket_count_;
+        std::size_t size_index_;
+        std::size_t size_;
+        float mlf_;
+        std::size_t max_load_;
+        bucket_pointer buckets_;
+        arena_pointer arena_;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Data access
+
+        value_allocator const& value_alloc() const
+        {
+          return allocators_.first();
+        }
+
+        bucket_allocator const& bucket_alloc() const
+        {
+          return allocators_.second();
+        }
+
+        value_allocator& value_alloc() { return allocators_.first(); }
+
+        bucket_allocator& bucket_alloc() { return allocators_.second(); }
+
+        boost::uint32_t* get_bucket(std::size_t bucket_index) const
+        {
+          BOOST_ASSERT(buckets_);
+          return boost::unordered::detail::pointer<boost::uint32_t>::get(
+                   buckets_) +
+                 bucket_index;
+        }
+
+        arena* get_arena() const
+        {
+          BOOST_ASSERT(arena_);
+          return boost::unordered::detail::pointer<arena>::get(arena_);
+        }
+
+        node* get_node(std::size_t index) const
+        {
+          return get_arena()->get(index);
+        }
+
+        // Returns the end iterator for 'compact_null', which is used to
+        // indicate that a value wasn't found.
+        iterator get_iterator(std::size_t index) const
+        {
+          return index != compact_null
+                   ? iterator(get_node(index), index, get_arena())
+                   : iterator();
+        }
+
+        iterator begin() const
+        {
+          if (!size_) {
+            return iterator();
+          }
+          arena* a = get_arena();
+          std::size_t index = 0;
+          node* n = a->get(0);
+          while (n->bucket_info_ == compact_null) {
+            n = a->next(n, ++index);
+          }
+          return iterator(n, index, a);
+        }
+
+        std::size_t hash(const_key_type& k) const
+        {
+          return policy::apply_hash(this->hash_function(), k);
+        }
+
+        std::size_t hash_to_bucket(std::size_t hash_value) const
+        {
+          return policy::position(size_index_, hash_value);
+        }
+
+        void set_bucket_count(std::size_t count)
+        {
+          bucket_count_ = count;
+          size_index_ = policy::size_index(count);
+        }
+
+        // The bucket indexes have to fit in 'bucket_info_', and the node
+        // indexes in the links.
+
+        std::size_t max_bucket_count() const
+        {
+          return policy::prev_bucket_count((std::min)(
+            bucket_allocator_traits::max_size(bucket_alloc()),
+            static_cast<std::size_t>(compact_null)));
+        }
+
+        std::size_t max_size() const
+        {
+          node_allocator alloc(value_alloc());
+          return (std::min)(node_allocator_traits::max_size(alloc),
+            static_cast<std::size_t>(compact_null - 1));
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Load methods
+
+        void recalculate_max_load()
+        {
+          using namespace std;
+
+          max_load_ = buckets_ ? boost::unordered::detail::double_to_size(
+                                   ceil(static_cast<double>(mlf_) *
+                                        static_cast<double>(bucket_count_)))
+                               : 0;
+        }
+
+        float max_load_factor() const { return mlf_; }
+
+        void max_load_factor(float z)
+        {
+          BOOST_ASSERT(z > 0);
+          mlf_ = (std::max)(z, minimum_max_load_factor);
+          recalculate_max_load();
+        }
+
+        std::size_t min_buckets_for_size(std::size_t size) const
+        {
+          using namespace std;
+
+          return policy::new_bucket_count(
+            boost::unordered::detail::double_to_size(
+              floor(static_cast<double>(size) / static_cast<double>(mlf_)) +
+              1));
+        }
+
+        // The bucket count to use for a copy. Keep the existing bucket count
+        // when it isn't much larger than required, so that the nodes can be
+        // copied into the same buckets without calling the hash function.
+        std::size_t copy_bucket_count() const
+        {
+          std::size_t min = min_buckets_for_size(size_);
+          return bucket_count_ >= min &&
+                     bucket_count_ <= min_buckets_for_size(size_ + (size_ >> 1))
+                   ? bucket_count_
+                   : min;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructors
+
+        compact_table(std::size_t num_buckets, hasher const& hf,
+          key_equal const& eq, value_allocator const& a)
+            : functions(hf, eq), allocators_(a, a), bucket_count_(0),
+              size_index_(0), size_(0), mlf_(1.0f), max_load_(0), buckets_(),
+              arena_()
+        {
+          set_bucket_count(policy::new_bucket_count(num_buckets));
+        }
+
+        compact_table(compact_table const& x, value_allocator const& a)
+            : functions(x), allocators_(a, a), bucket_count_(0),
+              size_index_(0), size_(0), mlf_(x.mlf_), max_load_(0),
+              buckets_(), arena_()
+        {
+          set_bucket_count(x.copy_bucket_count());
+        }
+
+        compact_table(compact_table& x, boost::unordered::detail::move_tag m)
+            : functions(x, m), allocators_(x.allocators_, m),
+              bucket_count_(x.bucket_count_), size_index_(x.size_index_),
+              size_(x.size_), mlf_(x.mlf_), max_load_(x.max_load_),
+              buckets_(x.buckets_), arena_(x.arena_)
+        {
+          x.buckets_ = bucket_pointer();
+          x.arena_ = arena_pointer();
+          x.size_ = 0;
+          x.max_load_ = 0;
+        }
+
+        compact_table(compact_table& x, value_allocator const& a,
+          boost::unordered::detail::move_tag m)
+            : functions(x, m), allocators_(a, a),
+              bucket_count_(x.bucket_count_), size_index_(x.size_index_),
+              size_(0), mlf_(x.mlf_), max_load_(0), buckets_(), arena_()
+        {
+        }
+
+        ~compact_table() { delete_all(); }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Buckets
+
+        // Allocates an empty bucket array. Doesn't touch the existing array,
+        // or the nodes, which should be dealt with by the caller.
+        //
+        // Strong exception safety.
+        void create_buckets(std::size_t new_count)
+        {
+          bucket_pointer new_buckets =
+            bucket_allocator_traits::allocate(bucket_alloc(), new_count);
+
+          // nothrow from here...
+          boost::uint32_t* b =
+            boost::unordered::detail::pointer<boost::uint32_t>::get(
+              new_buckets);
+          std::fill(b, b + new_count, compact_null);
+
+          buckets_ = new_buckets;
+          set_bucket_count(new_count);
+          recalculate_max_load();
+        }
+
+        void deallocate_buckets()
+        {
+          if (buckets_) {
+            bucket_allocator_traits::deallocate(
+              bucket_alloc(), buckets_, bucket_count_);
+            buckets_ = bucket_pointer();
+            max_load_ = 0;
+          }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Arena
+
+        // Strong exception safety.
+        void add_segment()
+        {
+          if (!arena_) {
+            arena_allocator alloc(value_alloc());
+            arena_pointer p = arena_allocator_traits::allocate(alloc, 1);
+            new (boost::unordered::detail::pointer<arena>::get(p)) arena();
+            arena_ = p;
+          }
+
+          arena* a = get_arena();
+          BOOST_ASSERT(a->segment_count_ < arena::max_segments);
+          std::size_t count = arena::segment_size(a->segment_count_);
+          node_allocator alloc(value_alloc());
+          a->segments_[a->segment_count_] =
+            node_allocator_traits::allocate(alloc, count);
+          ++a->segment_count_;
+          a->capacity_ += count;
+        }
+
+        void check_size(std::size_t size) const
+        {
+          if (size > max_size()) {
+            boost::throw_exception(std::length_error(
+              "Too many elements for unordered_compact_map."));
+          }
+        }
+
+        // Allocates segments until there's room for 'size' elements.
+        void reserve_nodes(std::size_t size)
+        {
+          check_size(size);
+          while (!arena_ || get_arena()->capacity_ < size) {
+            add_segment();
+          }
+        }
+
+        // Returns the index of a node that isn't in use, adding a segment
+        // if the arena is full. Strong exception safety.
+        std::size_t take_node()
+        {
+          if (!arena_ || (get_arena()->free_ == compact_null &&
+                           get_arena()->used_ == get_arena()->capacity_)) {
+            add_segment();
+          }
+
+          arena* a = get_arena();
+          if (a->free_ != compact_null) {
+            std::size_t index = a->free_;
+            a->free_ = a->get(index)->next_;
+            return index;
+          }
+          new (a->get(a->used_)) node();
+          return a->used_++;
+        }
+
+        void free_node(std::size_t index, node* n)
+        {
+          arena* a = get_arena();
+          n->bucket_info_ = compact_null;
+          n->next_ = a->free_;
+          a->free_ = static_cast<boost::uint32_t>(index);
+        }
+
+        void destroy_values()
+        {
+          if (size_) {
+            for (iterator it = begin(); it != iterator(); ++it) {
+              boost::unordered::detail::func::destroy_value(
+                value_alloc(), it.node_->value_ptr());
+            }
+            size_ = 0;
+          }
+        }
+
+        void deallocate_arena()
+        {
+          if (arena_) {
+            arena* a = get_arena();
+            node_allocator alloc(value_alloc());
+            for (std::size_t s = 0; s < a->segment_count_; ++s) {
+              node_allocator_traits::deallocate(
+                alloc, a->segments_[s], arena::segment_size(s));
+            }
+            boost::unordered::detail::func::destroy(a);
+            arena_allocator arena_alloc(value_alloc());
+            arena_allocator_traits::deallocate(arena_alloc, arena_, 1);
+            arena_ = arena_pointer();
+          }
+        }
+
+        void delete_all()
+        {
+          destroy_values();
+          deallocate_arena();
+          deallocate_buckets();
+        }
+
+        // Keeps the bucket array and the segments.
+        void clear_impl()
+        {
+          if (size_) {
+            destroy_values();
+            boost::uint32_t* b = get_bucket(0);
+            std::fill(b, b + bucket_count_, compact_null);
+          }
+          if (arena_) {
+            get_arena()->used_ = 0;
+            get_arena()->free_ = compact_null;
+          }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Copy and move the contents of another table into this one, which
+        // must be empty with nothing allocated. The nodes are packed at the
+        // start of the new arena.
+
+        template <typename Value>
+        void copy_node(node* src, BOOST_FWD_REF(Value) v, bool same_buckets)
+        {
+          std::size_t bucket_index =
+            same_buckets ? src->bucket_info_
+                         : hash_to_bucket(this->hash(extractor::extract(v)));
+          std::size_t index = take_node();
+          node* n = get_node(index);
+          BOOST_TRY
+          {
+            boost::unordered::detail::func::construct_from_args(
+              value_alloc(), n->value_ptr(), boost::forward<Value>(v));
+          }
+          BOOST_CATCH(...)
+          {
+            free_node(index, n);
+            BOOST_RETHROW
+          }
+          BOOST_CATCH_END
+          link_node(index, n, bucket_index);
+          ++size_;
+        }
+
+        void copy_buckets(compact_table const& src)
+        {
+          BOOST_ASSERT(!buckets_ && !size_);
+
+          if (src.size_) {
+            create_buckets(bucket_count_);
+            reserve_nodes(src.size_);
+            bool same_buckets = bucket_count_ == src.bucket_count_;
+            for (c_iterator it = src.begin(); it != c_iterator(); ++it) {
+              copy_node(it.node_, *it, same_buckets);
+            }
+          }
+        }
+
+        // Used when the allocators aren't equal, so the arena can't be
+        // stolen.
+        void move_buckets(compact_table& src)
+        {
+          BOOST_ASSERT(!buckets_ && !size_);
+
+          if (src.size_) {
+            create_buckets(src.bucket_count_);
+            reserve_nodes(src.size_);
+            for (iterator it = src.begin(); it != iterator(); ++it) {
+              copy_node(it.node_, boost::move(*it), true);
+            }
+          }
+        }
+
+        // Only call with an arena allocated with the current allocator, or
+        // one that is equal to it.
+        void move_buckets_from(compact_table& other)
+        {
+          BOOST_ASSERT(!buckets_ && !arena_);
+          buckets_ = other.buckets_;
+          arena_ = other.arena_;
+          bucket_count_ = other.bucket_count_;
+          size_index_ = other.size_index_;
+          size_ = other.size_;
+          mlf_ = other.mlf_;
+          max_load_ = other.max_load_;
+          other.buckets_ = bucket_pointer();
+          other.arena_ = arena_pointer();
+          other.size_ = 0;
+          other.max_load_ = 0;
+        }
+
+        void swap_contents(compact_table& x)
+        {
+          boost::swap(buckets_, x.buckets_);
+          boost::swap(arena_, x.arena_);
+          boost::swap(bucket_count_, x.bucket_count_);
+          boost::swap(size_index_, x.size_index_);
+          boost::swap(size_, x.size_);
+          boost::swap(mlf_, x.mlf_);
+          boost::swap(max_load_, x.max_load_);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Swap
+
+        void swap_allocators(compact_table& other, false_type)
+        {
+          boost::unordered::detail::func::ignore_unused_variable_warning(other);
+
+          // According to 23.2.1.8, if propagate_on_container_swap is
+          // false the behaviour is undefined unless the allocators
+          // are equal.
+          BOOST_ASSERT(value_alloc() == other.value_alloc());
+        }
+
+        void swap_allocators(compact_table& other, true_type)
+        {
+          allocators_.swap(other.allocators_);
+        }
+
+        // Only swaps the allocators if propagate_on_container_swap
+        void swap(compact_table& x)
+        {
+          set_hash_functions op1(*this, x);
+          set_hash_functions op2(x, *this);
+
+          swap_allocators(x, boost::unordered::detail::integral_constant<bool,
+                               allocator_traits<value_allocator>::
+                                 propagate_on_container_swap::value>());
+
+          swap_contents(x);
+          op1.commit();
+          op2.commit();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Assignment
+
+        void assign(compact_table const& x)
+        {
+          if (this != &x) {
+            assign(x, boost::unordered::detail::integral_constant<bool,
+                        allocator_traits<value_allocator>::
+                          propagate_on_container_copy_assignment::value>());
+          }
+        }
+
+        void assign(compact_table const& x, false_type)
+        {
+          // Strong exception safety.
+          set_hash_functions new_func_this(*this, x);
+          compact_table tmp(x, value_alloc());
+          tmp.copy_buckets(x);
+          new_func_this.commit();
+          swap_contents(tmp);
+        }
+
+        void assign(compact_table const& x, true_type)
+        {
+          if (value_alloc() == x.value_alloc()) {
+            allocators_.assign(x.allocators_);
+            assign(x, false_type());
+          } else {
+            set_hash_functions new_func_this(*this, x);
+
+            // Delete everything with current allocators before assigning
+            // the new ones.
+            delete_all();
+            allocators_.assign(x.allocators_);
+
+            // Copy over other data, all no throw.
+            new_func_this.commit();
+            mlf_ = x.mlf_;
+            set_bucket_count(x.copy_bucket_count());
+
+            // Finally copy the elements.
+            copy_buckets(x);
+          }
+        }
+
+        void move_assign(compact_table& x)
+        {
+          if (this != &x) {
+            move_assign(
+              x, boost::unordered::detail::integral_constant<bool,
+                   allocator_traits<value_allocator>::
+                     propagate_on_container_move_assignment::value>());
+          }
+        }
+
+        void move_assign(compact_table& x, true_type)
+        {
+          delete_all();
+          set_hash_functions new_func_this(*this, x);
+          allocators_.move_assign(x.allocators_);
+          // No throw from here.
+          move_buckets_from(x);
+          new_func_this.commit();
+        }
+
+        void move_assign(compact_table& x, false_type)
+        {
+          if (value_alloc() == x.value_alloc()) {
+            delete_all();
+            set_hash_functions new_func_this(*this, x);
+            // No throw from here.
+            move_buckets_from(x);
+            new_func_this.commit();
+          } else {
+            set_hash_functions new_func_this(*this, x);
+            compact_table tmp(x, value_alloc(), move_tag());
+            tmp.move_buckets(x);
+            new_func_this.commit();
+            swap_contents(tmp);
+          }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Find
+
+        // Returns compact_null if the key isn't found.
+        template <class Key, class Pred>
+        std::size_t find_node_impl(
+          std::size_t key_hash, Key const& k, Pred const& eq) const
+        {
+          if (!size_) {
+            return compact_null;
+          }
+
+          arena* a = get_arena();
+          std::size_t index = *get_bucket(hash_to_bucket(key_hash));
+          while (index != compact_null) {
+            node* n = a->get(index);
+            if (eq(k, extractor::extract(n->value()))) {
+              return index;
+            }
+            index = n->next_;
+          }
+          return compact_null;
+        }
+
+        std::size_t find_node(std::size_t key_hash, const_key_type& k) const
+        {
+          return this->find_node_impl(key_hash, k, this->key_eq());
+        }
+
+        std::size_t find_node(const_key_type& k) const
+        {
+          return this->find_node_impl(this->hash(k), k, this->key_eq());
+        }
+
+        iterator find(const_key_type& k) const
+        {
+          return get_iterator(find_node(k));
+        }
+
+        bool equals_unique(compact_table const& other) const
+        {
+          if (this->size_ != other.size_)
+            return false;
+
+          for (iterator it = begin(); it != iterator(); ++it) {
+            std::size_t index = other.find_node(extractor::extract(*it));
+
+            if (index == compact_null ||
+                *it != other.get_node(index)->value())
+              return false;
+          }
+
+          return true;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Reserve & Rehash
+
+        // basic exception safety
+        void reserve_for_insert(std::size_t size)
+        {
+          check_size(size);
+          if (!buckets_) {
+            create_buckets(
+              (std::max)(bucket_count_, min_buckets_for_size(size)));
+          } else if (size > max_load_) {
+            std::size_t num_buckets =
+              min_buckets_for_size((std::max)(size, size_ + (size_ >> 1)));
+            if (num_buckets != bucket_count_) {
+              rehash_impl(num_buckets);
+            }
+          }
+        }
+
+        void rehash(std::size_t min_buckets)
+        {
+          using namespace std;
+
+          if (!size_) {
+            deallocate_buckets();
+            set_bucket_count(policy::new_bucket_count(min_buckets));
+          } else {
+            min_buckets = policy::new_bucket_count((std::max)(min_buckets,
+              boost::unordered::detail::double_to_size(
+                floor(static_cast<double>(size_) / static_cast<double>(mlf_))) +
+                1));
+
+            if (min_buckets != bucket_count_)
+              rehash_impl(min_buckets);
+          }
+        }
+
+        // Also allocates room for the nodes.
+        void reserve(std::size_t size)
+        {
+          using namespace std;
+
+          reserve_nodes(size);
+          rehash(boost::unordered::detail::double_to_size(
+            ceil(static_cast<double>(size) / static_cast<double>(mlf_))));
+        }
+
+        // Relinks the nodes into a new bucket array, only the array is
+        // reallocated. If the hash function throws, the nodes which haven't
+        // been relinked yet are destroyed, so basic exception safety.
+        void rehash_impl(std::size_t num_buckets)
+        {
+          BOOST_ASSERT(buckets_ && size_);
+
+          bucket_pointer old_buckets = buckets_;
+          std::size_t old_count = bucket_count_;
+          create_buckets(num_buckets);
+          bucket_allocator_traits::deallocate(
+            bucket_alloc(), old_buckets, old_count);
+
+          // The nodes are visited in index order, which doesn't depend on
+          // the links.
+          iterator it = begin();
+          BOOST_TRY
+          {
+            for (; it != iterator(); ++it) {
+              link_node(it.index_, it.node_,
+                hash_to_bucket(this->hash(extractor::extract(*it))));
+            }
+          }
+          BOOST_CATCH(...)
+          {
+            while (it != iterator()) {
+              iterator n = it++;
+              boost::unordered::detail::func::destroy_value(
+                value_alloc(), n.node_->value_ptr());
+              free_node(n.index_, n.node_);
+              --size_;
+            }
+            BOOST_RETHROW
+          }
+          BOOST_CATCH_END
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Emplace/Insert
+
+        void link_node(std::size_t index, node* n, std::size_t bucket_index)
+        {
+          boost::uint32_t* b = get_bucket(bucket_index);
+          n->bucket_info_ = static_cast<boost::uint32_t>(bucket_index);
+          n->next_ = *b;
+          *b = static_cast<boost::uint32_t>(index);
+        }
+
+        // Construct a value in a free node. Strong exception safety.
+        template <typename... Args>
+        iterator add_value(std::size_t key_hash, BOOST_FWD_REF(Args)... args)
+        {
+          std::size_t index = take_node();
+          node* n = get_node(index);
+          BOOST_TRY
+          {
+            boost::unordered::detail::func::construct_from_args(
+              value_alloc(), n->value_ptr(), boost::forward<Args>(args)...);
+          }
+          BOOST_CATCH(...)
+          {
+            free_node(index, n);
+            BOOST_RETHROW
+          }
+          BOOST_CATCH_END
+          link_node(index, n, hash_to_bucket(key_hash));
+          ++size_;
+          return iterator(n, index, get_arena());
+        }
+
+        template <typename... Args>
+        iterator resize_and_add_value(
+          std::size_t key_hash, BOOST_FWD_REF(Args)... args)
+        {
+          this->reserve_for_insert(this->size_ + 1);
+          return this->add_value(key_hash, boost::forward<Args>(args)...);
+        }
+
+        template <typename... Args>
+        iterator emplace_hint_unique(
+          c_iterator hint, const_key_type& k, BOOST_FWD_REF(Args)... args)
+        {
+          if (hint.node_ &&
+              this->key_eq()(k, extractor::extract(hint.node_->value()))) {
+            return iterator(hint.node_, hint.index_, hint.arena_);
+          } else {
+            return emplace_unique(k, boost::forward<Args>(args)...).first;
+          }
+        }
+
+        template <typename... Args>
+        emplace_return emplace_unique(
+          const_key_type& k, BOOST_FWD_REF(Args)... args)
+        {
+          std::size_t key_hash = this->hash(k);
+          std::size_t index = this->find_node(key_hash, k);
+          if (index != compact_null) {
+            return emplace_return(get_iterator(index), false);
+          } else {
+            return emplace_return(
+              resize_and_add_value(key_hash, boost::forward<Args>(args)...),
+              true);
+          }
+        }
+
+        template <typename... Args>
+        iterator emplace_hint_unique(
+          c_iterator hint, no_key, BOOST_FWD_REF(Args)... args)
+        {
+          value_tmp b(this->value_alloc(), boost::forward<Args>(args)...);
+          const_key_type& k = extractor::extract(b.value());
+          if (hint.node_ &&
+              this->key_eq()(k, extractor::extract(hint.node_->value()))) {
+            return iterator(hint.node_, hint.index_, hint.arena_);
+          }
+          std::size_t key_hash = this->hash(k);
+          std::size_t index = this->find_node(key_hash, k);
+          if (index != compact_null) {
+            return get_iterator(index);
+          } else {
+            return resize_and_add_value(key_hash, boost::move(b.value()));
+          }
+        }
+
+        template <typename... Args>
+        emplace_return emplace_unique(no_key, BOOST_FWD_REF(Args)... args)
+        {
+          value_tmp b(this->value_alloc(), boost::forward<Args>(args)...);
+          const_key_type& k = extractor::extract(b.value());
+          std::size_t key_hash = this->hash(k);
+          std::size_t index = this->find_node(key_hash, k);
+          if (index != compact_null) {
+            return emplace_return(get_iterator(index), false);
+          } else {
+            return emplace_return(
+              resize_and_add_value(key_hash, boost::move(b.value())), true);
+          }
+        }
+
+        template <typename Key, typename... Args>
+        emplace_return try_emplace_unique(
+          BOOST_FWD_REF(Key) k, BOOST_FWD_REF(Args)... args)
+        {
+          std::size_t key_hash = this->hash(k);
+          std::size_t index = this->find_node(key_hash, k);
+          if (index != compact_null) {
+            return emplace_return(get_iterator(index), false);
+          } else {
+            return emplace_return(
+              resize_and_add_value(key_hash,
+                boost::unordered::piecewise_construct,
+                std::forward_as_tuple(boost::forward<Key>(k)),
+                std::forward_as_tuple(boost::forward<Args>(args)...)),
+              true);
+          }
+        }
+
+        template <typename Key, typename... Args>
+        iterator try_emplace_hint_unique(
+          c_iterator hint, BOOST_FWD_REF(Key) k, BOOST_FWD_REF(Args)... args)
+        {
+          if (hint.node_ && this->key_eq()(hint->first, k)) {
+            return iterator(hint.node_, hint.index_, hint.arena_);
+          } else {
+            return try_emplace_unique(
+              boost::forward<Key>(k), boost::forward<Args>(args)...)
+              .first;
+          }
+        }
+
+        template <typename Key, typename M>
+        emplace_return insert_or_assign_unique(
+          BOOST_FWD_REF(Key) k, BOOST_FWD_REF(M) obj)
+        {
+          std::size_t key_hash = this->hash(k);
+          std::size_t index = this->find_node(key_hash, k);
+
+          if (index != compact_null) {
+            get_node(index)->value().second = boost::forward<M>(obj);
+            return emplace_return(get_iterator(index), false);
+          } else {
+            return emplace_return(resize_and_add_value(key_hash,
+                                    boost::forward<Key>(k),
+                                    boost::forward<M>(obj)),
+              true);
+          }
+        }
+
+        template <class InputIt> void insert_range_unique(InputIt i, InputIt j)
+        {
+          if (i != j) {
+            this->reserve_for_insert(
+              this->size_ + boost::unordered::detail::insert_size(i, j));
+            for (; i != j; ++i) {
+              emplace_unique(extractor::extract(*i), *i);
+            }
+          }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Erase
+        //
+        // no throw
+
+        // Unlinks the node at 'index' from the chain starting at 'prev',
+        // and moves it to the free list.
+        void erase_node(boost::uint32_t* prev, std::size_t index, node* n)
+        {
+          *prev = n->next_;
+          boost::unordered::detail::func::destroy_value(
+            value_alloc(), n->value_ptr());
+          free_node(index, n);
+          --size_;
+        }
+
+        void erase_node(std::size_t index, node* n)
+        {
+          arena* a = get_arena();
+          boost::uint32_t* prev = get_bucket(n->bucket_info_);
+          while (*prev != index) {
+            prev = &a->get(*prev)->next_;
+          }
+          erase_node(prev, index, n);
+        }
+
+        iterator erase(c_iterator it)
+        {
+          iterator next(it.node_, it.index_, it.arena_);
+          ++next;
+          erase_node(it.index_, it.node_);
+          return next;
+        }
+
+        iterator erase_range(c_iterator first, c_iterator last)
+        {
+          while (first != last) {
+            c_iterator it = first;
+            ++first;
+            erase_node(it.index_, it.node_);
+          }
+          return iterator(last.node_, last.index_, last.arena_);
+        }
+
+        std::size_t erase_key_unique(const_key_type& k)
+        {
+          if (!size_) {
+            return 0;
+          }
+
+          arena* a = get_arena();
+          boost::uint32_t* prev = get_bucket(hash_to_bucket(this->hash(k)));
+          while (*prev != compact_null) {
+            std::size_t index = *prev;
+            node* n = a->get(index);
+            if (this->key_eq()(k, extractor::extract(n->value()))) {
+              erase_node(prev, index, n);
+              return 1;
+            }
+            prev = &n->next_;
+          }
+          return 0;
+        }
+      };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,679 @@
+
+// Copyright (C) 2017 Daniel James
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_UNORDERED_DETAIL_CONCURRENT_TABLE_HPP
+#define BOOST_UNORDERED_DETAIL_CONCURRENT_TABLE_HPP
+
+#include <boost/config.hpp>
+#if defined(BOOST_HAS_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <boost/unordered/detail/implementation.hpp>
+
+#if defined(BOOST_NO_CXX11_HDR_THREAD) || defined(BOOST_NO_CXX11_HDR_MUTEX) || \
+  defined(BOOST_NO_CXX11_HDR_ATOMIC) || defined(BOOST_NO_CXX11_LAMBDAS) ||     \
+  defined(BOOST_NO_CXX11_RVALUE_REFERENCES) ||                                 \
+  defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+#error "The concurrent containers require C++11 threads and atomics."
+#endif
+
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Concurrent table.
+//
+// A chained hash table which can be used from several threads at once. Each
+// bucket is a singly linked list of nodes, without the list through the
+// whole table that the other node containers use, as that would link
+// buckets that are locked separately.
+//
+// The buckets are protected by an array of mutexes, the 'stripes'. The
+// bucket count is a power of 2, and never less than the number of stripes,
+// and the Fibonacci policy picks buckets using the high bits of the hash
+// value. So each stripe covers a contiguous range of buckets, and the stripe
+// for a hash value can be found without knowing the current bucket count:
+//
+//     stripe 0           stripe 1           stripe 2  ...
+//     [b0 b1 b2 b3]      [b4 b5 b6 b7]      [b8 ...
+//
+// An operation on a single key locks the key's stripe, and can then read
+// the bucket array, as that is only changed while all the stripes are
+// locked. When an insert finds that the table is full, it releases its
+// stripe, locks them all in order to grow the table, and then starts
+// again. Nodes store their hash value, so growing doesn't call the hash
+// function while everything is locked.
+//
+// The element count is atomic, so that it can be updated with a single
+// stripe locked. As the load is checked before each insert, with only one
+// stripe locked, it can briefly go over the maximum by up to the number of
+// threads inserting at the same time.
+//
+// Nodes are allocated and destroyed without holding a lock when that's
+// possible, so the allocator has to be safe to use from several threads.
+
+namespace boost {
+  namespace unordered {
+    namespace detail {
+      // A mutex padded so that neighbouring stripes don't share a cache
+      // line.
+      struct concurrent_stripe
+      {
+        std::mutex mutex_;
+        char padding_[sizeof(std::mutex) < 64 ? 64 - sizeof(std::mutex) : 1];
+      };
+
+      // The number of stripes, several for each core so that threads don't
+      // often wait for each other.
+      inline std::size_t concurrent_stripe_count()
+      {
+        std::size_t cores = std::thread::hardware_concurrency();
+        std::size_t count = 16;
+        while (count < cores * 4 && count < 1024) {
+          count *= 2;
+        }
+        return count;
+      }
+
+      // Holds every stripe, for the operations which change the bucket
+      // array or look at the whole table. They're always locked in order,
+      // and nothing else holds more than one, so this can't deadlock.
+      class concurrent_lock_all
+      {
+        concurrent_stripe* stripes_;
+        std::size_t count_;
+
+        concurrent_lock_all(concurrent_lock_all const&);
+        concurrent_lock_all& operator=(concurrent_lock_all const&);
+
+      public:
+        concurrent_lock_all(concurrent_stripe* stripes, std::size_t count)
+            : stripes_(stripes), count_(0)
+        {
+          BOOST_TRY
+          {
+            for (; count_ < count; ++count_) {
+              stripes_[count_].mutex_.lock();
+            }
+          }
+          BOOST_CATCH(...)
+          {
+            release();
+            BOOST_RETHROW
+          }
+          BOOST_CATCH_END
+        }
+
+        ~concurrent_lock_all() { release(); }
+
+      private:
+        void release()
+        {
+          while (count_) {
+            stripes_[--count_].mutex_.unlock();
+          }
+        }
+      };
+
+      template <typename Types>
+      struct concurrent_table
+        : boost::unordered::detail::functions<typename Types::hasher,
+            typename Types::key_equal>
+      {
+      private:
+        concurrent_table(concurrent_table const&);
+        concurrent_table& operator=(concurrent_table const&);
+
+      public:
+        typedef typename Types::hasher hasher;
+        typedef typename Types::key_equal key_equal;
+        typedef typename Types::const_key_type const_key_type;
+        typedef typename Types::extractor extractor;
+        typedef typename Types::value_type value_type;
+
+        typedef boost::unordered::detail::functions<typename Types::hasher,
+          typename Types::key_equal>
+          functions;
+
+        // The hash value is always stored, for growing the table while
+        // it's locked.
+        typedef typename Types::value_allocator value_allocator;
+        typedef boost::unordered::detail::pick_node<value_allocator,
+          value_type, true, false>
+          pick;
+        typedef typename pick::node node;
+        typedef typename pick::bucket bucket;
+        typedef typename pick::link_pointer link_pointer;
+
+        typedef typename boost::unordered::detail::rebind_wrap<value_allocator,
+          node>::type node_allocator;
+        typedef typename boost::unordered::detail::rebind_wrap<value_allocator,
+          bucket>::type bucket_allocator;
+        typedef boost::unordered::detail::allocator_traits<node_allocator>
+          node_allocator_traits;
+        typedef boost::unordered::detail::allocator_traits<bucket_allocator>
+          bucket_allocator_traits;
+        typedef typename node_allocator_traits::pointer node_pointer;
+        typedef typename bucket_allocator_traits::pointer bucket_pointer;
+        typedef boost::unordered::detail::node_tmp<node_allocator> node_tmp;
+
+        // Keeps each stripe's buckets together, see above.
+        typedef boost::unordered::detail::fibonacci_policy<std::size_t> policy;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Members
+
+        boost::unordered::detail::compressed<bucket_allocator, node_allocator>
+          allocators_;
+        std::size_t stripe_count_;
+        std::size_t stripe_size_index_;
+        std::unique_ptr<concurrent_stripe[]> stripes_;
+        std::atomic<std::size_t> size_;
+
+        // Only changed while all the stripes are locked.
+        std::size_t bucket_count_;
+        std::size_t size_index_;
+        float mlf_;
+        std::size_t max_load_;
+        bucket_pointer buckets_;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Data access
+
+        bucket_allocator const& bucket_alloc() const
+        {
+          return allocators_.first();
+        }
+
+        node_allocator const& node_alloc() const
+        {
+          return allocators_.second();
+        }
+
+        bucket_allocator& bucket_alloc() { return allocators_.first(); }
+
+        node_allocator& node_alloc() { return allocators_.second(); }
+
+        // The node after a bucket or node.
+        template <class Pointer> static node_pointer next_node(Pointer n)
+        {
+          return static_cast<node_pointer>(n->next_);
+        }
+
+        // The node that a link points to.
+        static node_pointer link_node(link_pointer n)
+        {
+          return static_cast<node_pointer>(n);
+        }
+
+        bucket_pointer get_bucket(std::size_t bucket_index) const
+        {
+          BOOST_ASSERT(bucket_index < bucket_count_);
+          return buckets_ + static_cast<std::ptrdiff_t>(bucket_index);
+        }
+
+        std::size_t hash(const_key_type& k) const
+        {
+          return policy::apply_hash(this->hash_function(), k);
+        }
+
+        concurrent_stripe& get_stripe(std::size_t key_hash) const
+        {
+          return stripes_[policy::position(stripe_size_index_, key_hash)];
+        }
+
+        // The buckets covered by a stripe.
+        std::size_t stripe_buckets() const
+        {
+          return bucket_count_ / stripe_count_;
+        }
+
+        std::size_t size() const
+        {
+          return size_.load(std::memory_order_relaxed);
+        }
+
+        std::size_t max_bucket_count() const
+        {
+          return policy::prev_bucket_count(
+            bucket_allocator_traits::max_size(bucket_alloc()));
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Load methods
+
+        void recalculate_max_load()
+        {
+          using namespace std;
+
+          max_load_ = boost::unordered::detail::double_to_size(ceil(
+            static_cast<double>(mlf_) * static_cast<double>(bucket_count_)));
+        }
+
+        std::size_t min_buckets_for_size(std::size_t size) const
+        {
+          using namespace std;
+
+          return (std::max)(stripe_count_,
+            policy::new_bucket_count(boost::unordered::detail::double_to_size(
+              floor(static_cast<double>(size) / static_cast<double>(mlf_)) +
+              1)));
+        }
+
+        void max_load_factor(float z)
+        {
+          BOOST_ASSERT(z > 0);
+          concurrent_lock_all lock(stripes_.get(), stripe_count_);
+          mlf_ = (std::max)(z, minimum_max_load_factor);
+          recalculate_max_load();
+        }
+
+        // The bucket count can be read while holding any stripe.
+
+        float load_factor() const
+        {
+          std::lock_guard<std::mutex> lock(stripes_[0].mutex_);
+          return static_cast<float>(size()) / static_cast<float>(bucket_count_);
+        }
+
+        std::size_t bucket_count() const
+        {
+          std::lock_guard<std::mutex> lock(stripes_[0].mutex_);
+          return bucket_count_;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructors
+
+        concurrent_table(std::size_t num_buckets, hasher const& hf,
+          key_equal const& eq, value_allocator const& a)
+            : functions(hf, eq), allocators_(a, a),
+              stripe_count_(concurrent_stripe_count()),
+              stripe_size_index_(policy::size_index(stripe_count_)),
+              stripes_(new concurrent_stripe[stripe_count_]), size_(0),
+              bucket_count_(0), size_index_(0), mlf_(1.0f), max_load_(0),
+              buckets_()
+        {
+          create_buckets((std::max)(
+            stripe_count_, policy::new_bucket_count(num_buckets)));
+        }
+
+        // Copies 'x' while all its stripes are locked. The nodes go in the
+        // same buckets, so the hash function isn't called.
+        concurrent_table(concurrent_table const& x, value_allocator const& a)
+            : functions(x), allocators_(a, a), stripe_count_(x.stripe_count_),
+              stripe_size_index_(x.stripe_size_index_),
+              stripes_(new concurrent_stripe[stripe_count_]), size_(0),
+              bucket_count_(0), size_index_(0), mlf_(x.mlf_), max_load_(0),
+              buckets_()
+        {
+          concurrent_lock_all lock(x.stripes_.get(), x.stripe_count_);
+          create_buckets(x.bucket_count_);
+
+          BOOST_TRY
+          {
+            for (std::size_t i = 0; i < bucket_count_; ++i) {
+              link_pointer* prev = boost::addressof(get_bucket(i)->next_);
+              for (node_pointer n = next_node(x.get_bucket(i)); n;
+                   n = next_node(n)) {
+                node_pointer copy =
+                  boost::unordered::detail::func::construct_node(
+                    node_alloc(), n->value());
+                copy->set_hash(n->get_hash());
+                *prev = copy;
+                prev = boost::addressof(copy->next_);
+                size_.fetch_add(1, std::memory_order_relaxed);
+              }
+            }
+          }
+          BOOST_CATCH(...)
+          {
+            delete_buckets();
+            BOOST_RETHROW
+          }
+          BOOST_CATCH_END
+        }
+
+        ~concurrent_table() { delete_buckets(); }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Bucket arrays
+
+        bucket_pointer allocate_buckets(std::size_t count)
+        {
+          bucket_pointer buckets =
+            bucket_allocator_traits::allocate(bucket_alloc(), count);
+          bucket_pointer end = buckets + static_cast<std::ptrdiff_t>(count);
+          for (bucket_pointer i = buckets; i != end; ++i) {
+            new (pointer<void>::get(i)) bucket();
+          }
+          return buckets;
+        }
+
+        void destroy_bucket_array(bucket_pointer buckets, std::size_t count)
+        {
+          bucket_pointer end = buckets + static_cast<std::ptrdiff_t>(count);
+          for (bucket_pointer it = buckets; it != end; ++it) {
+            boost::unordered::detail::func::destroy(pointer<bucket>::get(it));
+          }
+          bucket_allocator_traits::deallocate(bucket_alloc(), buckets, count);
+        }
+
+        void create_buckets(std::size_t count)
+        {
+          BOOST_ASSERT(!buckets_);
+          buckets_ = allocate_buckets(count);
+          bucket_count_ = count;
+          size_index_ = policy::size_index(count);
+          recalculate_max_load();
+        }
+
+        // Destroys a list of nodes linked through 'next_'.
+        void delete_nodes(node_pointer n)
+        {
+          while (n) {
+            node_tmp tmp(n, node_alloc());
+            n = next_node(n);
+          }
+        }
+
+        void delete_buckets()
+        {
+          if (buckets_) {
+            for (std::size_t i = 0; i < bucket_count_; ++i) {
+              delete_nodes(next_node(get_bucket(i)));
+            }
+            destroy_bucket_array(buckets_, bucket_count_);
+            buckets_ = bucket_pointer();
+            size_.store(0, std::memory_order_relaxed);
+          }
+        }
+
+        // Call with all the stripes locked. Only the allocation can throw,
+        // which leaves the table unchanged.
+        void rehash_impl(std::size_t num_buckets)
+        {
+          BOOST_ASSERT(num_buckets >= stripe_count_);
+          bucket_pointer new_buckets = allocate_buckets(num_buckets);
+          std::size_t new_size_index = policy::size_index(num_buckets);
+
+          for (std::size_t i = 0; i < bucket_count_; ++i) {
+            bucket_pointer b = get_bucket(i);
+            node_pointer n = next_node(b);
+            while (n) {
+              node_pointer next = next_node(n);
+              bucket_pointer dst =
+                new_buckets + static_cast<std::ptrdiff_t>(policy::position(
+                                new_size_index, n->get_hash()));
+              n->next_ = dst->next_;
+              dst->next_ = n;
+              n = next;
+            }
+            b->next_ = link_pointer();
+          }
+
+          destroy_bucket_array(buckets_, bucket_count_);
+          buckets_ = new_buckets;
+          bucket_count_ = num_buckets;
+          size_index_ = new_size_index;
+          recalculate_max_load();
+        }
+
+        void rehash(std::size_t min_buckets)
+        {
+          concurrent_lock_all lock(stripes_.get(), stripe_count_);
+          std::size_t num_buckets =
+            (std::max)(min_buckets_for_size(size()),
+              (std::max)(stripe_count_, policy::new_bucket_count(min_buckets)));
+          if (num_buckets != bucket_count_) {
+            rehash_impl(num_buckets);
+          }
+        }
+
+        void reserve(std::size_t count)
+        {
+          using namespace std;
+
+          rehash(boost::unordered::detail::double_to_size(
+            ceil(static_cast<double>(count) / static_cast<double>(mlf_))));
+        }
+
+        // Called without holding a stripe, when an insert found that the
+        // table was full. Another thread might have already grown it.
+        void reserve_for_insert()
+        {
+          concurrent_lock_all lock(stripes_.get(), stripe_count_);
+          std::size_t size = this->size();
+          if (size >= max_load_) {
+            std::size_t num_buckets =
+              min_buckets_for_size((std::max)(size + 1, size + (size >> 1)));
+            if (num_buckets > bucket_count_) {
+              rehash_impl(num_buckets);
+            } else {
+              // Can't grow any further.
+              max_load_ = (std::numeric_limits<std::size_t>::max)();
+            }
+          }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Lookup, with the key's stripe locked
+
+        node_pointer find_node(std::size_t key_hash, const_key_type& k) const
+        {
+          for (node_pointer n = next_node(
+                 get_bucket(policy::position(size_index_, key_hash)));
+               n; n = next_node(n)) {
+            if (n->get_hash() == key_hash &&
+                this->key_eq()(k, extractor::extract(n->value()))) {
+              return n;
+            }
+          }
+          return node_pointer();
+        }
+
+        void add_node(node_pointer n, std::size_t key_hash)
+        {
+          n->set_hash(key_hash);
+          bucket_pointer b = get_bucket(policy::position(size_index_, key_hash));
+          n->next_ = b->next_;
+          b->next_ = n;
+          size_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Visitation
+
+        template <class F>
+        std::size_t visit(const_key_type& k, F&& f) const
+        {
+          std::size_t key_hash = this->hash(k);
+          std::lock_guard<std::mutex> lock(get_stripe(key_hash).mutex_);
+          node_pointer n = find_node(key_hash, k);
+          if (n) {
+            f(n->value());
+          }
+          return n ? 1 : 0;
+        }
+
+        // Locks the stripes one at a time, so this doesn't see a snapshot
+        // of the whole table.
+        template <class F> std::size_t visit_all(F&& f) const
+        {
+          std::size_t count = 0;
+          for (std::size_t s = 0; s < stripe_count_; ++s) {
+            std::lock_guard<std::mutex> lock(stripes_[s].mutex_);
+            std::size_t first = s * stripe_buckets();
+            std::size_t last = first + stripe_buckets();
+            for (std::size_t i = first; i < last; ++i) {
+              for (node_pointer n = next_node(get_bucket(i)); n;
+                   n = next_node(n)) {
+                f(n->value());
+                ++count;
+              }
+            }
+          }
+          return count;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Insert
+        //
+        // If there's an element for 'k', calls 'f' for it, otherwise inserts
+        // the node returned by 'construct', which is called with the stripe
+        // locked.
+
+        template <class Construct, class F>
+        bool insert_or_visit_impl(
+          const_key_type& k, Construct const& construct, F&& f)
+        {
+          std::size_t key_hash = this->hash(k);
+          concurrent_stripe& stripe = get_stripe(key_hash);
+
+          for (;;) {
+            std::unique_lock<std::mutex> lock(stripe.mutex_);
+            node_pointer n = find_node(key_hash, k);
+            if (n) {
+              f(n->value());
+              return false;
+            }
+            if (size() >= max_load_) {
+              lock.unlock();
+              reserve_for_insert();
+              continue;
+            }
+            add_node(construct(), key_hash);
+            return true;
+          }
+        }
+
+        template <class F, class... Args>
+        bool emplace_or_visit(F&& f, Args&&... args)
+        {
+          // Construct the node before locking, as the key is needed.
+          node_tmp b(boost::unordered::detail::func::construct_node_from_args(
+                       node_alloc(), boost::forward<Args>(args)...),
+            node_alloc());
+          return insert_or_visit_impl(extractor::extract(b.node_->value()),
+            [&b] { return b.release(); }, f);
+        }
+
+        template <class F, class Key, class... Args>
+        bool try_emplace_or_visit(F&& f, Key&& k, Args&&... args)
+        {
+          return insert_or_visit_impl(k,
+            [&] {
+              return boost::unordered::detail::func::construct_node_from_args(
+                this->node_alloc(), boost::unordered::piecewise_construct,
+                std::forward_as_tuple(boost::forward<Key>(k)),
+                std::forward_as_tuple(boost::forward<Args>(args)...));
+            },
+            f);
+        }
+
+        template <class F, class V> bool insert_or_visit(V&& v, F&& f)
+        {
+          return insert_or_visit_impl(extractor::extract(v),
+            [&] {
+              return boost::unordered::detail::func::construct_node(
+                this->node_alloc(), boost::forward<V>(v));
+            },
+            f);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Erase
+        //
+        // The nodes are unlinked with the stripe locked, and destroyed
+        // after it's released.
+
+        template <class F>
+        std::size_t erase_key_if(const_key_type& k, F&& f)
+        {
+          std::size_t key_hash = this->hash(k);
+          node_pointer n = node_pointer();
+          {
+            std::lock_guard<std::mutex> lock(get_stripe(key_hash).mutex_);
+            link_pointer* prev = boost::addressof(
+              get_bucket(policy::position(size_index_, key_hash))->next_);
+            while (*prev) {
+              node_pointer it = link_node(*prev);
+              if (it->get_hash() == key_hash &&
+                  this->key_eq()(k, extractor::extract(it->value()))) {
+                if (f(it->value())) {
+                  n = it;
+                  *prev = n->next_;
+                  size_.fetch_sub(1, std::memory_order_relaxed);
+                }
+                break;
+              }
+              prev = boost::addressof(it->next_);
+            }
+          }
+          node_tmp tmp(n, node_alloc());
+          return n ? 1 : 0;
+        }
+
+        template <class F> std::size_t erase_if(F&& f)
+        {
+          std::size_t count = 0;
+          for (std::size_t s = 0; s < stripe_count_; ++s) {
+            node_pointer erased = node_pointer();
+            {
+              std::lock_guard<std::mutex> lock(stripes_[s].mutex_);
+              std::size_t first = s * stripe_buckets();
+              std::size_t last = first + stripe_buckets();
+              for (std::size_t i = first; i < last; ++i) {
+                link_pointer* prev = boost::addressof(get_bucket(i)->next_);
+                while (*prev) {
+                  node_pointer n = link_node(*prev);
+                  if (f(n->value())) {
+                    *prev = n->next_;
+                    n->next_ = erased;
+                    erased = n;
+                    size_.fetch_sub(1, std::memory_order_relaxed);
+                    ++count;
+                  } else {
+                    prev = boost::addressof(n->next_);
+                  }
+                }
+              }
+            }
+            delete_nodes(erased);
+          }
+          return count;
+        }
+
+        void clear()
+        {
+          node_pointer erased = node_pointer();
+          {
+            concurrent_lock_all lock(stripes_.get(), stripe_count_);
+            for (std::size_t i = 0; i < bucket_count_; ++i) {
+              bucket_pointer b = get_bucket(i);
+              while (b->next_) {
+                node_pointer n = next_node(b);
+                b->next_ = n->next_;
+                n->next_ = erased;
+                erased = n;
+              }
+            }
+            size_.store(0, std::memory_order_relaxed);
+          }
+          delete_nodes(erased);
+        }
+
+      };
+    }
+  }
+}
+
+#endif
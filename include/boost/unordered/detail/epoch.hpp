@@ -0,0 +1,144 @@
+
+// Copyright (C) 2017 Daniel James
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_UNORDERED_DETAIL_EPOCH_HPP
+#define BOOST_UNORDERED_DETAIL_EPOCH_HPP
+
+#include <boost/config.hpp>
+#if defined(BOOST_HAS_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <boost/unordered/detail/implementation.hpp>
+
+#if defined(BOOST_NO_CXX11_HDR_THREAD) || defined(BOOST_NO_CXX11_HDR_ATOMIC)
+#error "Epoch based reclamation requires C++11 threads and atomics."
+#endif
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Epoch based reclamation.
+//
+// Lets readers use nodes without taking a lock, while a writer unlinks them.
+// A reader enters the current epoch by incrementing one of two counters,
+// picked by the epoch's lowest bit, in a slot chosen by its thread id. So
+// readers on different threads rarely write to the same cache line.
+//
+// Once a writer has unlinked some nodes, 'synchronize' moves to the next
+// epoch and waits until every reader that entered the previous one has
+// left. Readers that enter after that can't reach the unlinked nodes, so
+// they can be deallocated.
+//
+// A reader reads the epoch, increments its counter and then reads the
+// epoch again, starting over if it changed. As these and the writer's
+// update of the epoch are all sequentially consistent, either the writer
+// sees the reader's increment and waits for it, or the reader sees the new
+// epoch, and so everything the writer did before it.
+//
+// Only one thread can call 'synchronize' at a time, it's expected to hold
+// the writer's lock.
+
+namespace boost {
+  namespace unordered {
+    namespace detail {
+      // The reader counts for the two epochs, padded so that neighbouring
+      // slots don't share a cache line.
+      struct epoch_slot
+      {
+        std::atomic<std::size_t> readers_[2];
+        char padding_[2 * sizeof(std::atomic<std::size_t>) < 64
+                        ? 64 - 2 * sizeof(std::atomic<std::size_t>)
+                        : 1];
+
+        epoch_slot()
+        {
+          readers_[0].store(0, std::memory_order_relaxed);
+          readers_[1].store(0, std::memory_order_relaxed);
+        }
+      };
+
+      class epoch_domain
+      {
+        std::atomic<std::size_t> epoch_;
+        std::size_t slot_count_;
+        std::unique_ptr<epoch_slot[]> slots_;
+
+        epoch_domain(epoch_domain const&);
+        epoch_domain& operator=(epoch_domain const&);
+
+      public:
+        // 'slot_count' must be a power of 2.
+        explicit epoch_domain(std::size_t slot_count)
+            : epoch_(0), slot_count_(slot_count),
+              slots_(new epoch_slot[slot_count])
+        {
+          BOOST_ASSERT(slot_count && !(slot_count & (slot_count - 1)));
+        }
+
+        // Returns the counter to pass to 'leave'.
+        std::atomic<std::size_t>& enter() const
+        {
+          epoch_slot& slot =
+            slots_[boost::unordered::detail::mix_hash_value(
+                     std::hash<std::thread::id>()(std::this_thread::get_id())) &
+                   (slot_count_ - 1)];
+
+          for (;;) {
+            std::size_t epoch = epoch_.load(std::memory_order_seq_cst);
+            std::atomic<std::size_t>& readers = slot.readers_[epoch & 1];
+            readers.fetch_add(1, std::memory_order_seq_cst);
+            if (epoch_.load(std::memory_order_seq_cst) == epoch) {
+              return readers;
+            }
+            readers.fetch_sub(1, std::memory_order_release);
+          }
+        }
+
+        static void leave(std::atomic<std::size_t>& readers)
+        {
+          readers.fetch_sub(1, std::memory_order_release);
+        }
+
+        // Waits until every reader which might have seen something the
+        // calling thread unlinked has left.
+        void synchronize()
+        {
+          std::size_t epoch = epoch_.load(std::memory_order_relaxed);
+          epoch_.store(epoch + 1, std::memory_order_seq_cst);
+          for (std::size_t i = 0; i < slot_count_; ++i) {
+            while (slots_[i].readers_[epoch & 1].load(
+              std::memory_order_seq_cst)) {
+              std::this_thread::yield();
+            }
+          }
+        }
+      };
+
+      // Keeps a reader in the current epoch for its lifetime.
+      class epoch_guard
+      {
+        std::atomic<std::size_t>& readers_;
+
+        epoch_guard(epoch_guard const&);
+        epoch_guard& operator=(epoch_guard const&);
+
+      public:
+        explicit epoch_guard(epoch_domain const& domain)
+            : readers_(domain.enter())
+        {
+        }
+
+        ~epoch_guard() { epoch_domain::leave(readers_); }
+      };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,1311 @@
+// Copyright (C) 2017 Daniel James
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_UNORDERED_DETAIL_FLAT_TABLE_HPP
+#define BOOST_UNORDERED_DETAIL_FLAT_TABLE_HPP
+
+#include <boost/config.hpp>
+#if defined(BOOST_HAS_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <boost/unordered/detail/implementation.hpp>
+#include <cstring>
+#include <tuple>
+
+#if defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES) ||                              \
+  defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+#error "The flat containers require variadic templates and rvalue references."
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Configuration
+//
+// BOOST_UNORDERED_FLAT_SSE2
+//
+// Match control groups using SSE2 instructions. Can be disabled by defining
+// BOOST_UNORDERED_DISABLE_SSE2, in which case a portable implementation is
+// used.
+
+#if !defined(BOOST_UNORDERED_FLAT_SSE2)
+#if !defined(BOOST_UNORDERED_DISABLE_SSE2) &&                                  \
+  (defined(__SSE2__) || defined(_M_X64) ||                                     \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define BOOST_UNORDERED_FLAT_SSE2 1
+#else
+#define BOOST_UNORDERED_FLAT_SSE2 0
+#endif
+#endif
+
+#if BOOST_UNORDERED_FLAT_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(BOOST_MSVC)
+#include <intrin.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Open addressing table.
+//
+// The values are stored inline in a single array, with a parallel array of
+// control bytes recording the state of each slot. The slots are split into
+// groups of 16, and the hash policy picks the group to start probing from.
+// If the key isn't found in that group, the following groups are checked
+// in turn, stopping at the first group which has an empty slot.
+//
+// The control byte for a full slot holds a 7-bit fragment of the element's
+// hash value, so a lookup can compare a whole group at once, and only calls
+// the equality predicate for elements whose fragment matches. Empty and
+// deleted slots have the top bit set, so they never match a fragment.
+//
+// Erasing an element leaves a 'deleted' marker in its slot, so that the
+// probe sequences for other elements aren't broken, unless the group
+// already has an empty slot, in which case no probe sequence can have
+// continued past it.
+//
+// The control array has an extra 'sentinel' entry at the end, so that
+// iterators can find the end of the table without knowing its size.
+
+namespace boost {
+  namespace unordered {
+    namespace detail {
+      template <typename Types> struct flat_table;
+
+      enum flat_ctrl_values
+      {
+        flat_empty = 0x80,
+        flat_deleted = 0xFE,
+        flat_sentinel = 0xFF
+      };
+
+      inline bool flat_is_full(unsigned char c) { return !(c & 0x80); }
+
+      // Index of the lowest set bit, 'x' must be non-zero.
+      inline unsigned flat_first_bit(unsigned x)
+      {
+        BOOST_ASSERT(x);
+#if defined(BOOST_GCC) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_ctz(x));
+#elif defined(BOOST_MSVC)
+        unsigned long r;
+        _BitScanForward(&r, x);
+        return static_cast<unsigned>(r);
+#else
+        unsigned r = 0;
+        while (!(x & 1)) {
+          x >>= 1;
+          ++r;
+        }
+        return r;
+#endif
+      }
+
+      // The 7-bit fragment stored in the control byte. It has to be
+      // independent of the bits that pick the group, or the elements in a
+      // group would all have the same fragment: fibonacci_policy uses the
+      // high bits of the hash value multiplied by the golden ratio, and
+      // pow2_policy the low bits. So take the low bits of the fully mixed
+      // hash value, which are affected by all of its bits.
+      inline unsigned char flat_fragment(std::size_t hash)
+      {
+        return static_cast<unsigned char>(
+          boost::unordered::detail::mix_hash_value(hash) & 0x7f);
+      }
+
+      // Operations on a group of 16 control bytes, returning a bit mask of
+      // the matching slots.
+
+      struct flat_group
+      {
+        static const std::size_t size = 16;
+
+#if BOOST_UNORDERED_FLAT_SSE2
+        static __m128i load(unsigned char const* g)
+        {
+          return _mm_loadu_si128(reinterpret_cast<__m128i const*>(g));
+        }
+
+        static unsigned match(unsigned char const* g, unsigned char fragment)
+        {
+          return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(
+            load(g), _mm_set1_epi8(static_cast<char>(fragment)))));
+        }
+
+        static unsigned match_empty(unsigned char const* g)
+        {
+          return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(
+            load(g), _mm_set1_epi8(static_cast<char>(flat_empty)))));
+        }
+
+        // Sentinels aren't included in any group, so everything with the
+        // top bit set is empty or deleted.
+        static unsigned match_empty_or_deleted(unsigned char const* g)
+        {
+          return static_cast<unsigned>(_mm_movemask_epi8(load(g)));
+        }
+#else
+        static unsigned match(unsigned char const* g, unsigned char fragment)
+        {
+          unsigned mask = 0;
+          for (unsigned i = 0; i < size; ++i) {
+            mask |= static_cast<unsigned>(g[i] == fragment) << i;
+          }
+          return mask;
+        }
+
+        static unsigned match_empty(unsigned char const* g)
+        {
+          return match(g, static_cast<unsigned char>(flat_empty));
+        }
+
+        static unsigned match_empty_or_deleted(unsigned char const* g)
+        {
+          unsigned mask = 0;
+          for (unsigned i = 0; i < size; ++i) {
+            mask |= static_cast<unsigned>(g[i] >> 7) << i;
+          }
+          return mask;
+        }
+#endif
+      };
+    }
+
+    namespace iterator_detail {
+      template <typename ValueType> struct c_flat_iterator;
+
+      template <typename ValueType>
+      struct flat_iterator
+        : public std::iterator<std::forward_iterator_tag, ValueType,
+            std::ptrdiff_t, ValueType*, ValueType&>
+      {
+#if !defined(BOOST_NO_MEMBER_TEMPLATE_FRIENDS)
+        template <typename>
+        friend struct boost::unordered::iterator_detail::c_flat_iterator;
+        template <typename> friend struct boost::unordered::detail::flat_table;
+
+      private:
+#endif
+        unsigned char const* ctrl_;
+        ValueType* value_;
+
+        void increment()
+        {
+          do {
+            ++ctrl_;
+            ++value_;
+          } while (!boost::unordered::detail::flat_is_full(*ctrl_) &&
+                   *ctrl_ != boost::unordered::detail::flat_sentinel);
+
+          if (*ctrl_ == boost::unordered::detail::flat_sentinel) {
+            ctrl_ = 0;
+            value_ = 0;
+          }
+        }
+
+      public:
+        typedef ValueType value_type;
+
+        flat_iterator() BOOST_NOEXCEPT : ctrl_(), value_() {}
+
+        flat_iterator(unsigned char const* c, ValueType* v) BOOST_NOEXCEPT
+          : ctrl_(c),
+            value_(v)
+        {
+        }
+
+        value_type& operator*() const { return *value_; }
+
+        value_type* operator->() const { return value_; }
+
+        flat_iterator& operator++()
+        {
+          increment();
+          return *this;
+        }
+
+        flat_iterator operator++(int)
+        {
+          flat_iterator tmp(*this);
+          increment();
+          return tmp;
+        }
+
+        bool operator==(flat_iterator const& x) const BOOST_NOEXCEPT
+        {
+          return value_ == x.value_;
+        }
+
+        bool operator!=(flat_iterator const& x) const BOOST_NOEXCEPT
+        {
+          return value_ != x.value_;
+        }
+      };
+
+      template <typename ValueType>
+      struct c_flat_iterator
+        : public std::iterator<std::forward_iterator_tag, ValueType,
+            std::ptrdiff_t, ValueType const*, ValueType const&>
+      {
+#if !defined(BOOST_NO_MEMBER_TEMPLATE_FRIENDS)
+        template <typename> friend struct boost::unordered::detail::flat_table;
+
+      private:
+#endif
+        typedef boost::unordered::iterator_detail::flat_iterator<ValueType>
+          n_iterator;
+
+        unsigned char const* ctrl_;
+        ValueType const* value_;
+
+        void increment()
+        {
+          do {
+            ++ctrl_;
+            ++value_;
+          } while (!boost::unordered::detail::flat_is_full(*ctrl_) &&
+                   *ctrl_ != boost::unordered::detail::flat_sentinel);
+
+          if (*ctrl_ == boost::unordered::detail::flat_sentinel) {
+            ctrl_ = 0;
+            value_ = 0;
+          }
+        }
+
+      public:
+        typedef ValueType value_type;
+
+        c_flat_iterator() BOOST_NOEXCEPT : ctrl_(), value_() {}
+
+        c_flat_iterator(unsigned char const* c, ValueType const* v)
+          BOOST_NOEXCEPT : ctrl_(c),
+                           value_(v)
+        {
+        }
+
+        c_flat_iterator(n_iterator const& x) BOOST_NOEXCEPT : ctrl_(x.ctrl_),
+                                                              value_(x.value_)
+        {
+        }
+
+        value_type const& operator*() const { return *value_; }
+
+        value_type const* operator->() const { return value_; }
+
+        c_flat_iterator& operator++()
+        {
+          increment();
+          return *this;
+        }
+
+        c_flat_iterator operator++(int)
+        {
+          c_flat_iterator tmp(*this);
+          increment();
+          return tmp;
+        }
+
+        friend bool operator==(
+          c_flat_iterator const& x, c_flat_iterator const& y) BOOST_NOEXCEPT
+        {
+          return x.value_ == y.value_;
+        }
+
+        friend bool operator!=(
+          c_flat_iterator const& x, c_flat_iterator const& y) BOOST_NOEXCEPT
+        {
+          return x.value_ != y.value_;
+        }
+      };
+    }
+
+    namespace detail {
+      namespace func {
+        template <typename Alloc, typename T>
+        inline void destroy_value(Alloc& alloc, T* x)
+        {
+#if BOOST_UNORDERED_CXX11_CONSTRUCTION
+          boost::unordered::detail::allocator_traits<Alloc>::destroy(alloc, x);
+#else
+          boost::unordered::detail::func::ignore_unused_variable_warning(alloc);
+          boost::unordered::detail::func::destroy(x);
+#endif
+        }
+      }
+
+      // Temporary value, used when the key can't be extracted from the
+      // emplace arguments.
+
+      template <typename Alloc> struct flat_value_tmp
+      {
+        typedef typename boost::unordered::detail::allocator_traits<
+          Alloc>::value_type value_type;
+
+        Alloc& alloc_;
+        boost::unordered::detail::value_base<value_type> storage_;
+
+        template <typename... Args>
+        explicit flat_value_tmp(Alloc& a, BOOST_FWD_REF(Args)... args)
+            : alloc_(a), storage_()
+        {
+          boost::unordered::detail::func::construct_from_args(
+            alloc_, storage_.value_ptr(), boost::forward<Args>(args)...);
+        }
+
+        ~flat_value_tmp()
+        {
+          boost::unordered::detail::func::destroy_value(
+            alloc_, storage_.value_ptr());
+        }
+
+        value_type& value() { return storage_.value(); }
+
+      private:
+        flat_value_tmp(flat_value_tmp const&);
+        flat_value_tmp& operator=(flat_value_tmp const&);
+      };
+
+      template <typename Types>
+      struct flat_table
+        : boost::unordered::detail::functions<typename Types::hasher,
+            typename Types::key_equal>
+      {
+      private:
+        flat_table(flat_table const&);
+        flat_table& operator=(flat_table const&);
+
+      public:
+        typedef typename Types::hasher hasher;
+        typedef typename Types::key_equal key_equal;
+        typedef typename Types::const_key_type const_key_type;
+        typedef typename Types::extractor extractor;
+        typedef typename Types::value_type value_type;
+        typedef typename Types::policy policy;
+        typedef typename Types::iterator iterator;
+        typedef typename Types::c_iterator c_iterator;
+
+        typedef boost::unordered::detail::functions<typename Types::hasher,
+          typename Types::key_equal>
+          functions;
+        typedef typename functions::set_hash_functions set_hash_functions;
+
+        typedef typename Types::value_allocator value_allocator;
+        typedef typename boost::unordered::detail::rebind_wrap<value_allocator,
+          unsigned char>::type ctrl_allocator;
+        typedef boost::unordered::detail::allocator_traits<value_allocator>
+          value_allocator_traits;
+        typedef boost::unordered::detail::allocator_traits<ctrl_allocator>
+          ctrl_allocator_traits;
+        typedef typename value_allocator_traits::pointer value_pointer;
+        typedef typename ctrl_allocator_traits::pointer ctrl_pointer;
+        typedef boost::unordered::detail::flat_value_tmp<value_allocator>
+          value_tmp;
+
+        typedef std::pair<iterator, bool> emplace_return;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Members
+
+        boost::unordered::detail::compressed<value_allocator, ctrl_allocator>
+          allocators_;
+        std::size_t bucket_count_;
+        // 'policy::size_index' for the number of groups.
+        std::size_t size_index_;
+        std::size_t size_;
+        std::size_t deleted_;
+        std::size_t max_load_;
+        value_pointer values_;
+        ctrl_pointer ctrl_;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Data access
+
+        value_allocator const& value_alloc() const
+        {
+          return allocators_.first();
+        }
+
+        ctrl_allocator const& ctrl_alloc() const
+        {
+          return allocators_.second();
+        }
+
+        value_allocator& value_alloc() { return allocators_.first(); }
+
+        ctrl_allocator& ctrl_alloc() { return allocators_.second(); }
+
+        value_type* get_value(std::size_t index) const
+        {
+          BOOST_ASSERT(values_);
+          return boost::unordered::detail::pointer<value_type>::get(values_) +
+                 index;
+        }
+
+        unsigned char* get_ctrl(std::size_t index) const
+        {
+          BOOST_ASSERT(ctrl_);
+          return boost::unordered::detail::pointer<unsigned char>::get(ctrl_) +
+                 index;
+        }
+
+        // Returns the end iterator for 'bucket_count_', which is used to
+        // indicate that a value wasn't found.
+        iterator get_iterator(std::size_t index) const
+        {
+          return index < bucket_count_
+                   ? iterator(get_ctrl(index), get_value(index))
+                   : iterator();
+        }
+
+        std::size_t get_index(c_iterator it) const
+        {
+          BOOST_ASSERT(it.value_);
+          return static_cast<std::size_t>(it.value_ - get_value(0));
+        }
+
+        std::size_t next_full(std::size_t index) const
+        {
+          unsigned char const* c = get_ctrl(index);
+          while (!flat_is_full(*c) && *c != flat_sentinel) {
+            ++c;
+          }
+          return static_cast<std::size_t>(c - get_ctrl(0));
+        }
+
+        iterator begin() const
+        {
+          return size_ ? get_iterator(next_full(0)) : iterator();
+        }
+
+        // The number of slots is always a multiple of the group size,
+        // with the number of groups chosen by the hash policy.
+
+        static std::size_t new_bucket_count(std::size_t min)
+        {
+          return policy::new_bucket_count(min / flat_group::size +
+                                          (min % flat_group::size ? 1 : 0)) *
+                 flat_group::size;
+        }
+
+        static std::size_t prev_bucket_count(std::size_t max)
+        {
+          return policy::prev_bucket_count(max / flat_group::size) *
+                 flat_group::size;
+        }
+
+        std::size_t group_count() const
+        {
+          return bucket_count_ / flat_group::size;
+        }
+
+        static std::size_t group_size_index(std::size_t count)
+        {
+          return policy::size_index(count / flat_group::size);
+        }
+
+        void set_bucket_count(std::size_t count)
+        {
+          bucket_count_ = count;
+          size_index_ = group_size_index(count);
+        }
+
+        std::size_t hash_to_group(std::size_t hash_value) const
+        {
+          return policy::position(size_index_, hash_value);
+        }
+
+        std::size_t next_group(std::size_t group) const
+        {
+          ++group;
+          return group == group_count() ? 0 : group;
+        }
+
+        unsigned char const* get_group(std::size_t group) const
+        {
+          return get_ctrl(group * flat_group::size);
+        }
+
+        const_key_type& get_key(std::size_t index) const
+        {
+          return extractor::extract(*get_value(index));
+        }
+
+        std::size_t hash(const_key_type& k) const
+        {
+          return policy::apply_hash(this->hash_function(), k);
+        }
+
+        std::size_t max_bucket_count() const
+        {
+          // -1 to account for the sentinel.
+          return prev_bucket_count(
+            (std::min)(value_allocator_traits::max_size(value_alloc()),
+              ctrl_allocator_traits::max_size(ctrl_alloc()) - 1));
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Load methods
+        //
+        // The maximum load factor is fixed as the length of the probe
+        // sequences grows rapidly once the table is mostly full. It must be
+        // less than 1, so that every probe sequence ends at a group with an
+        // empty slot.
+
+        static float max_load_factor() { return 0.875f; }
+
+        void recalculate_max_load()
+        {
+          using namespace std;
+
+          max_load_ = values_ ? boost::unordered::detail::double_to_size(floor(
+                                  static_cast<double>(max_load_factor()) *
+                                  static_cast<double>(bucket_count_)))
+                              : 0;
+        }
+
+        std::size_t min_buckets_for_size(std::size_t size) const
+        {
+          using namespace std;
+
+          return new_bucket_count(boost::unordered::detail::double_to_size(
+            floor(static_cast<double>(size) /
+                  static_cast<double>(max_load_factor())) +
+            1));
+        }
+
+        // The bucket count to use for a copy. Keep the existing layout
+        // when it isn't much larger than required, so that the values can
+        // be copied into the same slots without calling the hash function.
+        std::size_t copy_bucket_count() const
+        {
+          std::size_t min = min_buckets_for_size(size_ + (size_ >> 1));
+          return bucket_count_ <= min ? bucket_count_
+                                      : min_buckets_for_size(size_);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructors
+
+        flat_table(std::size_t num_buckets, hasher const& hf,
+          key_equal const& eq, value_allocator const& a)
+            : functions(hf, eq), allocators_(a, a),
+              bucket_count_(new_bucket_count(num_buckets)),
+              size_index_(group_size_index(bucket_count_)), size_(0),
+              deleted_(0), max_load_(0), values_(), ctrl_()
+        {
+        }
+
+        flat_table(flat_table const& x, value_allocator const& a)
+            : functions(x), allocators_(a, a),
+              bucket_count_(x.copy_bucket_count()),
+              size_index_(group_size_index(bucket_count_)), size_(0),
+              deleted_(0), max_load_(0), values_(), ctrl_()
+        {
+        }
+
+        flat_table(flat_table& x, boost::unordered::detail::move_tag m)
+            : functions(x, m), allocators_(x.allocators_, m),
+              bucket_count_(x.bucket_count_), size_index_(x.size_index_),
+              size_(x.size_), deleted_(x.deleted_), max_load_(x.max_load_),
+              values_(x.values_), ctrl_(x.ctrl_)
+        {
+          x.values_ = value_pointer();
+          x.ctrl_ = ctrl_pointer();
+          x.size_ = 0;
+          x.deleted_ = 0;
+          x.max_load_ = 0;
+        }
+
+        flat_table(flat_table& x, value_allocator const& a,
+          boost::unordered::detail::move_tag m)
+            : functions(x, m), allocators_(a, a),
+              bucket_count_(x.bucket_count_), size_index_(x.size_index_),
+              size_(0), deleted_(0), max_load_(0), values_(), ctrl_()
+        {
+        }
+
+        ~flat_table() { delete_buckets(); }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Create and delete the slot arrays
+
+        // Allocate empty slot arrays. Doesn't touch the existing arrays,
+        // which should either be empty or dealt with by the caller.
+        //
+        // Strong exception safety.
+        void create_buckets(std::size_t new_count)
+        {
+          ctrl_pointer new_ctrl =
+            ctrl_allocator_traits::allocate(ctrl_alloc(), new_count + 1);
+          value_pointer new_values;
+          BOOST_TRY
+          {
+            new_values =
+              value_allocator_traits::allocate(value_alloc(), new_count);
+          }
+          BOOST_CATCH(...)
+          {
+            ctrl_allocator_traits::deallocate(
+              ctrl_alloc(), new_ctrl, new_count + 1);
+            BOOST_RETHROW
+          }
+          BOOST_CATCH_END
+
+          // nothrow from here...
+          unsigned char* c = boost::unordered::detail::pointer<
+            unsigned char>::get(new_ctrl);
+          std::memset(c, flat_empty, new_count);
+          c[new_count] = flat_sentinel;
+
+          values_ = new_values;
+          ctrl_ = new_ctrl;
+          set_bucket_count(new_count);
+          size_ = 0;
+          deleted_ = 0;
+          recalculate_max_load();
+        }
+
+        void destroy_values()
+        {
+          if (size_) {
+            unsigned char* c = get_ctrl(0);
+            for (std::size_t i = 0; i < bucket_count_; ++i) {
+              if (flat_is_full(c[i])) {
+                boost::unordered::detail::func::destroy_value(
+                  value_alloc(), get_value(i));
+              }
+            }
+          }
+        }
+
+        void deallocate_buckets()
+        {
+          value_allocator_traits::deallocate(
+            value_alloc(), values_, bucket_count_);
+          ctrl_allocator_traits::deallocate(
+            ctrl_alloc(), ctrl_, bucket_count_ + 1);
+          values_ = value_pointer();
+          ctrl_ = ctrl_pointer();
+          max_load_ = 0;
+        }
+
+        void delete_buckets()
+        {
+          if (values_) {
+            destroy_values();
+            deallocate_buckets();
+            size_ = 0;
+            deleted_ = 0;
+          }
+        }
+
+        void clear_impl()
+        {
+          if (size_ || deleted_) {
+            destroy_values();
+            std::memset(get_ctrl(0), flat_empty, bucket_count_);
+            size_ = 0;
+            deleted_ = 0;
+          }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Copy and move the contents of another table into this one, which
+        // must be empty with no slots allocated.
+
+        // Copies the control bytes, including deleted markers, so that the
+        // values can stay in the same slots without rehashing.
+        void copy_buckets_same_layout(flat_table const& src)
+        {
+          create_buckets(src.bucket_count_);
+          unsigned char const* src_ctrl = src.get_ctrl(0);
+          unsigned char* c = get_ctrl(0);
+
+          for (std::size_t i = 0; i < bucket_count_; ++i) {
+            if (flat_is_full(src_ctrl[i])) {
+              boost::unordered::detail::func::construct_from_args(
+                value_alloc(), get_value(i), *src.get_value(i));
+              c[i] = src_ctrl[i];
+              ++size_;
+            } else if (src_ctrl[i] == flat_deleted) {
+              c[i] = flat_deleted;
+              ++deleted_;
+            }
+          }
+        }
+
+        void copy_buckets(flat_table const& src)
+        {
+          BOOST_ASSERT(!values_ && !size_);
+
+          if (!src.size_) {
+            return;
+          } else if (bucket_count_ == src.bucket_count_) {
+            copy_buckets_same_layout(src);
+          } else {
+            create_buckets(bucket_count_);
+            unsigned char const* src_ctrl = src.get_ctrl(0);
+            for (std::size_t i = 0; i < src.bucket_count_; ++i) {
+              if (flat_is_full(src_ctrl[i])) {
+                value_type const& v = *src.get_value(i);
+                std::size_t key_hash = this->hash(extractor::extract(v));
+                add_value(find_free_bucket(key_hash), key_hash, v);
+              }
+            }
+          }
+        }
+
+        // Moves the values of src into the same slots, used when the
+        // allocators aren't equal so the arrays can't be stolen.
+        void move_buckets(flat_table& src)
+        {
+          BOOST_ASSERT(!values_ && !size_);
+
+          if (src.size_) {
+            create_buckets(src.bucket_count_);
+            unsigned char const* src_ctrl = src.get_ctrl(0);
+            unsigned char* c = get_ctrl(0);
+
+            for (std::size_t i = 0; i < bucket_count_; ++i) {
+              if (flat_is_full(src_ctrl[i])) {
+                boost::unordered::detail::func::construct_from_args(
+                  value_alloc(), get_value(i), boost::move(*src.get_value(i)));
+                c[i] = src_ctrl[i];
+                ++size_;
+              } else if (src_ctrl[i] == flat_deleted) {
+                c[i] = flat_deleted;
+                ++deleted_;
+              }
+            }
+          }
+        }
+
+        // Only call with arrays allocated with the current allocator, or
+        // one that is equal to it.
+        void move_buckets_from(flat_table& other)
+        {
+          BOOST_ASSERT(!values_);
+          values_ = other.values_;
+          ctrl_ = other.ctrl_;
+          bucket_count_ = other.bucket_count_;
+          size_index_ = other.size_index_;
+          size_ = other.size_;
+          deleted_ = other.deleted_;
+          max_load_ = other.max_load_;
+          other.values_ = value_pointer();
+          other.ctrl_ = ctrl_pointer();
+          other.size_ = 0;
+          other.deleted_ = 0;
+          other.max_load_ = 0;
+        }
+
+        void swap_contents(flat_table& x)
+        {
+          boost::swap(values_, x.values_);
+          boost::swap(ctrl_, x.ctrl_);
+          boost::swap(bucket_count_, x.bucket_count_);
+          boost::swap(size_index_, x.size_index_);
+          boost::swap(size_, x.size_);
+          boost::swap(deleted_, x.deleted_);
+          boost::swap(max_load_, x.max_load_);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Swap
+
+        void swap_allocators(flat_table& other, false_type)
+        {
+          boost::unordered::detail::func::ignore_unused_variable_warning(other);
+
+          // According to 23.2.1.8, if propagate_on_container_swap is
+          // false the behaviour is undefined unless the allocators
+          // are equal.
+          BOOST_ASSERT(value_alloc() == other.value_alloc());
+        }
+
+        void swap_allocators(flat_table& other, true_type)
+        {
+          allocators_.swap(other.allocators_);
+        }
+
+        // Only swaps the allocators if propagate_on_container_swap
+        void swap(flat_table& x)
+        {
+          set_hash_functions op1(*this, x);
+          set_hash_functions op2(x, *this);
+
+          swap_allocators(x, boost::unordered::detail::integral_constant<bool,
+                               allocator_traits<value_allocator>::
+                                 propagate_on_container_swap::value>());
+
+          swap_contents(x);
+          op1.commit();
+          op2.commit();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Assignment
+
+        void assign(flat_table const& x)
+        {
+          if (this != &x) {
+            assign(x, boost::unordered::detail::integral_constant<bool,
+                        allocator_traits<value_allocator>::
+                          propagate_on_container_copy_assignment::value>());
+          }
+        }
+
+        void assign(flat_table const& x, false_type)
+        {
+          // Strong exception safety.
+          set_hash_functions new_func_this(*this, x);
+          flat_table tmp(x, value_alloc());
+          tmp.copy_buckets(x);
+          new_func_this.commit();
+          swap_contents(tmp);
+        }
+
+        void assign(flat_table const& x, true_type)
+        {
+          if (value_alloc() == x.value_alloc()) {
+            allocators_.assign(x.allocators_);
+            assign(x, false_type());
+          } else {
+            set_hash_functions new_func_this(*this, x);
+
+            // Delete everything with current allocators before assigning
+            // the new ones.
+            delete_buckets();
+            allocators_.assign(x.allocators_);
+
+            // Copy over other data, all no throw.
+            new_func_this.commit();
+            set_bucket_count(x.copy_bucket_count());
+
+            // Finally copy the elements.
+            copy_buckets(x);
+          }
+        }
+
+        void move_assign(flat_table& x)
+        {
+          if (this != &x) {
+            move_assign(
+              x, boost::unordered::detail::integral_constant<bool,
+                   allocator_traits<value_allocator>::
+                     propagate_on_container_move_assignment::value>());
+          }
+        }
+
+        void move_assign(flat_table& x, true_type)
+        {
+          delete_buckets();
+          set_hash_functions new_func_this(*this, x);
+          allocators_.move_assign(x.allocators_);
+          // No throw from here.
+          move_buckets_from(x);
+          new_func_this.commit();
+        }
+
+        void move_assign(flat_table& x, false_type)
+        {
+          if (value_alloc() == x.value_alloc()) {
+            delete_buckets();
+            set_hash_functions new_func_this(*this, x);
+            // No throw from here.
+            move_buckets_from(x);
+            new_func_this.commit();
+          } else {
+            set_hash_functions new_func_this(*this, x);
+            flat_table tmp(x, value_alloc(), move_tag());
+            tmp.move_buckets(x);
+            new_func_this.commit();
+            swap_contents(tmp);
+          }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Find
+
+        // Returns bucket_count_ if the key isn't found.
+        template <class Key, class Pred>
+        std::size_t find_bucket_impl(
+          std::size_t key_hash, Key const& k, Pred const& eq) const
+        {
+          if (!size_) {
+            return bucket_count_;
+          }
+
+          value_type const* v = get_value(0);
+          unsigned char fragment = flat_fragment(key_hash);
+          std::size_t group = hash_to_group(key_hash);
+
+          for (;;) {
+            unsigned char const* g = get_group(group);
+            for (unsigned m = flat_group::match(g, fragment); m; m &= m - 1) {
+              std::size_t index =
+                group * flat_group::size + flat_first_bit(m);
+              if (eq(k, extractor::extract(v[index]))) {
+                return index;
+              }
+            }
+            if (flat_group::match_empty(g)) {
+              return bucket_count_;
+            }
+            group = next_group(group);
+          }
+        }
+
+        std::size_t find_bucket(std::size_t key_hash, const_key_type& k) const
+        {
+          return this->find_bucket_impl(key_hash, k, this->key_eq());
+        }
+
+        std::size_t find_bucket(const_key_type& k) const
+        {
+          return this->find_bucket_impl(this->hash(k), k, this->key_eq());
+        }
+
+        iterator find(const_key_type& k) const
+        {
+          return get_iterator(find_bucket(k));
+        }
+
+        // The first slot that a value with the given hash can be placed in.
+        // There must be at least one empty slot.
+        std::size_t find_free_bucket(std::size_t key_hash) const
+        {
+          std::size_t group = hash_to_group(key_hash);
+          for (;;) {
+            unsigned m = flat_group::match_empty_or_deleted(get_group(group));
+            if (m) {
+              return group * flat_group::size + flat_first_bit(m);
+            }
+            group = next_group(group);
+          }
+        }
+
+        bool equals_unique(flat_table const& other) const
+        {
+          if (this->size_ != other.size_)
+            return false;
+
+          for (iterator it = begin(); it != iterator(); ++it) {
+            std::size_t index = other.find_bucket(extractor::extract(*it));
+
+            if (index == other.bucket_count_ ||
+                *it != *other.get_value(index))
+              return false;
+          }
+
+          return true;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Reserve & Rehash
+
+        // basic exception safety
+        void reserve_for_insert(std::size_t size)
+        {
+          if (!values_) {
+            create_buckets(
+              (std::max)(bucket_count_, min_buckets_for_size(size)));
+          } else if (size + deleted_ > max_load_) {
+            // If there are a lot of deleted markers, this might rehash
+            // into a table of the same size, which clears them.
+            rehash_impl(
+              min_buckets_for_size((std::max)(size, size_ + (size_ >> 1))));
+          }
+        }
+
+        void rehash(std::size_t min_buckets)
+        {
+          if (!size_) {
+            delete_buckets();
+            set_bucket_count(new_bucket_count(min_buckets));
+          } else {
+            min_buckets = (std::max)(new_bucket_count(min_buckets),
+              min_buckets_for_size(size_));
+
+            if (min_buckets != bucket_count_ || deleted_)
+              rehash_impl(min_buckets);
+          }
+        }
+
+        void reserve(std::size_t size)
+        {
+          rehash(min_buckets_for_size(size));
+        }
+
+        // If the hash function or a move throws, the values that haven't
+        // been moved yet are lost, so basic exception safety.
+        void rehash_impl(std::size_t num_buckets)
+        {
+          BOOST_ASSERT(values_);
+
+          value_pointer old_values = values_;
+          ctrl_pointer old_ctrl = ctrl_;
+          std::size_t old_count = bucket_count_;
+          std::size_t remaining = size_;
+
+          values_ = value_pointer();
+          ctrl_ = ctrl_pointer();
+          BOOST_TRY { create_buckets(num_buckets); }
+          BOOST_CATCH(...)
+          {
+            values_ = old_values;
+            ctrl_ = old_ctrl;
+            BOOST_RETHROW
+          }
+          BOOST_CATCH_END
+
+          value_type* v = boost::unordered::detail::pointer<value_type>::get(
+            old_values);
+          unsigned char* c = boost::unordered::detail::pointer<
+            unsigned char>::get(old_ctrl);
+
+          BOOST_TRY
+          {
+            for (std::size_t i = 0; remaining; ++i) {
+              if (flat_is_full(c[i])) {
+                std::size_t key_hash = this->hash(extractor::extract(v[i]));
+                add_value(find_free_bucket(key_hash), key_hash,
+                  boost::move_if_noexcept(v[i]));
+                c[i] = flat_empty;
+                --remaining;
+                boost::unordered::detail::func::destroy_value(
+                  value_alloc(), v + i);
+              }
+            }
+          }
+          BOOST_CATCH(...)
+          {
+            for (std::size_t i = 0; remaining; ++i) {
+              if (flat_is_full(c[i])) {
+                --remaining;
+                boost::unordered::detail::func::destroy_value(
+                  value_alloc(), v + i);
+              }
+            }
+            value_allocator_traits::deallocate(
+              value_alloc(), old_values, old_count);
+            ctrl_allocator_traits::deallocate(
+              ctrl_alloc(), old_ctrl, old_count + 1);
+            BOOST_RETHROW
+          }
+          BOOST_CATCH_END
+
+          value_allocator_traits::deallocate(
+            value_alloc(), old_values, old_count);
+          ctrl_allocator_traits::deallocate(
+            ctrl_alloc(), old_ctrl, old_count + 1);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Emplace/Insert
+
+        // Construct a value in a free slot. Strong exception safety.
+        template <typename... Args>
+        value_type* add_value(
+          std::size_t index, std::size_t key_hash, BOOST_FWD_REF(Args)... args)
+        {
+          unsigned char* c = get_ctrl(index);
+          BOOST_ASSERT(!flat_is_full(*c));
+          value_type* v = get_value(index);
+          boost::unordered::detail::func::construct_from_args(
+            value_alloc(), v, boost::forward<Args>(args)...);
+          if (*c == flat_deleted) {
+            --deleted_;
+          }
+          *c = flat_fragment(key_hash);
+          ++size_;
+          return v;
+        }
+
+        template <typename... Args>
+        iterator resize_and_add_value(
+          std::size_t key_hash, BOOST_FWD_REF(Args)... args)
+        {
+          this->reserve_for_insert(this->size_ + 1);
+          std::size_t index = this->find_free_bucket(key_hash);
+          this->add_value(index, key_hash, boost::forward<Args>(args)...);
+          return get_iterator(index);
+        }
+
+        template <typename... Args>
+        iterator emplace_hint_unique(
+          c_iterator hint, const_key_type& k, BOOST_FWD_REF(Args)... args)
+        {
+          if (hint.value_ &&
+              this->key_eq()(k, extractor::extract(*hint.value_))) {
+            return get_iterator(get_index(hint));
+          } else {
+            return emplace_unique(k, boost::forward<Args>(args)...).first;
+          }
+        }
+
+        template <typename... Args>
+        emplace_return emplace_unique(
+          const_key_type& k, BOOST_FWD_REF(Args)... args)
+        {
+          std::size_t key_hash = this->hash(k);
+          std::size_t index = this->find_bucket(key_hash, k);
+          if (index != bucket_count_) {
+            return emplace_return(get_iterator(index), false);
+          } else {
+            return emplace_return(
+              resize_and_add_value(key_hash, boost::forward<Args>(args)...),
+              true);
+          }
+        }
+
+        template <typename... Args>
+        iterator emplace_hint_unique(
+          c_iterator hint, no_key, BOOST_FWD_REF(Args)... args)
+        {
+          value_tmp b(this->value_alloc(), boost::forward<Args>(args)...);
+          const_key_type& k = extractor::extract(b.value());
+          if (hint.value_ &&
+              this->key_eq()(k, extractor::extract(*hint.value_))) {
+            return get_iterator(get_index(hint));
+          }
+          std::size_t key_hash = this->hash(k);
+          std::size_t index = this->find_bucket(key_hash, k);
+          if (index != bucket_count_) {
+            return get_iterator(index);
+          } else {
+            return resize_and_add_value(key_hash, boost::move(b.value()));
+          }
+        }
+
+        template <typename... Args>
+        emplace_return emplace_unique(no_key, BOOST_FWD_REF(Args)... args)
+        {
+          value_tmp b(this->value_alloc(), boost::forward<Args>(args)...);
+          const_key_type& k = extractor::extract(b.value());
+          std::size_t key_hash = this->hash(k);
+          std::size_t index = this->find_bucket(key_hash, k);
+          if (index != bucket_count_) {
+            return emplace_return(get_iterator(index), false);
+          } else {
+            return emplace_return(
+              resize_and_add_value(key_hash, boost::move(b.value())), true);
+          }
+        }
+
+        template <typename Key, typename... Args>
+        emplace_return try_emplace_unique(
+          BOOST_FWD_REF(Key) k, BOOST_FWD_REF(Args)... args)
+        {
+          std::size_t key_hash = this->hash(k);
+          std::size_t index = this->find_bucket(key_hash, k);
+          if (index != bucket_count_) {
+            return emplace_return(get_iterator(index), false);
+          } else {
+            return emplace_return(
+              resize_and_add_value(key_hash,
+                boost::unordered::piecewise_construct,
+                std::forward_as_tuple(boost::forward<Key>(k)),
+                std::forward_as_tuple(boost::forward<Args>(args)...)),
+              true);
+          }
+        }
+
+        template <typename Key, typename... Args>
+        iterator try_emplace_hint_unique(
+          c_iterator hint, BOOST_FWD_REF(Key) k, BOOST_FWD_REF(Args)... args)
+        {
+          if (hint.value_ && this->key_eq()(hint->first, k)) {
+            return get_iterator(get_index(hint));
+          } else {
+            return try_emplace_unique(
+              boost::forward<Key>(k), boost::forward<Args>(args)...)
+              .first;
+          }
+        }
+
+        template <typename Key, typename M>
+        emplace_return insert_or_assign_unique(
+          BOOST_FWD_REF(Key) k, BOOST_FWD_REF(M) obj)
+        {
+          std::size_t key_hash = this->hash(k);
+          std::size_t index = this->find_bucket(key_hash, k);
+
+          if (index != bucket_count_) {
+            get_value(index)->second = boost::forward<M>(obj);
+            return emplace_return(get_iterator(index), false);
+          } else {
+            return emplace_return(resize_and_add_value(key_hash,
+                                    boost::forward<Key>(k),
+                                    boost::forward<M>(obj)),
+              true);
+          }
+        }
+
+        template <class InputIt> void insert_range_unique(InputIt i, InputIt j)
+        {
+          if (i != j) {
+            this->reserve_for_insert(
+              this->size_ + boost::unordered::detail::insert_size(i, j));
+            for (; i != j; ++i) {
+              emplace_unique(extractor::extract(*i), *i);
+            }
+          }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Erase
+        //
+        // no throw
+
+        void erase_bucket(std::size_t index)
+        {
+          unsigned char* c = get_ctrl(index);
+          BOOST_ASSERT(flat_is_full(*c));
+          boost::unordered::detail::func::destroy_value(
+            value_alloc(), get_value(index));
+          if (flat_group::match_empty(get_group(index / flat_group::size))) {
+            *c = flat_empty;
+          } else {
+            *c = flat_deleted;
+            ++deleted_;
+          }
+          --size_;
+        }
+
+        iterator erase(c_iterator it)
+        {
+          std::size_t index = get_index(it);
+          iterator next = get_iterator(index);
+          ++next;
+          erase_bucket(index);
+          return next;
+        }
+
+        iterator erase_range(c_iterator first, c_iterator last)
+        {
+          while (first != last) {
+            std::size_t index = get_index(first);
+            ++first;
+            erase_bucket(index);
+          }
+          return last.value_ ? get_iterator(get_index(last)) : iterator();
+        }
+
+        std::size_t erase_key_unique(const_key_type& k)
+        {
+          std::size_t index = this->find_bucket(k);
+          if (index == bucket_count_)
+            return 0;
+          erase_bucket(index);
+          return 1;
+        }
+      };
+    }
+  }
+}
+
+#endif
@@ -13,6 +13,7 @@
 #endif
 
 #include <boost/assert.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/detail/no_exceptions_support.hpp>
 #include <boost/detail/select_type.hpp>
 #include <boost/iterator/iterator_categories.hpp>
@@ -26,6 +27,7 @@
 #include <boost/preprocessor/repetition/enum_params.hpp>
 #include <boost/preprocessor/repetition/repeat_from_to.hpp>
 #include <boost/preprocessor/seq/enum.hpp>
+#include <boost/preprocessor/seq/for_each_i.hpp>
 #include <boost/preprocessor/seq/size.hpp>
 #include <boost/swap.hpp>
 #include <boost/throw_exception.hpp>
@@ -41,6 +43,8 @@
 #include <boost/type_traits/is_same.hpp>
 #include <boost/type_traits/remove_const.hpp>
 #include <boost/unordered/detail/fwd.hpp>
+#include <boost/unordered/hash_traits.hpp>
+#include <boost/unordered/node_traits.hpp>
 #include <boost/utility/addressof.hpp>
 #include <boost/utility/enable_if.hpp>
 #include <cmath>
@@ -137,6 +141,50 @@
 #include <tuple>
 #endif
 
+// BOOST_UNORDERED_PREFETCH(p)
+//
+// Hint that the memory at 'p' will be read soon, used to overlap the cache
+// misses for the keys in a batched lookup. Does nothing when the compiler
+// doesn't have a prefetch intrinsic.
+
+#if !defined(BOOST_UNORDERED_PREFETCH)
+#if defined(__GNUC__)
+#define BOOST_UNORDERED_PREFETCH(p) __builtin_prefetch(p)
+#elif defined(BOOST_MSVC) && (defined(_M_IX86) || defined(_M_X64))
+#include <xmmintrin.h>
+#define BOOST_UNORDERED_PREFETCH(p)                                            \
+  _mm_prefetch(reinterpret_cast<char const*>(p), _MM_HINT_T0)
+#else
+#define BOOST_UNORDERED_PREFETCH(p) ((void)0)
+#endif
+#endif
+
+// BOOST_UNORDERED_ENABLE_STATS
+//
+// Define to make the node based containers count the calls to the hash
+// function and equality predicate, and rehashes, and to add 'get_stats' and
+// 'reset_stats' to them. When it isn't defined, nothing is counted.
+
+#if defined(BOOST_UNORDERED_ENABLE_STATS)
+#include <boost/unordered/stats.hpp>
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC)
+#include <atomic>
+#endif
+#define BOOST_UNORDERED_STATS_ADD(counter, n) (this->stats_.counter.add(n))
+#else
+#define BOOST_UNORDERED_STATS_ADD(counter, n) ((void)0)
+#endif
+
+// BOOST_UNORDERED_ENABLE_PARALLEL
+//
+// Define to add 'insert_parallel' to the node based containers, which builds
+// an empty container from a random access range on several threads.
+// Requires C++11 threads.
+
+#if defined(BOOST_UNORDERED_ENABLE_PARALLEL)
+#include <boost/unordered/detail/parallel.hpp>
+#endif
+
 // BOOST_UNORDERED_CXX11_CONSTRUCTION
 //
 // Use C++11 construction, requires variadic arguments, good construct support
@@ -202,6 +250,8 @@ namespace boost {
       template <typename Node> struct c_iterator;
       template <typename Node> struct l_iterator;
       template <typename Node> struct cl_iterator;
+      template <typename Node> struct r_iterator;
+      template <typename Node> struct cr_iterator;
     }
   }
 }
@@ -214,16 +264,83 @@ namespace boost {
       template <typename NodePointer> struct bucket;
       struct ptr_bucket;
 
-      template <typename A, typename T> struct node;
-      template <typename T> struct ptr_node;
+      template <typename A, typename T, bool StoreHash = false,
+        bool DoublyLinked = false>
+      struct node;
+      template <typename T, bool StoreHash = false, bool DoublyLinked = false>
+      struct ptr_node;
 
       static const float minimum_max_load_factor = 1e-3f;
       static const std::size_t default_bucket_count = 11;
 
+      // The number of keys that find_many prefetches at a time.
+      static const std::size_t find_many_batch = 16;
+
+      // During an incremental rehash, the bucket index stored in each node
+      // has this bit set or cleared, to tell whether it's in the old or the
+      // new bucket array. The top bit is used to mark groups.
+      static const std::size_t bucket_generation_bit =
+        ~((std::size_t)-1 >> 1) >> 1;
+
       struct move_tag
       {
       };
 
+#if defined(BOOST_UNORDERED_ENABLE_STATS)
+      // Lookups are counted, so the counters are incremented from const
+      // member functions, which might be called from several threads at
+      // once. The increments are relaxed, as nothing else depends on them.
+      class stats_counter
+      {
+        stats_counter(stats_counter const&);
+        stats_counter& operator=(stats_counter const&);
+
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC)
+        std::atomic<std::size_t> value_;
+
+      public:
+        stats_counter() : value_(0) {}
+
+        void add(std::size_t n)
+        {
+          value_.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        std::size_t get() const
+        {
+          return value_.load(std::memory_order_relaxed);
+        }
+
+        void reset() { value_.store(0, std::memory_order_relaxed); }
+#else
+        std::size_t value_;
+
+      public:
+        stats_counter() : value_(0) {}
+
+        void add(std::size_t n) { value_ += n; }
+        std::size_t get() const { return value_; }
+        void reset() { value_ = 0; }
+#endif
+      };
+
+      struct stats_counters
+      {
+        stats_counter hash_calls;
+        stats_counter key_eq_calls;
+        stats_counter rehashes;
+        stats_counter rehashed_nodes;
+
+        void reset()
+        {
+          hash_calls.reset();
+          key_eq_calls.reset();
+          rehashes.reset();
+          rehashed_nodes.reset();
+        }
+      };
+#endif
+
       struct empty_emplace
       {
       };
@@ -306,10 +423,34 @@ namespace boost {
         BOOST_UNORDERED_PRIMES);
 #endif
 
-#undef BOOST_UNORDERED_PRIMES
-
       typedef prime_list_template<std::size_t> prime_list;
 
+      // no throw
+      //
+      // 'hash % prime_list::value[index]'. Each prime gets its own case with
+      // a constant divisor, so that the compiler can replace the division
+      // with a multiplication.
+      inline std::size_t prime_mod(std::size_t hash, std::size_t index)
+      {
+        BOOST_ASSERT(index < static_cast<std::size_t>(prime_list::length));
+
+        switch (index) {
+#define BOOST_UNORDERED_PRIME_MOD(r, data, i, prime)                           \
+  case i:                                                                      \
+    return hash % prime;
+
+          BOOST_PP_SEQ_FOR_EACH_I(
+            BOOST_UNORDERED_PRIME_MOD, _, BOOST_UNORDERED_PRIMES)
+
+#undef BOOST_UNORDERED_PRIME_MOD
+
+        default:
+          return hash % prime_list::value[index];
+        }
+      }
+
+#undef BOOST_UNORDERED_PRIMES
+
       // no throw
       inline std::size_t next_prime(std::size_t num)
       {
@@ -336,6 +477,20 @@ namespace boost {
         return *bound;
       }
 
+      // no throw
+      //
+      // The index of 'num' in the prime list, 'num' must be in the list.
+      inline std::size_t prime_index(std::size_t num)
+      {
+        std::size_t const* const prime_list_begin = prime_list::value;
+        std::size_t const* const prime_list_end =
+          prime_list_begin + prime_list::length;
+        std::size_t const* bound =
+          std::lower_bound(prime_list_begin, prime_list_end, num);
+        BOOST_ASSERT(bound != prime_list_end && *bound == num);
+        return static_cast<std::size_t>(bound - prime_list_begin);
+      }
+
       //////////////////////////////////////////////////////////////////////////
       // insert_size/initial_size
 
@@ -542,6 +697,59 @@ namespace boost {
         template <typename T> convert_from_anything(T const&);
       };
 
+      // Does a function object have an 'is_transparent' member type, i.e.
+      // can it be called with types other than the key type?
+      template <typename T> struct is_transparent
+      {
+        template <typename X>
+        static choice1::type test(choice1, typename X::is_transparent* = 0);
+
+        template <typename X> static choice2::type test(choice2, void* = 0);
+
+        enum
+        {
+          value = (1 == sizeof(test<T>(choose())))
+        };
+      };
+
+      // Heterogeneous lookup is only used when both the hash function and the
+      // equality predicate are transparent.
+      template <typename Hash, typename Pred> struct are_transparent
+      {
+        enum
+        {
+          value = is_transparent<Hash>::value && is_transparent<Pred>::value
+        };
+      };
+
+      // Return type 'R' for a lookup member template with argument type
+      // 'Key'. 'Key' doesn't affect the condition, it's only there so that
+      // the return type depends on the member template's parameter, which
+      // makes it a substitution failure instead of an error when the
+      // functions aren't transparent.
+      template <typename Key, typename Hash, typename Pred, typename R>
+      struct enable_if_transparent
+          : boost::enable_if_c<are_transparent<Hash, Pred>::value, R>
+      {
+      };
+
+      // For erase, also exclude anything that converts to an iterator, so
+      // that those calls still erase by iterator.
+      template <typename Key, typename Container>
+      struct transparent_non_iterable
+      {
+        enum
+        {
+          value =
+            are_transparent<typename Container::hasher,
+              typename Container::key_equal>::value &&
+            !boost::is_convertible<Key,
+              typename Container::iterator>::value &&
+            !boost::is_convertible<Key,
+              typename Container::const_iterator>::value
+        };
+      };
+
       // Get a pointer from a smart pointer, a bit simpler than pointer_traits
       // as we already know the pointer type that we want.
       template <typename T> struct pointer
@@ -2213,6 +2421,209 @@ namespace boost {
         }
       };
 
+      // Iterators over a range of buckets, used to split a container for
+      // parallel traversal. During an incremental rehash, a range can also
+      // include some of the old buckets, which are visited after the new
+      // ones.
+
+      template <typename Node>
+      struct r_iterator
+        : public std::iterator<std::forward_iterator_tag,
+            typename Node::value_type, std::ptrdiff_t,
+            typename Node::value_type*, typename Node::value_type&>
+      {
+#if !defined(BOOST_NO_MEMBER_TEMPLATE_FRIENDS)
+        template <typename Node2>
+        friend struct boost::unordered::iterator_detail::cr_iterator;
+
+      private:
+#endif
+        typedef typename Node::node_pointer node_pointer;
+        typedef typename Node::bucket_pointer bucket_pointer;
+        node_pointer ptr_;
+        bucket_pointer bucket_;
+        bucket_pointer end_;
+        std::size_t bucket_index_;
+        bucket_pointer old_bucket_;
+        bucket_pointer old_end_;
+        std::size_t old_bucket_index_;
+
+        // Find the first node in the current bucket or the ones after it.
+        void find_node()
+        {
+          for (;;) {
+            for (; bucket_ != end_; ++bucket_, ++bucket_index_) {
+              if (bucket_->next_) {
+                ptr_ = static_cast<node_pointer>(bucket_->next_->next_);
+                return;
+              }
+            }
+            if (old_bucket_ == old_end_) {
+              ptr_ = node_pointer();
+              return;
+            }
+            bucket_ = old_bucket_;
+            end_ = old_end_;
+            bucket_index_ = old_bucket_index_;
+            old_bucket_ = old_end_;
+          }
+        }
+
+      public:
+        typedef typename Node::value_type value_type;
+
+        r_iterator() BOOST_NOEXCEPT : ptr_() {}
+
+        r_iterator(bucket_pointer first, bucket_pointer last, std::size_t b,
+          bucket_pointer old_first, bucket_pointer old_last,
+          std::size_t old_b) BOOST_NOEXCEPT : ptr_(),
+                                              bucket_(first),
+                                              end_(last),
+                                              bucket_index_(b),
+                                              old_bucket_(old_first),
+                                              old_end_(old_last),
+                                              old_bucket_index_(old_b)
+        {
+          find_node();
+        }
+
+        value_type& operator*() const { return ptr_->value(); }
+
+        value_type* operator->() const { return ptr_->value_ptr(); }
+
+        r_iterator& operator++()
+        {
+          ptr_ = static_cast<node_pointer>(ptr_->next_);
+          if (!ptr_ || ptr_->get_bucket() != bucket_index_) {
+            ++bucket_;
+            ++bucket_index_;
+            find_node();
+          }
+          return *this;
+        }
+
+        r_iterator operator++(int)
+        {
+          r_iterator tmp(*this);
+          ++(*this);
+          return tmp;
+        }
+
+        bool operator==(r_iterator const& x) const BOOST_NOEXCEPT
+        {
+          return ptr_ == x.ptr_;
+        }
+
+        bool operator!=(r_iterator const& x) const BOOST_NOEXCEPT
+        {
+          return ptr_ != x.ptr_;
+        }
+      };
+
+      template <typename Node>
+      struct cr_iterator
+        : public std::iterator<std::forward_iterator_tag,
+            typename Node::value_type, std::ptrdiff_t,
+            typename Node::value_type const*, typename Node::value_type const&>
+      {
+        friend struct boost::unordered::iterator_detail::r_iterator<Node>;
+
+      private:
+        typedef typename Node::node_pointer node_pointer;
+        typedef typename Node::bucket_pointer bucket_pointer;
+        node_pointer ptr_;
+        bucket_pointer bucket_;
+        bucket_pointer end_;
+        std::size_t bucket_index_;
+        bucket_pointer old_bucket_;
+        bucket_pointer old_end_;
+        std::size_t old_bucket_index_;
+
+        void find_node()
+        {
+          for (;;) {
+            for (; bucket_ != end_; ++bucket_, ++bucket_index_) {
+              if (bucket_->next_) {
+                ptr_ = static_cast<node_pointer>(bucket_->next_->next_);
+                return;
+              }
+            }
+            if (old_bucket_ == old_end_) {
+              ptr_ = node_pointer();
+              return;
+            }
+            bucket_ = old_bucket_;
+            end_ = old_end_;
+            bucket_index_ = old_bucket_index_;
+            old_bucket_ = old_end_;
+          }
+        }
+
+      public:
+        typedef typename Node::value_type value_type;
+
+        cr_iterator() BOOST_NOEXCEPT : ptr_() {}
+
+        cr_iterator(bucket_pointer first, bucket_pointer last, std::size_t b,
+          bucket_pointer old_first, bucket_pointer old_last,
+          std::size_t old_b) BOOST_NOEXCEPT : ptr_(),
+                                              bucket_(first),
+                                              end_(last),
+                                              bucket_index_(b),
+                                              old_bucket_(old_first),
+                                              old_end_(old_last),
+                                              old_bucket_index_(old_b)
+        {
+          find_node();
+        }
+
+        cr_iterator(
+          boost::unordered::iterator_detail::r_iterator<Node> const& x)
+          BOOST_NOEXCEPT : ptr_(x.ptr_),
+                           bucket_(x.bucket_),
+                           end_(x.end_),
+                           bucket_index_(x.bucket_index_),
+                           old_bucket_(x.old_bucket_),
+                           old_end_(x.old_end_),
+                           old_bucket_index_(x.old_bucket_index_)
+        {
+        }
+
+        value_type const& operator*() const { return ptr_->value(); }
+
+        value_type const* operator->() const { return ptr_->value_ptr(); }
+
+        cr_iterator& operator++()
+        {
+          ptr_ = static_cast<node_pointer>(ptr_->next_);
+          if (!ptr_ || ptr_->get_bucket() != bucket_index_) {
+            ++bucket_;
+            ++bucket_index_;
+            find_node();
+          }
+          return *this;
+        }
+
+        cr_iterator operator++(int)
+        {
+          cr_iterator tmp(*this);
+          ++(*this);
+          return tmp;
+        }
+
+        friend bool operator==(
+          cr_iterator const& x, cr_iterator const& y) BOOST_NOEXCEPT
+        {
+          return x.ptr_ == y.ptr_;
+        }
+
+        friend bool operator!=(
+          cr_iterator const& x, cr_iterator const& y) BOOST_NOEXCEPT
+        {
+          return x.ptr_ != y.ptr_;
+        }
+      };
+
       template <typename Node>
       struct iterator
         : public std::iterator<std::forward_iterator_tag,
@@ -2457,6 +2868,17 @@ namespace boost {
       //
       // Hash Policy
 
+      // Each policy provides:
+      //
+      //   apply_hash(hf, x)           - the hash value for a key.
+      //   mix_hash(hash_value)        - the hash value for the output of
+      //                                 the hash function.
+      //   new_bucket_count(min)       - the smallest bucket count >= min.
+      //   prev_bucket_count(max)      - the largest bucket count <= max.
+      //   size_index(bucket_count)    - precomputed by the table whenever
+      //                                 its bucket count changes.
+      //   position(size_index, hash)  - the bucket for a hash value.
+
       template <typename SizeT> struct prime_policy
       {
         template <typename Hash, typename T>
@@ -2465,9 +2887,18 @@ namespace boost {
           return hf(x);
         }
 
-        static inline SizeT to_bucket(SizeT bucket_count, SizeT hash)
+        static inline SizeT mix_hash(SizeT hash_value) { return hash_value; }
+
+        // The table stores the index of its bucket count in the prime
+        // list, and uses it to find buckets without a runtime division.
+        static inline std::size_t size_index(SizeT bucket_count)
+        {
+          return boost::unordered::detail::prime_index(bucket_count);
+        }
+
+        static inline SizeT position(std::size_t size_index, SizeT hash)
         {
-          return hash % bucket_count;
+          return boost::unordered::detail::prime_mod(hash, size_index);
         }
 
         static inline SizeT new_bucket_count(SizeT min)
@@ -2481,25 +2912,26 @@ namespace boost {
         }
       };
 
-      template <typename SizeT> struct mix64_policy
+      // Power of 2 bucket counts, using the low bits of the hash value.
+      template <typename SizeT> struct pow2_policy
       {
         template <typename Hash, typename T>
         static inline SizeT apply_hash(Hash const& hf, T const& x)
         {
-          SizeT key = hf(x);
-          key = (~key) + (key << 21); // key = (key << 21) - key - 1;
-          key = key ^ (key >> 24);
-          key = (key + (key << 3)) + (key << 8); // key * 265
-          key = key ^ (key >> 14);
-          key = (key + (key << 2)) + (key << 4); // key * 21
-          key = key ^ (key >> 28);
-          key = key + (key << 31);
-          return key;
+          return hf(x);
+        }
+
+        static inline SizeT mix_hash(SizeT hash_value) { return hash_value; }
+
+        // The size index is the mask for the bucket count.
+        static inline std::size_t size_index(SizeT bucket_count)
+        {
+          return bucket_count - 1;
         }
 
-        static inline SizeT to_bucket(SizeT bucket_count, SizeT hash)
+        static inline SizeT position(std::size_t size_index, SizeT hash)
         {
-          return hash & (bucket_count - 1);
+          return hash & size_index;
         }
 
         static inline SizeT new_bucket_count(SizeT min)
@@ -2507,56 +2939,156 @@ namespace boost {
           if (min <= 4)
             return 4;
           --min;
-          min |= min >> 1;
-          min |= min >> 2;
-          min |= min >> 4;
-          min |= min >> 8;
-          min |= min >> 16;
-          min |= min >> 32;
+          for (int shift = 1; shift < std::numeric_limits<SizeT>::digits;
+               shift *= 2) {
+            min |= min >> shift;
+          }
           return min + 1;
         }
 
         static inline SizeT prev_bucket_count(SizeT max)
         {
-          max |= max >> 1;
-          max |= max >> 2;
-          max |= max >> 4;
-          max |= max >> 8;
-          max |= max >> 16;
-          max |= max >> 32;
+          for (int shift = 1; shift < std::numeric_limits<SizeT>::digits;
+               shift *= 2) {
+            max |= max >> shift;
+          }
           return (max >> 1) + 1;
         }
       };
 
-      template <int digits, int radix> struct pick_policy_impl
+      // Mixes the hash value before using its low bits, for 64 bit
+      // std::size_t.
+      template <typename SizeT> struct mix64_policy : pow2_policy<SizeT>
       {
-        typedef prime_policy<std::size_t> type;
-      };
+        template <typename Hash, typename T>
+        static inline SizeT apply_hash(Hash const& hf, T const& x)
+        {
+          return mix_hash(hf(x));
+        }
 
-      template <> struct pick_policy_impl<64, 2>
-      {
-        typedef mix64_policy<std::size_t> type;
+        static inline SizeT mix_hash(SizeT key)
+        {
+          key = (~key) + (key << 21); // key = (key << 21) - key - 1;
+          key = key ^ (key >> 24);
+          key = (key + (key << 3)) + (key << 8); // key * 265
+          key = key ^ (key >> 14);
+          key = (key + (key << 2)) + (key << 4); // key * 21
+          key = key ^ (key >> 28);
+          key = key + (key << 31);
+          return key;
+        }
       };
 
-      template <typename T>
-      struct pick_policy2
-        : pick_policy_impl<std::numeric_limits<std::size_t>::digits,
-            std::numeric_limits<std::size_t>::radix>
+      // 2^digits divided by the golden ratio, rounded to an odd number.
+      template <int digits> struct fibonacci_multiplier;
+
+      template <> struct fibonacci_multiplier<32>
       {
+        static boost::uint32_t value() { return 2654435769u; }
       };
 
-      // While the mix policy is generally faster, the prime policy is a lot
-      // faster when a large number consecutive integers are used, because
-      // there are no collisions. Since that is probably quite common, use
-      // prime policy for integeral types. But not the smaller ones, as they
-      // don't have enough unique values for this to be an issue.
-
-      template <> struct pick_policy2<int>
+      template <> struct fibonacci_multiplier<64>
       {
-        typedef prime_policy<std::size_t> type;
+        static boost::uint64_t value()
+        {
+          return (static_cast<boost::uint64_t>(2654435769u) << 32) +
+                 2135587861u;
+        }
       };
 
-      template <> struct pick_policy2<unsigned int>
+      // Power of 2 bucket counts, using the high bits of the hash value
+      // multiplied by the Fibonacci constant. A single multiplication, which
+      // spreads out hash values that only differ in their low bits.
+      template <typename SizeT> struct fibonacci_policy : pow2_policy<SizeT>
+      {
+        // The size index is the shift which leaves log2(bucket_count) bits.
+        static inline std::size_t size_index(SizeT bucket_count)
+        {
+          std::size_t shift = std::numeric_limits<SizeT>::digits;
+          while (bucket_count > 1) {
+            bucket_count >>= 1;
+            --shift;
+          }
+          return shift;
+        }
+
+        static inline SizeT position(std::size_t size_index, SizeT hash)
+        {
+          return static_cast<SizeT>(
+            (hash * fibonacci_multiplier<
+                      std::numeric_limits<SizeT>::digits>::value()) >>
+            size_index);
+        }
+      };
+
+      // Mixes the bits of a hash value, used by the hash guard. These are
+      // the finalizers from MurmurHash3.
+      template <int digits> struct hash_mixer
+      {
+        static std::size_t apply(std::size_t x) { return x; }
+      };
+
+      template <> struct hash_mixer<32>
+      {
+        static boost::uint32_t apply(boost::uint32_t x)
+        {
+          x ^= x >> 16;
+          x *= 0x85ebca6bu;
+          x ^= x >> 13;
+          x *= 0xc2b2ae35u;
+          x ^= x >> 16;
+          return x;
+        }
+      };
+
+      template <> struct hash_mixer<64>
+      {
+        static boost::uint64_t apply(boost::uint64_t x)
+        {
+          x ^= x >> 33;
+          x *= (static_cast<boost::uint64_t>(0xff51afd7u) << 32) + 0xed558ccdu;
+          x ^= x >> 33;
+          x *= (static_cast<boost::uint64_t>(0xc4ceb9feu) << 32) + 0x1a85ec53u;
+          x ^= x >> 33;
+          return x;
+        }
+      };
+
+      inline std::size_t mix_hash_value(std::size_t hash)
+      {
+        return static_cast<std::size_t>(
+          hash_mixer<std::numeric_limits<std::size_t>::digits>::apply(hash));
+      }
+
+      template <int digits, int radix> struct pick_policy_impl
+      {
+        typedef prime_policy<std::size_t> type;
+      };
+
+      template <> struct pick_policy_impl<64, 2>
+      {
+        typedef mix64_policy<std::size_t> type;
+      };
+
+      template <typename T>
+      struct pick_policy2
+        : pick_policy_impl<std::numeric_limits<std::size_t>::digits,
+            std::numeric_limits<std::size_t>::radix>
+      {
+      };
+
+      // While the mix policy is generally faster, the prime policy is a lot
+      // faster when a large number consecutive integers are used, because
+      // there are no collisions. Since that is probably quite common, use
+      // prime policy for integeral types. But not the smaller ones, as they
+      // don't have enough unique values for this to be an issue.
+
+      template <> struct pick_policy2<int>
+      {
+        typedef prime_policy<std::size_t> type;
+      };
+
+      template <> struct pick_policy2<unsigned int>
       {
         typedef prime_policy<std::size_t> type;
       };
@@ -2584,8 +3116,37 @@ namespace boost {
       };
 #endif
 
+      // Maps the 'boost::unordered::bucket_policy' selected for the hash
+      // function to the policy implementation.
+      template <typename T, typename Selected> struct pick_policy3;
+
+      template <typename T>
+      struct pick_policy3<T, boost::unordered::default_bucket_policy>
+        : pick_policy2<typename boost::remove_cv<T>::type>
+      {
+      };
+
+      template <typename T>
+      struct pick_policy3<T, boost::unordered::prime_bucket_policy>
+      {
+        typedef prime_policy<std::size_t> type;
+      };
+
+      template <typename T>
+      struct pick_policy3<T, boost::unordered::pow2_bucket_policy>
+      {
+        typedef pow2_policy<std::size_t> type;
+      };
+
       template <typename T>
-      struct pick_policy : pick_policy2<typename boost::remove_cv<T>::type>
+      struct pick_policy3<T, boost::unordered::fibonacci_bucket_policy>
+      {
+        typedef fibonacci_policy<std::size_t> type;
+      };
+
+      template <typename T, typename H>
+      struct pick_policy
+        : pick_policy3<T, typename boost::unordered::bucket_policy<H>::type>
       {
       };
 
@@ -2827,9 +3388,227 @@ namespace boost {
         value_base& operator=(value_base const&);
       };
 
+      // The key held by an entry. When the entry was created from an lvalue,
+      // this just points to it, so a lookup which finds the key doesn't
+      // copy it, and it's only copied when it's inserted. An rvalue won't
+      // outlive the call, so it's moved into the entry's own storage. Without
+      // rvalue references a temporary can't be told apart from an lvalue, so
+      // the key is always copied.
+
+      template <typename Key> class entry_key
+      {
+        Key const* key_;
+        value_base<Key> owned_;
+        bool is_owned_;
+
+        entry_key& operator=(entry_key const&);
+
+      public:
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+        explicit entry_key(Key const& k) : key_(&k), is_owned_(false) {}
+#else
+        explicit entry_key(Key const& k) : is_owned_(true)
+        {
+          new (owned_.address()) Key(k);
+          key_ = owned_.value_ptr();
+        }
+#endif
+
+        explicit entry_key(BOOST_RV_REF(Key) k) : is_owned_(true)
+        {
+          new (owned_.address()) Key(boost::move(k));
+          key_ = owned_.value_ptr();
+        }
+
+        entry_key(entry_key const& x) : key_(x.key_), is_owned_(x.is_owned_)
+        {
+          if (is_owned_) {
+            new (owned_.address()) Key(x.owned_.value());
+            key_ = owned_.value_ptr();
+          }
+        }
+
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+        entry_key(entry_key&& x) : key_(x.key_), is_owned_(x.is_owned_)
+        {
+          if (is_owned_) {
+            new (owned_.address()) Key(boost::move(x.owned_.value()));
+            key_ = owned_.value_ptr();
+          }
+        }
+#endif
+
+        ~entry_key()
+        {
+          if (is_owned_) {
+            boost::unordered::detail::func::destroy(owned_.value_ptr());
+          }
+        }
+
+        Key const& value() const { return *key_; }
+
+        // Only an owned key can be moved into the node.
+        bool owned() const { return is_owned_; }
+        Key& owned_value() { return owned_.value(); }
+      };
+
+      //////////////////////////////////////////////////////////////////////////
+      // Optional table state
+      //
+      // The members for incremental rehashing and the hash guard are only
+      // stored when the hash function's traits turn them on. Otherwise the
+      // table derives from an empty specialization, whose accessors return
+      // constants, so the code which uses them is compiled away.
+
+      template <typename Types, bool Incremental>
+      struct incremental_rehash_state
+      {
+        typedef typename boost::unordered::detail::rebind_wrap<
+          typename Types::value_allocator, typename Types::bucket>::type
+          bucket_allocator;
+        typedef typename boost::unordered::detail::allocator_traits<
+          bucket_allocator>::pointer bucket_pointer;
+
+        // 'old_buckets_' is the bucket array that the nodes are being moved
+        // from, the buckets before 'rehash_position_' have been moved.
+        // 'bucket_generation_' is the generation bit for the nodes in the
+        // table's current bucket array.
+        bucket_pointer old_buckets_;
+        std::size_t old_bucket_count_;
+        std::size_t old_size_index_;
+        std::size_t rehash_position_;
+        std::size_t bucket_generation_;
+
+        incremental_rehash_state()
+            : old_buckets_(), old_bucket_count_(0), old_size_index_(0),
+              rehash_position_(0), bucket_generation_(0)
+        {
+        }
+
+        bucket_pointer old_buckets() const { return old_buckets_; }
+        std::size_t old_bucket_count() const { return old_bucket_count_; }
+        std::size_t old_size_index() const { return old_size_index_; }
+        std::size_t rehash_position() const { return rehash_position_; }
+        std::size_t bucket_generation() const { return bucket_generation_; }
+
+        // Start moving the nodes out of 'buckets', which the table has just
+        // replaced.
+        void start_rehash(
+          bucket_pointer buckets, std::size_t count, std::size_t size_index)
+        {
+          old_buckets_ = buckets;
+          old_bucket_count_ = count;
+          old_size_index_ = size_index;
+          rehash_position_ = 0;
+          bucket_generation_ ^= bucket_generation_bit;
+        }
+
+        // Returns true once every old bucket has been moved.
+        bool next_rehash_position()
+        {
+          return ++rehash_position_ == old_bucket_count_;
+        }
+
+        void clear_old_buckets() { old_buckets_ = bucket_pointer(); }
+
+        // Only used for a table that isn't rehashing, so that the nodes can
+        // be copied with their bucket indexes.
+        void copy_rehash_state(incremental_rehash_state const& x)
+        {
+          BOOST_ASSERT(!x.old_buckets_);
+          bucket_generation_ = x.bucket_generation_;
+        }
+
+        // Takes the other table's old buckets.
+        void move_rehash_state(incremental_rehash_state& x)
+        {
+          old_buckets_ = x.old_buckets_;
+          old_bucket_count_ = x.old_bucket_count_;
+          old_size_index_ = x.old_size_index_;
+          rehash_position_ = x.rehash_position_;
+          bucket_generation_ = x.bucket_generation_;
+          x.old_buckets_ = bucket_pointer();
+        }
+
+        void swap_rehash_state(incremental_rehash_state& x)
+        {
+          boost::swap(old_buckets_, x.old_buckets_);
+          boost::swap(old_bucket_count_, x.old_bucket_count_);
+          boost::swap(old_size_index_, x.old_size_index_);
+          boost::swap(rehash_position_, x.rehash_position_);
+          boost::swap(bucket_generation_, x.bucket_generation_);
+        }
+      };
+
+      template <typename Types>
+      struct incremental_rehash_state<Types, false>
+      {
+        typedef typename boost::unordered::detail::rebind_wrap<
+          typename Types::value_allocator, typename Types::bucket>::type
+          bucket_allocator;
+        typedef typename boost::unordered::detail::allocator_traits<
+          bucket_allocator>::pointer bucket_pointer;
+
+        bucket_pointer old_buckets() const { return bucket_pointer(); }
+        std::size_t old_bucket_count() const { return 0; }
+        std::size_t old_size_index() const { return 0; }
+        std::size_t rehash_position() const { return 0; }
+        std::size_t bucket_generation() const { return 0; }
+
+        void start_rehash(bucket_pointer, std::size_t, std::size_t)
+        {
+          BOOST_ASSERT(false);
+        }
+
+        bool next_rehash_position() { return true; }
+        void clear_old_buckets() {}
+        void copy_rehash_state(incremental_rehash_state const&) {}
+        void move_rehash_state(incremental_rehash_state&) {}
+        void swap_rehash_state(incremental_rehash_state&) {}
+      };
+
+      // The hash guard states.
+      enum
+      {
+        guard_checking,
+        guard_pending,
+        guard_mixed
+      };
+
+      template <bool Guarded> struct hash_guard_state
+      {
+        // Becomes 'guard_pending' when a bucket is found with too many
+        // elements, and then 'guard_mixed' when the table has been rehashed
+        // with mixed hash values, which is only done once.
+        int hash_guard_;
+
+        hash_guard_state() : hash_guard_(guard_checking) {}
+
+        int hash_guard() const { return hash_guard_; }
+        void set_hash_guard(int state) { hash_guard_ = state; }
+
+        void swap_hash_guard(hash_guard_state& x)
+        {
+          boost::swap(hash_guard_, x.hash_guard_);
+        }
+      };
+
+      template <> struct hash_guard_state<false>
+      {
+        int hash_guard() const { return guard_checking; }
+        void set_hash_guard(int) {}
+        void swap_hash_guard(hash_guard_state&) {}
+      };
+
       template <typename Types>
       struct table : boost::unordered::detail::functions<typename Types::hasher,
-                       typename Types::key_equal>
+                       typename Types::key_equal>,
+                     boost::unordered::detail::incremental_rehash_state<Types,
+                       boost::unordered::incremental_rehash<
+                         typename Types::hasher>::value>,
+                     boost::unordered::detail::hash_guard_state<
+                       boost::unordered::hash_guard<
+                         typename Types::hasher>::value>
       {
       private:
         table(table const&);
@@ -2850,6 +3629,8 @@ namespace boost {
         typedef typename Types::c_iterator c_iterator;
         typedef typename Types::l_iterator l_iterator;
         typedef typename Types::cl_iterator cl_iterator;
+        typedef typename Types::r_iterator r_iterator;
+        typedef typename Types::cr_iterator cr_iterator;
 
         typedef boost::unordered::detail::functions<typename Types::hasher,
           typename Types::key_equal>
@@ -2875,17 +3656,44 @@ namespace boost {
 
         typedef std::pair<iterator, bool> emplace_return;
 
+        enum
+        {
+          incremental = boost::unordered::incremental_rehash<hasher>::value
+        };
+
+        enum
+        {
+          guarded = boost::unordered::hash_guard<hasher>::value
+        };
+
+        // The hash guard states.
+        typedef boost::unordered::detail::incremental_rehash_state<Types,
+          incremental>
+          rehash_state;
+        typedef boost::unordered::detail::hash_guard_state<guarded> guard_state;
+
         ////////////////////////////////////////////////////////////////////////
         // Members
 
         boost::unordered::detail::compressed<bucket_allocator, node_allocator>
           allocators_;
         std::size_t bucket_count_;
+        // 'policy::size_index(bucket_count_)', for 'policy::position'.
+        std::size_t size_index_;
         std::size_t size_;
         float mlf_;
         std::size_t max_load_;
         bucket_pointer buckets_;
 
+        // The incremental rehash and hash guard members are in the
+        // 'rehash_state' and 'guard_state' bases.
+
+#if defined(BOOST_UNORDERED_ENABLE_STATS)
+        // Mutable, as lookups are counted. Each table has its own counters,
+        // they're not copied or swapped along with the elements.
+        mutable boost::unordered::detail::stats_counters stats_;
+#endif
+
         ////////////////////////////////////////////////////////////////////////
         // Data access
 
@@ -2948,19 +3756,43 @@ namespace boost {
         std::size_t max_bucket_count() const
         {
           // -1 to account for the start bucket.
-          return policy::prev_bucket_count(
-            bucket_allocator_traits::max_size(bucket_alloc()) - 1);
+          std::size_t max_buckets =
+            bucket_allocator_traits::max_size(bucket_alloc()) - 1;
+          // The bucket indexes can't include the generation bit.
+          if (incremental && max_buckets >= bucket_generation_bit) {
+            max_buckets = bucket_generation_bit - 1;
+          }
+          return policy::prev_bucket_count(max_buckets);
         }
 
         bucket_pointer get_bucket(std::size_t bucket_index) const
         {
+          if (incremental) {
+            std::size_t position = bucket_position(bucket_index);
+            if ((bucket_index ^ this->bucket_generation()) &
+                bucket_generation_bit) {
+              BOOST_ASSERT(this->old_buckets() &&
+                           position < this->old_bucket_count());
+              return this->old_buckets() +
+                     static_cast<std::ptrdiff_t>(position);
+            }
+            bucket_index = position;
+          }
           BOOST_ASSERT(buckets_);
           return buckets_ + static_cast<std::ptrdiff_t>(bucket_index);
         }
 
+        // The extra bucket at the end of the array, which holds the start of
+        // the list.
+        bucket_pointer get_start_bucket() const
+        {
+          BOOST_ASSERT(buckets_);
+          return buckets_ + static_cast<std::ptrdiff_t>(bucket_count_);
+        }
+
         link_pointer get_previous_start() const
         {
-          return get_bucket(bucket_count_)->first_from_start();
+          return get_start_bucket()->first_from_start();
         }
 
         link_pointer get_previous_start(std::size_t bucket_index) const
@@ -2983,11 +3815,130 @@ namespace boost {
 
         std::size_t hash_to_bucket(std::size_t hash_value) const
         {
-          return policy::to_bucket(bucket_count_, hash_value);
+          return this->hash_to_bucket(
+            hash_value, size_index_, this->hash_guard() == guard_mixed);
+        }
+
+        // The bucket for a different bucket count or hash guard state,
+        // used while rehashing.
+        std::size_t hash_to_bucket(
+          std::size_t hash_value, std::size_t size_index, bool mixed) const
+        {
+          if (guarded && mixed) {
+            hash_value = boost::unordered::detail::mix_hash_value(hash_value);
+          }
+          return incremental ? policy::position(size_index, hash_value) |
+                                 this->bucket_generation()
+                             : policy::position(size_index, hash_value);
+        }
+
+        // The position of a bucket in its bucket array, without the
+        // generation bit.
+        static std::size_t bucket_position(std::size_t bucket_index)
+        {
+          return incremental ? bucket_index & ~bucket_generation_bit
+                             : bucket_index;
+        }
+
+        // The bucket interface numbers the buckets in the current array
+        // first, followed by the old buckets which haven't been moved yet,
+        // so that it includes every element during an incremental rehash.
+        std::size_t local_bucket_count() const
+        {
+          return this->old_buckets() ? bucket_count_ +
+                                         this->old_bucket_count() -
+                                         this->rehash_position()
+                                     : bucket_count_;
+        }
+
+        // The bucket index for a position in the bucket interface.
+        std::size_t local_bucket_index(std::size_t position) const
+        {
+          if (incremental && position >= bucket_count_) {
+            BOOST_ASSERT(position < local_bucket_count());
+            return (position - bucket_count_ + this->rehash_position()) |
+                   (this->bucket_generation() ^ bucket_generation_bit);
+          }
+          return position | this->bucket_generation();
+        }
+
+        // The position in the bucket interface for a bucket index.
+        std::size_t local_position(std::size_t bucket_index) const
+        {
+          std::size_t position = bucket_position(bucket_index);
+          if (incremental && ((bucket_index ^ this->bucket_generation()) &
+                               bucket_generation_bit)) {
+            position = position - this->rehash_position() + bucket_count_;
+          }
+          return position;
+        }
+
+        // The position of the bucket which contains 'k'. While rehashing,
+        // a key might be in either bucket array, so it has to be looked up.
+        std::size_t local_bucket(const_key_type& k) const
+        {
+          std::size_t key_hash = this->hash(k);
+          std::size_t bucket_index = this->hash_to_bucket(key_hash);
+          if (incremental && this->old_buckets()) {
+            node_pointer n = this->find_node_impl(key_hash, k, this->key_eq());
+            if (n) {
+              bucket_index = this->node_bucket(n);
+            }
+          }
+          return local_position(bucket_index);
+        }
+
+        l_iterator local_begin(std::size_t position) const
+        {
+          std::size_t bucket_index = local_bucket_index(position);
+          return l_iterator(begin(bucket_index), bucket_index, bucket_count_);
+        }
+
+        // Splits the buckets into 'count' ranges of about the same size, and
+        // returns an iterator to the start of range 'index'. The ranges
+        // are disjoint, and between them visit every element.
+        r_iterator range_begin(std::size_t index, std::size_t count) const
+        {
+          BOOST_ASSERT(index < count);
+          if (!size_)
+            return r_iterator();
+
+          std::size_t first = range_bound(bucket_count_, index, count);
+          std::size_t last = range_bound(bucket_count_, index + 1, count);
+          bucket_pointer old_first = bucket_pointer();
+          bucket_pointer old_last = bucket_pointer();
+          std::size_t old_index = 0;
+
+          // The old buckets that haven't been moved yet.
+          if (incremental && this->old_buckets()) {
+            std::size_t remaining =
+              this->old_bucket_count() - this->rehash_position();
+            old_index =
+              this->rehash_position() + range_bound(remaining, index, count);
+            old_first =
+              this->old_buckets() + static_cast<std::ptrdiff_t>(old_index);
+            old_last = this->old_buckets() +
+                       static_cast<std::ptrdiff_t>(this->rehash_position() +
+                                                   range_bound(remaining,
+                                                     index + 1, count));
+            old_index |= this->bucket_generation() ^ bucket_generation_bit;
+          }
+
+          return r_iterator(buckets_ + static_cast<std::ptrdiff_t>(first),
+            buckets_ + static_cast<std::ptrdiff_t>(last),
+            first | this->bucket_generation(), old_first, old_last, old_index);
+        }
+
+        // 'n * index / count' without overflowing.
+        static std::size_t range_bound(
+          std::size_t n, std::size_t index, std::size_t count)
+        {
+          return n / count * index + n % count * index / count;
         }
 
-        std::size_t bucket_size(std::size_t index) const
+        std::size_t bucket_size(std::size_t position) const
         {
+          std::size_t index = local_bucket_index(position);
           node_pointer n = begin(index);
           if (!n)
             return 0;
@@ -3004,6 +3955,12 @@ namespace boost {
         ////////////////////////////////////////////////////////////////////////
         // Load methods
 
+        void set_bucket_count(std::size_t count)
+        {
+          bucket_count_ = count;
+          size_index_ = policy::size_index(count);
+        }
+
         void recalculate_max_load()
         {
           using namespace std;
@@ -3044,29 +4001,45 @@ namespace boost {
               1));
         }
 
+        // The bucket count to use for a copy. Keep the existing bucket count
+        // when it isn't much larger than required, so that the nodes can be
+        // copied into the same buckets without calling the hash function.
+        std::size_t copy_bucket_count() const
+        {
+          std::size_t min = min_buckets_for_size(size_);
+          return bucket_count_ >= min &&
+                     bucket_count_ <= min_buckets_for_size(size_ + (size_ >> 1))
+                   ? bucket_count_
+                   : min;
+        }
+
         ////////////////////////////////////////////////////////////////////////
         // Constructors
 
         table(std::size_t num_buckets, hasher const& hf, key_equal const& eq,
           node_allocator const& a)
             : functions(hf, eq), allocators_(a, a),
-              bucket_count_(policy::new_bucket_count(num_buckets)), size_(0),
+              bucket_count_(policy::new_bucket_count(num_buckets)),
+              size_index_(policy::size_index(bucket_count_)), size_(0),
               mlf_(1.0f), max_load_(0), buckets_()
         {
         }
 
         table(table const& x, node_allocator const& a)
-            : functions(x), allocators_(a, a),
-              bucket_count_(x.min_buckets_for_size(x.size_)), size_(0),
+            : functions(x), guard_state(x), allocators_(a, a),
+              bucket_count_(x.copy_bucket_count()),
+              size_index_(policy::size_index(bucket_count_)), size_(0),
               mlf_(x.mlf_), max_load_(0), buckets_()
         {
         }
 
         table(table& x, boost::unordered::detail::move_tag m)
-            : functions(x, m), allocators_(x.allocators_, m),
-              bucket_count_(x.bucket_count_), size_(x.size_), mlf_(x.mlf_),
+            : functions(x, m), guard_state(x),
+              allocators_(x.allocators_, m), bucket_count_(x.bucket_count_),
+              size_index_(x.size_index_), size_(x.size_), mlf_(x.mlf_),
               max_load_(x.max_load_), buckets_(x.buckets_)
         {
+          this->move_rehash_state(x);
           x.buckets_ = bucket_pointer();
           x.size_ = 0;
           x.max_load_ = 0;
@@ -3074,9 +4047,9 @@ namespace boost {
 
         table(table& x, node_allocator const& a,
           boost::unordered::detail::move_tag m)
-            : functions(x, m), allocators_(a, a),
-              bucket_count_(x.bucket_count_), size_(0), mlf_(x.mlf_),
-              max_load_(0), buckets_()
+            : functions(x, m), guard_state(x), allocators_(a, a),
+              bucket_count_(x.bucket_count_), size_index_(x.size_index_),
+              size_(0), mlf_(x.mlf_), max_load_(0), buckets_()
         {
         }
 
@@ -3094,10 +4067,11 @@ namespace boost {
         // Clear the bucket pointers.
         void clear_buckets()
         {
-          bucket_pointer end = get_bucket(bucket_count_);
+          bucket_pointer end = get_start_bucket();
           for (bucket_pointer it = buckets_; it != end; ++it) {
             it->next_ = node_pointer();
           }
+          destroy_old_buckets();
         }
 
         // Create container buckets. If the container already contains any
@@ -3132,17 +4106,83 @@ namespace boost {
           }
 
           // nothrow from here...
-          bucket_count_ = new_count;
+          set_bucket_count(new_count);
           recalculate_max_load();
 
-          bucket_pointer end =
-            buckets_ + static_cast<std::ptrdiff_t>(new_count);
-          for (bucket_pointer i = buckets_; i != end; ++i) {
+          construct_buckets(buckets_, new_count, dummy_node);
+        }
+
+        static void construct_buckets(
+          bucket_pointer buckets, std::size_t count, link_pointer dummy_node)
+        {
+          bucket_pointer end = buckets + static_cast<std::ptrdiff_t>(count);
+          for (bucket_pointer i = buckets; i != end; ++i) {
             new (pointer<void>::get(i)) bucket();
           }
           new (pointer<void>::get(end)) bucket(dummy_node);
         }
 
+        ////////////////////////////////////////////////////////////////////////
+        // Clone
+        //
+        // When the source has the same number of buckets, the nodes can be
+        // copied in order, keeping their bucket information, so the hash
+        // function isn't called and the bucket pointers are set up in one
+        // pass.
+
+        // The nodes can't be cloned while the source is rehashing
+        // incrementally, as some of them are in the old buckets.
+        bool can_clone(table const& src) const
+        {
+          return bucket_count_ == src.bucket_count_ && !src.old_buckets();
+        }
+
+        void clone_buckets(table const& src)
+        {
+          BOOST_ASSERT(can_clone(src) && !size_);
+          this->create_buckets(this->bucket_count_);
+          this->copy_rehash_state(src);
+          this->set_hash_guard(src.hash_guard());
+
+          link_pointer prev = this->get_previous_start();
+          for (node_pointer n = src.begin(); n; n = next_node(n)) {
+            prev = this->add_clone(prev, n,
+              boost::unordered::detail::func::construct_node(
+                this->node_alloc(), n->value()));
+          }
+        }
+
+        void clone_buckets_move(table const& src)
+        {
+          BOOST_ASSERT(can_clone(src) && !size_);
+          this->create_buckets(this->bucket_count_);
+          this->copy_rehash_state(src);
+          this->set_hash_guard(src.hash_guard());
+
+          link_pointer prev = this->get_previous_start();
+          for (node_pointer n = src.begin(); n; n = next_node(n)) {
+            prev = this->add_clone(prev, n,
+              boost::unordered::detail::func::construct_node(
+                this->node_alloc(), boost::move(n->value())));
+          }
+        }
+
+        // Add 'n', a copy of 'src', after 'prev', which is the last node.
+        link_pointer add_clone(
+          link_pointer prev, node_pointer src, node_pointer n)
+        {
+          n->bucket_info_ = src->bucket_info_;
+          n->set_hash(src->get_hash());
+
+          bucket_pointer b = this->get_bucket(n->get_bucket());
+          if (!b->next_) {
+            b->next_ = prev;
+          }
+          set_next(prev, n);
+          ++this->size_;
+          return n;
+        }
+
         ////////////////////////////////////////////////////////////////////////
         // Swap and Move
 
@@ -3175,6 +4215,9 @@ namespace boost {
 
           boost::swap(buckets_, x.buckets_);
           boost::swap(bucket_count_, x.bucket_count_);
+          boost::swap(size_index_, x.size_index_);
+          this->swap_rehash_state(x);
+          this->swap_hash_guard(x);
           boost::swap(size_, x.size_);
           std::swap(mlf_, x.mlf_);
           std::swap(max_load_, x.max_load_);
@@ -3190,8 +4233,11 @@ namespace boost {
           BOOST_ASSERT(!buckets_);
           buckets_ = other.buckets_;
           bucket_count_ = other.bucket_count_;
+          size_index_ = other.size_index_;
           size_ = other.size_;
           max_load_ = other.max_load_;
+          this->move_rehash_state(other);
+          this->set_hash_guard(other.hash_guard());
           other.buckets_ = bucket_pointer();
           other.size_ = 0;
           other.max_load_ = 0;
@@ -3214,7 +4260,7 @@ namespace boost {
         {
           if (buckets_) {
             node_pointer n =
-              static_cast<node_pointer>(get_bucket(bucket_count_)->next_);
+              static_cast<node_pointer>(get_start_bucket()->next_);
 
             if (bucket::extra_node) {
               node_pointer next = next_node(n);
@@ -3238,13 +4284,55 @@ namespace boost {
 
         void destroy_buckets()
         {
-          bucket_pointer end = get_bucket(bucket_count_ + 1);
-          for (bucket_pointer it = buckets_; it != end; ++it) {
-            boost::unordered::detail::func::destroy(pointer<bucket>::get(it));
-          }
+          destroy_bucket_array(buckets_, bucket_count_);
+          destroy_old_buckets();
+        }
+
+        void destroy_old_buckets()
+        {
+          if (this->old_buckets()) {
+            destroy_bucket_array(this->old_buckets(), this->old_bucket_count());
+            this->clear_old_buckets();
+          }
+        }
+
+        void destroy_bucket_array(bucket_pointer buckets, std::size_t count)
+        {
+          bucket_pointer end = buckets + static_cast<std::ptrdiff_t>(count + 1);
+          for (bucket_pointer it = buckets; it != end; ++it) {
+            boost::unordered::detail::func::destroy(pointer<bucket>::get(it));
+          }
 
           bucket_allocator_traits::deallocate(
-            bucket_alloc(), buckets_, bucket_count_ + 1);
+            bucket_alloc(), buckets, count + 1);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Links between nodes
+
+        // Link 'n' (which can be null) after 'prev'. When the nodes are
+        // doubly linked, this also sets the link back from 'n'.
+        static void set_next(link_pointer prev, node_pointer n)
+        {
+          prev->next_ = n;
+          if (n) {
+            n->set_prev(prev);
+          }
+        }
+
+        // Find the link before 'n', searching from the start of its bucket
+        // unless the nodes are doubly linked.
+        link_pointer get_previous_node(node_pointer n) const
+        {
+          if (node::doubly_linked) {
+            return n->get_prev();
+          }
+
+          link_pointer prev = this->get_previous_start(this->node_bucket(n));
+          while (prev->next_ != n) {
+            prev = prev->next_;
+          }
+          return prev;
         }
 
         ////////////////////////////////////////////////////////////////////////
@@ -3335,7 +4423,7 @@ namespace boost {
             // Copy over other data, all no throw.
             new_func_this.commit();
             mlf_ = x.mlf_;
-            bucket_count_ = min_buckets_for_size(x.size_);
+            set_bucket_count(x.copy_bucket_count());
 
             // Finally copy the elements.
             if (x.size_) {
@@ -3403,9 +4491,50 @@ namespace boost {
 
         std::size_t hash(const_key_type& k) const
         {
+          BOOST_UNORDERED_STATS_ADD(hash_calls, 1);
+          return policy::apply_hash(this->hash_function(), k);
+        }
+
+        // Hash a key of a different type, when the hash function is
+        // transparent.
+        template <class Key> std::size_t transparent_hash(Key const& k) const
+        {
+          BOOST_UNORDERED_STATS_ADD(hash_calls, 1);
           return policy::apply_hash(this->hash_function(), k);
         }
 
+        // The hash value for a key, from a value that the caller has already
+        // computed with the hash function.
+        std::size_t precomputed_hash(
+          const_key_type& k, std::size_t hash_value) const
+        {
+          BOOST_ASSERT(hash_value == this->hash_function()(k));
+          boost::unordered::detail::func::ignore_unused_variable_warning(k);
+          return policy::mix_hash(hash_value);
+        }
+
+        template <class Pred, class Key1, class Key2>
+        bool keys_equal(Pred const& eq, Key1 const& k1, Key2 const& k2) const
+        {
+          BOOST_UNORDERED_STATS_ADD(key_eq_calls, 1);
+          return eq(k1, k2);
+        }
+
+        // The hash value for a node that's already in a container, only
+        // calls the hash function if the node doesn't store it.
+        std::size_t node_hash(node_pointer n) const
+        {
+          return node::hash_stored ? n->get_hash()
+                                   : this->hash(this->get_key(n));
+        }
+
+        // When nodes store their hash value, compare it before calling the
+        // equality predicate, which can be a lot more expensive.
+        static bool hash_may_match(node_pointer n, std::size_t key_hash)
+        {
+          return !node::hash_stored || n->get_hash() == key_hash;
+        }
+
         // Find Node
 
         node_pointer find_node(std::size_t key_hash, const_key_type& k) const
@@ -3418,18 +4547,69 @@ namespace boost {
           return this->find_node_impl(hash(k), k, this->key_eq());
         }
 
+        // Find using a key of a different type, when the hash function and
+        // equality predicate are transparent.
+        template <class Key>
+        node_pointer find_node_transparent(Key const& k) const
+        {
+          return this->find_node_impl(
+            this->transparent_hash(k), k, this->key_eq());
+        }
+
         template <class Key, class Pred>
         node_pointer find_node_impl(
           std::size_t key_hash, Key const& k, Pred const& eq) const
         {
           std::size_t bucket_index = this->hash_to_bucket(key_hash);
-          node_pointer n = this->begin(bucket_index);
+          node_pointer n = this->find_node_impl(
+            this->begin(bucket_index), bucket_index, key_hash, k, eq);
+          return n ? n : this->find_old_node(key_hash, k, eq);
+        }
+
+        // While rehashing incrementally, find the key's bucket in the old
+        // array, if it hasn't been moved yet.
+        bool old_bucket_index(
+          std::size_t key_hash, std::size_t& bucket_index) const
+        {
+          if (!incremental || !this->old_buckets()) {
+            return false;
+          }
+          if (guarded && this->hash_guard() == guard_mixed) {
+            key_hash = boost::unordered::detail::mix_hash_value(key_hash);
+          }
+          std::size_t position =
+            policy::position(this->old_size_index(), key_hash);
+          if (position < this->rehash_position()) {
+            return false;
+          }
+          bucket_index =
+            position | (this->bucket_generation() ^ bucket_generation_bit);
+          return true;
+        }
 
+        template <class Key, class Pred>
+        node_pointer find_old_node(
+          std::size_t key_hash, Key const& k, Pred const& eq) const
+        {
+          std::size_t bucket_index;
+          return this->old_bucket_index(key_hash, bucket_index)
+                   ? this->find_node_impl(this->begin(bucket_index),
+                       bucket_index, key_hash, k, eq)
+                   : node_pointer();
+        }
+
+        // Search for the key starting from 'n', the first node in its
+        // bucket.
+        template <class Key, class Pred>
+        node_pointer find_node_impl(node_pointer n, std::size_t bucket_index,
+          std::size_t key_hash, Key const& k, Pred const& eq) const
+        {
           for (;;) {
             if (!n)
               return n;
 
-            if (eq(k, this->get_key(n))) {
+            if (hash_may_match(n, key_hash) &&
+                this->keys_equal(eq, k, this->get_key(n))) {
               return n;
             } else if (this->node_bucket(n) != bucket_index) {
               return node_pointer();
@@ -3439,9 +4619,85 @@ namespace boost {
           }
         }
 
-        // Find the node before the key, so that it can be erased.
+        // Find several keys, writing an 'Iterator' for each one to 'out'.
+        // The keys are handled in batches: first they're all hashed, then
+        // their buckets are prefetched, followed by the link before the
+        // first node in each bucket, and then the first nodes. The keys are
+        // only compared after that, so that the cache misses for the keys in
+        // a batch overlap instead of happening one after the other.
+        template <class Iterator, class ForwardIt, class OutputIt>
+        OutputIt find_many(ForwardIt first, ForwardIt last, OutputIt out) const
+        {
+          std::size_t hashes[find_many_batch];
+          std::size_t bucket_indexes[find_many_batch];
+          link_pointer prevs[find_many_batch];
+
+          while (first != last) {
+            ForwardIt batch_begin = first;
+            std::size_t count = 0;
+            for (; count < find_many_batch && first != last; ++first) {
+              hashes[count++] = this->hash(*first);
+            }
+
+            if (!size_) {
+              for (std::size_t i = 0; i < count; ++i) {
+                *out++ = Iterator(node_pointer());
+              }
+              continue;
+            }
+
+            for (std::size_t i = 0; i < count; ++i) {
+              bucket_indexes[i] = this->hash_to_bucket(hashes[i]);
+              BOOST_UNORDERED_PREFETCH(
+                boost::addressof(*this->get_bucket(bucket_indexes[i])));
+            }
+
+            for (std::size_t i = 0; i < count; ++i) {
+              prevs[i] = this->get_previous_start(bucket_indexes[i]);
+              if (prevs[i]) {
+                BOOST_UNORDERED_PREFETCH(boost::addressof(*prevs[i]));
+              }
+            }
+
+            for (std::size_t i = 0; i < count; ++i) {
+              if (prevs[i] && prevs[i]->next_) {
+                BOOST_UNORDERED_PREFETCH(
+                  boost::addressof(*next_node(prevs[i])));
+              }
+            }
+
+            for (std::size_t i = 0; i < count; ++i, ++batch_begin) {
+              const_key_type& k = *batch_begin;
+              node_pointer n =
+                prevs[i] ? this->find_node_impl(next_node(prevs[i]),
+                             bucket_indexes[i], hashes[i], k, this->key_eq())
+                         : node_pointer();
+              *out++ = Iterator(
+                n ? n : this->find_old_node(hashes[i], k, this->key_eq()));
+            }
+          }
+
+          return out;
+        }
+
+        // Find the node before the key, so that it can be erased. If the key
+        // is found in the old buckets during an incremental rehash,
+        // 'bucket_index' is set to its old bucket.
+        template <class Key>
         link_pointer find_previous_node(
-          const_key_type& k, std::size_t bucket_index)
+          Key const& k, std::size_t key_hash, std::size_t& bucket_index)
+        {
+          link_pointer prev =
+            this->find_previous_node_impl(k, key_hash, bucket_index);
+          if (!prev && this->old_bucket_index(key_hash, bucket_index)) {
+            prev = this->find_previous_node_impl(k, key_hash, bucket_index);
+          }
+          return prev;
+        }
+
+        template <class Key>
+        link_pointer find_previous_node_impl(
+          Key const& k, std::size_t key_hash, std::size_t bucket_index)
         {
           link_pointer prev = this->get_previous_start(bucket_index);
           if (!prev) {
@@ -3455,7 +4711,9 @@ namespace boost {
             } else if (n->is_first_in_group()) {
               if (node_bucket(n) != bucket_index) {
                 return link_pointer();
-              } else if (this->key_eq()(k, this->get_key(n))) {
+              } else if (hash_may_match(n, key_hash) &&
+                         this->keys_equal(
+                           this->key_eq(), k, this->get_key(n))) {
                 return prev;
               }
             }
@@ -3472,7 +4730,8 @@ namespace boost {
           }
           std::size_t key_hash = this->hash(k);
           std::size_t bucket_index = this->hash_to_bucket(key_hash);
-          link_pointer prev = this->find_previous_node(k, bucket_index);
+          link_pointer prev =
+            this->find_previous_node(k, key_hash, bucket_index);
           if (!prev) {
             return node_pointer();
           }
@@ -3481,7 +4740,7 @@ namespace boost {
           if (n2) {
             n2->set_first_in_group();
           }
-          prev->next_ = n2;
+          set_next(prev, n2);
           --this->size_;
           this->fix_bucket(bucket_index, prev, n2);
           n->next_ = link_pointer();
@@ -3496,6 +4755,50 @@ namespace boost {
         void reserve(std::size_t);
         void rehash_impl(std::size_t);
 
+        // Incremental rehash
+
+        void start_incremental_rehash(std::size_t);
+        void incremental_rehash_step();
+        void move_old_bucket();
+
+        // Hash guard
+
+        void check_bucket_length(std::size_t bucket_index);
+        void rehash_mixed(std::size_t);
+
+#if defined(BOOST_UNORDERED_ENABLE_PARALLEL)
+        // Parallel build
+
+        template <class RandomIt, class Unique>
+        bool build_parallel(RandomIt, RandomIt, std::size_t threads, Unique);
+        bool link_parallel(bucket_pointer, node_pointer, std::size_t&,
+          boost::unordered::detail::true_type);
+        bool link_parallel(bucket_pointer, node_pointer, std::size_t&,
+          boost::unordered::detail::false_type);
+
+        // Parallel rehash
+
+        void rehash_parallel(std::size_t min_buckets, std::size_t threads);
+        void rehash_parallel_impl(
+          std::size_t num_buckets, bool mixed, std::size_t threads);
+
+        // Parallel traversal
+
+        template <class Iterator, class F>
+        void for_each_parallel(F&, std::size_t threads) const;
+#endif
+
+#if defined(BOOST_UNORDERED_ENABLE_STATS)
+        // Statistics
+
+        boost::unordered::stats get_stats() const;
+
+        void reset_stats()
+        {
+          stats_.reset();
+        }
+#endif
+
         ////////////////////////////////////////////////////////////////////////
         // Unique keys
 
@@ -3507,7 +4810,8 @@ namespace boost {
             return false;
 
           for (node_pointer n1 = this->begin(); n1; n1 = next_node(n1)) {
-            node_pointer n2 = other.find_node(other.get_key(n1));
+            node_pointer n2 =
+              other.find_node(other.node_hash(n1), other.get_key(n1));
 
             if (!n2 || n1->value() != n2->value())
               return false;
@@ -3526,6 +4830,7 @@ namespace boost {
 
           // TODO: Do this need to set_first_in_group ?
           n->bucket_info_ = bucket_index;
+          n->set_hash(key_hash);
           // n->set_first_in_group();
 
           if (!b->next_) {
@@ -3536,14 +4841,17 @@ namespace boost {
             }
 
             b->next_ = start_node;
-            n->next_ = start_node->next_;
-            start_node->next_ = n;
+            set_next(n, next_node(start_node));
+            set_next(start_node, n);
           } else {
-            n->next_ = b->next_->next_;
-            b->next_->next_ = n;
+            set_next(n, next_node(b->next_));
+            set_next(b->next_, n);
           }
 
           ++this->size_;
+          if (guarded && this->hash_guard() == guard_checking) {
+            this->check_bucket_length(bucket_index);
+          }
           return n;
         }
 
@@ -3559,7 +4867,8 @@ namespace boost {
         iterator emplace_hint_unique(
           c_iterator hint, const_key_type& k, BOOST_UNORDERED_EMPLACE_ARGS)
         {
-          if (hint.node_ && this->key_eq()(k, this->get_key(hint.node_))) {
+          if (hint.node_ &&
+              this->keys_equal(this->key_eq(), k, this->get_key(hint.node_))) {
             return iterator(hint.node_);
           } else {
             return emplace_unique(k, BOOST_UNORDERED_EMPLACE_FORWARD).first;
@@ -3592,7 +4901,8 @@ namespace boost {
                        this->node_alloc(), BOOST_UNORDERED_EMPLACE_FORWARD),
             this->node_alloc());
           const_key_type& k = this->get_key(b.node_);
-          if (hint.node_ && this->key_eq()(k, this->get_key(hint.node_))) {
+          if (hint.node_ &&
+              this->keys_equal(this->key_eq(), k, this->get_key(hint.node_))) {
             return iterator(hint.node_);
           }
           std::size_t key_hash = this->hash(k);
@@ -3623,6 +4933,25 @@ namespace boost {
           }
         }
 
+        template <BOOST_UNORDERED_EMPLACE_TEMPLATE>
+        emplace_return emplace_with_hash_unique(
+          std::size_t hash_value, BOOST_UNORDERED_EMPLACE_ARGS)
+        {
+          node_tmp b(boost::unordered::detail::func::construct_node_from_args(
+                       this->node_alloc(), BOOST_UNORDERED_EMPLACE_FORWARD),
+            this->node_alloc());
+          const_key_type& k = this->get_key(b.node_);
+          std::size_t key_hash = this->precomputed_hash(k, hash_value);
+          node_pointer pos = this->find_node(key_hash, k);
+          if (pos) {
+            return emplace_return(iterator(pos), false);
+          } else {
+            return emplace_return(
+              iterator(this->resize_and_add_node_unique(b.release(), key_hash)),
+              true);
+          }
+        }
+
         template <typename Key>
         emplace_return try_emplace_unique(BOOST_FWD_REF(Key) k)
         {
@@ -3643,7 +4972,7 @@ namespace boost {
         template <typename Key>
         iterator try_emplace_hint_unique(c_iterator hint, BOOST_FWD_REF(Key) k)
         {
-          if (hint.node_ && this->key_eq()(hint->first, k)) {
+          if (hint.node_ && this->keys_equal(this->key_eq(), hint->first, k)) {
             return iterator(hint.node_);
           } else {
             return try_emplace_unique(k).first;
@@ -3673,13 +5002,47 @@ namespace boost {
         iterator try_emplace_hint_unique(
           c_iterator hint, BOOST_FWD_REF(Key) k, BOOST_UNORDERED_EMPLACE_ARGS)
         {
-          if (hint.node_ && this->key_eq()(hint->first, k)) {
+          if (hint.node_ && this->keys_equal(this->key_eq(), hint->first, k)) {
             return iterator(hint.node_);
           } else {
             return try_emplace_unique(k, BOOST_UNORDERED_EMPLACE_FORWARD).first;
           }
         }
 
+        // Insert a key that an entry didn't find, using the hash value
+        // from its lookup.
+
+        template <typename Key>
+        node_pointer insert_entry_unique(
+          BOOST_FWD_REF(Key) k, std::size_t key_hash)
+        {
+          return this->resize_and_add_node_unique(
+            boost::unordered::detail::func::construct_node(
+              this->node_alloc(), boost::forward<Key>(k)),
+            key_hash);
+        }
+
+        template <typename Key>
+        node_pointer try_emplace_entry_unique(
+          BOOST_FWD_REF(Key) k, std::size_t key_hash)
+        {
+          return this->resize_and_add_node_unique(
+            boost::unordered::detail::func::construct_node_pair(
+              this->node_alloc(), boost::forward<Key>(k)),
+            key_hash);
+        }
+
+        template <typename Key, BOOST_UNORDERED_EMPLACE_TEMPLATE>
+        node_pointer try_emplace_entry_unique(BOOST_FWD_REF(Key) k,
+          std::size_t key_hash, BOOST_UNORDERED_EMPLACE_ARGS)
+        {
+          return this->resize_and_add_node_unique(
+            boost::unordered::detail::func::construct_node_pair_from_args(
+              this->node_alloc(), boost::forward<Key>(k),
+              BOOST_UNORDERED_EMPLACE_FORWARD),
+            key_hash);
+        }
+
         template <typename Key, typename M>
         emplace_return insert_or_assign_unique(
           BOOST_FWD_REF(Key) k, BOOST_FWD_REF(M) obj)
@@ -3731,7 +5094,8 @@ namespace boost {
             return iterator();
           }
           const_key_type& k = this->get_key(np.ptr_);
-          if (hint.node_ && this->key_eq()(k, this->get_key(hint.node_))) {
+          if (hint.node_ &&
+              this->keys_equal(this->key_eq(), k, this->get_key(hint.node_))) {
             return iterator(hint.node_);
           }
           std::size_t key_hash = this->hash(k);
@@ -3758,7 +5122,14 @@ namespace boost {
             while (prev->next_) {
               node_pointer n = other_table::next_node(prev);
               const_key_type& k = this->get_key(n);
-              std::size_t key_hash = this->hash(k);
+              // A stored hash value can only be reused if the other
+              // container's hash function must give the same value, so not
+              // for a hash function with state, such as a seed.
+              std::size_t key_hash =
+                boost::is_same<hasher, typename other_table::hasher>::value &&
+                    boost::is_empty<hasher>::value
+                  ? this->node_hash(n)
+                  : this->hash(k);
               node_pointer pos = this->find_node(key_hash, k);
 
               if (pos) {
@@ -3766,7 +5137,7 @@ namespace boost {
               } else {
                 this->reserve_for_insert(this->size_ + 1);
                 node_pointer n2 = next_node(n);
-                prev->next_ = n2;
+                set_next(prev, n2);
                 if (n2 && n->is_first_in_group()) {
                   n2->set_first_in_group();
                 }
@@ -3851,12 +5222,9 @@ namespace boost {
           node_pointer n = i.node_;
           BOOST_ASSERT(n);
           std::size_t bucket_index = this->node_bucket(n);
-          link_pointer prev = this->get_previous_start(bucket_index);
-          while (prev->next_ != n) {
-            prev = prev->next_;
-          }
+          link_pointer prev = this->get_previous_node(n);
           node_pointer n2 = next_node(n);
-          prev->next_ = n2;
+          set_next(prev, n2);
           --this->size_;
           this->fix_bucket(bucket_index, prev, n2);
           n->next_ = link_pointer();
@@ -3869,17 +5237,38 @@ namespace boost {
         // no throw
 
         std::size_t erase_key_unique(const_key_type& k)
+        {
+          return this->erase_key_unique_impl(k);
+        }
+
+        // Erase using a key of a different type, when the hash function and
+        // equality predicate are transparent.
+        template <class Key> std::size_t erase_key_unique_impl(Key const& k)
+        {
+          if (!this->size_)
+            return 0;
+          return this->erase_key_unique_hashed(k, this->transparent_hash(k));
+        }
+
+        std::size_t erase_key_unique(const_key_type& k, std::size_t hash_value)
+        {
+          return this->erase_key_unique_hashed(
+            k, this->precomputed_hash(k, hash_value));
+        }
+
+        template <class Key>
+        std::size_t erase_key_unique_hashed(Key const& k, std::size_t key_hash)
         {
           if (!this->size_)
             return 0;
-          std::size_t key_hash = this->hash(k);
           std::size_t bucket_index = this->hash_to_bucket(key_hash);
-          link_pointer prev = this->find_previous_node(k, bucket_index);
+          link_pointer prev =
+            this->find_previous_node(k, key_hash, bucket_index);
           if (!prev)
             return 0;
           node_pointer n = next_node(prev);
           node_pointer n2 = next_node(n);
-          prev->next_ = n2;
+          set_next(prev, n2);
           --size_;
           this->fix_bucket(bucket_index, prev, n2);
           this->destroy_node(n);
@@ -3891,12 +5280,10 @@ namespace boost {
           std::size_t bucket_index = this->node_bucket(i);
 
           // Find the node before i.
-          link_pointer prev = this->get_previous_start(bucket_index);
-          while (prev->next_ != i)
-            prev = prev->next_;
+          link_pointer prev = this->get_previous_node(i);
 
           // Delete the nodes.
-          prev->next_ = j;
+          set_next(prev, j);
           do {
             node_pointer next = next_node(i);
             destroy_node(i);
@@ -3911,10 +5298,15 @@ namespace boost {
 
         void copy_buckets(table const& src, true_type)
         {
+          if (this->can_clone(src)) {
+            this->clone_buckets(src);
+            return;
+          }
+
           this->create_buckets(this->bucket_count_);
 
           for (node_pointer n = src.begin(); n; n = next_node(n)) {
-            std::size_t key_hash = this->hash(this->get_key(n));
+            std::size_t key_hash = this->node_hash(n);
             this->add_node_unique(
               boost::unordered::detail::func::construct_node(
                 this->node_alloc(), n->value()),
@@ -3925,10 +5317,15 @@ namespace boost {
         // TODO: Should be move_buckets_uniq
         void move_buckets(table const& src)
         {
+          if (this->can_clone(src)) {
+            this->clone_buckets_move(src);
+            return;
+          }
+
           this->create_buckets(this->bucket_count_);
 
           for (node_pointer n = src.begin(); n; n = next_node(n)) {
-            std::size_t key_hash = this->hash(this->get_key(n));
+            std::size_t key_hash = this->node_hash(n);
             this->add_node_unique(
               boost::unordered::detail::func::construct_node(
                 this->node_alloc(), boost::move(n->value())),
@@ -3940,7 +5337,7 @@ namespace boost {
         {
           node_holder<node_allocator> holder(*this);
           for (node_pointer n = src.begin(); n; n = next_node(n)) {
-            std::size_t key_hash = this->hash(this->get_key(n));
+            std::size_t key_hash = this->node_hash(n);
             this->add_node_unique(holder.copy_of(n->value()), key_hash);
           }
         }
@@ -3949,7 +5346,7 @@ namespace boost {
         {
           node_holder<node_allocator> holder(*this);
           for (node_pointer n = src.begin(); n; n = next_node(n)) {
-            std::size_t key_hash = this->hash(this->get_key(n));
+            std::size_t key_hash = this->node_hash(n);
             this->add_node_unique(holder.move_copy_of(n->value()), key_hash);
           }
         }
@@ -3965,7 +5362,8 @@ namespace boost {
             return false;
 
           for (node_pointer n1 = this->begin(); n1;) {
-            node_pointer n2 = other.find_node(other.get_key(n1));
+            node_pointer n2 =
+              other.find_node(other.node_hash(n1), other.get_key(n1));
             if (!n2)
               return false;
             node_pointer end1 = next_group(n1);
@@ -4048,13 +5446,16 @@ namespace boost {
         inline node_pointer add_node_equiv(
           node_pointer n, std::size_t key_hash, node_pointer pos)
         {
-          std::size_t bucket_index = this->hash_to_bucket(key_hash);
+          // During an incremental rehash 'pos' might be in the old buckets.
+          std::size_t bucket_index =
+            pos ? this->node_bucket(pos) : this->hash_to_bucket(key_hash);
           n->bucket_info_ = bucket_index;
+          n->set_hash(key_hash);
 
           if (pos) {
             n->reset_first_in_group();
-            n->next_ = pos->next_;
-            pos->next_ = n;
+            set_next(n, next_node(pos));
+            set_next(pos, n);
             if (n->next_) {
               std::size_t next_bucket = this->node_bucket(next_node(n));
               if (next_bucket != bucket_index) {
@@ -4074,14 +5475,17 @@ namespace boost {
               }
 
               b->next_ = start_node;
-              n->next_ = start_node->next_;
-              start_node->next_ = n;
+              set_next(n, next_node(start_node));
+              set_next(start_node, n);
             } else {
-              n->next_ = b->next_->next_;
-              b->next_->next_ = n;
+              set_next(n, next_node(b->next_));
+              set_next(b->next_, n);
             }
           }
           ++this->size_;
+          if (guarded && !pos && this->hash_guard() == guard_checking) {
+            this->check_bucket_length(bucket_index);
+          }
           return n;
         }
 
@@ -4089,9 +5493,10 @@ namespace boost {
           node_pointer n, node_pointer hint)
         {
           n->bucket_info_ = hint->bucket_info_;
+          n->set_hash(hint->get_hash());
           n->reset_first_in_group();
-          n->next_ = hint->next_;
-          hint->next_ = n;
+          set_next(n, next_node(hint));
+          set_next(hint, n);
           if (n->next_) {
             std::size_t next_bucket = this->node_bucket(next_node(n));
             if (next_bucket != this->node_bucket(n)) {
@@ -4113,11 +5518,23 @@ namespace boost {
             this->add_node_equiv(a.release(), key_hash, position));
         }
 
+        iterator emplace_with_hash_equiv(std::size_t hash_value, node_pointer n)
+        {
+          node_tmp a(n, this->node_alloc());
+          const_key_type& k = this->get_key(a.node_);
+          std::size_t key_hash = this->precomputed_hash(k, hash_value);
+          node_pointer position = this->find_node(key_hash, k);
+          this->reserve_for_insert(this->size_ + 1);
+          return iterator(
+            this->add_node_equiv(a.release(), key_hash, position));
+        }
+
         iterator emplace_hint_equiv(c_iterator hint, node_pointer n)
         {
           node_tmp a(n, this->node_alloc());
           const_key_type& k = this->get_key(a.node_);
-          if (hint.node_ && this->key_eq()(k, this->get_key(hint.node_))) {
+          if (hint.node_ &&
+              this->keys_equal(this->key_eq(), k, this->get_key(hint.node_))) {
             this->reserve_for_insert(this->size_ + 1);
             return iterator(
               this->add_using_hint_equiv(a.release(), hint.node_));
@@ -4165,7 +5582,9 @@ namespace boost {
           if (np) {
             const_key_type& k = this->get_key(np.ptr_);
 
-            if (hint.node_ && this->key_eq()(k, this->get_key(hint.node_))) {
+            if (hint.node_ &&
+                this->keys_equal(
+                  this->key_eq(), k, this->get_key(hint.node_))) {
               this->reserve_for_insert(this->size_ + 1);
               result =
                 iterator(this->add_using_hint_equiv(np.ptr_, hint.node_));
@@ -4231,12 +5650,8 @@ namespace boost {
           node_pointer j(next_node(i));
           std::size_t bucket_index = this->node_bucket(i);
 
-          link_pointer prev = this->get_previous_start(bucket_index);
-          while (prev->next_ != i) {
-            prev = next_node(prev);
-          }
-
-          prev->next_ = j;
+          link_pointer prev = this->get_previous_node(i);
+          set_next(prev, j);
           if (j && i->is_first_in_group()) {
             j->set_first_in_group();
           }
@@ -4253,13 +5668,34 @@ namespace boost {
         // no throw
 
         std::size_t erase_key_equiv(const_key_type& k)
+        {
+          return this->erase_key_equiv_impl(k);
+        }
+
+        // Erase using a key of a different type, when the hash function and
+        // equality predicate are transparent.
+        template <class Key> std::size_t erase_key_equiv_impl(Key const& k)
+        {
+          if (!this->size_)
+            return 0;
+          return this->erase_key_equiv_hashed(k, this->transparent_hash(k));
+        }
+
+        std::size_t erase_key_equiv(const_key_type& k, std::size_t hash_value)
+        {
+          return this->erase_key_equiv_hashed(
+            k, this->precomputed_hash(k, hash_value));
+        }
+
+        template <class Key>
+        std::size_t erase_key_equiv_hashed(Key const& k, std::size_t key_hash)
         {
           if (!this->size_)
             return 0;
 
-          std::size_t key_hash = this->hash(k);
           std::size_t bucket_index = this->hash_to_bucket(key_hash);
-          link_pointer prev = this->find_previous_node(k, bucket_index);
+          link_pointer prev =
+            this->find_previous_node(k, key_hash, bucket_index);
           if (!prev)
             return 0;
 
@@ -4272,7 +5708,7 @@ namespace boost {
             n = n2;
           } while (n && !n->is_first_in_group());
           size_ -= deleted_count;
-          prev->next_ = n;
+          set_next(prev, n);
           this->fix_bucket(bucket_index, prev, n);
           return deleted_count;
         }
@@ -4281,15 +5717,12 @@ namespace boost {
         {
           std::size_t bucket_index = this->node_bucket(i);
 
-          link_pointer prev = this->get_previous_start(bucket_index);
-          while (prev->next_ != i) {
-            prev = next_node(prev);
-          }
+          link_pointer prev = this->get_previous_node(i);
 
           // Delete the nodes.
           // Is it inefficient to call fix_bucket for every node?
           bool includes_first = false;
-          prev->next_ = j;
+          set_next(prev, j);
           do {
             includes_first = includes_first || i->is_first_in_group();
             node_pointer next = next_node(i);
@@ -4310,10 +5743,15 @@ namespace boost {
 
         void copy_buckets(table const& src, false_type)
         {
+          if (this->can_clone(src)) {
+            this->clone_buckets(src);
+            return;
+          }
+
           this->create_buckets(this->bucket_count_);
 
           for (node_pointer n = src.begin(); n;) {
-            std::size_t key_hash = this->hash(this->get_key(n));
+            std::size_t key_hash = this->node_hash(n);
             node_pointer group_end(next_group(n));
             node_pointer pos = this->add_node_equiv(
               boost::unordered::detail::func::construct_node(
@@ -4330,10 +5768,15 @@ namespace boost {
 
         void move_buckets_equiv(table const& src)
         {
+          if (this->can_clone(src)) {
+            this->clone_buckets_move(src);
+            return;
+          }
+
           this->create_buckets(this->bucket_count_);
 
           for (node_pointer n = src.begin(); n;) {
-            std::size_t key_hash = this->hash(this->get_key(n));
+            std::size_t key_hash = this->node_hash(n);
             node_pointer group_end(next_group(n));
             node_pointer pos = this->add_node_equiv(
               boost::unordered::detail::func::construct_node(
@@ -4352,7 +5795,7 @@ namespace boost {
         {
           node_holder<node_allocator> holder(*this);
           for (node_pointer n = src.begin(); n;) {
-            std::size_t key_hash = this->hash(this->get_key(n));
+            std::size_t key_hash = this->node_hash(n);
             node_pointer group_end(next_group(n));
             node_pointer pos = this->add_node_equiv(
               holder.copy_of(n->value()), key_hash, node_pointer());
@@ -4366,7 +5809,7 @@ namespace boost {
         {
           node_holder<node_allocator> holder(*this);
           for (node_pointer n = src.begin(); n;) {
-            std::size_t key_hash = this->hash(this->get_key(n));
+            std::size_t key_hash = this->node_hash(n);
             node_pointer group_end(next_group(n));
             node_pointer pos = this->add_node_equiv(
               holder.move_copy_of(n->value()), key_hash, node_pointer());
@@ -4384,10 +5827,11 @@ namespace boost {
       template <typename Types> inline void table<Types>::clear_impl()
       {
         if (size_) {
-          bucket_pointer end = get_bucket(bucket_count_);
+          bucket_pointer end = get_start_bucket();
           for (bucket_pointer it = buckets_; it != end; ++it) {
             it->next_ = node_pointer();
           }
+          destroy_old_buckets();
 
           link_pointer prev = end->first_from_start();
           node_pointer n = next_node(prev);
@@ -4402,6 +5846,48 @@ namespace boost {
         }
       }
 
+#if defined(BOOST_UNORDERED_ENABLE_STATS)
+      //////////////////////////////////////////////////////////////////////////
+      // Statistics
+      //
+      // The chain lengths are found by walking the list, as each bucket's
+      // nodes are next to each other. During an incremental rehash, the
+      // buckets are counted the same way as in the bucket interface, which
+      // includes the old buckets that haven't been moved.
+
+      template <typename Types>
+      inline boost::unordered::stats table<Types>::get_stats() const
+      {
+        boost::unordered::stats s;
+        s.hash_calls = stats_.hash_calls.get();
+        s.key_eq_calls = stats_.key_eq_calls.get();
+        s.rehashes = stats_.rehashes.get();
+        s.rehashed_nodes = stats_.rehashed_nodes.get();
+        s.size = size_;
+        s.bucket_count = local_bucket_count();
+        s.chain_lengths.push_back(0);
+
+        node_pointer n = begin();
+        while (n) {
+          std::size_t bucket_index = node_bucket(n);
+          std::size_t length = 0;
+          do {
+            ++length;
+            n = next_node(n);
+          } while (n && node_bucket(n) == bucket_index);
+
+          if (length >= s.chain_lengths.size()) {
+            s.chain_lengths.resize(length + 1);
+          }
+          ++s.chain_lengths[length];
+          ++s.used_buckets;
+        }
+
+        s.chain_lengths[0] = s.bucket_count - s.used_buckets;
+        return s;
+      }
+#endif
+
       //////////////////////////////////////////////////////////////////////////
       // Reserve & Rehash
 
@@ -4411,12 +5897,27 @@ namespace boost {
       {
         if (!buckets_) {
           create_buckets((std::max)(bucket_count_, min_buckets_for_size(size)));
-        } else if (size > max_load_) {
+        } else if (size > max_load_ ||
+                   (guarded && this->hash_guard() == guard_pending)) {
           std::size_t num_buckets =
-            min_buckets_for_size((std::max)(size, size_ + (size_ >> 1)));
+            size > max_load_
+              ? min_buckets_for_size((std::max)(size, size_ + (size_ >> 1)))
+              : bucket_count_;
+
+          if (guarded && this->hash_guard() == guard_pending) {
+            this->rehash_mixed(num_buckets);
+          } else if (num_buckets != bucket_count_) {
+            // If the last incremental rehash hasn't finished, the elements
+            // are all rehashed at once.
+            if (incremental && !this->old_buckets())
+              this->start_incremental_rehash(num_buckets);
+            else
+              this->rehash_impl(num_buckets);
+          }
+        }
 
-          if (num_buckets != bucket_count_)
-            this->rehash_impl(num_buckets);
+        if (incremental) {
+          this->incremental_rehash_step();
         }
       }
 
@@ -4430,15 +5931,23 @@ namespace boost {
 
         if (!size_) {
           delete_buckets();
-          bucket_count_ = policy::new_bucket_count(min_buckets);
+          set_bucket_count(policy::new_bucket_count(min_buckets));
         } else {
           min_buckets = policy::new_bucket_count((std::max)(min_buckets,
             boost::unordered::detail::double_to_size(
               floor(static_cast<double>(size_) / static_cast<double>(mlf_))) +
               1));
 
-          if (min_buckets != bucket_count_)
+          if (guarded && this->hash_guard() == guard_pending) {
+            this->rehash_mixed(min_buckets);
+          } else if (min_buckets != bucket_count_) {
             this->rehash_impl(min_buckets);
+          } else if (incremental) {
+            // Finish moving the nodes from the old buckets.
+            while (this->old_buckets()) {
+              this->move_old_bucket();
+            }
+          }
         }
       }
 
@@ -4448,12 +5957,20 @@ namespace boost {
         BOOST_ASSERT(this->buckets_);
 
         this->create_buckets(num_buckets);
+        BOOST_UNORDERED_STATS_ADD(rehashes, 1);
+        BOOST_UNORDERED_STATS_ADD(rehashed_nodes, size_);
         link_pointer prev = this->get_previous_start();
+
+        // The start of the list might have moved along with the buckets.
+        if (prev->next_) {
+          next_node(prev)->set_prev(prev);
+        }
+
         BOOST_TRY
         {
           while (prev->next_) {
             node_pointer n = next_node(prev);
-            std::size_t key_hash = this->hash(this->get_key(n));
+            std::size_t key_hash = this->node_hash(n);
             std::size_t bucket_index = this->hash_to_bucket(key_hash);
 
             n->bucket_info_ = bucket_index;
@@ -4477,10 +5994,10 @@ namespace boost {
               b->next_ = prev;
               prev = n;
             } else {
-              link_pointer next = n->next_;
-              n->next_ = b->next_->next_;
-              b->next_->next_ = prev->next_;
-              prev->next_ = next;
+              node_pointer next = next_node(n);
+              set_next(n, next_node(b->next_));
+              set_next(b->next_, next_node(prev));
+              set_next(prev, next);
             }
           }
         }
@@ -4499,6 +6016,684 @@ namespace boost {
         BOOST_CATCH_END
       }
 
+      //////////////////////////////////////////////////////////////////////////
+      // Incremental rehash
+      //
+      // The old bucket array is kept, and the nodes are moved a bucket at a
+      // time by the following inserts and erases. Each node's bucket index
+      // includes a generation bit, so that the buckets in both arrays are
+      // found by 'get_bucket', and the nodes stay in the same list.
+
+      // Strong exception safety.
+      template <typename Types>
+      inline void table<Types>::start_incremental_rehash(
+        std::size_t num_buckets)
+      {
+        BOOST_ASSERT(this->buckets_ && !this->old_buckets());
+
+        bucket_pointer new_buckets =
+          bucket_allocator_traits::allocate(bucket_alloc(), num_buckets + 1);
+
+        // nothrow from here...
+        bucket_pointer old_start = this->get_start_bucket();
+        construct_buckets(new_buckets, num_buckets, old_start->next_);
+        old_start->next_ = link_pointer();
+
+        this->start_rehash(buckets_, bucket_count_, size_index_);
+        buckets_ = new_buckets;
+        set_bucket_count(num_buckets);
+        recalculate_max_load();
+        BOOST_UNORDERED_STATS_ADD(rehashes, 1);
+
+        // The start of the list might have moved along with the buckets.
+        link_pointer prev = this->get_previous_start();
+        if (prev->next_) {
+          node_pointer n = next_node(prev);
+          this->get_bucket(this->node_bucket(n))->next_ = prev;
+          n->set_prev(prev);
+        }
+      }
+
+      // Move enough buckets to finish before the container grows again.
+      template <typename Types>
+      inline void table<Types>::incremental_rehash_step()
+      {
+        if (this->old_buckets()) {
+          std::size_t remaining =
+            this->old_bucket_count() - this->rehash_position();
+          std::size_t steps =
+            remaining / (max_load_ > size_ ? max_load_ - size_ + 1 : 1) + 1;
+          while (steps-- && this->old_buckets()) {
+            this->move_old_bucket();
+          }
+        }
+      }
+
+      // Move the nodes in the old bucket at 'rehash_position()' to the new
+      // buckets, a group at a time. If the hash function throws, the nodes
+      // that haven't been moved are still in the old bucket, so the table is
+      // still valid.
+      template <typename Types>
+      inline void table<Types>::move_old_bucket()
+      {
+        bucket_pointer old_bucket =
+          this->old_buckets() +
+          static_cast<std::ptrdiff_t>(this->rehash_position());
+
+        while (old_bucket->next_) {
+          link_pointer prev = old_bucket->next_;
+          node_pointer n = next_node(prev);
+          std::size_t bucket_index = this->hash_to_bucket(this->node_hash(n));
+
+          // Unlink the group from the old bucket.
+          node_pointer last = n;
+          for (;;) {
+            node_pointer next = next_node(last);
+            if (!next || next->is_first_in_group()) {
+              break;
+            }
+            last = next;
+          }
+          node_pointer next = next_node(last);
+          set_next(prev, next);
+          this->fix_bucket(this->node_bucket(n), prev, next);
+
+          n->bucket_info_ = bucket_index;
+          BOOST_UNORDERED_STATS_ADD(rehashed_nodes, 1);
+          for (node_pointer it = next_node(n); it != next; it = next_node(it)) {
+            it->bucket_info_ = bucket_index;
+            it->reset_first_in_group();
+            BOOST_UNORDERED_STATS_ADD(rehashed_nodes, 1);
+          }
+
+          // And link it into its new bucket.
+          bucket_pointer b = this->get_bucket(bucket_index);
+          if (!b->next_) {
+            link_pointer start_node = this->get_previous_start();
+            if (start_node->next_) {
+              this->get_bucket(this->node_bucket(next_node(start_node)))
+                ->next_ = last;
+            }
+            b->next_ = start_node;
+            set_next(last, next_node(start_node));
+            set_next(start_node, n);
+          } else {
+            set_next(last, next_node(b->next_));
+            set_next(b->next_, n);
+          }
+        }
+
+        if (this->next_rehash_position()) {
+          destroy_old_buckets();
+        }
+      }
+
+      ////////////////////////////////////////////////////////////////////////
+      // Hash guard
+      //
+      // Called after adding a new key. Counts the groups in its bucket, and
+      // if there are far more than a reasonable hash function would
+      // produce, the next insert or rehash will switch to mixed hash values.
+      // The rehash isn't done here, as the caller is still using the node.
+      template <typename Types>
+      inline void table<Types>::check_bucket_length(std::size_t bucket_index)
+      {
+        using namespace std;
+
+        std::size_t nodes = 0;
+        std::size_t length = 0;
+        std::size_t limit = 0;
+        for (node_pointer n = next_node(this->get_bucket(bucket_index)->next_);
+             n && this->node_bucket(n) == bucket_index; n = next_node(n)) {
+          length += n->is_first_in_group() ? 1 : 0;
+          if (++nodes <= 8) {
+            continue;
+          }
+
+          // The limit is twice the log of the size plus the maximum load
+          // factor, so it's only worked out for long buckets.
+          if (!limit) {
+            limit = 8 + 2 * boost::unordered::detail::double_to_size(
+                              ceil(static_cast<double>(mlf_)));
+            for (std::size_t x = size_; x > 1; x >>= 1) {
+              limit += 2;
+            }
+          }
+
+          if (length > limit) {
+            this->set_hash_guard(guard_pending);
+            return;
+          } else if (nodes > 4 * limit) {
+            // Don't walk through large groups of equivalent elements.
+            return;
+          }
+        }
+      }
+
+      // basic exception safety
+      template <typename Types>
+      inline void table<Types>::rehash_mixed(std::size_t num_buckets)
+      {
+        BOOST_ASSERT(this->hash_guard() == guard_pending);
+
+        // The old buckets were found using unmixed hash values.
+        if (incremental) {
+          while (this->old_buckets()) {
+            this->move_old_bucket();
+          }
+        }
+
+        this->set_hash_guard(guard_mixed);
+        this->rehash_impl(num_buckets);
+      }
+
+#if defined(BOOST_UNORDERED_ENABLE_PARALLEL)
+      ////////////////////////////////////////////////////////////////////////
+      // Parallel build
+      //
+      // Builds an empty container from a random access range. The bucket
+      // array is split into one partition of consecutive buckets for each
+      // thread:
+      //
+      // 1. Each thread hashes a chunk of the range, and counts the elements
+      //    that belong in each partition.
+      // 2. Each thread writes the indexes of its elements into an array
+      //    ordered by partition, keeping the order of the range within a
+      //    partition.
+      // 3. Each thread constructs the nodes for its partition, and links
+      //    them into its buckets. While a partition is being built, its
+      //    buckets point to their first node, rather than the previous node.
+      //    Then the buckets are linked into a list for the whole partition.
+      //
+      // Finally, the partition lists are joined. Since the threads only
+      // write to their own buckets, nothing needs to be locked. The hash
+      // function, equality predicate and allocator are called from several
+      // threads at once.
+      //
+      // Returns false without doing anything if the container isn't empty,
+      // or the range is too small to be worth splitting.
+      //
+      // Basic exception safety, the container is empty after an exception.
+
+      template <typename Types>
+      template <class RandomIt, class Unique>
+      inline bool table<Types>::build_parallel(
+        RandomIt first, RandomIt last, std::size_t threads, Unique unique)
+      {
+        std::size_t const length = static_cast<std::size_t>(last - first);
+        threads =
+          boost::unordered::detail::parallel_threads(threads, length, 4096);
+        if (size_ || threads < 2) {
+          return false;
+        }
+
+        if (incremental) {
+          while (this->old_buckets()) {
+            this->move_old_bucket();
+          }
+        }
+        std::size_t min_buckets = min_buckets_for_size(length);
+        if (!buckets_ || bucket_count_ < min_buckets) {
+          create_buckets((std::max)(bucket_count_, min_buckets));
+        }
+
+        std::size_t const chunk_size = (length + threads - 1) / threads;
+        std::size_t const partition_size =
+          (bucket_count_ + threads - 1) / threads;
+        std::vector<std::size_t> hashes(length);
+        std::vector<std::size_t> offsets(threads * threads);
+        std::vector<std::size_t> order(length);
+
+        // 1. Hash the elements, and count the elements for each partition.
+        boost::unordered::detail::parallel_for(threads, [&](std::size_t t) {
+          std::size_t* counts = &offsets[t * threads];
+          std::size_t end = (std::min)(length, (t + 1) * chunk_size);
+          for (std::size_t i = t * chunk_size; i < end; ++i) {
+            hashes[i] = policy::apply_hash(
+              this->hash_function(), extractor::extract(first[i]));
+            ++counts[bucket_position(this->hash_to_bucket(hashes[i])) /
+                     partition_size];
+          }
+        });
+        BOOST_UNORDERED_STATS_ADD(hash_calls, length);
+
+        // Turn the counts into the position of each chunk's elements.
+        std::vector<std::size_t> partition_begin(threads + 1);
+        std::size_t total = 0;
+        for (std::size_t p = 0; p < threads; ++p) {
+          partition_begin[p] = total;
+          for (std::size_t t = 0; t < threads; ++t) {
+            std::size_t count = offsets[t * threads + p];
+            offsets[t * threads + p] = total;
+            total += count;
+          }
+        }
+        partition_begin[threads] = total;
+
+        // 2. Sort the indexes by partition.
+        boost::unordered::detail::parallel_for(threads, [&](std::size_t t) {
+          std::size_t* positions = &offsets[t * threads];
+          std::size_t end = (std::min)(length, (t + 1) * chunk_size);
+          for (std::size_t i = t * chunk_size; i < end; ++i) {
+            order[positions[bucket_position(this->hash_to_bucket(
+                                hashes[i])) /
+                            partition_size]++] = i;
+          }
+        });
+
+        // 3. Build the partitions.
+        std::vector<node_pointer> heads(threads), tails(threads);
+        std::vector<bucket_pointer> first_buckets(threads);
+        std::vector<std::size_t> sizes(threads), eq_calls(threads);
+        std::vector<char> linked(threads);
+
+        BOOST_TRY
+        {
+          boost::unordered::detail::parallel_for(threads, [&](std::size_t p) {
+            node_allocator alloc(this->node_alloc());
+            for (std::size_t i = partition_begin[p];
+                 i < partition_begin[p + 1]; ++i) {
+              std::size_t index = order[i];
+              std::size_t bucket_index = this->hash_to_bucket(hashes[index]);
+              bucket_pointer b = this->get_bucket(bucket_index);
+              node_tmp tmp(
+                boost::unordered::detail::func::construct_node_from_args(
+                  alloc, first[index]),
+                alloc);
+              tmp.node_->bucket_info_ = bucket_index;
+              tmp.node_->set_hash(hashes[index]);
+              if (this->link_parallel(b, tmp.node_, eq_calls[p], unique)) {
+                tmp.release();
+                ++sizes[p];
+              }
+            }
+
+            // Join the buckets into a list, and point them at the previous
+            // node. The first bucket's previous node is in an earlier
+            // partition, so it's set below.
+            std::size_t end =
+              (std::min)(bucket_count_, (p + 1) * partition_size);
+            for (std::size_t pos = p * partition_size; pos < end; ++pos) {
+              bucket_pointer b = buckets_ + static_cast<std::ptrdiff_t>(pos);
+              if (!b->next_) {
+                continue;
+              }
+              node_pointer head = static_cast<node_pointer>(b->next_);
+              if (tails[p]) {
+                set_next(tails[p], head);
+                b->next_ = tails[p];
+              } else {
+                heads[p] = head;
+                first_buckets[p] = b;
+                b->next_ = link_pointer();
+              }
+              node_pointer tail = head;
+              while (tail->next_) {
+                tail = next_node(tail);
+              }
+              tails[p] = tail;
+            }
+            linked[p] = 1;
+          });
+        }
+        BOOST_CATCH(...)
+        {
+          for (std::size_t p = 0; p < threads; ++p) {
+            std::size_t end =
+              (std::min)(bucket_count_, (p + 1) * partition_size);
+            for (std::size_t pos = p * partition_size; pos < end; ++pos) {
+              bucket_pointer b = buckets_ + static_cast<std::ptrdiff_t>(pos);
+              node_pointer n = linked[p]
+                                 ? node_pointer()
+                                 : static_cast<node_pointer>(b->next_);
+              b->next_ = link_pointer();
+              while (n) {
+                node_pointer next = next_node(n);
+                this->destroy_node(n);
+                n = next;
+              }
+            }
+            for (node_pointer n = heads[p]; linked[p] && n;) {
+              node_pointer next = next_node(n);
+              this->destroy_node(n);
+              n = next;
+            }
+          }
+          BOOST_RETHROW
+        }
+        BOOST_CATCH_END
+
+        link_pointer prev = this->get_previous_start();
+        for (std::size_t p = 0; p < threads; ++p) {
+          if (heads[p]) {
+            set_next(prev, heads[p]);
+            first_buckets[p]->next_ = prev;
+            prev = tails[p];
+          }
+          size_ += sizes[p];
+          BOOST_UNORDERED_STATS_ADD(key_eq_calls, eq_calls[p]);
+        }
+
+        return true;
+      }
+
+      // Link 'n' into a bucket in a partition that is being built, where
+      // the bucket points to its first node. Returns false if the key is
+      // already in the bucket.
+      template <typename Types>
+      inline bool table<Types>::link_parallel(bucket_pointer b, node_pointer n,
+        std::size_t& eq_calls, boost::unordered::detail::true_type)
+      {
+        node_pointer n2 = static_cast<node_pointer>(b->next_);
+        if (!n2) {
+          b->next_ = n;
+          return true;
+        }
+        for (;;) {
+          if (hash_may_match(n2, n->get_hash())) {
+            ++eq_calls;
+            if (this->key_eq()(this->get_key(n), this->get_key(n2))) {
+              return false;
+            }
+          }
+          if (!n2->next_) {
+            break;
+          }
+          n2 = next_node(n2);
+        }
+        set_next(n2, n);
+        return true;
+      }
+
+      // Equivalent elements go at the end of their group, so that they stay
+      // in the same order as the range.
+      template <typename Types>
+      inline bool table<Types>::link_parallel(bucket_pointer b, node_pointer n,
+        std::size_t& eq_calls, boost::unordered::detail::false_type)
+      {
+        node_pointer n2 = static_cast<node_pointer>(b->next_);
+        if (!n2) {
+          b->next_ = n;
+          return true;
+        }
+        for (;;) {
+          bool match = false;
+          if (hash_may_match(n2, n->get_hash())) {
+            ++eq_calls;
+            match = this->key_eq()(this->get_key(n), this->get_key(n2));
+          }
+
+          // Move to the end of the group.
+          node_pointer next = next_node(n2);
+          while (next && !next->is_first_in_group()) {
+            n2 = next;
+            next = next_node(n2);
+          }
+
+          if (match) {
+            n->reset_first_in_group();
+            set_next(n, next);
+            set_next(n2, n);
+            return true;
+          }
+          if (!next) {
+            break;
+          }
+          n2 = next;
+        }
+        set_next(n2, n);
+        return true;
+      }
+
+      ////////////////////////////////////////////////////////////////////////
+      // Parallel rehash
+      //
+      // Like 'rehash', but the nodes are moved to the new buckets on
+      // several threads. The new bucket array is created alongside the old
+      // one, which is split into a range of buckets for each thread:
+      //
+      // 1. Each thread walks the groups of nodes in its old buckets, and
+      //    records the first and last node of each one along with its new
+      //    bucket. This is where the hash function is called, if the hash
+      //    values aren't stored. Nothing is changed yet.
+      // 2. The records are sorted into a partition of the new buckets for
+      //    each thread, as in 'build_parallel'.
+      // 3. Each thread links the groups in its partition into its new
+      //    buckets, and joins those buckets into a list.
+      //
+      // Then the partition lists are joined, and the old bucket array is
+      // destroyed. This uses some extra memory for the records, about four
+      // words for each group of equivalent elements.
+      //
+      // Strong exception safety, the hash function and the allocations can
+      // only throw before anything has been changed.
+
+      template <typename Types>
+      inline void table<Types>::rehash_parallel(
+        std::size_t min_buckets, std::size_t threads)
+      {
+        using namespace std;
+
+        threads =
+          boost::unordered::detail::parallel_threads(threads, size_, 4096);
+        if (threads < 2) {
+          this->rehash(min_buckets);
+          return;
+        }
+
+        min_buckets = policy::new_bucket_count((std::max)(min_buckets,
+          boost::unordered::detail::double_to_size(
+            floor(static_cast<double>(size_) / static_cast<double>(mlf_))) +
+            1));
+
+        if (incremental) {
+          while (this->old_buckets()) {
+            this->move_old_bucket();
+          }
+        }
+
+        bool pending = guarded && this->hash_guard() == guard_pending;
+        if (pending || min_buckets != bucket_count_) {
+          this->rehash_parallel_impl(
+            min_buckets, pending || this->hash_guard() == guard_mixed, threads);
+          if (pending) {
+            this->set_hash_guard(guard_mixed);
+          }
+        }
+      }
+
+      template <typename Types>
+      inline void table<Types>::rehash_parallel_impl(
+        std::size_t num_buckets, bool mixed, std::size_t threads)
+      {
+        BOOST_ASSERT(buckets_ && !this->old_buckets());
+
+        struct group_record
+        {
+          node_pointer first;
+          node_pointer last;
+          std::size_t bucket_index;
+        };
+
+        std::size_t const size_index = policy::size_index(num_buckets);
+        std::size_t const old_partition_size =
+          (bucket_count_ + threads - 1) / threads;
+        std::size_t const partition_size =
+          (num_buckets + threads - 1) / threads;
+        std::vector<std::vector<group_record> > records(threads);
+        std::vector<std::size_t> offsets(threads * threads);
+        std::vector<std::size_t> thread_hash_calls(threads);
+        std::vector<std::size_t> partition_begin(threads + 1);
+        std::vector<group_record> sorted;
+        std::vector<node_pointer> heads(threads), tails(threads);
+        std::vector<bucket_pointer> first_buckets(threads);
+
+        bucket_pointer new_buckets =
+          bucket_allocator_traits::allocate(bucket_alloc(), num_buckets + 1);
+        construct_buckets(new_buckets, num_buckets, get_start_bucket()->next_);
+
+        BOOST_TRY
+        {
+          // 1. Find the new bucket for each group.
+          boost::unordered::detail::parallel_for(threads, [&](std::size_t t) {
+            std::size_t* counts = &offsets[t * threads];
+            std::size_t end =
+              (std::min)(bucket_count_, (t + 1) * old_partition_size);
+            for (std::size_t pos = t * old_partition_size; pos < end; ++pos) {
+              bucket_pointer b = buckets_ + static_cast<std::ptrdiff_t>(pos);
+              if (!b->next_) {
+                continue;
+              }
+              node_pointer n = next_node(b->next_);
+              while (n && bucket_position(this->node_bucket(n)) == pos) {
+                group_record r;
+                r.first = n;
+                std::size_t key_hash;
+                if (node::hash_stored) {
+                  key_hash = n->get_hash();
+                } else {
+                  key_hash = policy::apply_hash(
+                    this->hash_function(), this->get_key(n));
+                  ++thread_hash_calls[t];
+                }
+                r.bucket_index =
+                  this->hash_to_bucket(key_hash, size_index, mixed);
+
+                n = next_node(n);
+                r.last = r.first;
+                while (n && !n->is_first_in_group()) {
+                  r.last = n;
+                  n = next_node(n);
+                }
+
+                records[t].push_back(r);
+                ++counts[bucket_position(r.bucket_index) / partition_size];
+              }
+            }
+          });
+
+          // 2. Sort the records by partition.
+          std::size_t total = 0;
+          for (std::size_t p = 0; p < threads; ++p) {
+            partition_begin[p] = total;
+            for (std::size_t t = 0; t < threads; ++t) {
+              std::size_t count = offsets[t * threads + p];
+              offsets[t * threads + p] = total;
+              total += count;
+            }
+          }
+          partition_begin[threads] = total;
+
+          sorted.resize(total);
+          boost::unordered::detail::parallel_for(threads, [&](std::size_t t) {
+            std::size_t* positions = &offsets[t * threads];
+            for (std::size_t i = 0; i < records[t].size(); ++i) {
+              group_record const& r = records[t][i];
+              sorted[positions[bucket_position(r.bucket_index) /
+                               partition_size]++] = r;
+            }
+            std::vector<group_record>().swap(records[t]);
+          });
+
+          // 3. Link the groups into the new buckets. This doesn't throw, so
+          //    if parallel_for does, it's before any node has been changed.
+          boost::unordered::detail::parallel_for(threads, [&](std::size_t p) {
+            for (std::size_t i = partition_begin[p]; i < partition_begin[p + 1];
+                 ++i) {
+              group_record const& r = sorted[i];
+              node_pointer n = r.first;
+              n->bucket_info_ = r.bucket_index;
+              while (n != r.last) {
+                n = next_node(n);
+                n->bucket_info_ = r.bucket_index;
+                n->reset_first_in_group();
+              }
+
+              // While the partition is being built, each bucket points to its
+              // first node.
+              bucket_pointer b = new_buckets +
+                                 static_cast<std::ptrdiff_t>(
+                                   bucket_position(r.bucket_index));
+              set_next(r.last, static_cast<node_pointer>(b->next_));
+              b->next_ = r.first;
+            }
+
+            std::size_t end =
+              (std::min)(num_buckets, (p + 1) * partition_size);
+            for (std::size_t pos = p * partition_size; pos < end; ++pos) {
+              bucket_pointer b = new_buckets + static_cast<std::ptrdiff_t>(pos);
+              if (!b->next_) {
+                continue;
+              }
+              node_pointer head = static_cast<node_pointer>(b->next_);
+              if (tails[p]) {
+                set_next(tails[p], head);
+                b->next_ = tails[p];
+              } else {
+                heads[p] = head;
+                first_buckets[p] = b;
+                b->next_ = link_pointer();
+              }
+              node_pointer tail = head;
+              while (tail->next_) {
+                tail = next_node(tail);
+              }
+              tails[p] = tail;
+            }
+          });
+        }
+        BOOST_CATCH(...)
+        {
+          destroy_bucket_array(new_buckets, num_buckets);
+          BOOST_RETHROW
+        }
+        BOOST_CATCH_END
+
+        for (std::size_t t = 0; t < threads; ++t) {
+          BOOST_UNORDERED_STATS_ADD(hash_calls, thread_hash_calls[t]);
+        }
+
+        destroy_bucket_array(buckets_, bucket_count_);
+        buckets_ = new_buckets;
+        set_bucket_count(num_buckets);
+        recalculate_max_load();
+        BOOST_UNORDERED_STATS_ADD(rehashes, 1);
+        BOOST_UNORDERED_STATS_ADD(rehashed_nodes, size_);
+
+        link_pointer prev = this->get_previous_start();
+        for (std::size_t p = 0; p < threads; ++p) {
+          if (heads[p]) {
+            set_next(prev, heads[p]);
+            first_buckets[p]->next_ = prev;
+            prev = tails[p];
+          }
+        }
+      }
+
+      ////////////////////////////////////////////////////////////////////////
+      // Parallel traversal
+      //
+      // Each thread visits the elements in its own range of buckets. The
+      // table isn't changed, so it's safe as long as 'f' is.
+      template <typename Types>
+      template <class Iterator, class F>
+      inline void table<Types>::for_each_parallel(
+        F& f, std::size_t threads) const
+      {
+        threads =
+          boost::unordered::detail::parallel_threads(threads, size_, 4096);
+        std::size_t count = threads ? threads : 1;
+
+        boost::unordered::detail::parallel_for(
+          count, [this, &f, count](std::size_t i) {
+            Iterator end;
+            for (Iterator it(this->range_begin(i, count)); it != end; ++it) {
+              f(*it);
+            }
+          });
+      }
+#endif
+
 #if defined(BOOST_MSVC)
 #pragma warning(pop)
 #endif
@@ -4674,14 +6869,74 @@ namespace boost {
 #undef BOOST_UNORDERED_KEY_FROM_TUPLE
       };
 
+      ////////////////////////////////////////////////////////////////////////
+      // Node hash
+      //
+      // Nodes store their hash value when 'store_hash' is true for the hash
+      // function. Otherwise this is an empty base.
+
+      template <bool StoreHash> struct node_hash
+      {
+        BOOST_STATIC_CONSTANT(bool, hash_stored = false);
+
+        void set_hash(std::size_t) {}
+        std::size_t get_hash() const { return 0; }
+      };
+
+      template <> struct node_hash<true>
+      {
+        BOOST_STATIC_CONSTANT(bool, hash_stored = true);
+
+        std::size_t hash_;
+
+        node_hash() : hash_(0) {}
+
+        void set_hash(std::size_t h) { hash_ = h; }
+        std::size_t get_hash() const { return hash_; }
+      };
+
+      ////////////////////////////////////////////////////////////////////////
+      // Node previous link
+      //
+      // When 'doubly_linked' is true for the hash function, nodes also link
+      // back to the node (or bucket) before them, so that they can be
+      // unlinked without searching the bucket.
+
+      template <typename LinkPointer, bool DoublyLinked> struct node_prev
+      {
+        BOOST_STATIC_CONSTANT(bool, doubly_linked = false);
+
+        void set_prev(LinkPointer) {}
+        LinkPointer get_prev() const { return LinkPointer(); }
+      };
+
+      template <typename LinkPointer> struct node_prev<LinkPointer, true>
+      {
+        BOOST_STATIC_CONSTANT(bool, doubly_linked = true);
+
+        LinkPointer prev_;
+
+        node_prev() : prev_() {}
+
+        void set_prev(LinkPointer p) { prev_ = p; }
+        LinkPointer get_prev() const { return prev_; }
+      };
+
       ////////////////////////////////////////////////////////////////////////
       // Unique nodes
 
-      template <typename A, typename T>
-      struct node : boost::unordered::detail::value_base<T>
+      template <typename A, typename T, bool StoreHash, bool DoublyLinked>
+      struct node
+        : boost::unordered::detail::value_base<T>,
+          boost::unordered::detail::node_hash<StoreHash>,
+          boost::unordered::detail::node_prev<
+            typename ::boost::unordered::detail::allocator_traits<
+              typename ::boost::unordered::detail::rebind_wrap<A,
+                node<A, T, StoreHash, DoublyLinked> >::type>::pointer,
+            DoublyLinked>
       {
         typedef typename ::boost::unordered::detail::rebind_wrap<A,
-          node<A, T> >::type allocator;
+          node<A, T, StoreHash, DoublyLinked> >::type allocator;
         typedef typename ::boost::unordered::detail::allocator_traits<
           allocator>::pointer node_pointer;
         typedef node_pointer link_pointer;
@@ -4719,12 +6974,16 @@ namespace boost {
         node& operator=(node const&);
       };
 
-      template <typename T>
-      struct ptr_node : boost::unordered::detail::ptr_bucket
+      template <typename T, bool StoreHash, bool DoublyLinked>
+      struct ptr_node
+        : boost::unordered::detail::ptr_bucket,
+          boost::unordered::detail::node_hash<StoreHash>,
+          boost::unordered::detail::node_prev<
+            boost::unordered::detail::ptr_bucket*, DoublyLinked>
       {
         typedef T value_type;
         typedef boost::unordered::detail::ptr_bucket bucket_base;
-        typedef ptr_node<T>* node_pointer;
+        typedef ptr_node<T, StoreHash, DoublyLinked>* node_pointer;
         typedef ptr_bucket* link_pointer;
         typedef ptr_bucket* bucket_pointer;
 
@@ -4764,10 +7023,12 @@ namespace boost {
       // If the allocator uses raw pointers use ptr_node
       // Otherwise use node.
 
-      template <typename A, typename T, typename NodePtr, typename BucketPtr>
+      template <typename A, typename T, bool StoreHash, bool DoublyLinked,
+        typename NodePtr, typename BucketPtr>
       struct pick_node2
       {
-        typedef boost::unordered::detail::node<A, T> node;
+        typedef boost::unordered::detail::node<A, T, StoreHash, DoublyLinked>
+          node;
 
         typedef typename boost::unordered::detail::allocator_traits<
           typename boost::unordered::detail::rebind_wrap<A,
@@ -4777,22 +7038,27 @@ namespace boost {
         typedef node_pointer link_pointer;
       };
 
-      template <typename A, typename T>
-      struct pick_node2<A, T, boost::unordered::detail::ptr_node<T>*,
+      template <typename A, typename T, bool StoreHash, bool DoublyLinked>
+      struct pick_node2<A, T, StoreHash, DoublyLinked,
+        boost::unordered::detail::ptr_node<T, StoreHash, DoublyLinked>*,
         boost::unordered::detail::ptr_bucket*>
       {
-        typedef boost::unordered::detail::ptr_node<T> node;
+        typedef boost::unordered::detail::ptr_node<T, StoreHash, DoublyLinked>
+          node;
         typedef boost::unordered::detail::ptr_bucket bucket;
         typedef bucket* link_pointer;
       };
 
-      template <typename A, typename T> struct pick_node
+      template <typename A, typename T, bool StoreHash = false,
+        bool DoublyLinked = false>
+      struct pick_node
       {
         typedef typename boost::remove_const<T>::type nonconst;
 
         typedef boost::unordered::detail::allocator_traits<
           typename boost::unordered::detail::rebind_wrap<A,
-            boost::unordered::detail::ptr_node<nonconst> >::type>
+            boost::unordered::detail::ptr_node<nonconst, StoreHash,
+              DoublyLinked> >::type>
           tentative_node_traits;
 
         typedef boost::unordered::detail::allocator_traits<
@@ -4800,7 +7066,8 @@ namespace boost {
             boost::unordered::detail::ptr_bucket>::type>
           tentative_bucket_traits;
 
-        typedef pick_node2<A, nonconst, typename tentative_node_traits::pointer,
+        typedef pick_node2<A, nonconst, StoreHash, DoublyLinked,
+          typename tentative_node_traits::pointer,
           typename tentative_bucket_traits::pointer>
           pick;
 
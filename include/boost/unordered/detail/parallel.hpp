@@ -0,0 +1,90 @@
+
+// Copyright (C) 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_UNORDERED_DETAIL_PARALLEL_HPP
+#define BOOST_UNORDERED_DETAIL_PARALLEL_HPP
+
+#include <boost/config.hpp>
+#if defined(BOOST_HAS_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#if defined(BOOST_NO_CXX11_HDR_THREAD) || defined(BOOST_NO_CXX11_LAMBDAS) ||  \
+  defined(BOOST_NO_CXX11_RVALUE_REFERENCES) ||                                 \
+  defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+#error "BOOST_UNORDERED_ENABLE_PARALLEL requires C++11 threads and lambdas."
+#endif
+
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace boost {
+  namespace unordered {
+    namespace detail {
+      // The number of threads to use for 'count' items, so that each thread
+      // gets at least 'min_items'. Zero requested threads means one for
+      // each core.
+      inline std::size_t parallel_threads(
+        std::size_t requested, std::size_t count, std::size_t min_items)
+      {
+        if (!requested) {
+          requested = std::thread::hardware_concurrency();
+        }
+        std::size_t max_threads = count / min_items;
+        return requested < max_threads ? requested : max_threads;
+      }
+
+      // Calls 'f(i)' for each 'i' in [0, n), each on its own thread apart
+      // from 'f(0)' which is called on the current thread. If a thread
+      // can't be started, its call is made on the current thread instead,
+      // so every call is made. Once they've all finished, rethrows the
+      // first exception, if there was one. Apart from that, it can only
+      // throw before any call has been made.
+      template <class F> void parallel_for(std::size_t n, F const& f)
+      {
+        std::vector<std::exception_ptr> errors(n);
+        std::vector<std::thread> threads;
+        std::size_t started = 1;
+
+        try {
+          threads.reserve(n - 1);
+          for (; started < n; ++started) {
+            std::size_t i = started;
+            threads.push_back(std::thread([&f, &errors, i] {
+              try {
+                f(i);
+              } catch (...) {
+                errors[i] = std::current_exception();
+              }
+            }));
+          }
+        } catch (...) {
+        }
+
+        for (std::size_t i = 0; i < n; i = i ? i + 1 : started) {
+          try {
+            f(i);
+          } catch (...) {
+            errors[i] = std::current_exception();
+          }
+        }
+
+        for (std::size_t i = 0; i < threads.size(); ++i) {
+          threads[i].join();
+        }
+
+        for (std::size_t i = 0; i < n; ++i) {
+          if (errors[i]) {
+            std::rethrow_exception(errors[i]);
+          }
+        }
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,43 @@
+
+// Copyright (C) 2017 Daniel James
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/unordered/read_mostly_unordered_map_fwd.hpp>
+#include <boost/unordered/detail/read_mostly_table.hpp>
+
+namespace boost {
+  namespace unordered {
+    namespace detail {
+      template <typename A, typename K, typename M, typename H, typename P>
+      struct read_mostly_map
+      {
+        typedef boost::unordered::detail::read_mostly_map<A, K, M, H, P> types;
+
+        typedef std::pair<K const, M> value_type;
+        typedef H hasher;
+        typedef P key_equal;
+        typedef K const const_key_type;
+
+        typedef typename ::boost::unordered::detail::rebind_wrap<A,
+          value_type>::type value_allocator;
+        typedef boost::unordered::detail::allocator_traits<value_allocator>
+          value_allocator_traits;
+
+        typedef boost::unordered::detail::read_mostly_table<types> table;
+        typedef boost::unordered::detail::map_extractor<value_type> extractor;
+
+        typedef typename boost::unordered::detail::pick_policy<K, H>::type
+          policy;
+      };
+
+      template <typename K, typename M, typename H, typename P, typename A>
+      class instantiate_read_mostly_map
+      {
+        typedef boost::unordered::read_mostly_unordered_map<K, M, H, P, A>
+          container;
+        container x;
+      };
+    }
+  }
+}
@@ -0,0 +1,690 @@
+// Copyright (C) 2017 Daniel James
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_UNORDERED_DETAIL_READ_MOSTLY_TABLE_HPP
+#define BOOST_UNORDERED_DETAIL_READ_MOSTLY_TABLE_HPP
+
+#include <boost/config.hpp>
+#if defined(BOOST_HAS_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <boost/unordered/detail/concurrent_table.hpp>
+#include <boost/unordered/detail/epoch.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Read mostly table.
+//
+// A chained hash table where lookups don't take any locks, for tables which
+// are read far more often than they're changed. Writers are serialized by a
+// single mutex.
+//
+// The bucket heads and the links between nodes are atomic pointers. A
+// writer fully constructs a node before publishing it with a release store,
+// and never changes an element once it's been published: assigning to an
+// element replaces its node. So a reader which loads the links with acquire
+// always sees complete nodes, and a bucket list which is either before or
+// after each change.
+//
+// The bucket array is also published through an atomic pointer, along with
+// its size. Growing the table copies every node into a new array, as moving
+// them would break the lists that readers might be part way through.
+//
+// Unlinked nodes and bucket arrays can't be deallocated straight away, as
+// readers might still be using them. They're put on a list, and freed in
+// batches once the epoch domain has waited for the readers that might see
+// them to finish.
+//
+// The links are stored as atomic raw pointers, so this only works with
+// allocators which use raw pointers.
+
+namespace boost {
+  namespace unordered {
+    namespace detail {
+      template <typename T> struct read_mostly_node
+      {
+        typedef T value_type;
+
+        std::atomic<read_mostly_node*> next_;
+        std::size_t hash_;
+        boost::unordered::detail::value_base<T> value_base_;
+
+        read_mostly_node() : next_(), hash_(0) {}
+
+        void* address() { return value_base_.address(); }
+        value_type& value() { return value_base_.value(); }
+        value_type* value_ptr() { return value_base_.value_ptr(); }
+
+      private:
+        read_mostly_node& operator=(read_mostly_node const&);
+      };
+
+      // A bucket array, and the values the policy needs to use it, which are
+      // published together.
+      template <typename Node> struct read_mostly_buckets
+      {
+        std::size_t bucket_count_;
+        std::size_t size_index_;
+        std::atomic<Node*>* buckets_;
+      };
+
+      template <typename Types>
+      struct read_mostly_table
+        : boost::unordered::detail::functions<typename Types::hasher,
+            typename Types::key_equal>
+      {
+      private:
+        read_mostly_table(read_mostly_table const&);
+        read_mostly_table& operator=(read_mostly_table const&);
+
+      public:
+        typedef typename Types::hasher hasher;
+        typedef typename Types::key_equal key_equal;
+        typedef typename Types::const_key_type const_key_type;
+        typedef typename Types::extractor extractor;
+        typedef typename Types::value_type value_type;
+        typedef typename Types::policy policy;
+
+        typedef boost::unordered::detail::functions<typename Types::hasher,
+          typename Types::key_equal>
+          functions;
+
+        typedef typename Types::value_allocator value_allocator;
+        typedef boost::unordered::detail::read_mostly_node<value_type> node;
+        typedef boost::unordered::detail::read_mostly_buckets<node> buckets;
+        typedef std::atomic<node*> link;
+
+        typedef typename boost::unordered::detail::rebind_wrap<value_allocator,
+          node>::type node_allocator;
+        typedef typename boost::unordered::detail::rebind_wrap<value_allocator,
+          link>::type link_allocator;
+        typedef typename boost::unordered::detail::rebind_wrap<value_allocator,
+          buckets>::type buckets_allocator;
+        typedef boost::unordered::detail::allocator_traits<node_allocator>
+          node_allocator_traits;
+        typedef boost::unordered::detail::allocator_traits<link_allocator>
+          link_allocator_traits;
+        typedef boost::unordered::detail::allocator_traits<buckets_allocator>
+          buckets_allocator_traits;
+        typedef boost::unordered::detail::node_tmp<node_allocator> node_tmp;
+
+        BOOST_STATIC_ASSERT_MSG(
+          (boost::is_same<typename node_allocator_traits::pointer,
+            node*>::value),
+          "The read mostly containers require an allocator with raw pointers.");
+
+        // The number of unlinked nodes to collect before waiting for the
+        // readers and deallocating them.
+        static const std::size_t reclaim_batch = 64;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Members
+
+        boost::unordered::detail::compressed<link_allocator, node_allocator>
+          allocators_;
+        boost::unordered::detail::epoch_domain epochs_;
+        std::atomic<buckets*> buckets_;
+        std::atomic<std::size_t> size_;
+
+        // Only used by writers, with 'write_mutex_' locked.
+        mutable std::mutex write_mutex_;
+        float mlf_;
+        std::size_t max_load_;
+        std::vector<node*> retired_nodes_;
+        std::vector<buckets*> retired_buckets_;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Data access
+
+        link_allocator const& link_alloc() const { return allocators_.first(); }
+
+        node_allocator const& node_alloc() const
+        {
+          return allocators_.second();
+        }
+
+        link_allocator& link_alloc() { return allocators_.first(); }
+
+        node_allocator& node_alloc() { return allocators_.second(); }
+
+        std::size_t hash(const_key_type& k) const
+        {
+          return policy::apply_hash(this->hash_function(), k);
+        }
+
+        std::size_t size() const
+        {
+          return size_.load(std::memory_order_relaxed);
+        }
+
+        std::size_t max_bucket_count() const
+        {
+          return policy::prev_bucket_count(
+            link_allocator_traits::max_size(link_alloc()));
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Load methods
+
+        void recalculate_max_load()
+        {
+          using namespace std;
+
+          max_load_ = boost::unordered::detail::double_to_size(
+            ceil(static_cast<double>(mlf_) *
+                 static_cast<double>(
+                   buckets_.load(std::memory_order_relaxed)->bucket_count_)));
+        }
+
+        std::size_t min_buckets_for_size(std::size_t size) const
+        {
+          using namespace std;
+
+          return policy::new_bucket_count(
+            boost::unordered::detail::double_to_size(
+              floor(static_cast<double>(size) / static_cast<double>(mlf_)) +
+              1));
+        }
+
+        float max_load_factor() const
+        {
+          std::lock_guard<std::mutex> lock(write_mutex_);
+          return mlf_;
+        }
+
+        void max_load_factor(float z)
+        {
+          BOOST_ASSERT(z > 0);
+          std::lock_guard<std::mutex> lock(write_mutex_);
+          mlf_ = (std::max)(z, minimum_max_load_factor);
+          recalculate_max_load();
+        }
+
+        // The bucket array can be reclaimed once the reader has finished
+        // with it, so these have to enter the epoch.
+
+        float load_factor() const
+        {
+          boost::unordered::detail::epoch_guard guard(epochs_);
+          return static_cast<float>(size()) /
+                 static_cast<float>(
+                   buckets_.load(std::memory_order_acquire)->bucket_count_);
+        }
+
+        std::size_t bucket_count() const
+        {
+          boost::unordered::detail::epoch_guard guard(epochs_);
+          return buckets_.load(std::memory_order_acquire)->bucket_count_;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructors
+
+        read_mostly_table(std::size_t num_buckets, hasher const& hf,
+          key_equal const& eq, value_allocator const& a)
+            : functions(hf, eq), allocators_(a, a),
+              epochs_(concurrent_stripe_count()), buckets_(), size_(0),
+              mlf_(1.0f), max_load_(0)
+        {
+          buckets_.store(create_buckets(policy::new_bucket_count(num_buckets)),
+            std::memory_order_relaxed);
+          recalculate_max_load();
+        }
+
+        // Copies 'x' with its writer's lock held, putting the nodes in the
+        // same buckets.
+        read_mostly_table(read_mostly_table const& x, value_allocator const& a)
+            : functions(x), allocators_(a, a),
+              epochs_(concurrent_stripe_count()), buckets_(), size_(0),
+              mlf_(x.mlf_), max_load_(0)
+        {
+          std::lock_guard<std::mutex> lock(x.write_mutex_);
+          buckets* src = x.buckets_.load(std::memory_order_relaxed);
+          buckets* dst = create_buckets(src->bucket_count_);
+
+          BOOST_TRY
+          {
+            for (std::size_t i = 0; i < src->bucket_count_; ++i) {
+              link* prev = dst->buckets_ + i;
+              for (node* n = src->buckets_[i].load(std::memory_order_relaxed);
+                   n; n = n->next_.load(std::memory_order_relaxed)) {
+                node* copy = boost::unordered::detail::func::construct_node(
+                  node_alloc(), n->value());
+                copy->hash_ = n->hash_;
+                prev->store(copy, std::memory_order_relaxed);
+                prev = &copy->next_;
+                size_.fetch_add(1, std::memory_order_relaxed);
+              }
+            }
+          }
+          BOOST_CATCH(...)
+          {
+            delete_buckets(dst);
+            BOOST_RETHROW
+          }
+          BOOST_CATCH_END
+
+          buckets_.store(dst, std::memory_order_relaxed);
+          recalculate_max_load();
+        }
+
+        // There mustn't be any readers left, so everything can be
+        // deallocated straight away.
+        ~read_mostly_table()
+        {
+          delete_retired();
+          delete_buckets(buckets_.load(std::memory_order_relaxed));
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Bucket arrays
+
+        buckets* create_buckets(std::size_t count)
+        {
+          buckets_allocator alloc(node_alloc());
+          buckets* b = buckets_allocator_traits::allocate(alloc, 1);
+
+          BOOST_TRY
+          {
+            b->buckets_ = link_allocator_traits::allocate(link_alloc(), count);
+          }
+          BOOST_CATCH(...)
+          {
+            buckets_allocator_traits::deallocate(alloc, b, 1);
+            BOOST_RETHROW
+          }
+          BOOST_CATCH_END
+
+          for (std::size_t i = 0; i < count; ++i) {
+            new (b->buckets_ + i) link();
+            b->buckets_[i].store(0, std::memory_order_relaxed);
+          }
+          b->bucket_count_ = count;
+          b->size_index_ = policy::size_index(count);
+          return b;
+        }
+
+        void delete_node(node* n)
+        {
+          node_tmp tmp(n, node_alloc());
+        }
+
+        // Deletes a bucket array, along with any nodes still in it.
+        void delete_buckets(buckets* b)
+        {
+          for (std::size_t i = 0; i < b->bucket_count_; ++i) {
+            node* n = b->buckets_[i].load(std::memory_order_relaxed);
+            while (n) {
+              node* next = n->next_.load(std::memory_order_relaxed);
+              delete_node(n);
+              n = next;
+            }
+            boost::unordered::detail::func::destroy(b->buckets_ + i);
+          }
+          link_allocator_traits::deallocate(
+            link_alloc(), b->buckets_, b->bucket_count_);
+          buckets_allocator alloc(node_alloc());
+          buckets_allocator_traits::deallocate(alloc, b, 1);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Reclamation, with the writer's lock held
+
+        // Defers deleting a node that has just been unlinked. If there's no
+        // room to remember it, waits for the readers and deletes it now.
+        void retire(node* n)
+        {
+          BOOST_TRY { retired_nodes_.push_back(n); }
+          BOOST_CATCH(...)
+          {
+            epochs_.synchronize();
+            delete_node(n);
+          }
+          BOOST_CATCH_END
+        }
+
+        void retire(buckets* b)
+        {
+          BOOST_TRY { retired_buckets_.push_back(b); }
+          BOOST_CATCH(...)
+          {
+            epochs_.synchronize();
+            delete_buckets(b);
+          }
+          BOOST_CATCH_END
+        }
+
+        void delete_retired()
+        {
+          for (std::size_t i = 0; i < retired_nodes_.size(); ++i) {
+            delete_node(retired_nodes_[i]);
+          }
+          retired_nodes_.clear();
+          for (std::size_t i = 0; i < retired_buckets_.size(); ++i) {
+            delete_buckets(retired_buckets_[i]);
+          }
+          retired_buckets_.clear();
+        }
+
+        // Bucket arrays are large, so they're always reclaimed straight
+        // away.
+        void reclaim()
+        {
+          if (retired_buckets_.size() ||
+              retired_nodes_.size() >= reclaim_batch) {
+            epochs_.synchronize();
+            delete_retired();
+          }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Rehash, with the writer's lock held
+        //
+        // Copies the nodes to the new buckets, the old ones are reclaimed
+        // along with their bucket array. If a copy throws, the table is
+        // unchanged.
+
+        void rehash_impl(std::size_t num_buckets)
+        {
+          buckets* old = buckets_.load(std::memory_order_relaxed);
+          buckets* b = create_buckets(num_buckets);
+
+          BOOST_TRY
+          {
+            for (std::size_t i = 0; i < old->bucket_count_; ++i) {
+              for (node* n = old->buckets_[i].load(std::memory_order_relaxed);
+                   n; n = n->next_.load(std::memory_order_relaxed)) {
+                node* copy = boost::unordered::detail::func::construct_node(
+                  node_alloc(), n->value());
+                copy->hash_ = n->hash_;
+                link& head =
+                  b->buckets_[policy::position(b->size_index_, n->hash_)];
+                copy->next_.store(
+                  head.load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+                head.store(copy, std::memory_order_relaxed);
+              }
+            }
+          }
+          BOOST_CATCH(...)
+          {
+            delete_buckets(b);
+            BOOST_RETHROW
+          }
+          BOOST_CATCH_END
+
+          buckets_.store(b, std::memory_order_release);
+          recalculate_max_load();
+          retire(old);
+          reclaim();
+        }
+
+        void rehash(std::size_t min_buckets)
+        {
+          std::lock_guard<std::mutex> lock(write_mutex_);
+          std::size_t num_buckets = (std::max)(min_buckets_for_size(size()),
+            policy::new_bucket_count(min_buckets));
+          if (num_buckets !=
+              buckets_.load(std::memory_order_relaxed)->bucket_count_) {
+            rehash_impl(num_buckets);
+          }
+        }
+
+        void reserve(std::size_t count)
+        {
+          using namespace std;
+
+          rehash(boost::unordered::detail::double_to_size(
+            ceil(static_cast<double>(count) / static_cast<double>(mlf_))));
+        }
+
+        void reserve_for_insert()
+        {
+          std::size_t size = this->size();
+          if (size >= max_load_) {
+            std::size_t num_buckets =
+              min_buckets_for_size((std::max)(size + 1, size + (size >> 1)));
+            if (num_buckets >
+                buckets_.load(std::memory_order_relaxed)->bucket_count_) {
+              rehash_impl(num_buckets);
+            } else {
+              // Can't grow any further.
+              max_load_ = (std::numeric_limits<std::size_t>::max)();
+            }
+          }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Lookup
+
+        // Called by readers inside an epoch.
+        node* find_node(
+          buckets const* b, std::size_t key_hash, const_key_type& k) const
+        {
+          for (node* n = b->buckets_[policy::position(b->size_index_, key_hash)]
+                           .load(std::memory_order_acquire);
+               n; n = n->next_.load(std::memory_order_acquire)) {
+            if (n->hash_ == key_hash &&
+                this->key_eq()(k, extractor::extract(n->value()))) {
+              return n;
+            }
+          }
+          return 0;
+        }
+
+        // Called by writers, returns the link which points to the node for
+        // 'k', or null if there isn't one.
+        link* find_link(std::size_t key_hash, const_key_type& k)
+        {
+          buckets* b = buckets_.load(std::memory_order_relaxed);
+          link* prev = b->buckets_ + policy::position(b->size_index_, key_hash);
+          for (node* n; (n = prev->load(std::memory_order_relaxed)) != 0;
+               prev = &n->next_) {
+            if (n->hash_ == key_hash &&
+                this->key_eq()(k, extractor::extract(n->value()))) {
+              return prev;
+            }
+          }
+          return 0;
+        }
+
+        // Publishes a new node at the start of its bucket.
+        void add_node(node* n, std::size_t key_hash)
+        {
+          buckets* b = buckets_.load(std::memory_order_relaxed);
+          link& head = b->buckets_[policy::position(b->size_index_, key_hash)];
+          n->hash_ = key_hash;
+          n->next_.store(
+            head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+          head.store(n, std::memory_order_release);
+          size_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Publishes 'n' in place of the node that 'prev' points to.
+        void replace_node(link* prev, node* n)
+        {
+          node* old = prev->load(std::memory_order_relaxed);
+          n->hash_ = old->hash_;
+          n->next_.store(old->next_.load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+          prev->store(n, std::memory_order_release);
+          retire(old);
+          reclaim();
+        }
+
+        void unlink_node(link* prev)
+        {
+          node* n = prev->load(std::memory_order_relaxed);
+          prev->store(n->next_.load(std::memory_order_relaxed),
+            std::memory_order_release);
+          size_.fetch_sub(1, std::memory_order_relaxed);
+          retire(n);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Visitation, without any locks
+
+        template <class F>
+        std::size_t visit(const_key_type& k, F&& f) const
+        {
+          std::size_t key_hash = this->hash(k);
+          boost::unordered::detail::epoch_guard guard(epochs_);
+          node* n = find_node(
+            buckets_.load(std::memory_order_acquire), key_hash, k);
+          if (n) {
+            f(static_cast<value_type const&>(n->value()));
+          }
+          return n ? 1 : 0;
+        }
+
+        // Stays in the epoch for the whole traversal, so a long visit will
+        // hold up reclamation.
+        template <class F> std::size_t visit_all(F&& f) const
+        {
+          std::size_t count = 0;
+          boost::unordered::detail::epoch_guard guard(epochs_);
+          buckets* b = buckets_.load(std::memory_order_acquire);
+          for (std::size_t i = 0; i < b->bucket_count_; ++i) {
+            for (node* n = b->buckets_[i].load(std::memory_order_acquire); n;
+                 n = n->next_.load(std::memory_order_acquire)) {
+              f(static_cast<value_type const&>(n->value()));
+              ++count;
+            }
+          }
+          return count;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Insert
+
+        // Inserts the node returned by 'construct' if there isn't an element
+        // for 'k'.
+        template <class Construct>
+        bool insert_impl(const_key_type& k, Construct const& construct)
+        {
+          std::size_t key_hash = this->hash(k);
+          std::lock_guard<std::mutex> lock(write_mutex_);
+          if (find_link(key_hash, k)) {
+            return false;
+          }
+          reserve_for_insert();
+          add_node(construct(), key_hash);
+          return true;
+        }
+
+        template <class... Args> bool emplace(Args&&... args)
+        {
+          std::lock_guard<std::mutex> lock(write_mutex_);
+          node_tmp b(boost::unordered::detail::func::construct_node_from_args(
+                       node_alloc(), boost::forward<Args>(args)...),
+            node_alloc());
+          const_key_type& k = extractor::extract(b.node_->value());
+          std::size_t key_hash = this->hash(k);
+          if (find_link(key_hash, k)) {
+            return false;
+          }
+          reserve_for_insert();
+          add_node(b.release(), key_hash);
+          return true;
+        }
+
+        template <class Key, class... Args>
+        bool try_emplace(Key&& k, Args&&... args)
+        {
+          return insert_impl(k, [&] {
+            return boost::unordered::detail::func::construct_node_from_args(
+              this->node_alloc(), boost::unordered::piecewise_construct,
+              std::forward_as_tuple(boost::forward<Key>(k)),
+              std::forward_as_tuple(boost::forward<Args>(args)...));
+          });
+        }
+
+        template <class V> bool insert(V&& v)
+        {
+          return insert_impl(extractor::extract(v), [&] {
+            return boost::unordered::detail::func::construct_node(
+              this->node_alloc(), boost::forward<V>(v));
+          });
+        }
+
+        // Replaces an existing element's node, so that readers never see a
+        // partly assigned value.
+        template <class Key, class M> bool insert_or_assign(Key&& k, M&& obj)
+        {
+          std::size_t key_hash = this->hash(k);
+          std::lock_guard<std::mutex> lock(write_mutex_);
+          link* prev = find_link(key_hash, k);
+          if (!prev) {
+            reserve_for_insert();
+          }
+          node* n = boost::unordered::detail::func::construct_node_from_args(
+            node_alloc(), boost::unordered::piecewise_construct,
+            std::forward_as_tuple(boost::forward<Key>(k)),
+            std::forward_as_tuple(boost::forward<M>(obj)));
+          if (prev) {
+            replace_node(prev, n);
+            return false;
+          }
+          add_node(n, key_hash);
+          return true;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Erase
+
+        std::size_t erase(const_key_type& k)
+        {
+          std::size_t key_hash = this->hash(k);
+          std::lock_guard<std::mutex> lock(write_mutex_);
+          link* prev = find_link(key_hash, k);
+          if (!prev) {
+            return 0;
+          }
+          unlink_node(prev);
+          reclaim();
+          return 1;
+        }
+
+        template <class F> std::size_t erase_if(F&& f)
+        {
+          std::size_t count = 0;
+          std::lock_guard<std::mutex> lock(write_mutex_);
+          buckets* b = buckets_.load(std::memory_order_relaxed);
+          for (std::size_t i = 0; i < b->bucket_count_; ++i) {
+            link* prev = b->buckets_ + i;
+            for (node* n; (n = prev->load(std::memory_order_relaxed)) != 0;) {
+              if (f(static_cast<value_type const&>(n->value()))) {
+                unlink_node(prev);
+                ++count;
+              } else {
+                prev = &n->next_;
+              }
+            }
+          }
+          reclaim();
+          return count;
+        }
+
+        // Publishes an empty bucket array, and reclaims the old one along
+        // with its nodes.
+        void clear()
+        {
+          std::lock_guard<std::mutex> lock(write_mutex_);
+          buckets* old = buckets_.load(std::memory_order_relaxed);
+          buckets_.store(
+            create_buckets(old->bucket_count_), std::memory_order_release);
+          size_.store(0, std::memory_order_relaxed);
+          retire(old);
+          reclaim();
+        }
+      };
+    }
+  }
+}
+
+#endif
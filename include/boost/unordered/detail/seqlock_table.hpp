@@ -0,0 +1,730 @@
+
+// Copyright (C) 2017 Daniel James
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_UNORDERED_DETAIL_SEQLOCK_TABLE_HPP
+#define BOOST_UNORDERED_DETAIL_SEQLOCK_TABLE_HPP
+
+#include <boost/config.hpp>
+#if defined(BOOST_HAS_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <boost/unordered/detail/implementation.hpp>
+
+#if defined(BOOST_NO_CXX11_HDR_THREAD) || defined(BOOST_NO_CXX11_HDR_MUTEX) || \
+  defined(BOOST_NO_CXX11_HDR_ATOMIC) || defined(BOOST_NO_CXX11_LAMBDAS) ||     \
+  defined(BOOST_NO_CXX11_RVALUE_REFERENCES) ||                                 \
+  defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+#error "The concurrent containers require C++11 threads and atomics."
+#endif
+
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/aligned_storage.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <boost/type_traits/has_trivial_copy.hpp>
+#include <boost/type_traits/has_trivial_destructor.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Seqlock table.
+//
+// A chained hash table for one writer and many readers, where readers don't
+// write to shared memory at all. Every change is made between two
+// increments of a sequence counter, so the counter is odd while the table
+// is being changed. A reader loads the counter, searches the table, and
+// then checks that the counter hasn't changed, starting again if it has.
+//
+// A reader can be part way through reading a node while the writer changes
+// or erases it, so:
+//
+// - The keys and mapped values are stored in arrays of atomic words, which
+//   the reader copies with relaxed loads, and only uses once the counter
+//   has been checked. So they have to be trivially copyable. That includes
+//   the key passed to 'key_eq', so it's never called with a torn copy.
+//
+// - Nodes are never deallocated while the table exists. Erased nodes go on
+//   a free list to be reused by later inserts, so the memory a reader
+//   might be looking at is always a node.
+//
+// - Bucket arrays are published along with their size, and when the table
+//   is rehashed, the old ones are kept until it's destroyed. As the bucket
+//   count grows geometrically, they take up less memory than the current
+//   one.
+//
+// The counter is updated as in Hans Boehm's "Can seqlocks get along with
+// programming language memory models?": the writer makes it odd, and then
+// issues a release fence before making its changes, and the reader issues
+// an acquire fence before checking it.
+//
+// Writers are serialized by a mutex, but the table is designed for a single
+// writer thread, as each change makes the readers start again.
+
+namespace boost {
+  namespace unordered {
+    namespace detail {
+      // Stores a trivially copyable object in atomic words.
+      template <typename T> struct seqlock_value
+      {
+        BOOST_STATIC_ASSERT_MSG(boost::has_trivial_copy<T>::value &&
+                                  boost::has_trivial_destructor<T>::value,
+          "The seqlock containers require trivially copyable types.");
+
+        static const std::size_t word_count =
+          (sizeof(T) + sizeof(std::size_t) - 1) / sizeof(std::size_t);
+
+        // Somewhere to copy a T to, which doesn't need it to be default
+        // constructible.
+        typedef typename boost::aligned_storage<sizeof(T),
+          boost::alignment_of<T>::value>::type buffer;
+
+        std::atomic<std::size_t> words_[word_count];
+
+        void store(T const& x)
+        {
+          std::size_t words[word_count] = {};
+          std::memcpy(words, boost::addressof(x), sizeof(T));
+          for (std::size_t i = 0; i < word_count; ++i) {
+            words_[i].store(words[i], std::memory_order_relaxed);
+          }
+        }
+
+        // The result is only meaningful if the sequence counter didn't
+        // change while it was copied.
+        T const& load(buffer& b) const
+        {
+          std::size_t words[word_count];
+          for (std::size_t i = 0; i < word_count; ++i) {
+            words[i] = words_[i].load(std::memory_order_relaxed);
+          }
+          std::memcpy(b.address(), words, sizeof(T));
+          return *static_cast<T const*>(b.address());
+        }
+      };
+
+      template <typename K, typename M> struct seqlock_node
+      {
+        std::atomic<seqlock_node*> next_;
+        std::atomic<std::size_t> hash_;
+        seqlock_value<K> key_;
+        seqlock_value<M> mapped_;
+
+        seqlock_node() : next_(), hash_(0) {}
+
+      private:
+        seqlock_node(seqlock_node const&);
+        seqlock_node& operator=(seqlock_node const&);
+      };
+
+      // A bucket array and its size, which never change once published.
+      template <typename Node> struct seqlock_buckets
+      {
+        std::size_t bucket_count_;
+        std::size_t size_index_;
+        std::atomic<Node*>* buckets_;
+      };
+
+      template <typename Types>
+      struct seqlock_table
+        : boost::unordered::detail::functions<typename Types::hasher,
+            typename Types::key_equal>
+      {
+      private:
+        seqlock_table(seqlock_table const&);
+        seqlock_table& operator=(seqlock_table const&);
+
+      public:
+        typedef typename Types::hasher hasher;
+        typedef typename Types::key_equal key_equal;
+        typedef typename Types::key_type key_type;
+        typedef typename Types::mapped_type mapped_type;
+        typedef typename Types::value_type value_type;
+        typedef typename Types::policy policy;
+
+        typedef boost::unordered::detail::functions<typename Types::hasher,
+          typename Types::key_equal>
+          functions;
+
+        typedef typename Types::value_allocator value_allocator;
+        typedef boost::unordered::detail::seqlock_node<key_type, mapped_type>
+          node;
+        typedef boost::unordered::detail::seqlock_buckets<node> buckets;
+        typedef std::atomic<node*> link;
+        typedef typename seqlock_value<key_type>::buffer key_buffer;
+        typedef typename seqlock_value<mapped_type>::buffer mapped_buffer;
+
+        typedef typename boost::unordered::detail::rebind_wrap<value_allocator,
+          node>::type node_allocator;
+        typedef typename boost::unordered::detail::rebind_wrap<value_allocator,
+          link>::type link_allocator;
+        typedef typename boost::unordered::detail::rebind_wrap<value_allocator,
+          buckets>::type buckets_allocator;
+        typedef boost::unordered::detail::allocator_traits<node_allocator>
+          node_allocator_traits;
+        typedef boost::unordered::detail::allocator_traits<link_allocator>
+          link_allocator_traits;
+        typedef boost::unordered::detail::allocator_traits<buckets_allocator>
+          buckets_allocator_traits;
+
+        BOOST_STATIC_ASSERT_MSG(
+          (boost::is_same<typename node_allocator_traits::pointer,
+            node*>::value),
+          "The seqlock containers require an allocator with raw pointers.");
+
+        ////////////////////////////////////////////////////////////////////////
+        // Members
+
+        boost::unordered::detail::compressed<link_allocator, node_allocator>
+          allocators_;
+        std::atomic<std::size_t> sequence_;
+        std::atomic<buckets*> buckets_;
+        std::atomic<std::size_t> size_;
+
+        // Only used by writers, with 'write_mutex_' locked.
+        mutable std::mutex write_mutex_;
+        float mlf_;
+        std::size_t max_load_;
+        node* free_nodes_;
+        std::size_t allocated_nodes_;
+        std::vector<buckets*> old_buckets_;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Data access
+
+        link_allocator const& link_alloc() const { return allocators_.first(); }
+
+        node_allocator const& node_alloc() const
+        {
+          return allocators_.second();
+        }
+
+        link_allocator& link_alloc() { return allocators_.first(); }
+
+        node_allocator& node_alloc() { return allocators_.second(); }
+
+        std::size_t hash(key_type const& k) const
+        {
+          return policy::apply_hash(this->hash_function(), k);
+        }
+
+        std::size_t size() const
+        {
+          return size_.load(std::memory_order_relaxed);
+        }
+
+        std::size_t max_bucket_count() const
+        {
+          return policy::prev_bucket_count(
+            link_allocator_traits::max_size(link_alloc()));
+        }
+
+        // Published bucket arrays are never changed or deallocated, so these
+        // don't need to check the sequence counter.
+
+        std::size_t bucket_count() const
+        {
+          return buckets_.load(std::memory_order_acquire)->bucket_count_;
+        }
+
+        float load_factor() const
+        {
+          return static_cast<float>(size()) /
+                 static_cast<float>(bucket_count());
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Load methods
+
+        void recalculate_max_load()
+        {
+          using namespace std;
+
+          max_load_ = boost::unordered::detail::double_to_size(
+            ceil(static_cast<double>(mlf_) *
+                 static_cast<double>(
+                   buckets_.load(std::memory_order_relaxed)->bucket_count_)));
+        }
+
+        std::size_t min_buckets_for_size(std::size_t size) const
+        {
+          using namespace std;
+
+          return policy::new_bucket_count(
+            boost::unordered::detail::double_to_size(
+              floor(static_cast<double>(size) / static_cast<double>(mlf_)) +
+              1));
+        }
+
+        float max_load_factor() const
+        {
+          std::lock_guard<std::mutex> lock(write_mutex_);
+          return mlf_;
+        }
+
+        void max_load_factor(float z)
+        {
+          BOOST_ASSERT(z > 0);
+          std::lock_guard<std::mutex> lock(write_mutex_);
+          mlf_ = (std::max)(z, minimum_max_load_factor);
+          recalculate_max_load();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructors
+
+        seqlock_table(std::size_t num_buckets, hasher const& hf,
+          key_equal const& eq, value_allocator const& a)
+            : functions(hf, eq), allocators_(a, a), sequence_(0), buckets_(),
+              size_(0), mlf_(1.0f), max_load_(0), free_nodes_(0),
+              allocated_nodes_(0)
+        {
+          buckets_.store(create_buckets(policy::new_bucket_count(num_buckets)),
+            std::memory_order_relaxed);
+          recalculate_max_load();
+        }
+
+        // Copies 'x' with its writer's lock held. Only the elements are
+        // copied, not the free nodes.
+        seqlock_table(seqlock_table const& x, value_allocator const& a)
+            : functions(x), allocators_(a, a), sequence_(0), buckets_(),
+              size_(0), mlf_(x.mlf_), max_load_(0), free_nodes_(0),
+              allocated_nodes_(0)
+        {
+          std::lock_guard<std::mutex> lock(x.write_mutex_);
+          buckets* src = x.buckets_.load(std::memory_order_relaxed);
+          buckets_.store(
+            create_buckets(src->bucket_count_), std::memory_order_relaxed);
+          recalculate_max_load();
+
+          BOOST_TRY
+          {
+            key_buffer k;
+            mapped_buffer m;
+            for (std::size_t i = 0; i < src->bucket_count_; ++i) {
+              for (node* n = src->buckets_[i].load(std::memory_order_relaxed);
+                   n; n = n->next_.load(std::memory_order_relaxed)) {
+                node* copy = allocate_node();
+                copy->key_.store(n->key_.load(k));
+                copy->mapped_.store(n->mapped_.load(m));
+                add_node(copy, n->hash_.load(std::memory_order_relaxed));
+              }
+            }
+          }
+          BOOST_CATCH(...)
+          {
+            delete_all();
+            BOOST_RETHROW
+          }
+          BOOST_CATCH_END
+        }
+
+        ~seqlock_table() { delete_all(); }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Memory
+
+        buckets* create_buckets(std::size_t count)
+        {
+          buckets_allocator alloc(node_alloc());
+          buckets* b = buckets_allocator_traits::allocate(alloc, 1);
+
+          BOOST_TRY
+          {
+            b->buckets_ = link_allocator_traits::allocate(link_alloc(), count);
+          }
+          BOOST_CATCH(...)
+          {
+            buckets_allocator_traits::deallocate(alloc, b, 1);
+            BOOST_RETHROW
+          }
+          BOOST_CATCH_END
+
+          for (std::size_t i = 0; i < count; ++i) {
+            new (b->buckets_ + i) link();
+            b->buckets_[i].store(0, std::memory_order_relaxed);
+          }
+          b->bucket_count_ = count;
+          b->size_index_ = policy::size_index(count);
+          return b;
+        }
+
+        void delete_buckets(buckets* b)
+        {
+          for (std::size_t i = 0; i < b->bucket_count_; ++i) {
+            boost::unordered::detail::func::destroy(b->buckets_ + i);
+          }
+          link_allocator_traits::deallocate(
+            link_alloc(), b->buckets_, b->bucket_count_);
+          buckets_allocator alloc(node_alloc());
+          buckets_allocator_traits::deallocate(alloc, b, 1);
+        }
+
+        // Takes a node from the free list, or allocates one. Call before
+        // starting a write, as it can throw.
+        node* allocate_node()
+        {
+          if (free_nodes_) {
+            node* n = free_nodes_;
+            free_nodes_ = n->next_.load(std::memory_order_relaxed);
+            return n;
+          }
+          node* n = node_allocator_traits::allocate(node_alloc(), 1);
+          new (n) node();
+          ++allocated_nodes_;
+          return n;
+        }
+
+        // Puts a node on the free list. Readers might still be looking at
+        // it, so it isn't deallocated.
+        void free_node(node* n)
+        {
+          n->next_.store(free_nodes_, std::memory_order_relaxed);
+          free_nodes_ = n;
+        }
+
+        // Called when there can't be any readers, deallocates everything.
+        void delete_all()
+        {
+          buckets* b = buckets_.load(std::memory_order_relaxed);
+          if (b) {
+            for (std::size_t i = 0; i < b->bucket_count_; ++i) {
+              node* n = b->buckets_[i].load(std::memory_order_relaxed);
+              while (n) {
+                node* next = n->next_.load(std::memory_order_relaxed);
+                free_node(n);
+                n = next;
+              }
+            }
+            delete_buckets(b);
+            buckets_.store(0, std::memory_order_relaxed);
+          }
+          for (std::size_t i = 0; i < old_buckets_.size(); ++i) {
+            delete_buckets(old_buckets_[i]);
+          }
+          old_buckets_.clear();
+          while (free_nodes_) {
+            node* n = free_nodes_;
+            free_nodes_ = n->next_.load(std::memory_order_relaxed);
+            boost::unordered::detail::func::destroy(n);
+            node_allocator_traits::deallocate(node_alloc(), n, 1);
+          }
+          allocated_nodes_ = 0;
+          size_.store(0, std::memory_order_relaxed);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Writing, with the writer's lock held
+
+        // Makes the sequence counter odd, so that readers will start again.
+        void begin_write()
+        {
+          std::size_t sequence = sequence_.load(std::memory_order_relaxed);
+          BOOST_ASSERT(!(sequence & 1));
+          sequence_.store(sequence + 1, std::memory_order_relaxed);
+          std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        void end_write()
+        {
+          sequence_.store(sequence_.load(std::memory_order_relaxed) + 1,
+            std::memory_order_release);
+        }
+
+        // Keeps the sequence counter odd for its lifetime.
+        struct write_guard
+        {
+          seqlock_table& table_;
+
+          explicit write_guard(seqlock_table& t) : table_(t)
+          {
+            table_.begin_write();
+          }
+
+          ~write_guard() { table_.end_write(); }
+
+        private:
+          write_guard& operator=(write_guard const&);
+        };
+
+        // Call before a write that might add a node.
+        void reserve_for_insert()
+        {
+          std::size_t size = this->size();
+          if (size >= max_load_) {
+            std::size_t num_buckets =
+              min_buckets_for_size((std::max)(size + 1, size + (size >> 1)));
+            if (num_buckets >
+                buckets_.load(std::memory_order_relaxed)->bucket_count_) {
+              rehash_impl(num_buckets);
+            } else {
+              // Can't grow any further.
+              max_load_ = (std::numeric_limits<std::size_t>::max)();
+            }
+          }
+        }
+
+        // Moves the nodes to a new bucket array in a single write. The old
+        // array is kept, as readers might still be using it. Only the
+        // allocation can throw.
+        void rehash_impl(std::size_t num_buckets)
+        {
+          buckets* old = buckets_.load(std::memory_order_relaxed);
+          old_buckets_.reserve(old_buckets_.size() + 1);
+          buckets* b = create_buckets(num_buckets);
+
+          write_guard guard(*this);
+          for (std::size_t i = 0; i < old->bucket_count_; ++i) {
+            node* n = old->buckets_[i].load(std::memory_order_relaxed);
+            old->buckets_[i].store(0, std::memory_order_relaxed);
+            while (n) {
+              node* next = n->next_.load(std::memory_order_relaxed);
+              link& head = b->buckets_[policy::position(
+                b->size_index_, n->hash_.load(std::memory_order_relaxed))];
+              n->next_.store(
+                head.load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+              head.store(n, std::memory_order_relaxed);
+              n = next;
+            }
+          }
+          buckets_.store(b, std::memory_order_release);
+          old_buckets_.push_back(old);
+          recalculate_max_load();
+        }
+
+        void rehash(std::size_t min_buckets)
+        {
+          std::lock_guard<std::mutex> lock(write_mutex_);
+          std::size_t num_buckets = (std::max)(min_buckets_for_size(size()),
+            policy::new_bucket_count(min_buckets));
+          if (num_buckets !=
+              buckets_.load(std::memory_order_relaxed)->bucket_count_) {
+            rehash_impl(num_buckets);
+          }
+        }
+
+        void reserve(std::size_t count)
+        {
+          using namespace std;
+
+          rehash(boost::unordered::detail::double_to_size(
+            ceil(static_cast<double>(count) / static_cast<double>(mlf_))));
+        }
+
+        // Returns the link which points to the node for 'k', or null.
+        link* find_link(std::size_t key_hash, key_type const& k)
+        {
+          key_buffer buffer;
+          buckets* b = buckets_.load(std::memory_order_relaxed);
+          link* prev = b->buckets_ + policy::position(b->size_index_, key_hash);
+          for (node* n; (n = prev->load(std::memory_order_relaxed)) != 0;
+               prev = &n->next_) {
+            if (n->hash_.load(std::memory_order_relaxed) == key_hash &&
+                this->key_eq()(k, n->key_.load(buffer))) {
+              return prev;
+            }
+          }
+          return 0;
+        }
+
+        // Call inside a write.
+        void add_node(node* n, std::size_t key_hash)
+        {
+          buckets* b = buckets_.load(std::memory_order_relaxed);
+          link& head = b->buckets_[policy::position(b->size_index_, key_hash)];
+          n->hash_.store(key_hash, std::memory_order_relaxed);
+          n->next_.store(
+            head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+          head.store(n, std::memory_order_relaxed);
+          size_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Inserts 'k' and 'm' if there isn't an element for 'k', otherwise
+        // assigns 'm' to the existing element if 'assign' is true. Returns
+        // true if it inserted.
+        bool insert_impl(key_type const& k, mapped_type const& m, bool assign)
+        {
+          std::size_t key_hash = this->hash(k);
+          std::lock_guard<std::mutex> lock(write_mutex_);
+          link* prev = find_link(key_hash, k);
+          if (prev) {
+            if (assign) {
+              write_guard guard(*this);
+              prev->load(std::memory_order_relaxed)->mapped_.store(m);
+            }
+            return false;
+          }
+
+          reserve_for_insert();
+          node* n = allocate_node();
+          write_guard guard(*this);
+          n->key_.store(k);
+          n->mapped_.store(m);
+          add_node(n, key_hash);
+          return true;
+        }
+
+        std::size_t erase(key_type const& k)
+        {
+          std::size_t key_hash = this->hash(k);
+          std::lock_guard<std::mutex> lock(write_mutex_);
+          link* prev = find_link(key_hash, k);
+          if (!prev) {
+            return 0;
+          }
+          write_guard guard(*this);
+          node* n = prev->load(std::memory_order_relaxed);
+          prev->store(n->next_.load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+          free_node(n);
+          size_.fetch_sub(1, std::memory_order_relaxed);
+          return 1;
+        }
+
+        // 'f' is called outside of the write, with a copy of each element.
+        // A write is only started for the elements that are erased.
+        template <class F> std::size_t erase_if(F&& f)
+        {
+          std::size_t count = 0;
+          key_buffer k;
+          mapped_buffer m;
+          std::lock_guard<std::mutex> lock(write_mutex_);
+          buckets* b = buckets_.load(std::memory_order_relaxed);
+          for (std::size_t i = 0; i < b->bucket_count_; ++i) {
+            link* prev = b->buckets_ + i;
+            for (node* n; (n = prev->load(std::memory_order_relaxed)) != 0;) {
+              value_type v(n->key_.load(k), n->mapped_.load(m));
+              if (f(static_cast<value_type const&>(v))) {
+                write_guard guard(*this);
+                prev->store(n->next_.load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+                free_node(n);
+                size_.fetch_sub(1, std::memory_order_relaxed);
+                ++count;
+              } else {
+                prev = &n->next_;
+              }
+            }
+          }
+          return count;
+        }
+
+        void clear()
+        {
+          std::lock_guard<std::mutex> lock(write_mutex_);
+          write_guard guard(*this);
+          buckets* b = buckets_.load(std::memory_order_relaxed);
+          for (std::size_t i = 0; i < b->bucket_count_; ++i) {
+            node* n = b->buckets_[i].load(std::memory_order_relaxed);
+            b->buckets_[i].store(0, std::memory_order_relaxed);
+            while (n) {
+              node* next = n->next_.load(std::memory_order_relaxed);
+              free_node(n);
+              n = next;
+            }
+          }
+          size_.store(0, std::memory_order_relaxed);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Reading
+
+        // Copies the element for 'k' into 'k_out' and 'm_out', if there is
+        // one. Starts again whenever a write happened at the same time.
+        bool read(key_type const& k, key_buffer& k_out,
+          mapped_buffer& m_out) const
+        {
+          std::size_t key_hash = this->hash(k);
+
+          for (;;) {
+            std::size_t sequence = sequence_.load(std::memory_order_acquire);
+            if (sequence & 1) {
+              std::this_thread::yield();
+              continue;
+            }
+
+            bool found = false;
+            buckets* b = buckets_.load(std::memory_order_acquire);
+            std::size_t steps = 0;
+            for (node* n = b->buckets_[policy::position(
+                                         b->size_index_, key_hash)]
+                             .load(std::memory_order_relaxed);
+                 n; n = n->next_.load(std::memory_order_relaxed)) {
+              // A reader which saw a node just before it was reused could
+              // end up going round in circles, so check now and again.
+              if (!(++steps & 63) &&
+                  sequence_.load(std::memory_order_relaxed) != sequence) {
+                break;
+              }
+              if (n->hash_.load(std::memory_order_relaxed) != key_hash) {
+                continue;
+              }
+
+              // The copy might be torn, so check the counter before passing
+              // it to 'key_eq', which might not cope with an invalid value.
+              key_type const& key = n->key_.load(k_out);
+              std::atomic_thread_fence(std::memory_order_acquire);
+              if (sequence_.load(std::memory_order_relaxed) != sequence) {
+                break;
+              }
+              if (this->key_eq()(k, key)) {
+                n->mapped_.load(m_out);
+                found = true;
+                break;
+              }
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == sequence) {
+              return found;
+            }
+          }
+        }
+
+        template <class F>
+        std::size_t visit(key_type const& k, F&& f) const
+        {
+          key_buffer key;
+          mapped_buffer mapped;
+          if (!read(k, key, mapped)) {
+            return 0;
+          }
+          value_type const v(*static_cast<key_type const*>(key.address()),
+            *static_cast<mapped_type const*>(mapped.address()));
+          f(v);
+          return 1;
+        }
+
+        // Holds the writer's lock, as a traversal would rarely get through
+        // the whole table without a write.
+        template <class F> std::size_t visit_all(F&& f) const
+        {
+          std::size_t count = 0;
+          key_buffer k;
+          mapped_buffer m;
+          std::lock_guard<std::mutex> lock(write_mutex_);
+          buckets* b = buckets_.load(std::memory_order_relaxed);
+          for (std::size_t i = 0; i < b->bucket_count_; ++i) {
+            for (node* n = b->buckets_[i].load(std::memory_order_relaxed); n;
+                 n = n->next_.load(std::memory_order_relaxed)) {
+              value_type const v(n->key_.load(k), n->mapped_.load(m));
+              f(v);
+              ++count;
+            }
+          }
+          return count;
+        }
+      };
+    }
+  }
+}
+
+#endif
@@ -23,7 +23,10 @@ namespace boost {
         typedef boost::unordered::detail::allocator_traits<value_allocator>
           value_allocator_traits;
 
-        typedef boost::unordered::detail::pick_node<A, value_type> pick;
+        typedef boost::unordered::detail::pick_node<A, value_type,
+          boost::unordered::store_hash<H>::value,
+          boost::unordered::doubly_linked<H>::value>
+          pick;
         typedef typename pick::node node;
         typedef typename pick::bucket bucket;
         typedef typename pick::link_pointer link_pointer;
@@ -31,13 +34,18 @@ namespace boost {
         typedef boost::unordered::detail::table<types> table;
         typedef boost::unordered::detail::set_extractor<value_type> extractor;
 
-        typedef typename boost::unordered::detail::pick_policy<T>::type policy;
+        typedef typename boost::unordered::detail::pick_policy<T, H>::type
+          policy;
 
         typedef boost::unordered::iterator_detail::c_iterator<node> iterator;
         typedef boost::unordered::iterator_detail::c_iterator<node> c_iterator;
         typedef boost::unordered::iterator_detail::cl_iterator<node> l_iterator;
         typedef boost::unordered::iterator_detail::cl_iterator<node>
           cl_iterator;
+        typedef boost::unordered::iterator_detail::cr_iterator<node>
+          r_iterator;
+        typedef boost::unordered::iterator_detail::cr_iterator<node>
+          cr_iterator;
 
         typedef boost::unordered::node_handle_set<node, T, A> node_type;
         typedef boost::unordered::insert_return_type_set<node, T, A>
@@ -0,0 +1,94 @@
+
+// Copyright (C) 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_UNORDERED_HASH_TRAITS_HPP_INCLUDED
+#define BOOST_UNORDERED_HASH_TRAITS_HPP_INCLUDED
+
+#include <boost/config.hpp>
+#if defined(BOOST_HAS_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <boost/type_traits/integral_constant.hpp>
+
+namespace boost {
+  namespace unordered {
+    // Specialize to derive from boost::true_type for hash functions which
+    // are expensive to call. The node based containers will then store
+    // each element's hash value in its node, so that the hash function is
+    // only called once for each element, rather than again when rehashing
+    // or copying the container.
+    //
+    // The stored hash values are reused when merging from a container with
+    // the same type of hash function, so all objects of that type must
+    // return the same hash value for a key.
+    template <class Hash> struct store_hash : boost::false_type
+    {
+    };
+
+    // Specialize to derive from boost::true_type to make the node based
+    // containers rehash incrementally when they grow. Instead of moving all
+    // the elements to the new buckets in the insert that triggers the
+    // rehash, the old buckets are kept and each following insert or erase
+    // moves a few of them, so that no single insert has to touch every
+    // element. Lookups check both bucket arrays until the rehash finishes.
+    //
+    // This works best along with store_hash, as moving the elements doesn't
+    // call the hash function then.
+    template <class Hash> struct incremental_rehash : boost::false_type
+    {
+    };
+
+    // Specialize to derive from boost::true_type to make the node based
+    // containers check the length of a bucket whenever an element is added
+    // to it. If a bucket has far more elements than a reasonable hash
+    // function would produce, such as when integer keys which are multiples
+    // of the bucket count use the prime policy, the container is rehashed
+    // once, and from then on mixes the hash values before picking buckets.
+    template <class Hash> struct hash_guard : boost::false_type
+    {
+    };
+
+    // Bucket policies, which choose the bucket counts and how a hash value
+    // is mapped to a bucket. Select one for a hash function by specializing
+    // bucket_policy.
+    //
+    // default_bucket_policy: prime_bucket_policy for integer keys, as their
+    //     hash values are often consecutive. Otherwise when std::size_t is
+    //     64 bits, the hash value is mixed and then the low bits are used
+    //     with a power of 2 bucket count.
+    // prime_bucket_policy: a prime bucket count, and the hash value modulo
+    //     the bucket count.
+    // pow2_bucket_policy: a power of 2 bucket count, and the low bits of the
+    //     hash value. Only use this when all the bits of the hash value are
+    //     well mixed.
+    // fibonacci_bucket_policy: a power of 2 bucket count, and the high bits
+    //     of the hash value multiplied by 2^N divided by the golden ratio.
+    //     Cheaper than mixing, and spreads out hash values which only vary
+    //     in their low bits, but not ones which only vary in the highest.
+    struct default_bucket_policy
+    {
+    };
+
+    struct prime_bucket_policy
+    {
+    };
+
+    struct pow2_bucket_policy
+    {
+    };
+
+    struct fibonacci_bucket_policy
+    {
+    };
+
+    template <class Hash> struct bucket_policy
+    {
+      typedef default_bucket_policy type;
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,349 @@
+
+// Copyright (C) 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_UNORDERED_NODE_POOL_ALLOCATOR_HPP_INCLUDED
+#define BOOST_UNORDERED_NODE_POOL_ALLOCATOR_HPP_INCLUDED
+
+#include <boost/config.hpp>
+#if defined(BOOST_HAS_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <boost/assert.hpp>
+#include <boost/limits.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/type_with_alignment.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <new>
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Node pool allocator
+//
+// An allocator for the node based containers, which takes the nodes from
+// large slabs of memory instead of allocating them one at a time. Freed
+// nodes are kept in an intrusive free list, and reused by later
+// allocations.
+//
+// All the copies of an allocator, including rebound copies, share a pool.
+// A container copies its allocator for the nodes and the buckets, so
+// default constructing a container gives it its own pool, and a copy of a
+// container gets a new pool (from select_on_container_copy_construction).
+// The pool is shared by a container and any node handles extracted from it,
+// and is released along with the last copy of its allocator.
+//
+// Only single objects are taken from the pool, which for the containers are
+// the nodes. Each object size gets its own size class, chosen from
+// sizeof(T) of the allocator's value type, so the rebound copies for
+// different types don't interfere. Arrays, such as the buckets, and over
+// aligned types are allocated with operator new. Each size class counts
+// its live objects, and when the last one is deallocated, for example when
+// the container is cleared, its slabs are released.
+//
+// The pool isn't thread safe, so containers shouldn't share an allocator
+// across threads without synchronization. That includes 'insert_parallel',
+// which allocates nodes from several threads at once.
+
+namespace boost {
+  namespace unordered {
+    namespace detail {
+      class node_pool
+      {
+        struct free_chunk
+        {
+          free_chunk* next_;
+        };
+
+        struct slab
+        {
+          slab* next_;
+        };
+
+        // The first slab holds this many chunks, each new slab is twice the
+        // size of the previous one, up to the maximum.
+        static const std::size_t min_slab_chunks = 32;
+        static const std::size_t max_slab_chunks = 4096;
+
+      public:
+        // The slabs and free list for objects of one size.
+        class size_class
+        {
+          friend class node_pool;
+
+          size_class* next_;
+          std::size_t object_size_;
+          std::size_t object_align_;
+          std::size_t chunk_size_;
+          std::size_t header_size_;
+          std::size_t next_slab_chunks_;
+          std::size_t live_;
+          free_chunk* free_;
+          slab* slabs_;
+          char* unused_begin_;
+          char* unused_end_;
+
+          size_class(std::size_t size, std::size_t align, size_class* next)
+              : next_(next), object_size_(size), object_align_(align),
+                chunk_size_(0), header_size_(0),
+                next_slab_chunks_(min_slab_chunks), live_(0), free_(0),
+                slabs_(0), unused_begin_(0), unused_end_(0)
+          {
+            std::size_t chunk_align =
+              (std::max)(align, boost::alignment_of<free_chunk>::value);
+            chunk_size_ =
+              round_up((std::max)(size, sizeof(free_chunk)), chunk_align);
+            header_size_ = round_up(sizeof(slab), chunk_align);
+          }
+
+          ~size_class() { release_slabs(); }
+
+          size_class(size_class const&);
+          size_class& operator=(size_class const&);
+
+          void add_slab()
+          {
+            std::size_t chunks = next_slab_chunks_;
+            if ((std::numeric_limits<std::size_t>::max)() / chunk_size_ <
+                chunks + 1) {
+              boost::throw_exception(std::bad_alloc());
+            }
+
+            void* memory =
+              ::operator new(header_size_ + chunks * chunk_size_);
+            slab* s = static_cast<slab*>(memory);
+            s->next_ = slabs_;
+            slabs_ = s;
+            unused_begin_ = static_cast<char*>(memory) + header_size_;
+            unused_end_ = unused_begin_ + chunks * chunk_size_;
+
+            if (next_slab_chunks_ < max_slab_chunks) {
+              next_slab_chunks_ *= 2;
+            }
+          }
+
+          // Called when there are no live objects, so the free list only
+          // points into the slabs being released. The slab sizes start
+          // again from the minimum.
+          void release_slabs()
+          {
+            while (slabs_) {
+              slab* next = slabs_->next_;
+              ::operator delete(static_cast<void*>(slabs_));
+              slabs_ = next;
+            }
+            free_ = 0;
+            unused_begin_ = unused_end_ = 0;
+            next_slab_chunks_ = min_slab_chunks;
+          }
+
+        public:
+          void* allocate()
+          {
+            void* p;
+            if (free_) {
+              p = free_;
+              free_ = free_->next_;
+            } else {
+              if (unused_begin_ == unused_end_) {
+                add_slab();
+              }
+              p = unused_begin_;
+              unused_begin_ += chunk_size_;
+            }
+            ++live_;
+            return p;
+          }
+
+          void deallocate(void* p)
+          {
+            BOOST_ASSERT(live_);
+            if (!--live_) {
+              release_slabs();
+            } else {
+              free_chunk* c = static_cast<free_chunk*>(p);
+              c->next_ = free_;
+              free_ = c;
+            }
+          }
+        };
+
+      private:
+        std::size_t refs_;
+        size_class* classes_;
+
+        node_pool(node_pool const&);
+        node_pool& operator=(node_pool const&);
+
+        ~node_pool()
+        {
+          while (classes_) {
+            size_class* next = classes_->next_;
+            delete classes_;
+            classes_ = next;
+          }
+        }
+
+        static std::size_t round_up(std::size_t x, std::size_t align)
+        {
+          return (x + align - 1) / align * align;
+        }
+
+      public:
+        node_pool() : refs_(1), classes_(0) {}
+
+        void add_ref() { ++refs_; }
+
+        void remove_ref()
+        {
+          if (!--refs_) {
+            delete this;
+          }
+        }
+
+        // Is a single object of this alignment allocated from the pool?
+        static bool pooled_alignment(std::size_t align)
+        {
+          return align <=
+                 boost::alignment_of<boost::detail::max_align>::value;
+        }
+
+        // The size class for objects of this size and alignment, created
+        // the first time it's needed.
+        size_class& get_class(std::size_t size, std::size_t align)
+        {
+          BOOST_ASSERT(pooled_alignment(align));
+          for (size_class* c = classes_; c; c = c->next_) {
+            if (c->object_size_ == size && c->object_align_ == align) {
+              return *c;
+            }
+          }
+          classes_ = new size_class(size, align, classes_);
+          return *classes_;
+        }
+      };
+    }
+
+    template <class T> class node_pool_allocator
+    {
+      template <class> friend class node_pool_allocator;
+
+      typedef boost::unordered::detail::node_pool pool;
+
+      pool* pool_;
+
+      // The size class for T, looked up on the first pooled allocation.
+      mutable pool::size_class* class_;
+
+      pool::size_class& get_class() const
+      {
+        if (!class_) {
+          class_ = &pool_->get_class(sizeof(T), boost::alignment_of<T>::value);
+        }
+        return *class_;
+      }
+
+      static bool pooled(std::size_t n)
+      {
+        return n == 1 && pool::pooled_alignment(boost::alignment_of<T>::value);
+      }
+
+    public:
+      typedef T value_type;
+      typedef T* pointer;
+      typedef T const* const_pointer;
+      typedef T& reference;
+      typedef T const& const_reference;
+      typedef std::size_t size_type;
+      typedef std::ptrdiff_t difference_type;
+
+      // Moving or swapping a container takes its pool with it. Copy
+      // assignment keeps the target's pool, and copies the elements into it.
+      typedef boost::false_type propagate_on_container_copy_assignment;
+      typedef boost::true_type propagate_on_container_move_assignment;
+      typedef boost::true_type propagate_on_container_swap;
+
+      template <class U> struct rebind
+      {
+        typedef node_pool_allocator<U> other;
+      };
+
+      node_pool_allocator() : pool_(new pool()), class_(0) {}
+
+      node_pool_allocator(node_pool_allocator const& x)
+          : pool_(x.pool_), class_(x.class_)
+      {
+        pool_->add_ref();
+      }
+
+      template <class U>
+      node_pool_allocator(node_pool_allocator<U> const& x)
+          : pool_(x.pool_), class_(0)
+      {
+        pool_->add_ref();
+      }
+
+      node_pool_allocator& operator=(node_pool_allocator const& x)
+      {
+        x.pool_->add_ref();
+        pool_->remove_ref();
+        pool_ = x.pool_;
+        class_ = x.class_;
+        return *this;
+      }
+
+      ~node_pool_allocator() { pool_->remove_ref(); }
+
+      node_pool_allocator select_on_container_copy_construction() const
+      {
+        return node_pool_allocator();
+      }
+
+      pointer address(reference r) const { return &r; }
+      const_pointer address(const_reference r) const { return &r; }
+
+      pointer allocate(size_type n)
+      {
+        if (pooled(n)) {
+          return static_cast<pointer>(get_class().allocate());
+        }
+        if (n > max_size()) {
+          boost::throw_exception(std::bad_alloc());
+        }
+        return static_cast<pointer>(::operator new(n * sizeof(T)));
+      }
+
+      pointer allocate(size_type n, void const*) { return allocate(n); }
+
+      void deallocate(pointer p, size_type n)
+      {
+        if (pooled(n)) {
+          get_class().deallocate(p);
+        } else {
+          ::operator delete(static_cast<void*>(p));
+        }
+      }
+
+      size_type max_size() const
+      {
+        return (std::numeric_limits<size_type>::max)() / sizeof(T);
+      }
+
+      bool operator==(node_pool_allocator const& x) const
+      {
+        return pool_ == x.pool_;
+      }
+
+      bool operator!=(node_pool_allocator const& x) const
+      {
+        return pool_ != x.pool_;
+      }
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,33 @@
+
+// Copyright (C) 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_UNORDERED_NODE_TRAITS_HPP_INCLUDED
+#define BOOST_UNORDERED_NODE_TRAITS_HPP_INCLUDED
+
+#include <boost/config.hpp>
+#if defined(BOOST_HAS_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <boost/type_traits/integral_constant.hpp>
+
+namespace boost {
+  namespace unordered {
+    // Specialize to derive from boost::true_type to make the node based
+    // containers that use the hash function link each node back to the
+    // previous one. This costs a pointer per element, but erasing or
+    // extracting an element using an iterator doesn't have to search its
+    // bucket for the previous node, so it takes constant time however many
+    // elements are in the bucket.
+    //
+    // Like store_hash, this is a trait of the hash function since it's the
+    // template parameter that is usually specific to a container.
+    template <class Hash> struct doubly_linked : boost::false_type
+    {
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,279 @@
+
+// Copyright (C) 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+//  See http://www.boost.org/libs/unordered for documentation
+
+#ifndef BOOST_UNORDERED_READ_MOSTLY_UNORDERED_MAP_HPP_INCLUDED
+#define BOOST_UNORDERED_READ_MOSTLY_UNORDERED_MAP_HPP_INCLUDED
+
+#include <boost/config.hpp>
+#if defined(BOOST_HAS_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <boost/functional/hash.hpp>
+#include <boost/move/move.hpp>
+#include <boost/unordered/detail/read_mostly_map.hpp>
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+#include <initializer_list>
+#endif
+
+namespace boost {
+  namespace unordered {
+    // A map for many reader threads and occasional writers. Lookups don't
+    // take any locks, and elements are never changed in place, so visitors
+    // only get const access. Writers are serialized, and assigning to an
+    // element replaces it. The elements have to be copy constructible, as
+    // growing the map copies them.
+
+    template <class K, class T, class H, class P, class A>
+    class read_mostly_unordered_map
+    {
+    public:
+      typedef K key_type;
+      typedef T mapped_type;
+      typedef std::pair<const K, T> value_type;
+      typedef H hasher;
+      typedef P key_equal;
+      typedef A allocator_type;
+
+    private:
+      typedef boost::unordered::detail::read_mostly_map<A, K, T, H, P> types;
+      typedef typename types::value_allocator_traits value_allocator_traits;
+      typedef typename types::table table;
+
+    public:
+      typedef typename value_allocator_traits::pointer pointer;
+      typedef typename value_allocator_traits::const_pointer const_pointer;
+
+      typedef value_type& reference;
+      typedef value_type const& const_reference;
+
+      typedef std::size_t size_type;
+      typedef std::ptrdiff_t difference_type;
+
+    private:
+      table table_;
+
+      struct ignore_visit
+      {
+        void operator()(value_type const&) const {}
+      };
+
+      read_mostly_unordered_map& operator=(read_mostly_unordered_map const&);
+
+    public:
+      // constructors
+
+      read_mostly_unordered_map()
+          : table_(boost::unordered::detail::default_bucket_count, hasher(),
+              key_equal(), allocator_type())
+      {
+      }
+
+      explicit read_mostly_unordered_map(size_type n,
+        const hasher& hf = hasher(), const key_equal& eql = key_equal(),
+        const allocator_type& a = allocator_type())
+          : table_(n, hf, eql, a)
+      {
+      }
+
+      template <class InputIt>
+      read_mostly_unordered_map(InputIt f, InputIt l,
+        size_type n = boost::unordered::detail::default_bucket_count,
+        const hasher& hf = hasher(), const key_equal& eql = key_equal(),
+        const allocator_type& a = allocator_type())
+          : table_(n, hf, eql, a)
+      {
+        this->insert(f, l);
+      }
+
+      // Holds the writer's lock on 'other' while copying it.
+      read_mostly_unordered_map(read_mostly_unordered_map const& other)
+          : table_(other.table_,
+              value_allocator_traits::
+                select_on_container_copy_construction(
+                  other.get_allocator()))
+      {
+      }
+
+      explicit read_mostly_unordered_map(allocator_type const& a)
+          : table_(boost::unordered::detail::default_bucket_count, hasher(),
+              key_equal(), a)
+      {
+      }
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+      read_mostly_unordered_map(std::initializer_list<value_type> list,
+        size_type n = boost::unordered::detail::default_bucket_count,
+        const hasher& hf = hasher(), const key_equal& eql = key_equal(),
+        const allocator_type& a = allocator_type())
+          : table_(n, hf, eql, a)
+      {
+        this->insert(list.begin(), list.end());
+      }
+#endif
+
+      allocator_type get_allocator() const BOOST_NOEXCEPT
+      {
+        return table_.node_alloc();
+      }
+
+      // size
+      //
+      // While another thread is changing the container, these are only
+      // approximate.
+
+      bool empty() const BOOST_NOEXCEPT { return table_.size() == 0; }
+
+      size_type size() const BOOST_NOEXCEPT { return table_.size(); }
+
+      size_type max_size() const BOOST_NOEXCEPT;
+
+      // visitation
+      //
+      // These don't take any locks. 'f' is called with a const reference
+      // to the element, which stays valid until 'f' returns, even if
+      // another thread erases it. Returns the number of elements visited.
+
+      template <class F> size_type visit(const key_type& k, F f) const
+      {
+        return table_.visit(k, f);
+      }
+
+      template <class F> size_type cvisit(const key_type& k, F f) const
+      {
+        return table_.visit(k, f);
+      }
+
+      // Call 'f' for every element. Elements that are inserted or erased at
+      // the same time may or may not be visited.
+
+      template <class F> size_type visit_all(F f) const
+      {
+        return table_.visit_all(f);
+      }
+
+      template <class F> size_type cvisit_all(F f) const
+      {
+        return table_.visit_all(f);
+      }
+
+      bool contains(const key_type& k) const
+      {
+        return table_.visit(k, ignore_visit()) != 0;
+      }
+
+      size_type count(const key_type& k) const
+      {
+        return table_.visit(k, ignore_visit());
+      }
+
+      // modifiers
+      //
+      // Only one thread can change the container at a time. Return true if
+      // an element was inserted.
+
+      template <class... Args> bool emplace(BOOST_FWD_REF(Args)... args)
+      {
+        return table_.emplace(boost::forward<Args>(args)...);
+      }
+
+      template <class... Args>
+      bool try_emplace(const key_type& k, BOOST_FWD_REF(Args)... args)
+      {
+        return table_.try_emplace(k, boost::forward<Args>(args)...);
+      }
+
+      template <class... Args>
+      bool try_emplace(BOOST_RV_REF(key_type) k, BOOST_FWD_REF(Args)... args)
+      {
+        return table_.try_emplace(
+          boost::move(k), boost::forward<Args>(args)...);
+      }
+
+      bool insert(value_type const& x) { return table_.insert(x); }
+
+      bool insert(BOOST_RV_REF(value_type) x)
+      {
+        return table_.insert(boost::move(x));
+      }
+
+      template <class InputIt> size_type insert(InputIt first, InputIt last)
+      {
+        size_type count = 0;
+        for (; first != last; ++first) {
+          count += this->emplace(*first) ? 1 : 0;
+        }
+        return count;
+      }
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+      size_type insert(std::initializer_list<value_type> list)
+      {
+        return this->insert(list.begin(), list.end());
+      }
+#endif
+
+      // If there's already an element for 'k', it's replaced with a new
+      // one, as readers might be looking at the old value.
+
+      template <class M>
+      bool insert_or_assign(const key_type& k, BOOST_FWD_REF(M) obj)
+      {
+        return table_.insert_or_assign(k, boost::forward<M>(obj));
+      }
+
+      template <class M>
+      bool insert_or_assign(BOOST_RV_REF(key_type) k, BOOST_FWD_REF(M) obj)
+      {
+        return table_.insert_or_assign(boost::move(k), boost::forward<M>(obj));
+      }
+
+      // erase
+      //
+      // Erased elements are deallocated once no reader can be using them.
+
+      size_type erase(const key_type& k) { return table_.erase(k); }
+
+      // Erase every element that 'f' returns true for.
+      template <class F> size_type erase_if(F f) { return table_.erase_if(f); }
+
+      void clear() { table_.clear(); }
+
+      // observers
+
+      hasher hash_function() const { return table_.hash_function(); }
+
+      key_equal key_eq() const { return table_.key_eq(); }
+
+      // bucket interface
+
+      size_type bucket_count() const { return table_.bucket_count(); }
+
+      // hash policy
+
+      float load_factor() const { return table_.load_factor(); }
+
+      float max_load_factor() const { return table_.max_load_factor(); }
+
+      void max_load_factor(float m) { table_.max_load_factor(m); }
+
+      void rehash(size_type n) { table_.rehash(n); }
+
+      void reserve(size_type n) { table_.reserve(n); }
+    }; // class template read_mostly_unordered_map
+
+    template <class K, class T, class H, class P, class A>
+    std::size_t read_mostly_unordered_map<K, T, H, P, A>::max_size() const
+      BOOST_NOEXCEPT
+    {
+      return table::node_allocator_traits::max_size(table_.node_alloc());
+    }
+  } // namespace unordered
+} // namespace boost
+
+#endif // BOOST_UNORDERED_READ_MOSTLY_UNORDERED_MAP_HPP_INCLUDED
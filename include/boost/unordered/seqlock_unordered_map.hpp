@@ -0,0 +1,267 @@
+
+// Copyright (C) 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+//  See http://www.boost.org/libs/unordered for documentation
+
+#ifndef BOOST_UNORDERED_SEQLOCK_UNORDERED_MAP_HPP_INCLUDED
+#define BOOST_UNORDERED_SEQLOCK_UNORDERED_MAP_HPP_INCLUDED
+
+#include <boost/config.hpp>
+#if defined(BOOST_HAS_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <boost/functional/hash.hpp>
+#include <boost/move/move.hpp>
+#include <boost/unordered/detail/seqlock_map.hpp>
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+#include <initializer_list>
+#endif
+
+namespace boost {
+  namespace unordered {
+    // A map for a single writer thread and many readers. Lookups don't
+    // write to shared memory, they copy the element and start again if the
+    // writer changed the map in the meantime, so visitors are given a copy.
+    // The key and mapped types have to be trivially copyable. Erased
+    // elements' memory is reused for later inserts, and is only deallocated
+    // when the map is destroyed.
+
+    template <class K, class T, class H, class P, class A>
+    class seqlock_unordered_map
+    {
+    public:
+      typedef K key_type;
+      typedef T mapped_type;
+      typedef std::pair<const K, T> value_type;
+      typedef H hasher;
+      typedef P key_equal;
+      typedef A allocator_type;
+
+    private:
+      typedef boost::unordered::detail::seqlock_map<A, K, T, H, P> types;
+      typedef typename types::value_allocator_traits value_allocator_traits;
+      typedef typename types::table table;
+
+    public:
+      typedef typename value_allocator_traits::pointer pointer;
+      typedef typename value_allocator_traits::const_pointer const_pointer;
+
+      typedef value_type& reference;
+      typedef value_type const& const_reference;
+
+      typedef std::size_t size_type;
+      typedef std::ptrdiff_t difference_type;
+
+    private:
+      table table_;
+
+      struct ignore_visit
+      {
+        void operator()(value_type const&) const {}
+      };
+
+      seqlock_unordered_map& operator=(seqlock_unordered_map const&);
+
+    public:
+      // constructors
+
+      seqlock_unordered_map()
+          : table_(boost::unordered::detail::default_bucket_count, hasher(),
+              key_equal(), allocator_type())
+      {
+      }
+
+      explicit seqlock_unordered_map(size_type n,
+        const hasher& hf = hasher(), const key_equal& eql = key_equal(),
+        const allocator_type& a = allocator_type())
+          : table_(n, hf, eql, a)
+      {
+      }
+
+      template <class InputIt>
+      seqlock_unordered_map(InputIt f, InputIt l,
+        size_type n = boost::unordered::detail::default_bucket_count,
+        const hasher& hf = hasher(), const key_equal& eql = key_equal(),
+        const allocator_type& a = allocator_type())
+          : table_(n, hf, eql, a)
+      {
+        this->insert(f, l);
+      }
+
+      // Holds the writer's lock on 'other' while copying it.
+      seqlock_unordered_map(seqlock_unordered_map const& other)
+          : table_(other.table_,
+              value_allocator_traits::
+                select_on_container_copy_construction(
+                  other.get_allocator()))
+      {
+      }
+
+      explicit seqlock_unordered_map(allocator_type const& a)
+          : table_(boost::unordered::detail::default_bucket_count, hasher(),
+              key_equal(), a)
+      {
+      }
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+      seqlock_unordered_map(std::initializer_list<value_type> list,
+        size_type n = boost::unordered::detail::default_bucket_count,
+        const hasher& hf = hasher(), const key_equal& eql = key_equal(),
+        const allocator_type& a = allocator_type())
+          : table_(n, hf, eql, a)
+      {
+        this->insert(list.begin(), list.end());
+      }
+#endif
+
+      allocator_type get_allocator() const BOOST_NOEXCEPT
+      {
+        return table_.node_alloc();
+      }
+
+      // size
+      //
+      // While another thread is changing the container, these are only
+      // approximate.
+
+      bool empty() const BOOST_NOEXCEPT { return table_.size() == 0; }
+
+      size_type size() const BOOST_NOEXCEPT { return table_.size(); }
+
+      size_type max_size() const BOOST_NOEXCEPT;
+
+      // visitation
+      //
+      // These don't take any locks. 'f' is called with a const reference
+      // to a copy of the element, taken while the writer wasn't changing
+      // the map. Returns the number of elements visited.
+
+      template <class F> size_type visit(const key_type& k, F f) const
+      {
+        return table_.visit(k, f);
+      }
+
+      template <class F> size_type cvisit(const key_type& k, F f) const
+      {
+        return table_.visit(k, f);
+      }
+
+      // Call 'f' for every element. Holds the writer's lock, so 'f' can't
+      // change the map.
+
+      template <class F> size_type visit_all(F f) const
+      {
+        return table_.visit_all(f);
+      }
+
+      template <class F> size_type cvisit_all(F f) const
+      {
+        return table_.visit_all(f);
+      }
+
+      bool contains(const key_type& k) const
+      {
+        return table_.visit(k, ignore_visit()) != 0;
+      }
+
+      size_type count(const key_type& k) const
+      {
+        return table_.visit(k, ignore_visit());
+      }
+
+      // modifiers
+      //
+      // Only one thread can change the container at a time. Return true if
+      // an element was inserted.
+
+      template <class... Args> bool emplace(BOOST_FWD_REF(Args)... args)
+      {
+        value_type const x(boost::forward<Args>(args)...);
+        return table_.insert_impl(x.first, x.second, false);
+      }
+
+      template <class... Args>
+      bool try_emplace(const key_type& k, BOOST_FWD_REF(Args)... args)
+      {
+        return table_.insert_impl(
+          k, mapped_type(boost::forward<Args>(args)...), false);
+      }
+
+      bool insert(value_type const& x)
+      {
+        return table_.insert_impl(x.first, x.second, false);
+      }
+
+      template <class InputIt> size_type insert(InputIt first, InputIt last)
+      {
+        size_type count = 0;
+        for (; first != last; ++first) {
+          count += this->emplace(*first) ? 1 : 0;
+        }
+        return count;
+      }
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+      size_type insert(std::initializer_list<value_type> list)
+      {
+        return this->insert(list.begin(), list.end());
+      }
+#endif
+
+      // If there's already an element for 'k', its value is overwritten in
+      // place.
+
+      bool insert_or_assign(const key_type& k, const mapped_type& obj)
+      {
+        return table_.insert_impl(k, obj, true);
+      }
+
+      // erase
+      //
+      // Erased elements are kept for reuse by later inserts.
+
+      size_type erase(const key_type& k) { return table_.erase(k); }
+
+      // Erase every element that 'f' returns true for. 'f' is called
+      // with a copy of each element.
+      template <class F> size_type erase_if(F f) { return table_.erase_if(f); }
+
+      void clear() { table_.clear(); }
+
+      // observers
+
+      hasher hash_function() const { return table_.hash_function(); }
+
+      key_equal key_eq() const { return table_.key_eq(); }
+
+      // bucket interface
+
+      size_type bucket_count() const { return table_.bucket_count(); }
+
+      // hash policy
+
+      float load_factor() const { return table_.load_factor(); }
+
+      float max_load_factor() const { return table_.max_load_factor(); }
+
+      void max_load_factor(float m) { table_.max_load_factor(m); }
+
+      void rehash(size_type n) { table_.rehash(n); }
+
+      void reserve(size_type n) { table_.reserve(n); }
+    }; // class template seqlock_unordered_map
+
+    template <class K, class T, class H, class P, class A>
+    std::size_t seqlock_unordered_map<K, T, H, P, A>::max_size() const
+      BOOST_NOEXCEPT
+    {
+      return table::node_allocator_traits::max_size(table_.node_alloc());
+    }
+  } // namespace unordered
+} // namespace boost
+
+#endif // BOOST_UNORDERED_SEQLOCK_UNORDERED_MAP_HPP_INCLUDED
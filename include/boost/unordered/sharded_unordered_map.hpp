@@ -0,0 +1,683 @@
+
+// Copyright (C) 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+//  See http://www.boost.org/libs/unordered for documentation
+
+#ifndef BOOST_UNORDERED_SHARDED_UNORDERED_MAP_HPP_INCLUDED
+#define BOOST_UNORDERED_SHARDED_UNORDERED_MAP_HPP_INCLUDED
+
+#include <boost/config.hpp>
+#if defined(BOOST_HAS_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#if defined(BOOST_NO_CXX11_HDR_MUTEX) ||                                      \
+  defined(BOOST_NO_CXX11_RVALUE_REFERENCES) ||                                 \
+  defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+#error "boost::sharded_unordered_map requires C++11 mutexes."
+#endif
+
+#include <boost/static_assert.hpp>
+#include <boost/unordered/sharded_unordered_map_fwd.hpp>
+#include <boost/unordered/unordered_map.hpp>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+#include <initializer_list>
+#endif
+
+namespace boost {
+  namespace unordered {
+    // A map which can be used from several threads at once, made from
+    // 'Shards' unordered_maps, each with its own mutex. A key's shard is
+    // picked from the high bits of its hash value multiplied by 2^N divided
+    // by the golden ratio, and the shard then uses its bucket policy on the
+    // same hash value, so the hash function is only called once. As each
+    // shard grows separately, rehashing only holds up the threads using
+    // that shard.
+    //
+    // Like concurrent_unordered_map, elements are accessed by visitation,
+    // and visitors mustn't call back into the container.
+
+    template <class K, class T, class H, class P, class A, std::size_t Shards>
+    class sharded_unordered_map
+    {
+      BOOST_STATIC_ASSERT_MSG(Shards && !(Shards & (Shards - 1)),
+        "The number of shards must be a power of 2.");
+
+    public:
+      typedef K key_type;
+      typedef T mapped_type;
+      typedef std::pair<const K, T> value_type;
+      typedef H hasher;
+      typedef P key_equal;
+      typedef A allocator_type;
+      typedef boost::unordered_map<K, T, H, P, A> shard_type;
+
+      typedef typename shard_type::pointer pointer;
+      typedef typename shard_type::const_pointer const_pointer;
+
+      typedef value_type& reference;
+      typedef value_type const& const_reference;
+
+      typedef std::size_t size_type;
+      typedef std::ptrdiff_t difference_type;
+
+    private:
+      typedef boost::unordered::detail::fibonacci_policy<std::size_t>
+        shard_policy;
+
+      // Padded so that the mutexes of neighbouring shards are unlikely to
+      // share a cache line.
+      struct shard
+      {
+        mutable std::mutex mutex_;
+        shard_type map_;
+        char padding_[64];
+
+        shard(size_type n, hasher const& hf, key_equal const& eq,
+          allocator_type const& a)
+            : map_(n, hf, eq, a)
+        {
+        }
+
+        shard(shard_type const& x, allocator_type const& a) : map_(x, a) {}
+      };
+
+      typedef std::lock_guard<std::mutex> lock_guard;
+
+      hasher hash_;
+      std::size_t shard_shift_;
+      std::unique_ptr<shard> shards_[Shards];
+
+      sharded_unordered_map& operator=(sharded_unordered_map const&);
+
+      std::size_t shard_index(std::size_t key_hash) const
+      {
+        return Shards == 1 ? 0
+                           : shard_policy::position(shard_shift_, key_hash);
+      }
+
+      shard& get_shard(std::size_t key_hash) const
+      {
+        return *shards_[shard_index(key_hash)];
+      }
+
+      void create_shards(size_type n, hasher const& hf, key_equal const& eql,
+        allocator_type const& a)
+      {
+        size_type per_shard = (n + Shards - 1) / Shards;
+        for (std::size_t i = 0; i < Shards; ++i) {
+          shards_[i].reset(new shard(per_shard, hf, eql, a));
+        }
+      }
+
+    public:
+      // constructors
+
+      sharded_unordered_map()
+          : hash_(), shard_shift_(shard_policy::size_index(Shards))
+      {
+        create_shards(boost::unordered::detail::default_bucket_count,
+          hasher(), key_equal(), allocator_type());
+      }
+
+      explicit sharded_unordered_map(size_type n, const hasher& hf = hasher(),
+        const key_equal& eql = key_equal(),
+        const allocator_type& a = allocator_type())
+          : hash_(hf), shard_shift_(shard_policy::size_index(Shards))
+      {
+        create_shards(n, hf, eql, a);
+      }
+
+      template <class InputIt>
+      sharded_unordered_map(InputIt f, InputIt l,
+        size_type n = boost::unordered::detail::default_bucket_count,
+        const hasher& hf = hasher(), const key_equal& eql = key_equal(),
+        const allocator_type& a = allocator_type())
+          : hash_(hf), shard_shift_(shard_policy::size_index(Shards))
+      {
+        create_shards(n, hf, eql, a);
+        this->insert(f, l);
+      }
+
+      // Locks each of the shards of 'other' in turn while copying them.
+      sharded_unordered_map(sharded_unordered_map const& other)
+          : hash_(other.hash_), shard_shift_(other.shard_shift_)
+      {
+        for (std::size_t i = 0; i < Shards; ++i) {
+          lock_guard lock(other.shards_[i]->mutex_);
+          shards_[i].reset(new shard(other.shards_[i]->map_,
+            boost::unordered::detail::allocator_traits<allocator_type>::
+              select_on_container_copy_construction(
+                other.shards_[i]->map_.get_allocator())));
+        }
+      }
+
+      explicit sharded_unordered_map(allocator_type const& a)
+          : hash_(), shard_shift_(shard_policy::size_index(Shards))
+      {
+        create_shards(boost::unordered::detail::default_bucket_count,
+          hasher(), key_equal(), a);
+      }
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+      sharded_unordered_map(std::initializer_list<value_type> list,
+        size_type n = boost::unordered::detail::default_bucket_count,
+        const hasher& hf = hasher(), const key_equal& eql = key_equal(),
+        const allocator_type& a = allocator_type())
+          : hash_(hf), shard_shift_(shard_policy::size_index(Shards))
+      {
+        create_shards(n, hf, eql, a);
+        this->insert(list.begin(), list.end());
+      }
+#endif
+
+      allocator_type get_allocator() const BOOST_NOEXCEPT
+      {
+        return shards_[0]->map_.get_allocator();
+      }
+
+      static size_type shard_count() BOOST_NOEXCEPT { return Shards; }
+
+      // size
+      //
+      // Locks each shard in turn, so while other threads are changing the
+      // container, these are only approximate.
+
+      bool empty() const { return this->size() == 0; }
+
+      size_type size() const
+      {
+        size_type count = 0;
+        for (std::size_t i = 0; i < Shards; ++i) {
+          lock_guard lock(shards_[i]->mutex_);
+          count += shards_[i]->map_.size();
+        }
+        return count;
+      }
+
+      size_type max_size() const BOOST_NOEXCEPT
+      {
+        return shards_[0]->map_.max_size();
+      }
+
+      // visitation
+      //
+      // Call 'f' for the element with key 'k', if there is one, with its
+      // shard locked. Returns the number of elements visited.
+
+      template <class F> size_type visit(const key_type& k, F f)
+      {
+        std::size_t key_hash = hash_(k);
+        shard& s = get_shard(key_hash);
+        lock_guard lock(s.mutex_);
+        typename shard_type::iterator it = s.map_.find(k, key_hash);
+        if (it == s.map_.end()) {
+          return 0;
+        }
+        f(*it);
+        return 1;
+      }
+
+      template <class F> size_type visit(const key_type& k, F f) const
+      {
+        std::size_t key_hash = hash_(k);
+        shard const& s = get_shard(key_hash);
+        lock_guard lock(s.mutex_);
+        typename shard_type::const_iterator it = s.map_.find(k, key_hash);
+        if (it == s.map_.end()) {
+          return 0;
+        }
+        f(*it);
+        return 1;
+      }
+
+      template <class F> size_type cvisit(const key_type& k, F f) const
+      {
+        return this->visit(k, f);
+      }
+
+      // Call 'f' for every element, locking each shard in turn.
+
+      template <class F> size_type visit_all(F f)
+      {
+        size_type count = 0;
+        for (std::size_t i = 0; i < Shards; ++i) {
+          lock_guard lock(shards_[i]->mutex_);
+          shard_type& map = shards_[i]->map_;
+          for (typename shard_type::iterator it = map.begin(); it != map.end();
+               ++it) {
+            f(*it);
+            ++count;
+          }
+        }
+        return count;
+      }
+
+      template <class F> size_type visit_all(F f) const
+      {
+        size_type count = 0;
+        for (std::size_t i = 0; i < Shards; ++i) {
+          lock_guard lock(shards_[i]->mutex_);
+          shard_type const& map = shards_[i]->map_;
+          for (typename shard_type::const_iterator it = map.begin();
+               it != map.end(); ++it) {
+            f(*it);
+            ++count;
+          }
+        }
+        return count;
+      }
+
+      template <class F> size_type cvisit_all(F f) const
+      {
+        return this->visit_all(f);
+      }
+
+      // Call 'f' for the elements with each of the keys in [first, last).
+      // The keys are grouped by shard, so that each shard is only locked
+      // once.
+
+      template <class FwdIt, class F>
+      size_type visit(FwdIt first, FwdIt last, F f)
+      {
+        return visit_range<shard_type&, typename shard_type::iterator>(
+          *this, first, last, f);
+      }
+
+      template <class FwdIt, class F>
+      size_type visit(FwdIt first, FwdIt last, F f) const
+      {
+        return visit_range<shard_type const&,
+          typename shard_type::const_iterator>(*this, first, last, f);
+      }
+
+      template <class FwdIt, class F>
+      size_type cvisit(FwdIt first, FwdIt last, F f) const
+      {
+        return this->visit(first, last, f);
+      }
+
+      bool contains(const key_type& k) const { return this->count(k) != 0; }
+
+      size_type count(const key_type& k) const
+      {
+        std::size_t key_hash = hash_(k);
+        shard const& s = get_shard(key_hash);
+        lock_guard lock(s.mutex_);
+        return s.map_.find(k, key_hash) != s.map_.end() ? 1 : 0;
+      }
+
+      // emplace
+      //
+      // Returns true if the element was inserted, false if there was
+      // already an element with an equivalent key. The element is
+      // constructed before picking its shard, as its key is needed.
+
+      template <class... Args> bool emplace(BOOST_FWD_REF(Args)... args)
+      {
+        value_type v(boost::forward<Args>(args)...);
+        std::size_t key_hash = hash_(v.first);
+        shard& s = get_shard(key_hash);
+        lock_guard lock(s.mutex_);
+        return s.map_.emplace_with_hash(key_hash, boost::move(v)).second;
+      }
+
+      template <class... Args>
+      bool try_emplace(const key_type& k, BOOST_FWD_REF(Args)... args)
+      {
+        return try_emplace_impl(k, boost::forward<Args>(args)...);
+      }
+
+      template <class... Args>
+      bool try_emplace(BOOST_RV_REF(key_type) k, BOOST_FWD_REF(Args)... args)
+      {
+        return try_emplace_impl(boost::move(k), boost::forward<Args>(args)...);
+      }
+
+      bool insert(value_type const& x)
+      {
+        std::size_t key_hash = hash_(x.first);
+        shard& s = get_shard(key_hash);
+        lock_guard lock(s.mutex_);
+        return s.map_.emplace_with_hash(key_hash, x).second;
+      }
+
+      bool insert(BOOST_RV_REF(value_type) x)
+      {
+        std::size_t key_hash = hash_(x.first);
+        shard& s = get_shard(key_hash);
+        lock_guard lock(s.mutex_);
+        return s.map_.emplace_with_hash(key_hash, boost::move(x)).second;
+      }
+
+      // Inserts a range of elements, returning the number inserted. If the
+      // iterators are forward iterators, the elements are grouped by shard
+      // first, so that each shard is only locked once.
+
+      template <class InputIt> size_type insert(InputIt first, InputIt last)
+      {
+        return insert_range(first, last);
+      }
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+      size_type insert(std::initializer_list<value_type> list)
+      {
+        return this->insert(list.begin(), list.end());
+      }
+#endif
+
+      // Inserts 'x', or if there's already an element with an equivalent
+      // key, calls 'f' for it instead.
+
+      template <class F> bool insert_or_visit(value_type const& x, F f)
+      {
+        return insert_or_visit_impl(x, f);
+      }
+
+      template <class F> bool insert_or_visit(BOOST_RV_REF(value_type) x, F f)
+      {
+        return insert_or_visit_impl(boost::move(x), f);
+      }
+
+      template <class F> bool insert_or_cvisit(value_type const& x, F f)
+      {
+        return insert_or_visit_impl(
+          x, [&f](value_type const& v) { f(v); });
+      }
+
+      template <class F>
+      bool insert_or_cvisit(BOOST_RV_REF(value_type) x, F f)
+      {
+        return insert_or_visit_impl(
+          boost::move(x), [&f](value_type const& v) { f(v); });
+      }
+
+      template <class M>
+      bool insert_or_assign(const key_type& k, BOOST_FWD_REF(M) obj)
+      {
+        return insert_or_assign_impl(k, boost::forward<M>(obj));
+      }
+
+      template <class M>
+      bool insert_or_assign(BOOST_RV_REF(key_type) k, BOOST_FWD_REF(M) obj)
+      {
+        return insert_or_assign_impl(boost::move(k), boost::forward<M>(obj));
+      }
+
+      // erase
+      //
+      // Return the number of elements erased.
+
+      size_type erase(const key_type& k)
+      {
+        std::size_t key_hash = hash_(k);
+        shard& s = get_shard(key_hash);
+        lock_guard lock(s.mutex_);
+        return s.map_.erase(k, key_hash);
+      }
+
+      // Erase the elements with each of the keys in [first, last), locking
+      // each shard once.
+      template <class FwdIt> size_type erase(FwdIt first, FwdIt last)
+      {
+        std::vector<std::pair<std::size_t, FwdIt> > groups[Shards];
+        group_keys(first, last, groups);
+
+        size_type count = 0;
+        for (std::size_t i = 0; i < Shards; ++i) {
+          if (!groups[i].empty()) {
+            lock_guard lock(shards_[i]->mutex_);
+            for (std::size_t j = 0; j < groups[i].size(); ++j) {
+              count += shards_[i]->map_.erase(
+                *groups[i][j].second, groups[i][j].first);
+            }
+          }
+        }
+        return count;
+      }
+
+      // Erase the element with key 'k' if 'f' returns true for it.
+      template <class F> size_type erase_if(const key_type& k, F f)
+      {
+        std::size_t key_hash = hash_(k);
+        shard& s = get_shard(key_hash);
+        lock_guard lock(s.mutex_);
+        typename shard_type::iterator it = s.map_.find(k, key_hash);
+        if (it == s.map_.end() || !f(*it)) {
+          return 0;
+        }
+        s.map_.erase(it);
+        return 1;
+      }
+
+      // Erase every element that 'f' returns true for, locking each shard
+      // in turn.
+      template <class F> size_type erase_if(F f)
+      {
+        size_type count = 0;
+        for (std::size_t i = 0; i < Shards; ++i) {
+          lock_guard lock(shards_[i]->mutex_);
+          shard_type& map = shards_[i]->map_;
+          for (typename shard_type::iterator it = map.begin();
+               it != map.end();) {
+            if (f(*it)) {
+              it = map.erase(it);
+              ++count;
+            } else {
+              ++it;
+            }
+          }
+        }
+        return count;
+      }
+
+      void clear()
+      {
+        for (std::size_t i = 0; i < Shards; ++i) {
+          lock_guard lock(shards_[i]->mutex_);
+          shards_[i]->map_.clear();
+        }
+      }
+
+      // observers
+
+      hasher hash_function() const { return hash_; }
+
+      key_equal key_eq() const { return shards_[0]->map_.key_eq(); }
+
+      // bucket interface
+      //
+      // The total over all the shards.
+
+      size_type bucket_count() const
+      {
+        size_type count = 0;
+        for (std::size_t i = 0; i < Shards; ++i) {
+          lock_guard lock(shards_[i]->mutex_);
+          count += shards_[i]->map_.bucket_count();
+        }
+        return count;
+      }
+
+      // hash policy
+
+      float load_factor() const
+      {
+        size_type elements = 0, buckets = 0;
+        for (std::size_t i = 0; i < Shards; ++i) {
+          lock_guard lock(shards_[i]->mutex_);
+          elements += shards_[i]->map_.size();
+          buckets += shards_[i]->map_.bucket_count();
+        }
+        return static_cast<float>(elements) / static_cast<float>(buckets);
+      }
+
+      float max_load_factor() const
+      {
+        lock_guard lock(shards_[0]->mutex_);
+        return shards_[0]->map_.max_load_factor();
+      }
+
+      void max_load_factor(float m)
+      {
+        for (std::size_t i = 0; i < Shards; ++i) {
+          lock_guard lock(shards_[i]->mutex_);
+          shards_[i]->map_.max_load_factor(m);
+        }
+      }
+
+      // Each shard gets an equal share of the buckets or elements.
+
+      void rehash(size_type n)
+      {
+        for (std::size_t i = 0; i < Shards; ++i) {
+          lock_guard lock(shards_[i]->mutex_);
+          shards_[i]->map_.rehash((n + Shards - 1) / Shards);
+        }
+      }
+
+      void reserve(size_type n)
+      {
+        for (std::size_t i = 0; i < Shards; ++i) {
+          lock_guard lock(shards_[i]->mutex_);
+          shards_[i]->map_.reserve((n + Shards - 1) / Shards);
+        }
+      }
+
+    private:
+      template <class Key, class... Args>
+      bool try_emplace_impl(Key&& k, Args&&... args)
+      {
+        std::size_t key_hash = hash_(k);
+        shard& s = get_shard(key_hash);
+        lock_guard lock(s.mutex_);
+        if (s.map_.find(k, key_hash) != s.map_.end()) {
+          return false;
+        }
+        s.map_.emplace_with_hash(key_hash,
+          boost::unordered::piecewise_construct,
+          std::forward_as_tuple(boost::forward<Key>(k)),
+          std::forward_as_tuple(boost::forward<Args>(args)...));
+        return true;
+      }
+
+      template <class V, class F> bool insert_or_visit_impl(V&& x, F&& f)
+      {
+        std::size_t key_hash = hash_(x.first);
+        shard& s = get_shard(key_hash);
+        lock_guard lock(s.mutex_);
+        typename shard_type::iterator it = s.map_.find(x.first, key_hash);
+        if (it != s.map_.end()) {
+          f(*it);
+          return false;
+        }
+        s.map_.emplace_with_hash(key_hash, boost::forward<V>(x));
+        return true;
+      }
+
+      template <class Key, class M>
+      bool insert_or_assign_impl(Key&& k, M&& obj)
+      {
+        std::size_t key_hash = hash_(k);
+        shard& s = get_shard(key_hash);
+        lock_guard lock(s.mutex_);
+        typename shard_type::iterator it = s.map_.find(k, key_hash);
+        if (it != s.map_.end()) {
+          it->second = boost::forward<M>(obj);
+          return false;
+        }
+        s.map_.emplace_with_hash(key_hash, boost::forward<Key>(k),
+          boost::forward<M>(obj));
+        return true;
+      }
+
+      // Hashes the keys in [first, last), and adds each one's hash value and
+      // iterator to its shard's group.
+      template <class FwdIt>
+      void group_keys(FwdIt first, FwdIt last,
+        std::vector<std::pair<std::size_t, FwdIt> >* groups) const
+      {
+        for (; first != last; ++first) {
+          std::size_t key_hash = hash_(*first);
+          groups[shard_index(key_hash)].push_back(
+            std::make_pair(key_hash, first));
+        }
+      }
+
+      template <class Map, class Iterator, class Self, class FwdIt, class F>
+      static size_type visit_range(Self& self, FwdIt first, FwdIt last, F& f)
+      {
+        std::vector<std::pair<std::size_t, FwdIt> > groups[Shards];
+        self.group_keys(first, last, groups);
+
+        size_type count = 0;
+        for (std::size_t i = 0; i < Shards; ++i) {
+          if (!groups[i].empty()) {
+            lock_guard lock(self.shards_[i]->mutex_);
+            Map map = self.shards_[i]->map_;
+            for (std::size_t j = 0; j < groups[i].size(); ++j) {
+              Iterator it =
+                map.find(*groups[i][j].second, groups[i][j].first);
+              if (it != map.end()) {
+                f(*it);
+                ++count;
+              }
+            }
+          }
+        }
+        return count;
+      }
+
+      template <class FwdIt>
+      size_type insert_range(FwdIt first, FwdIt last,
+        typename boost::unordered::detail::enable_if_forward<FwdIt,
+          void*>::type = 0)
+      {
+        std::vector<std::pair<std::size_t, FwdIt> > groups[Shards];
+        for (; first != last; ++first) {
+          std::size_t key_hash = hash_((*first).first);
+          groups[shard_index(key_hash)].push_back(
+            std::make_pair(key_hash, first));
+        }
+
+        size_type count = 0;
+        for (std::size_t i = 0; i < Shards; ++i) {
+          if (!groups[i].empty()) {
+            lock_guard lock(shards_[i]->mutex_);
+            for (std::size_t j = 0; j < groups[i].size(); ++j) {
+              count += shards_[i]
+                           ->map_
+                           .emplace_with_hash(
+                             groups[i][j].first, *groups[i][j].second)
+                           .second
+                         ? 1
+                         : 0;
+            }
+          }
+        }
+        return count;
+      }
+
+      template <class InputIt>
+      size_type insert_range(InputIt first, InputIt last,
+        typename boost::unordered::detail::disable_if_forward<InputIt,
+          void*>::type = 0)
+      {
+        size_type count = 0;
+        for (; first != last; ++first) {
+          count += this->emplace(*first) ? 1 : 0;
+        }
+        return count;
+      }
+    }; // class template sharded_unordered_map
+  } // namespace unordered
+} // namespace boost
+
+#endif // BOOST_UNORDERED_SHARDED_UNORDERED_MAP_HPP_INCLUDED
@@ -0,0 +1,46 @@
+
+// Copyright (C) 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_UNORDERED_STATS_HPP_INCLUDED
+#define BOOST_UNORDERED_STATS_HPP_INCLUDED
+
+#include <boost/config.hpp>
+#if defined(BOOST_HAS_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <cstddef>
+#include <vector>
+
+namespace boost {
+  namespace unordered {
+    // Statistics for a node based container, returned by 'get_stats' when
+    // BOOST_UNORDERED_ENABLE_STATS is defined.
+    struct stats
+    {
+      // Counted since the container was constructed, or since
+      // 'reset_stats' was last called.
+      std::size_t hash_calls;
+      std::size_t key_eq_calls;
+      std::size_t rehashes;
+      std::size_t rehashed_nodes;
+
+      // The current state of the container. 'chain_lengths[n]' is the
+      // number of buckets which contain 'n' elements.
+      std::size_t size;
+      std::size_t bucket_count;
+      std::size_t used_buckets;
+      std::vector<std::size_t> chain_lengths;
+
+      stats()
+          : hash_calls(0), key_eq_calls(0), rehashes(0), rehashed_nodes(0),
+            size(0), bucket_count(0), used_buckets(0), chain_lengths()
+      {
+      }
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,771 @@
+
+// Copyright (C) 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+//  See http://www.boost.org/libs/unordered for documentation
+
+#ifndef BOOST_UNORDERED_UNORDERED_COMPACT_MAP_HPP_INCLUDED
+#define BOOST_UNORDERED_UNORDERED_COMPACT_MAP_HPP_INCLUDED
+
+#include <boost/config.hpp>
+#if defined(BOOST_HAS_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <boost/functional/hash.hpp>
+#include <boost/move/move.hpp>
+#include <boost/type_traits/is_constructible.hpp>
+#include <boost/unordered/detail/compact_map.hpp>
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+#include <initializer_list>
+#endif
+
+#if defined(BOOST_MSVC)
+#pragma warning(push)
+#if BOOST_MSVC >= 1400
+#pragma warning(disable : 4396) // the inline specifier cannot be used when a
+// friend declaration refers to a specialization
+// of a function template
+#endif
+#endif
+
+namespace boost {
+  namespace unordered {
+    // An unordered map which links its nodes with 32-bit indexes into an
+    // arena, so it can hold fewer than 2^32 - 1 elements. Has the same
+    // interface as unordered_map, apart from the node and local bucket
+    // interfaces. Rehashing invalidates iterators, but not pointers or
+    // references, and the memory for erased elements is reused by later
+    // inserts, only being deallocated when the container is destroyed.
+
+    template <class K, class T, class H, class P, class A>
+    class unordered_compact_map
+    {
+    public:
+      typedef K key_type;
+      typedef T mapped_type;
+      typedef std::pair<const K, T> value_type;
+      typedef H hasher;
+      typedef P key_equal;
+      typedef A allocator_type;
+
+    private:
+      typedef boost::unordered::detail::compact_map<A, K, T, H, P> types;
+      typedef typename types::value_allocator_traits value_allocator_traits;
+      typedef typename types::table table;
+
+    public:
+      typedef typename value_allocator_traits::pointer pointer;
+      typedef typename value_allocator_traits::const_pointer const_pointer;
+
+      typedef value_type& reference;
+      typedef value_type const& const_reference;
+
+      typedef std::size_t size_type;
+      typedef std::ptrdiff_t difference_type;
+
+      typedef typename table::iterator iterator;
+      typedef typename table::c_iterator const_iterator;
+
+    private:
+      table table_;
+
+    public:
+      // constructors
+
+      unordered_compact_map();
+
+      explicit unordered_compact_map(size_type, const hasher& = hasher(),
+        const key_equal& = key_equal(),
+        const allocator_type& = allocator_type());
+
+      template <class InputIt>
+      unordered_compact_map(InputIt, InputIt,
+        size_type = boost::unordered::detail::default_bucket_count,
+        const hasher& = hasher(), const key_equal& = key_equal(),
+        const allocator_type& = allocator_type());
+
+      unordered_compact_map(unordered_compact_map const&);
+
+      unordered_compact_map(BOOST_RV_REF(unordered_compact_map) other)
+        BOOST_NOEXCEPT_IF(table::nothrow_move_constructible)
+          : table_(other.table_, boost::unordered::detail::move_tag())
+      {
+        // The move is done in table_
+      }
+
+      explicit unordered_compact_map(allocator_type const&);
+
+      unordered_compact_map(
+        unordered_compact_map const&, allocator_type const&);
+
+      unordered_compact_map(
+        BOOST_RV_REF(unordered_compact_map), allocator_type const&);
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+      unordered_compact_map(std::initializer_list<value_type>,
+        size_type = boost::unordered::detail::default_bucket_count,
+        const hasher& = hasher(), const key_equal& l = key_equal(),
+        const allocator_type& = allocator_type());
+#endif
+
+      explicit unordered_compact_map(size_type, const allocator_type&);
+
+      explicit unordered_compact_map(
+        size_type, const hasher&, const allocator_type&);
+
+      template <class InputIt>
+      unordered_compact_map(InputIt, InputIt, size_type, const allocator_type&);
+
+      template <class InputIt>
+      unordered_compact_map(
+        InputIt, InputIt, size_type, const hasher&, const allocator_type&);
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+      unordered_compact_map(
+        std::initializer_list<value_type>, size_type, const allocator_type&);
+
+      unordered_compact_map(std::initializer_list<value_type>, size_type,
+        const hasher&, const allocator_type&);
+#endif
+
+      // Destructor
+
+      ~unordered_compact_map() BOOST_NOEXCEPT;
+
+      // Assign
+
+      unordered_compact_map& operator=(unordered_compact_map const& x)
+      {
+        table_.assign(x.table_);
+        return *this;
+      }
+
+      unordered_compact_map& operator=(BOOST_RV_REF(unordered_compact_map) x)
+      {
+        table_.move_assign(x.table_);
+        return *this;
+      }
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+      unordered_compact_map& operator=(std::initializer_list<value_type>);
+#endif
+
+      allocator_type get_allocator() const BOOST_NOEXCEPT
+      {
+        return table_.value_alloc();
+      }
+
+      // iterators
+
+      iterator begin() BOOST_NOEXCEPT { return table_.begin(); }
+
+      const_iterator begin() const BOOST_NOEXCEPT { return table_.begin(); }
+
+      iterator end() BOOST_NOEXCEPT { return iterator(); }
+
+      const_iterator end() const BOOST_NOEXCEPT { return const_iterator(); }
+
+      const_iterator cbegin() const BOOST_NOEXCEPT { return table_.begin(); }
+
+      const_iterator cend() const BOOST_NOEXCEPT { return const_iterator(); }
+
+      // size and capacity
+
+      bool empty() const BOOST_NOEXCEPT { return table_.size_ == 0; }
+
+      size_type size() const BOOST_NOEXCEPT { return table_.size_; }
+
+      size_type max_size() const BOOST_NOEXCEPT;
+
+      // emplace
+
+      template <class... Args>
+      std::pair<iterator, bool> emplace(BOOST_FWD_REF(Args)... args)
+      {
+        return table_.emplace_unique(
+          table::extractor::extract(boost::forward<Args>(args)...),
+          boost::forward<Args>(args)...);
+      }
+
+      template <class... Args>
+      iterator emplace_hint(const_iterator hint, BOOST_FWD_REF(Args)... args)
+      {
+        return table_.emplace_hint_unique(hint,
+          table::extractor::extract(boost::forward<Args>(args)...),
+          boost::forward<Args>(args)...);
+      }
+
+      std::pair<iterator, bool> insert(value_type const& x)
+      {
+        return this->emplace(x);
+      }
+
+      std::pair<iterator, bool> insert(BOOST_RV_REF(value_type) x)
+      {
+        return this->emplace(boost::move(x));
+      }
+
+      template <class P2>
+      std::pair<iterator, bool> insert(BOOST_RV_REF(P2) obj,
+        typename boost::enable_if_c<
+          boost::is_constructible<value_type, BOOST_RV_REF(P2)>::value,
+          void*>::type = 0)
+      {
+        return this->emplace(boost::forward<P2>(obj));
+      }
+
+      iterator insert(const_iterator hint, value_type const& x)
+      {
+        return this->emplace_hint(hint, x);
+      }
+
+      iterator insert(const_iterator hint, BOOST_RV_REF(value_type) x)
+      {
+        return this->emplace_hint(hint, boost::move(x));
+      }
+
+      template <class P2>
+      iterator insert(const_iterator hint, BOOST_RV_REF(P2) obj,
+        typename boost::enable_if_c<
+          boost::is_constructible<value_type, BOOST_RV_REF(P2)>::value,
+          void*>::type = 0)
+      {
+        return this->emplace_hint(hint, boost::forward<P2>(obj));
+      }
+
+      template <class InputIt> void insert(InputIt, InputIt);
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+      void insert(std::initializer_list<value_type>);
+#endif
+
+      template <class... Args>
+      std::pair<iterator, bool> try_emplace(
+        key_type const& k, BOOST_FWD_REF(Args)... args)
+      {
+        return table_.try_emplace_unique(k, boost::forward<Args>(args)...);
+      }
+
+      template <class... Args>
+      std::pair<iterator, bool> try_emplace(
+        BOOST_RV_REF(key_type) k, BOOST_FWD_REF(Args)... args)
+      {
+        return table_.try_emplace_unique(
+          boost::move(k), boost::forward<Args>(args)...);
+      }
+
+      template <class... Args>
+      iterator try_emplace(
+        const_iterator hint, key_type const& k, BOOST_FWD_REF(Args)... args)
+      {
+        return table_.try_emplace_hint_unique(
+          hint, k, boost::forward<Args>(args)...);
+      }
+
+      template <class... Args>
+      iterator try_emplace(const_iterator hint, BOOST_RV_REF(key_type) k,
+        BOOST_FWD_REF(Args)... args)
+      {
+        return table_.try_emplace_hint_unique(
+          hint, boost::move(k), boost::forward<Args>(args)...);
+      }
+
+      template <class M>
+      std::pair<iterator, bool> insert_or_assign(
+        key_type const& k, BOOST_FWD_REF(M) obj)
+      {
+        return table_.insert_or_assign_unique(k, boost::forward<M>(obj));
+      }
+
+      template <class M>
+      std::pair<iterator, bool> insert_or_assign(
+        BOOST_RV_REF(key_type) k, BOOST_FWD_REF(M) obj)
+      {
+        return table_.insert_or_assign_unique(
+          boost::move(k), boost::forward<M>(obj));
+      }
+
+      template <class M>
+      iterator insert_or_assign(
+        const_iterator, key_type const& k, BOOST_FWD_REF(M) obj)
+      {
+        return table_.insert_or_assign_unique(k, boost::forward<M>(obj)).first;
+      }
+
+      template <class M>
+      iterator insert_or_assign(
+        const_iterator, BOOST_RV_REF(key_type) k, BOOST_FWD_REF(M) obj)
+      {
+        return table_
+          .insert_or_assign_unique(boost::move(k), boost::forward<M>(obj))
+          .first;
+      }
+
+      iterator erase(iterator);
+      iterator erase(const_iterator);
+      size_type erase(const key_type&);
+      iterator erase(const_iterator, const_iterator);
+
+      void swap(unordered_compact_map&);
+      void clear() BOOST_NOEXCEPT { table_.clear_impl(); }
+
+      // observers
+
+      hasher hash_function() const;
+      key_equal key_eq() const;
+
+      // lookup
+
+      iterator find(const key_type&);
+      const_iterator find(const key_type&) const;
+
+      template <class CompatibleKey, class CompatibleHash,
+        class CompatiblePredicate>
+      iterator find(CompatibleKey const&, CompatibleHash const&,
+        CompatiblePredicate const&);
+
+      template <class CompatibleKey, class CompatibleHash,
+        class CompatiblePredicate>
+      const_iterator find(CompatibleKey const&, CompatibleHash const&,
+        CompatiblePredicate const&) const;
+
+      size_type count(const key_type&) const;
+
+      std::pair<iterator, iterator> equal_range(const key_type&);
+      std::pair<const_iterator, const_iterator> equal_range(
+        const key_type&) const;
+
+      mapped_type& operator[](const key_type&);
+      mapped_type& operator[](BOOST_RV_REF(key_type));
+      mapped_type& at(const key_type&);
+      mapped_type const& at(const key_type&) const;
+
+      // bucket interface
+
+      size_type bucket_count() const BOOST_NOEXCEPT
+      {
+        return table_.bucket_count_;
+      }
+
+      size_type max_bucket_count() const BOOST_NOEXCEPT
+      {
+        return table_.max_bucket_count();
+      }
+
+      // hash policy
+
+      float load_factor() const BOOST_NOEXCEPT;
+      float max_load_factor() const BOOST_NOEXCEPT
+      {
+        return table_.max_load_factor();
+      }
+      void max_load_factor(float m) BOOST_NOEXCEPT
+      {
+        table_.max_load_factor(m);
+      }
+      void rehash(size_type);
+      void reserve(size_type);
+
+#if !BOOST_WORKAROUND(__BORLANDC__, < 0x0582)
+      friend bool operator==<K, T, H, P, A>(
+        unordered_compact_map const&, unordered_compact_map const&);
+      friend bool operator!=<K, T, H, P, A>(
+        unordered_compact_map const&, unordered_compact_map const&);
+#endif
+    }; // class template unordered_compact_map
+
+    ////////////////////////////////////////////////////////////////////////////
+
+    template <class K, class T, class H, class P, class A>
+    unordered_compact_map<K, T, H, P, A>::unordered_compact_map()
+        : table_(boost::unordered::detail::default_bucket_count, hasher(),
+            key_equal(), allocator_type())
+    {
+    }
+
+    template <class K, class T, class H, class P, class A>
+    unordered_compact_map<K, T, H, P, A>::unordered_compact_map(size_type n,
+      const hasher& hf, const key_equal& eql, const allocator_type& a)
+        : table_(n, hf, eql, a)
+    {
+    }
+
+    template <class K, class T, class H, class P, class A>
+    template <class InputIt>
+    unordered_compact_map<K, T, H, P, A>::unordered_compact_map(InputIt f,
+      InputIt l, size_type n, const hasher& hf, const key_equal& eql,
+      const allocator_type& a)
+        : table_(n, hf, eql, a)
+    {
+      this->insert(f, l);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    unordered_compact_map<K, T, H, P, A>::unordered_compact_map(
+      unordered_compact_map const& other)
+        : table_(other.table_,
+            unordered_compact_map::value_allocator_traits::
+              select_on_container_copy_construction(other.get_allocator()))
+    {
+      table_.copy_buckets(other.table_);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    unordered_compact_map<K, T, H, P, A>::unordered_compact_map(
+      allocator_type const& a)
+        : table_(boost::unordered::detail::default_bucket_count, hasher(),
+            key_equal(), a)
+    {
+    }
+
+    template <class K, class T, class H, class P, class A>
+    unordered_compact_map<K, T, H, P, A>::unordered_compact_map(
+      unordered_compact_map const& other, allocator_type const& a)
+        : table_(other.table_, a)
+    {
+      table_.copy_buckets(other.table_);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    unordered_compact_map<K, T, H, P, A>::unordered_compact_map(
+      BOOST_RV_REF(unordered_compact_map) other, allocator_type const& a)
+        : table_(other.table_, a, boost::unordered::detail::move_tag())
+    {
+      if (table_.value_alloc() == other.table_.value_alloc()) {
+        table_.move_buckets_from(other.table_);
+      } else {
+        table_.move_buckets(other.table_);
+      }
+    }
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+
+    template <class K, class T, class H, class P, class A>
+    unordered_compact_map<K, T, H, P, A>::unordered_compact_map(
+      std::initializer_list<value_type> list, size_type n, const hasher& hf,
+      const key_equal& eql, const allocator_type& a)
+        : table_(n, hf, eql, a)
+    {
+      this->insert(list.begin(), list.end());
+    }
+
+#endif
+
+    template <class K, class T, class H, class P, class A>
+    unordered_compact_map<K, T, H, P, A>::unordered_compact_map(
+      size_type n, const allocator_type& a)
+        : table_(n, hasher(), key_equal(), a)
+    {
+    }
+
+    template <class K, class T, class H, class P, class A>
+    unordered_compact_map<K, T, H, P, A>::unordered_compact_map(
+      size_type n, const hasher& hf, const allocator_type& a)
+        : table_(n, hf, key_equal(), a)
+    {
+    }
+
+    template <class K, class T, class H, class P, class A>
+    template <class InputIt>
+    unordered_compact_map<K, T, H, P, A>::unordered_compact_map(
+      InputIt f, InputIt l, size_type n, const allocator_type& a)
+        : table_(n, hasher(), key_equal(), a)
+    {
+      this->insert(f, l);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    template <class InputIt>
+    unordered_compact_map<K, T, H, P, A>::unordered_compact_map(InputIt f,
+      InputIt l, size_type n, const hasher& hf, const allocator_type& a)
+        : table_(n, hf, key_equal(), a)
+    {
+      this->insert(f, l);
+    }
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+
+    template <class K, class T, class H, class P, class A>
+    unordered_compact_map<K, T, H, P, A>::unordered_compact_map(
+      std::initializer_list<value_type> list, size_type n,
+      const allocator_type& a)
+        : table_(n, hasher(), key_equal(), a)
+    {
+      this->insert(list.begin(), list.end());
+    }
+
+    template <class K, class T, class H, class P, class A>
+    unordered_compact_map<K, T, H, P, A>::unordered_compact_map(
+      std::initializer_list<value_type> list, size_type n, const hasher& hf,
+      const allocator_type& a)
+        : table_(n, hf, key_equal(), a)
+    {
+      this->insert(list.begin(), list.end());
+    }
+
+#endif
+
+    template <class K, class T, class H, class P, class A>
+    unordered_compact_map<K, T, H, P, A>::~unordered_compact_map()
+      BOOST_NOEXCEPT
+    {
+    }
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+
+    template <class K, class T, class H, class P, class A>
+    unordered_compact_map<K, T, H, P, A>& unordered_compact_map<K, T, H, P, A>::
+    operator=(std::initializer_list<value_type> list)
+    {
+      table_.clear_impl();
+      this->insert(list.begin(), list.end());
+      return *this;
+    }
+
+#endif
+
+    // size and capacity
+
+    template <class K, class T, class H, class P, class A>
+    std::size_t unordered_compact_map<K, T, H, P, A>::max_size() const
+      BOOST_NOEXCEPT
+    {
+      return table_.max_size();
+    }
+
+    // modifiers
+
+    template <class K, class T, class H, class P, class A>
+    template <class InputIt>
+    void unordered_compact_map<K, T, H, P, A>::insert(
+      InputIt first, InputIt last)
+    {
+      table_.insert_range_unique(first, last);
+    }
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+    template <class K, class T, class H, class P, class A>
+    void unordered_compact_map<K, T, H, P, A>::insert(
+      std::initializer_list<value_type> list)
+    {
+      this->insert(list.begin(), list.end());
+    }
+#endif
+
+    template <class K, class T, class H, class P, class A>
+    typename unordered_compact_map<K, T, H, P, A>::iterator
+    unordered_compact_map<K, T, H, P, A>::erase(iterator position)
+    {
+      return table_.erase(position);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    typename unordered_compact_map<K, T, H, P, A>::iterator
+    unordered_compact_map<K, T, H, P, A>::erase(const_iterator position)
+    {
+      return table_.erase(position);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    typename unordered_compact_map<K, T, H, P, A>::size_type
+    unordered_compact_map<K, T, H, P, A>::erase(const key_type& k)
+    {
+      return table_.erase_key_unique(k);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    typename unordered_compact_map<K, T, H, P, A>::iterator
+    unordered_compact_map<K, T, H, P, A>::erase(
+      const_iterator first, const_iterator last)
+    {
+      return table_.erase_range(first, last);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    void unordered_compact_map<K, T, H, P, A>::swap(
+      unordered_compact_map& other)
+    {
+      table_.swap(other.table_);
+    }
+
+    // observers
+
+    template <class K, class T, class H, class P, class A>
+    typename unordered_compact_map<K, T, H, P, A>::hasher
+    unordered_compact_map<K, T, H, P, A>::hash_function() const
+    {
+      return table_.hash_function();
+    }
+
+    template <class K, class T, class H, class P, class A>
+    typename unordered_compact_map<K, T, H, P, A>::key_equal
+    unordered_compact_map<K, T, H, P, A>::key_eq() const
+    {
+      return table_.key_eq();
+    }
+
+    // lookup
+
+    template <class K, class T, class H, class P, class A>
+    typename unordered_compact_map<K, T, H, P, A>::iterator
+    unordered_compact_map<K, T, H, P, A>::find(const key_type& k)
+    {
+      return table_.find(k);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    typename unordered_compact_map<K, T, H, P, A>::const_iterator
+    unordered_compact_map<K, T, H, P, A>::find(const key_type& k) const
+    {
+      return table_.find(k);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    template <class CompatibleKey, class CompatibleHash,
+      class CompatiblePredicate>
+    typename unordered_compact_map<K, T, H, P, A>::iterator
+    unordered_compact_map<K, T, H, P, A>::find(CompatibleKey const& k,
+      CompatibleHash const& hash, CompatiblePredicate const& eq)
+    {
+      return table_.get_iterator(
+        table_.find_node_impl(table::policy::apply_hash(hash, k), k, eq));
+    }
+
+    template <class K, class T, class H, class P, class A>
+    template <class CompatibleKey, class CompatibleHash,
+      class CompatiblePredicate>
+    typename unordered_compact_map<K, T, H, P, A>::const_iterator
+    unordered_compact_map<K, T, H, P, A>::find(CompatibleKey const& k,
+      CompatibleHash const& hash, CompatiblePredicate const& eq) const
+    {
+      return table_.get_iterator(
+        table_.find_node_impl(table::policy::apply_hash(hash, k), k, eq));
+    }
+
+    template <class K, class T, class H, class P, class A>
+    typename unordered_compact_map<K, T, H, P, A>::size_type
+    unordered_compact_map<K, T, H, P, A>::count(const key_type& k) const
+    {
+      return table_.find_node(k) !=
+                 boost::unordered::detail::compact_null
+               ? 1
+               : 0;
+    }
+
+    template <class K, class T, class H, class P, class A>
+    std::pair<typename unordered_compact_map<K, T, H, P, A>::iterator,
+      typename unordered_compact_map<K, T, H, P, A>::iterator>
+    unordered_compact_map<K, T, H, P, A>::equal_range(const key_type& k)
+    {
+      iterator first = table_.find(k);
+      iterator last = first;
+      if (last != iterator())
+        ++last;
+      return std::make_pair(first, last);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    std::pair<typename unordered_compact_map<K, T, H, P, A>::const_iterator,
+      typename unordered_compact_map<K, T, H, P, A>::const_iterator>
+    unordered_compact_map<K, T, H, P, A>::equal_range(const key_type& k) const
+    {
+      const_iterator first = table_.find(k);
+      const_iterator last = first;
+      if (last != const_iterator())
+        ++last;
+      return std::make_pair(first, last);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    typename unordered_compact_map<K, T, H, P, A>::mapped_type&
+      unordered_compact_map<K, T, H, P, A>::operator[](const key_type& k)
+    {
+      return table_.try_emplace_unique(k).first->second;
+    }
+
+    template <class K, class T, class H, class P, class A>
+    typename unordered_compact_map<K, T, H, P, A>::mapped_type&
+      unordered_compact_map<K, T, H, P, A>::operator[](BOOST_RV_REF(key_type) k)
+    {
+      return table_.try_emplace_unique(boost::move(k)).first->second;
+    }
+
+    template <class K, class T, class H, class P, class A>
+    typename unordered_compact_map<K, T, H, P, A>::mapped_type&
+    unordered_compact_map<K, T, H, P, A>::at(const key_type& k)
+    {
+      std::size_t index = table_.find_node(k);
+      if (index != boost::unordered::detail::compact_null)
+        return table_.get_node(index)->value().second;
+
+      boost::throw_exception(
+        std::out_of_range("Unable to find key in unordered_compact_map."));
+    }
+
+    template <class K, class T, class H, class P, class A>
+    typename unordered_compact_map<K, T, H, P, A>::mapped_type const&
+    unordered_compact_map<K, T, H, P, A>::at(const key_type& k) const
+    {
+      std::size_t index = table_.find_node(k);
+      if (index != boost::unordered::detail::compact_null)
+        return table_.get_node(index)->value().second;
+
+      boost::throw_exception(
+        std::out_of_range("Unable to find key in unordered_compact_map."));
+    }
+
+    // hash policy
+
+    template <class K, class T, class H, class P, class A>
+    float unordered_compact_map<K, T, H, P, A>::load_factor() const
+      BOOST_NOEXCEPT
+    {
+      BOOST_ASSERT(table_.bucket_count_ != 0);
+      return static_cast<float>(table_.size_) /
+             static_cast<float>(table_.bucket_count_);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    void unordered_compact_map<K, T, H, P, A>::rehash(size_type n)
+    {
+      table_.rehash(n);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    void unordered_compact_map<K, T, H, P, A>::reserve(size_type n)
+    {
+      table_.reserve(n);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    inline bool operator==(unordered_compact_map<K, T, H, P, A> const& m1,
+      unordered_compact_map<K, T, H, P, A> const& m2)
+    {
+      return m1.table_.equals_unique(m2.table_);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    inline bool operator!=(unordered_compact_map<K, T, H, P, A> const& m1,
+      unordered_compact_map<K, T, H, P, A> const& m2)
+    {
+      return !m1.table_.equals_unique(m2.table_);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    inline void swap(unordered_compact_map<K, T, H, P, A>& m1,
+      unordered_compact_map<K, T, H, P, A>& m2)
+      BOOST_NOEXCEPT_IF(BOOST_NOEXCEPT_EXPR(m1.swap(m2)))
+    {
+      m1.swap(m2);
+    }
+  } // namespace unordered
+} // namespace boost
+
+#if defined(BOOST_MSVC)
+#pragma warning(pop)
+#endif
+
+#endif // BOOST_UNORDERED_UNORDERED_COMPACT_MAP_HPP_INCLUDED
@@ -0,0 +1,631 @@
+
+// Copyright (C) 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+//  See http://www.boost.org/libs/unordered for documentation
+
+#ifndef BOOST_UNORDERED_UNORDERED_FLAT_SET_HPP_INCLUDED
+#define BOOST_UNORDERED_UNORDERED_FLAT_SET_HPP_INCLUDED
+
+#include <boost/config.hpp>
+#if defined(BOOST_HAS_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <boost/functional/hash.hpp>
+#include <boost/move/move.hpp>
+#include <boost/unordered/detail/flat_set.hpp>
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+#include <initializer_list>
+#endif
+
+#if defined(BOOST_MSVC)
+#pragma warning(push)
+#if BOOST_MSVC >= 1400
+#pragma warning(disable : 4396) // the inline specifier cannot be used when a
+// friend declaration refers to a specialization
+// of a function template
+#endif
+#endif
+
+namespace boost {
+  namespace unordered {
+    // An unordered set which stores its values in a single array, using
+    // open addressing. Has the same interface as unordered_set, apart from
+    // the node and local bucket interfaces. Inserting or rehashing
+    // invalidates iterators, pointers and references, and the maximum
+    // load factor can't be changed.
+
+    template <class T, class H, class P, class A>
+    class unordered_flat_set
+    {
+    public:
+      typedef T key_type;
+      typedef T value_type;
+      typedef H hasher;
+      typedef P key_equal;
+      typedef A allocator_type;
+
+    private:
+      typedef boost::unordered::detail::flat_set<A, T, H, P> types;
+      typedef typename types::value_allocator_traits value_allocator_traits;
+      typedef typename types::table table;
+
+    public:
+      typedef typename value_allocator_traits::pointer pointer;
+      typedef typename value_allocator_traits::const_pointer const_pointer;
+
+      typedef value_type& reference;
+      typedef value_type const& const_reference;
+
+      typedef std::size_t size_type;
+      typedef std::ptrdiff_t difference_type;
+
+      typedef typename table::iterator iterator;
+      typedef typename table::c_iterator const_iterator;
+
+    private:
+      table table_;
+
+    public:
+      // constructors
+
+      unordered_flat_set();
+
+      explicit unordered_flat_set(size_type, const hasher& = hasher(),
+        const key_equal& = key_equal(),
+        const allocator_type& = allocator_type());
+
+      template <class InputIt>
+      unordered_flat_set(InputIt, InputIt,
+        size_type = boost::unordered::detail::default_bucket_count,
+        const hasher& = hasher(), const key_equal& = key_equal(),
+        const allocator_type& = allocator_type());
+
+      unordered_flat_set(unordered_flat_set const&);
+
+      unordered_flat_set(BOOST_RV_REF(unordered_flat_set) other)
+        BOOST_NOEXCEPT_IF(table::nothrow_move_constructible)
+          : table_(other.table_, boost::unordered::detail::move_tag())
+      {
+        // The move is done in table_
+      }
+
+      explicit unordered_flat_set(allocator_type const&);
+
+      unordered_flat_set(unordered_flat_set const&, allocator_type const&);
+
+      unordered_flat_set(
+        BOOST_RV_REF(unordered_flat_set), allocator_type const&);
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+      unordered_flat_set(std::initializer_list<value_type>,
+        size_type = boost::unordered::detail::default_bucket_count,
+        const hasher& = hasher(), const key_equal& l = key_equal(),
+        const allocator_type& = allocator_type());
+#endif
+
+      explicit unordered_flat_set(size_type, const allocator_type&);
+
+      explicit unordered_flat_set(
+        size_type, const hasher&, const allocator_type&);
+
+      template <class InputIt>
+      unordered_flat_set(InputIt, InputIt, size_type, const allocator_type&);
+
+      template <class InputIt>
+      unordered_flat_set(
+        InputIt, InputIt, size_type, const hasher&, const allocator_type&);
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+      unordered_flat_set(
+        std::initializer_list<value_type>, size_type, const allocator_type&);
+
+      unordered_flat_set(std::initializer_list<value_type>, size_type,
+        const hasher&, const allocator_type&);
+#endif
+
+      // Destructor
+
+      ~unordered_flat_set() BOOST_NOEXCEPT;
+
+      // Assign
+
+      unordered_flat_set& operator=(unordered_flat_set const& x)
+      {
+        table_.assign(x.table_);
+        return *this;
+      }
+
+      unordered_flat_set& operator=(BOOST_RV_REF(unordered_flat_set) x)
+      {
+        table_.move_assign(x.table_);
+        return *this;
+      }
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+      unordered_flat_set& operator=(std::initializer_list<value_type>);
+#endif
+
+      allocator_type get_allocator() const BOOST_NOEXCEPT
+      {
+        return table_.value_alloc();
+      }
+
+      // iterators
+
+      iterator begin() BOOST_NOEXCEPT { return table_.begin(); }
+
+      const_iterator begin() const BOOST_NOEXCEPT { return table_.begin(); }
+
+      iterator end() BOOST_NOEXCEPT { return iterator(); }
+
+      const_iterator end() const BOOST_NOEXCEPT { return const_iterator(); }
+
+      const_iterator cbegin() const BOOST_NOEXCEPT { return table_.begin(); }
+
+      const_iterator cend() const BOOST_NOEXCEPT { return const_iterator(); }
+
+      // size and capacity
+
+      bool empty() const BOOST_NOEXCEPT { return table_.size_ == 0; }
+
+      size_type size() const BOOST_NOEXCEPT { return table_.size_; }
+
+      size_type max_size() const BOOST_NOEXCEPT;
+
+      // emplace
+
+      template <class... Args>
+      std::pair<iterator, bool> emplace(BOOST_FWD_REF(Args)... args)
+      {
+        return table_.emplace_unique(
+          table::extractor::extract(boost::forward<Args>(args)...),
+          boost::forward<Args>(args)...);
+      }
+
+      template <class... Args>
+      iterator emplace_hint(const_iterator hint, BOOST_FWD_REF(Args)... args)
+      {
+        return table_.emplace_hint_unique(hint,
+          table::extractor::extract(boost::forward<Args>(args)...),
+          boost::forward<Args>(args)...);
+      }
+
+      std::pair<iterator, bool> insert(value_type const& x)
+      {
+        return this->emplace(x);
+      }
+
+      std::pair<iterator, bool> insert(BOOST_RV_REF(value_type) x)
+      {
+        return this->emplace(boost::move(x));
+      }
+
+      iterator insert(const_iterator hint, value_type const& x)
+      {
+        return this->emplace_hint(hint, x);
+      }
+
+      iterator insert(const_iterator hint, BOOST_RV_REF(value_type) x)
+      {
+        return this->emplace_hint(hint, boost::move(x));
+      }
+
+      template <class InputIt> void insert(InputIt, InputIt);
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+      void insert(std::initializer_list<value_type>);
+#endif
+
+      iterator erase(const_iterator);
+      size_type erase(const key_type&);
+      iterator erase(const_iterator, const_iterator);
+
+      void swap(unordered_flat_set&);
+      void clear() BOOST_NOEXCEPT { table_.clear_impl(); }
+
+      // observers
+
+      hasher hash_function() const;
+      key_equal key_eq() const;
+
+      // lookup
+
+      iterator find(const key_type&);
+      const_iterator find(const key_type&) const;
+
+      template <class CompatibleKey, class CompatibleHash,
+        class CompatiblePredicate>
+      iterator find(CompatibleKey const&, CompatibleHash const&,
+        CompatiblePredicate const&);
+
+      template <class CompatibleKey, class CompatibleHash,
+        class CompatiblePredicate>
+      const_iterator find(CompatibleKey const&, CompatibleHash const&,
+        CompatiblePredicate const&) const;
+
+      size_type count(const key_type&) const;
+
+      std::pair<iterator, iterator> equal_range(const key_type&);
+      std::pair<const_iterator, const_iterator> equal_range(
+        const key_type&) const;
+
+      // bucket interface
+
+      size_type bucket_count() const BOOST_NOEXCEPT
+      {
+        return table_.bucket_count_;
+      }
+
+      size_type max_bucket_count() const BOOST_NOEXCEPT
+      {
+        return table_.max_bucket_count();
+      }
+
+      // hash policy
+
+      float load_factor() const BOOST_NOEXCEPT;
+      float max_load_factor() const BOOST_NOEXCEPT
+      {
+        return table_.max_load_factor();
+      }
+      void max_load_factor(float) BOOST_NOEXCEPT {}
+      void rehash(size_type);
+      void reserve(size_type);
+
+#if !BOOST_WORKAROUND(__BORLANDC__, < 0x0582)
+      friend bool operator==<T, H, P, A>(
+        unordered_flat_set const&, unordered_flat_set const&);
+      friend bool operator!=<T, H, P, A>(
+        unordered_flat_set const&, unordered_flat_set const&);
+#endif
+    }; // class template unordered_flat_set
+
+    ////////////////////////////////////////////////////////////////////////////
+
+    template <class T, class H, class P, class A>
+    unordered_flat_set<T, H, P, A>::unordered_flat_set()
+        : table_(boost::unordered::detail::default_bucket_count, hasher(),
+            key_equal(), allocator_type())
+    {
+    }
+
+    template <class T, class H, class P, class A>
+    unordered_flat_set<T, H, P, A>::unordered_flat_set(size_type n,
+      const hasher& hf, const key_equal& eql, const allocator_type& a)
+        : table_(n, hf, eql, a)
+    {
+    }
+
+    template <class T, class H, class P, class A>
+    template <class InputIt>
+    unordered_flat_set<T, H, P, A>::unordered_flat_set(InputIt f,
+      InputIt l, size_type n, const hasher& hf, const key_equal& eql,
+      const allocator_type& a)
+        : table_(n, hf, eql, a)
+    {
+      this->insert(f, l);
+    }
+
+    template <class T, class H, class P, class A>
+    unordered_flat_set<T, H, P, A>::unordered_flat_set(
+      unordered_flat_set const& other)
+        : table_(other.table_,
+            unordered_flat_set::value_allocator_traits::
+              select_on_container_copy_construction(other.get_allocator()))
+    {
+      table_.copy_buckets(other.table_);
+    }
+
+    template <class T, class H, class P, class A>
+    unordered_flat_set<T, H, P, A>::unordered_flat_set(
+      allocator_type const& a)
+        : table_(boost::unordered::detail::default_bucket_count, hasher(),
+            key_equal(), a)
+    {
+    }
+
+    template <class T, class H, class P, class A>
+    unordered_flat_set<T, H, P, A>::unordered_flat_set(
+      unordered_flat_set const& other, allocator_type const& a)
+        : table_(other.table_, a)
+    {
+      table_.copy_buckets(other.table_);
+    }
+
+    template <class T, class H, class P, class A>
+    unordered_flat_set<T, H, P, A>::unordered_flat_set(
+      BOOST_RV_REF(unordered_flat_set) other, allocator_type const& a)
+        : table_(other.table_, a, boost::unordered::detail::move_tag())
+    {
+      if (table_.value_alloc() == other.table_.value_alloc()) {
+        table_.move_buckets_from(other.table_);
+      } else {
+        table_.move_buckets(other.table_);
+      }
+    }
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+
+    template <class T, class H, class P, class A>
+    unordered_flat_set<T, H, P, A>::unordered_flat_set(
+      std::initializer_list<value_type> list, size_type n, const hasher& hf,
+      const key_equal& eql, const allocator_type& a)
+        : table_(n, hf, eql, a)
+    {
+      this->insert(list.begin(), list.end());
+    }
+
+#endif
+
+    template <class T, class H, class P, class A>
+    unordered_flat_set<T, H, P, A>::unordered_flat_set(
+      size_type n, const allocator_type& a)
+        : table_(n, hasher(), key_equal(), a)
+    {
+    }
+
+    template <class T, class H, class P, class A>
+    unordered_flat_set<T, H, P, A>::unordered_flat_set(
+      size_type n, const hasher& hf, const allocator_type& a)
+        : table_(n, hf, key_equal(), a)
+    {
+    }
+
+    template <class T, class H, class P, class A>
+    template <class InputIt>
+    unordered_flat_set<T, H, P, A>::unordered_flat_set(
+      InputIt f, InputIt l, size_type n, const allocator_type& a)
+        : table_(n, hasher(), key_equal(), a)
+    {
+      this->insert(f, l);
+    }
+
+    template <class T, class H, class P, class A>
+    template <class InputIt>
+    unordered_flat_set<T, H, P, A>::unordered_flat_set(InputIt f,
+      InputIt l, size_type n, const hasher& hf, const allocator_type& a)
+        : table_(n, hf, key_equal(), a)
+    {
+      this->insert(f, l);
+    }
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+
+    template <class T, class H, class P, class A>
+    unordered_flat_set<T, H, P, A>::unordered_flat_set(
+      std::initializer_list<value_type> list, size_type n,
+      const allocator_type& a)
+        : table_(n, hasher(), key_equal(), a)
+    {
+      this->insert(list.begin(), list.end());
+    }
+
+    template <class T, class H, class P, class A>
+    unordered_flat_set<T, H, P, A>::unordered_flat_set(
+      std::initializer_list<value_type> list, size_type n, const hasher& hf,
+      const allocator_type& a)
+        : table_(n, hf, key_equal(), a)
+    {
+      this->insert(list.begin(), list.end());
+    }
+
+#endif
+
+    template <class T, class H, class P, class A>
+    unordered_flat_set<T, H, P, A>::~unordered_flat_set() BOOST_NOEXCEPT
+    {
+    }
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+
+    template <class T, class H, class P, class A>
+    unordered_flat_set<T, H, P, A>& unordered_flat_set<T, H, P, A>::
+    operator=(std::initializer_list<value_type> list)
+    {
+      table_.clear_impl();
+      this->insert(list.begin(), list.end());
+      return *this;
+    }
+
+#endif
+
+    // size and capacity
+
+    template <class T, class H, class P, class A>
+    std::size_t unordered_flat_set<T, H, P, A>::max_size() const
+      BOOST_NOEXCEPT
+    {
+      using namespace std;
+
+      // size <= mlf * count
+      return boost::unordered::detail::double_to_size(
+        floor(static_cast<double>(table_.max_load_factor()) *
+              static_cast<double>(table_.max_bucket_count())));
+    }
+
+    // modifiers
+
+    template <class T, class H, class P, class A>
+    template <class InputIt>
+    void unordered_flat_set<T, H, P, A>::insert(InputIt first, InputIt last)
+    {
+      table_.insert_range_unique(first, last);
+    }
+
+#if !defined(BOOST_NO_CXX11_HDR_INITIALIZER_LIST)
+    template <class T, class H, class P, class A>
+    void unordered_flat_set<T, H, P, A>::insert(
+      std::initializer_list<value_type> list)
+    {
+      this->insert(list.begin(), list.end());
+    }
+#endif
+
+    template <class T, class H, class P, class A>
+    typename unordered_flat_set<T, H, P, A>::iterator
+    unordered_flat_set<T, H, P, A>::erase(const_iterator position)
+    {
+      return table_.erase(position);
+    }
+
+    template <class T, class H, class P, class A>
+    typename unordered_flat_set<T, H, P, A>::size_type
+    unordered_flat_set<T, H, P, A>::erase(const key_type& k)
+    {
+      return table_.erase_key_unique(k);
+    }
+
+    template <class T, class H, class P, class A>
+    typename unordered_flat_set<T, H, P, A>::iterator
+    unordered_flat_set<T, H, P, A>::erase(
+      const_iterator first, const_iterator last)
+    {
+      return table_.erase_range(first, last);
+    }
+
+    template <class T, class H, class P, class A>
+    void unordered_flat_set<T, H, P, A>::swap(unordered_flat_set& other)
+    {
+      table_.swap(other.table_);
+    }
+
+    // observers
+
+    template <class T, class H, class P, class A>
+    typename unordered_flat_set<T, H, P, A>::hasher
+    unordered_flat_set<T, H, P, A>::hash_function() const
+    {
+      return table_.hash_function();
+    }
+
+    template <class T, class H, class P, class A>
+    typename unordered_flat_set<T, H, P, A>::key_equal
+    unordered_flat_set<T, H, P, A>::key_eq() const
+    {
+      return table_.key_eq();
+    }
+
+    // lookup
+
+    template <class T, class H, class P, class A>
+    typename unordered_flat_set<T, H, P, A>::iterator
+    unordered_flat_set<T, H, P, A>::find(const key_type& k)
+    {
+      return table_.find(k);
+    }
+
+    template <class T, class H, class P, class A>
+    typename unordered_flat_set<T, H, P, A>::const_iterator
+    unordered_flat_set<T, H, P, A>::find(const key_type& k) const
+    {
+      return table_.find(k);
+    }
+
+    template <class T, class H, class P, class A>
+    template <class CompatibleKey, class CompatibleHash,
+      class CompatiblePredicate>
+    typename unordered_flat_set<T, H, P, A>::iterator
+    unordered_flat_set<T, H, P, A>::find(CompatibleKey const& k,
+      CompatibleHash const& hash, CompatiblePredicate const& eq)
+    {
+      return table_.get_iterator(
+        table_.find_bucket_impl(table::policy::apply_hash(hash, k), k, eq));
+    }
+
+    template <class T, class H, class P, class A>
+    template <class CompatibleKey, class CompatibleHash,
+      class CompatiblePredicate>
+    typename unordered_flat_set<T, H, P, A>::const_iterator
+    unordered_flat_set<T, H, P, A>::find(CompatibleKey const& k,
+      CompatibleHash const& hash, CompatiblePredicate const& eq) const
+    {
+      return table_.get_iterator(
+        table_.find_bucket_impl(table::policy::apply_hash(hash, k), k, eq));
+    }
+
+    template <class T, class H, class P, class A>
+    typename unordered_flat_set<T, H, P, A>::size_type
+    unordered_flat_set<T, H, P, A>::count(const key_type& k) const
+    {
+      return table_.find_bucket(k) != table_.bucket_count_ ? 1 : 0;
+    }
+
+    template <class T, class H, class P, class A>
+    std::pair<typename unordered_flat_set<T, H, P, A>::iterator,
+      typename unordered_flat_set<T, H, P, A>::iterator>
+    unordered_flat_set<T, H, P, A>::equal_range(const key_type& k)
+    {
+      iterator first = table_.find(k);
+      iterator last = first;
+      if (last != iterator())
+        ++last;
+      return std::make_pair(first, last);
+    }
+
+    template <class T, class H, class P, class A>
+    std::pair<typename unordered_flat_set<T, H, P, A>::const_iterator,
+      typename unordered_flat_set<T, H, P, A>::const_iterator>
+    unordered_flat_set<T, H, P, A>::equal_range(const key_type& k) const
+    {
+      const_iterator first = table_.find(k);
+      const_iterator last = first;
+      if (last != const_iterator())
+        ++last;
+      return std::make_pair(first, last);
+    }
+
+    // hash policy
+
+    template <class T, class H, class P, class A>
+    float unordered_flat_set<T, H, P, A>::load_factor() const BOOST_NOEXCEPT
+    {
+      BOOST_ASSERT(table_.bucket_count_ != 0);
+      return static_cast<float>(table_.size_) /
+             static_cast<float>(table_.bucket_count_);
+    }
+
+    template <class T, class H, class P, class A>
+    void unordered_flat_set<T, H, P, A>::rehash(size_type n)
+    {
+      table_.rehash(n);
+    }
+
+    template <class T, class H, class P, class A>
+    void unordered_flat_set<T, H, P, A>::reserve(size_type n)
+    {
+      table_.reserve(n);
+    }
+
+    template <class T, class H, class P, class A>
+    inline bool operator==(unordered_flat_set<T, H, P, A> const& m1,
+      unordered_flat_set<T, H, P, A> const& m2)
+    {
+      return m1.table_.equals_unique(m2.table_);
+    }
+
+    template <class T, class H, class P, class A>
+    inline bool operator!=(unordered_flat_set<T, H, P, A> const& m1,
+      unordered_flat_set<T, H, P, A> const& m2)
+    {
+      return !m1.table_.equals_unique(m2.table_);
+    }
+
+    template <class T, class H, class P, class A>
+    inline void swap(unordered_flat_set<T, H, P, A>& m1,
+      unordered_flat_set<T, H, P, A>& m2)
+      BOOST_NOEXCEPT_IF(BOOST_NOEXCEPT_EXPR(m1.swap(m2)))
+    {
+      m1.swap(m2);
+    }
+  } // namespace unordered
+} // namespace boost
+
+#if defined(BOOST_MSVC)
+#pragma warning(pop)
+#endif
+
+#endif // BOOST_UNORDERED_UNORDERED_FLAT_SET_HPP_INCLUDED
@@ -0,0 +1,43 @@
+
+// Copyright (C) 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_UNORDERED_FLAT_SET_FWD_HPP_INCLUDED
+#define BOOST_UNORDERED_FLAT_SET_FWD_HPP_INCLUDED
+
+#include <boost/config.hpp>
+#if defined(BOOST_HAS_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <boost/functional/hash_fwd.hpp>
+#include <boost/unordered/detail/fwd.hpp>
+#include <functional>
+#include <memory>
+
+namespace boost {
+  namespace unordered {
+    template <class T, class H = boost::hash<T>, class P = std::equal_to<T>,
+      class A = std::allocator<T> >
+    class unordered_flat_set;
+
+    template <class T, class H, class P, class A>
+    inline bool operator==(unordered_flat_set<T, H, P, A> const&,
+      unordered_flat_set<T, H, P, A> const&);
+    template <class T, class H, class P, class A>
+    inline bool operator!=(unordered_flat_set<T, H, P, A> const&,
+      unordered_flat_set<T, H, P, A> const&);
+    template <class T, class H, class P, class A>
+    inline void swap(
+      unordered_flat_set<T, H, P, A>& m1, unordered_flat_set<T, H, P, A>& m2)
+      BOOST_NOEXCEPT_IF(BOOST_NOEXCEPT_EXPR(m1.swap(m2)));
+  }
+
+  using boost::unordered::unordered_flat_set;
+  using boost::unordered::swap;
+  using boost::unordered::operator==;
+  using boost::unordered::operator!=;
+}
+
+#endif
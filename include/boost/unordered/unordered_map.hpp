@@ -72,8 +72,11 @@ namespace boost {
       typedef typename table::c_iterator const_iterator;
       typedef typename table::l_iterator local_iterator;
       typedef typename table::cl_iterator const_local_iterator;
+      typedef typename table::r_iterator range_iterator;
+      typedef typename table::cr_iterator const_range_iterator;
       typedef typename types::node_type node_type;
       typedef typename types::insert_return_type insert_return_type;
+      typedef boost::unordered::map_entry<table> entry_type;
 
     private:
       table table_;
@@ -372,6 +375,38 @@ namespace boost {
 
 #undef BOOST_UNORDERED_EMPLACE
 
+#endif
+
+      // Emplace using a hash value that has already been computed by
+      // 'hash_function()', e.g. to pick a container.
+
+#if !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+
+      template <class... Args>
+      std::pair<iterator, bool> emplace_with_hash(
+        std::size_t hash_value, BOOST_FWD_REF(Args)... args)
+      {
+        return table_.emplace_with_hash_unique(
+          hash_value, boost::forward<Args>(args)...);
+      }
+
+#else
+
+#define BOOST_UNORDERED_EMPLACE_WITH_HASH(z, n, _)                             \
+  template <BOOST_PP_ENUM_PARAMS_Z(z, n, typename A)>                          \
+  std::pair<iterator, bool> emplace_with_hash(std::size_t hash_value,          \
+    BOOST_PP_ENUM_##z(n, BOOST_UNORDERED_FWD_PARAM, a))                        \
+  {                                                                            \
+    return table_.emplace_with_hash_unique(hash_value,                         \
+      boost::unordered::detail::create_emplace_args(                           \
+        BOOST_PP_ENUM_##z(n, BOOST_UNORDERED_CALL_FORWARD, a)));               \
+  }
+
+      BOOST_PP_REPEAT_FROM_TO(1, BOOST_PP_INC(BOOST_UNORDERED_EMPLACE_LIMIT),
+        BOOST_UNORDERED_EMPLACE_WITH_HASH, _)
+
+#undef BOOST_UNORDERED_EMPLACE_WITH_HASH
+
 #endif
 
       std::pair<iterator, bool> insert(value_type const& x)
@@ -418,6 +453,13 @@ namespace boost {
       void insert(std::initializer_list<value_type>);
 #endif
 
+#if defined(BOOST_UNORDERED_ENABLE_PARALLEL)
+      // Insert a random access range using several threads, one for each
+      // core by default. Only faster when the container is empty.
+      template <class RandomIt>
+      void insert_parallel(RandomIt, RandomIt, std::size_t threads = 0);
+#endif
+
       // extract
 
       node_type extract(const_iterator position)
@@ -713,6 +755,18 @@ namespace boost {
       iterator erase(iterator);
       iterator erase(const_iterator);
       size_type erase(const key_type&);
+      size_type erase(const key_type&, std::size_t hash_value);
+
+      template <class Key>
+      typename boost::enable_if_c<
+        boost::unordered::detail::transparent_non_iterable<Key,
+          unordered_map>::value,
+        size_type>::type
+      erase(Key const& k)
+      {
+        return table_.erase_key_unique_impl(k);
+      }
+
       iterator erase(const_iterator, const_iterator);
       BOOST_UNORDERED_DEPRECATED("Use erase instead")
       void quick_erase(const_iterator it) { erase(it); }
@@ -752,6 +806,11 @@ namespace boost {
       iterator find(const key_type&);
       const_iterator find(const key_type&) const;
 
+      // Lookup using a hash value that has already been computed by
+      // 'hash_function()'.
+      iterator find(const key_type&, std::size_t hash_value);
+      const_iterator find(const key_type&, std::size_t hash_value) const;
+
       template <class CompatibleKey, class CompatibleHash,
         class CompatiblePredicate>
       iterator find(CompatibleKey const&, CompatibleHash const&,
@@ -762,22 +821,116 @@ namespace boost {
       const_iterator find(CompatibleKey const&, CompatibleHash const&,
         CompatiblePredicate const&) const;
 
+      template <class ForwardIt, class OutputIt>
+      OutputIt find_many(ForwardIt, ForwardIt, OutputIt);
+
+      template <class ForwardIt, class OutputIt>
+      OutputIt find_many(ForwardIt, ForwardIt, OutputIt) const;
+
+      // Look up a key, so that it can be inserted without hashing it again.
+      entry_type entry(const key_type&);
+      entry_type entry(BOOST_RV_REF(key_type));
+
+      bool contains(const key_type&) const;
+
       size_type count(const key_type&) const;
 
       std::pair<iterator, iterator> equal_range(const key_type&);
       std::pair<const_iterator, const_iterator> equal_range(
         const key_type&) const;
 
+      template <class Key>
+      typename boost::unordered::detail::enable_if_transparent<Key, H, P,
+        iterator>::type
+      find(Key const& k)
+      {
+        return iterator(table_.find_node_transparent(k));
+      }
+
+      template <class Key>
+      typename boost::unordered::detail::enable_if_transparent<Key, H, P,
+        const_iterator>::type
+      find(Key const& k) const
+      {
+        return const_iterator(table_.find_node_transparent(k));
+      }
+
+      template <class Key>
+      typename boost::unordered::detail::enable_if_transparent<Key, H, P,
+        bool>::type
+      contains(Key const& k) const
+      {
+        return table_.find_node_transparent(k) ? true : false;
+      }
+
+      template <class Key>
+      typename boost::unordered::detail::enable_if_transparent<Key, H, P,
+        size_type>::type
+      count(Key const& k) const
+      {
+        return table_.find_node_transparent(k) ? 1 : 0;
+      }
+
+      template <class Key>
+      typename boost::unordered::detail::enable_if_transparent<Key, H, P,
+        std::pair<iterator, iterator> >::type
+      equal_range(Key const& k)
+      {
+        node_pointer n = table_.find_node_transparent(k);
+        return std::make_pair(
+          iterator(n), iterator(n ? table::next_node(n) : n));
+      }
+
+      template <class Key>
+      typename boost::unordered::detail::enable_if_transparent<Key, H, P,
+        std::pair<const_iterator, const_iterator> >::type
+      equal_range(Key const& k) const
+      {
+        node_pointer n = table_.find_node_transparent(k);
+        return std::make_pair(
+          const_iterator(n), const_iterator(n ? table::next_node(n) : n));
+      }
+
       mapped_type& operator[](const key_type&);
       mapped_type& operator[](BOOST_RV_REF(key_type));
       mapped_type& at(const key_type&);
       mapped_type const& at(const key_type&) const;
 
+      template <class Key>
+      typename boost::unordered::detail::enable_if_transparent<Key, H, P,
+        mapped_type&>::type
+      at(Key const& k)
+      {
+        if (table_.size_) {
+          node_pointer n = table_.find_node_transparent(k);
+          if (n)
+            return n->value().second;
+        }
+
+        boost::throw_exception(
+          std::out_of_range("Unable to find key in unordered_map."));
+      }
+
+      template <class Key>
+      typename boost::unordered::detail::enable_if_transparent<Key, H, P,
+        mapped_type const&>::type
+      at(Key const& k) const
+      {
+        if (table_.size_) {
+          node_pointer n = table_.find_node_transparent(k);
+          if (n)
+            return n->value().second;
+        }
+
+        boost::throw_exception(
+          std::out_of_range("Unable to find key in unordered_map."));
+      }
+
       // bucket interface
 
       size_type bucket_count() const BOOST_NOEXCEPT
       {
-        return table_.bucket_count_;
+        return table_.local_bucket_count();
       }
 
       size_type max_bucket_count() const BOOST_NOEXCEPT
@@ -789,17 +942,17 @@ namespace boost {
 
       size_type bucket(const key_type& k) const
       {
-        return table_.hash_to_bucket(table_.hash(k));
+        return table_.local_bucket(k);
       }
 
       local_iterator begin(size_type n)
       {
-        return local_iterator(table_.begin(n), n, table_.bucket_count_);
+        return table_.local_begin(n);
       }
 
       const_local_iterator begin(size_type n) const
       {
-        return const_local_iterator(table_.begin(n), n, table_.bucket_count_);
+        return const_local_iterator(table_.local_begin(n));
       }
 
       local_iterator end(size_type) { return local_iterator(); }
@@ -811,7 +964,7 @@ namespace boost {
 
       const_local_iterator cbegin(size_type n) const
       {
-        return const_local_iterator(table_.begin(n), n, table_.bucket_count_);
+        return const_local_iterator(table_.local_begin(n));
       }
 
       const_local_iterator cend(size_type) const
@@ -819,6 +972,43 @@ namespace boost {
         return const_local_iterator();
       }
 
+      // Split the buckets into 'count' ranges, to visit the elements on
+      // several threads.
+
+      range_iterator range_begin(size_type index, size_type count)
+      {
+        return table_.range_begin(index, count);
+      }
+
+      const_range_iterator range_begin(size_type index, size_type count) const
+      {
+        return const_range_iterator(table_.range_begin(index, count));
+      }
+
+      range_iterator range_end(size_type, size_type)
+      {
+        return range_iterator();
+      }
+
+      const_range_iterator range_end(size_type, size_type) const
+      {
+        return const_range_iterator();
+      }
+
+#if defined(BOOST_UNORDERED_ENABLE_PARALLEL)
+      // Call 'f' for every element, using several threads.
+      template <class F> void for_each_parallel(F f, std::size_t threads = 0)
+      {
+        table_.template for_each_parallel<range_iterator>(f, threads);
+      }
+
+      template <class F>
+      void for_each_parallel(F f, std::size_t threads = 0) const
+      {
+        table_.template for_each_parallel<const_range_iterator>(f, threads);
+      }
+#endif
+
       // hash policy
 
       float load_factor() const BOOST_NOEXCEPT;
@@ -827,6 +1017,18 @@ namespace boost {
       void rehash(size_type);
       void reserve(size_type);
 
+#if defined(BOOST_UNORDERED_ENABLE_PARALLEL)
+      // Rehash using several threads, one for each core by default.
+      void rehash_parallel(size_type, std::size_t threads = 0);
+#endif
+
+#if defined(BOOST_UNORDERED_ENABLE_STATS)
+      // statistics
+
+      boost::unordered::stats get_stats() const { return table_.get_stats(); }
+      void reset_stats() { table_.reset_stats(); }
+#endif
+
 #if !BOOST_WORKAROUND(__BORLANDC__, < 0x0582)
       friend bool operator==
         <K, T, H, P, A>(unordered_map const&, unordered_map const&);
@@ -873,6 +1075,8 @@ namespace boost {
       typedef typename table::c_iterator const_iterator;
       typedef typename table::l_iterator local_iterator;
       typedef typename table::cl_iterator const_local_iterator;
+      typedef typename table::r_iterator range_iterator;
+      typedef typename table::cr_iterator const_range_iterator;
       typedef typename types::node_type node_type;
 
     private:
@@ -1172,6 +1376,41 @@ namespace boost {
 
 #undef BOOST_UNORDERED_EMPLACE
 
+#endif
+
+      // Emplace using a hash value that has already been computed by
+      // 'hash_function()', e.g. to pick a container.
+
+#if !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+
+      template <class... Args>
+      iterator emplace_with_hash(
+        std::size_t hash_value, BOOST_FWD_REF(Args)... args)
+      {
+        return iterator(table_.emplace_with_hash_equiv(hash_value,
+          boost::unordered::detail::func::construct_node_from_args(
+            table_.node_alloc(), boost::forward<Args>(args)...)));
+      }
+
+#else
+
+#define BOOST_UNORDERED_EMPLACE_WITH_HASH(z, n, _)                             \
+  template <BOOST_PP_ENUM_PARAMS_Z(z, n, typename A)>                          \
+  iterator emplace_with_hash(std::size_t hash_value,                           \
+    BOOST_PP_ENUM_##z(n, BOOST_UNORDERED_FWD_PARAM, a))                        \
+  {                                                                            \
+    return iterator(table_.emplace_with_hash_equiv(hash_value,                 \
+      boost::unordered::detail::func::construct_node_from_args(                \
+        table_.node_alloc(),                                                   \
+        boost::unordered::detail::create_emplace_args(                         \
+          BOOST_PP_ENUM_##z(n, BOOST_UNORDERED_CALL_FORWARD, a)))));           \
+  }
+
+      BOOST_PP_REPEAT_FROM_TO(1, BOOST_PP_INC(BOOST_UNORDERED_EMPLACE_LIMIT),
+        BOOST_UNORDERED_EMPLACE_WITH_HASH, _)
+
+#undef BOOST_UNORDERED_EMPLACE_WITH_HASH
+
 #endif
 
       iterator insert(value_type const& x) { return this->emplace(x); }
@@ -1215,6 +1454,13 @@ namespace boost {
       void insert(std::initializer_list<value_type>);
 #endif
 
+#if defined(BOOST_UNORDERED_ENABLE_PARALLEL)
+      // Insert a random access range using several threads, one for each
+      // core by default. Only faster when the container is empty.
+      template <class RandomIt>
+      void insert_parallel(RandomIt, RandomIt, std::size_t threads = 0);
+#endif
+
       // extract
 
       node_type extract(const_iterator position)
@@ -1251,6 +1497,18 @@ namespace boost {
       iterator erase(iterator);
       iterator erase(const_iterator);
       size_type erase(const key_type&);
+      size_type erase(const key_type&, std::size_t hash_value);
+
+      template <class Key>
+      typename boost::enable_if_c<
+        boost::unordered::detail::transparent_non_iterable<Key,
+          unordered_multimap>::value,
+        size_type>::type
+      erase(Key const& k)
+      {
+        return table_.erase_key_equiv_impl(k);
+      }
+
       iterator erase(const_iterator, const_iterator);
       BOOST_UNORDERED_DEPRECATED("Use erase instead")
       void quick_erase(const_iterator it) { erase(it); }
@@ -1290,6 +1548,11 @@ namespace boost {
       iterator find(const key_type&);
       const_iterator find(const key_type&) const;
 
+      // Lookup using a hash value that has already been computed by
+      // 'hash_function()'.
+      iterator find(const key_type&, std::size_t hash_value);
+      const_iterator find(const key_type&, std::size_t hash_value) const;
+
       template <class CompatibleKey, class CompatibleHash,
         class CompatiblePredicate>
       iterator find(CompatibleKey const&, CompatibleHash const&,
@@ -1300,17 +1563,78 @@ namespace boost {
       const_iterator find(CompatibleKey const&, CompatibleHash const&,
         CompatiblePredicate const&) const;
 
+      template <class ForwardIt, class OutputIt>
+      OutputIt find_many(ForwardIt, ForwardIt, OutputIt);
+
+      template <class ForwardIt, class OutputIt>
+      OutputIt find_many(ForwardIt, ForwardIt, OutputIt) const;
+
+      bool contains(const key_type&) const;
+
       size_type count(const key_type&) const;
 
       std::pair<iterator, iterator> equal_range(const key_type&);
       std::pair<const_iterator, const_iterator> equal_range(
         const key_type&) const;
 
+      template <class Key>
+      typename boost::unordered::detail::enable_if_transparent<Key, H, P,
+        iterator>::type
+      find(Key const& k)
+      {
+        return iterator(table_.find_node_transparent(k));
+      }
+
+      template <class Key>
+      typename boost::unordered::detail::enable_if_transparent<Key, H, P,
+        const_iterator>::type
+      find(Key const& k) const
+      {
+        return const_iterator(table_.find_node_transparent(k));
+      }
+
+      template <class Key>
+      typename boost::unordered::detail::enable_if_transparent<Key, H, P,
+        bool>::type
+      contains(Key const& k) const
+      {
+        return table_.find_node_transparent(k) ? true : false;
+      }
+
+      template <class Key>
+      typename boost::unordered::detail::enable_if_transparent<Key, H, P,
+        size_type>::type
+      count(Key const& k) const
+      {
+        node_pointer n = table_.find_node_transparent(k);
+        return n ? table_.group_count(n) : 0;
+      }
+
+      template <class Key>
+      typename boost::unordered::detail::enable_if_transparent<Key, H, P,
+        std::pair<iterator, iterator> >::type
+      equal_range(Key const& k)
+      {
+        node_pointer n = table_.find_node_transparent(k);
+        return std::make_pair(
+          iterator(n), iterator(n ? table_.next_group(n) : n));
+      }
+
+      template <class Key>
+      typename boost::unordered::detail::enable_if_transparent<Key, H, P,
+        std::pair<const_iterator, const_iterator> >::type
+      equal_range(Key const& k) const
+      {
+        node_pointer n = table_.find_node_transparent(k);
+        return std::make_pair(
+          const_iterator(n), const_iterator(n ? table_.next_group(n) : n));
+      }
+
       // bucket interface
 
       size_type bucket_count() const BOOST_NOEXCEPT
       {
-        return table_.bucket_count_;
+        return table_.local_bucket_count();
       }
 
       size_type max_bucket_count() const BOOST_NOEXCEPT
@@ -1322,17 +1646,17 @@ namespace boost {
 
       size_type bucket(const key_type& k) const
       {
-        return table_.hash_to_bucket(table_.hash(k));
+        return table_.local_bucket(k);
       }
 
       local_iterator begin(size_type n)
       {
-        return local_iterator(table_.begin(n), n, table_.bucket_count_);
+        return table_.local_begin(n);
       }
 
       const_local_iterator begin(size_type n) const
       {
-        return const_local_iterator(table_.begin(n), n, table_.bucket_count_);
+        return const_local_iterator(table_.local_begin(n));
       }
 
       local_iterator end(size_type) { return local_iterator(); }
@@ -1344,7 +1668,7 @@ namespace boost {
 
       const_local_iterator cbegin(size_type n) const
       {
-        return const_local_iterator(table_.begin(n), n, table_.bucket_count_);
+        return const_local_iterator(table_.local_begin(n));
       }
 
       const_local_iterator cend(size_type) const
@@ -1352,6 +1676,43 @@ namespace boost {
         return const_local_iterator();
       }
 
+      // Split the buckets into 'count' ranges, to visit the elements on
+      // several threads.
+
+      range_iterator range_begin(size_type index, size_type count)
+      {
+        return table_.range_begin(index, count);
+      }
+
+      const_range_iterator range_begin(size_type index, size_type count) const
+      {
+        return const_range_iterator(table_.range_begin(index, count));
+      }
+
+      range_iterator range_end(size_type, size_type)
+      {
+        return range_iterator();
+      }
+
+      const_range_iterator range_end(size_type, size_type) const
+      {
+        return const_range_iterator();
+      }
+
+#if defined(BOOST_UNORDERED_ENABLE_PARALLEL)
+      // Call 'f' for every element, using several threads.
+      template <class F> void for_each_parallel(F f, std::size_t threads = 0)
+      {
+        table_.template for_each_parallel<range_iterator>(f, threads);
+      }
+
+      template <class F>
+      void for_each_parallel(F f, std::size_t threads = 0) const
+      {
+        table_.template for_each_parallel<const_range_iterator>(f, threads);
+      }
+#endif
+
       // hash policy
 
       float load_factor() const BOOST_NOEXCEPT;
@@ -1360,6 +1721,18 @@ namespace boost {
       void rehash(size_type);
       void reserve(size_type);
 
+#if defined(BOOST_UNORDERED_ENABLE_PARALLEL)
+      // Rehash using several threads, one for each core by default.
+      void rehash_parallel(size_type, std::size_t threads = 0);
+#endif
+
+#if defined(BOOST_UNORDERED_ENABLE_STATS)
+      // statistics
+
+      boost::unordered::stats get_stats() const { return table_.get_stats(); }
+      void reset_stats() { table_.reset_stats(); }
+#endif
+
 #if !BOOST_WORKAROUND(__BORLANDC__, < 0x0582)
       friend bool operator==
         <K, T, H, P, A>(unordered_multimap const&, unordered_multimap const&);
@@ -1565,6 +1938,19 @@ namespace boost {
     }
 #endif
 
+#if defined(BOOST_UNORDERED_ENABLE_PARALLEL)
+    template <class K, class T, class H, class P, class A>
+    template <class RandomIt>
+    void unordered_map<K, T, H, P, A>::insert_parallel(
+      RandomIt first, RandomIt last, std::size_t threads)
+    {
+      if (!table_.build_parallel(
+            first, last, threads, boost::unordered::detail::true_type())) {
+        this->insert(first, last);
+      }
+    }
+#endif
+
     template <class K, class T, class H, class P, class A>
     typename unordered_map<K, T, H, P, A>::iterator
     unordered_map<K, T, H, P, A>::erase(iterator position)
@@ -1594,6 +1980,14 @@ namespace boost {
       return table_.erase_key_unique(k);
     }
 
+    template <class K, class T, class H, class P, class A>
+    typename unordered_map<K, T, H, P, A>::size_type
+    unordered_map<K, T, H, P, A>::erase(
+      const key_type& k, std::size_t hash_value)
+    {
+      return table_.erase_key_unique(k, hash_value);
+    }
+
     template <class K, class T, class H, class P, class A>
     typename unordered_map<K, T, H, P, A>::iterator
     unordered_map<K, T, H, P, A>::erase(
@@ -1684,6 +2078,38 @@ namespace boost {
       return const_iterator(table_.find_node(k));
     }
 
+    template <class K, class T, class H, class P, class A>
+    typename unordered_map<K, T, H, P, A>::iterator
+    unordered_map<K, T, H, P, A>::find(
+      const key_type& k, std::size_t hash_value)
+    {
+      return iterator(
+        table_.find_node(table_.precomputed_hash(k, hash_value), k));
+    }
+
+    template <class K, class T, class H, class P, class A>
+    typename unordered_map<K, T, H, P, A>::const_iterator
+    unordered_map<K, T, H, P, A>::find(
+      const key_type& k, std::size_t hash_value) const
+    {
+      return const_iterator(
+        table_.find_node(table_.precomputed_hash(k, hash_value), k));
+    }
+
+    template <class K, class T, class H, class P, class A>
+    typename unordered_map<K, T, H, P, A>::entry_type
+    unordered_map<K, T, H, P, A>::entry(const key_type& k)
+    {
+      return entry_type(table_, k);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    typename unordered_map<K, T, H, P, A>::entry_type
+    unordered_map<K, T, H, P, A>::entry(BOOST_RV_REF(key_type) k)
+    {
+      return entry_type(table_, boost::move(k));
+    }
+
     template <class K, class T, class H, class P, class A>
     template <class CompatibleKey, class CompatibleHash,
       class CompatiblePredicate>
@@ -1706,6 +2132,28 @@ namespace boost {
         table_.find_node_impl(table::policy::apply_hash(hash, k), k, eq));
     }
 
+    template <class K, class T, class H, class P, class A>
+    template <class ForwardIt, class OutputIt>
+    OutputIt unordered_map<K, T, H, P, A>::find_many(
+      ForwardIt first, ForwardIt last, OutputIt out)
+    {
+      return table_.template find_many<iterator>(first, last, out);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    template <class ForwardIt, class OutputIt>
+    OutputIt unordered_map<K, T, H, P, A>::find_many(
+      ForwardIt first, ForwardIt last, OutputIt out) const
+    {
+      return table_.template find_many<const_iterator>(first, last, out);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    bool unordered_map<K, T, H, P, A>::contains(const key_type& k) const
+    {
+      return table_.find_node(k) ? true : false;
+    }
+
     template <class K, class T, class H, class P, class A>
     typename unordered_map<K, T, H, P, A>::size_type
     unordered_map<K, T, H, P, A>::count(const key_type& k) const
@@ -1788,7 +2236,7 @@ namespace boost {
     {
       BOOST_ASSERT(table_.bucket_count_ != 0);
       return static_cast<float>(table_.size_) /
-             static_cast<float>(table_.bucket_count_);
+             static_cast<float>(table_.local_bucket_count());
     }
 
     template <class K, class T, class H, class P, class A>
@@ -1803,6 +2251,15 @@ namespace boost {
       table_.rehash(n);
     }
 
+#if defined(BOOST_UNORDERED_ENABLE_PARALLEL)
+    template <class K, class T, class H, class P, class A>
+    void unordered_map<K, T, H, P, A>::rehash_parallel(
+      size_type n, std::size_t threads)
+    {
+      table_.rehash_parallel(n, threads);
+    }
+#endif
+
     template <class K, class T, class H, class P, class A>
     void unordered_map<K, T, H, P, A>::reserve(size_type n)
     {
@@ -2047,6 +2504,19 @@ namespace boost {
     }
 #endif
 
+#if defined(BOOST_UNORDERED_ENABLE_PARALLEL)
+    template <class K, class T, class H, class P, class A>
+    template <class RandomIt>
+    void unordered_multimap<K, T, H, P, A>::insert_parallel(
+      RandomIt first, RandomIt last, std::size_t threads)
+    {
+      if (!table_.build_parallel(
+            first, last, threads, boost::unordered::detail::false_type())) {
+        this->insert(first, last);
+      }
+    }
+#endif
+
     template <class K, class T, class H, class P, class A>
     typename unordered_multimap<K, T, H, P, A>::iterator
     unordered_multimap<K, T, H, P, A>::erase(iterator position)
@@ -2076,6 +2546,14 @@ namespace boost {
       return table_.erase_key_equiv(k);
     }
 
+    template <class K, class T, class H, class P, class A>
+    typename unordered_multimap<K, T, H, P, A>::size_type
+    unordered_multimap<K, T, H, P, A>::erase(
+      const key_type& k, std::size_t hash_value)
+    {
+      return table_.erase_key_equiv(k, hash_value);
+    }
+
     template <class K, class T, class H, class P, class A>
     typename unordered_multimap<K, T, H, P, A>::iterator
     unordered_multimap<K, T, H, P, A>::erase(
@@ -2174,6 +2652,24 @@ namespace boost {
       return const_iterator(table_.find_node(k));
     }
 
+    template <class K, class T, class H, class P, class A>
+    typename unordered_multimap<K, T, H, P, A>::iterator
+    unordered_multimap<K, T, H, P, A>::find(
+      const key_type& k, std::size_t hash_value)
+    {
+      return iterator(
+        table_.find_node(table_.precomputed_hash(k, hash_value), k));
+    }
+
+    template <class K, class T, class H, class P, class A>
+    typename unordered_multimap<K, T, H, P, A>::const_iterator
+    unordered_multimap<K, T, H, P, A>::find(
+      const key_type& k, std::size_t hash_value) const
+    {
+      return const_iterator(
+        table_.find_node(table_.precomputed_hash(k, hash_value), k));
+    }
+
     template <class K, class T, class H, class P, class A>
     template <class CompatibleKey, class CompatibleHash,
       class CompatiblePredicate>
@@ -2196,6 +2692,28 @@ namespace boost {
         table_.find_node_impl(table::policy::apply_hash(hash, k), k, eq));
     }
 
+    template <class K, class T, class H, class P, class A>
+    template <class ForwardIt, class OutputIt>
+    OutputIt unordered_multimap<K, T, H, P, A>::find_many(
+      ForwardIt first, ForwardIt last, OutputIt out)
+    {
+      return table_.template find_many<iterator>(first, last, out);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    template <class ForwardIt, class OutputIt>
+    OutputIt unordered_multimap<K, T, H, P, A>::find_many(
+      ForwardIt first, ForwardIt last, OutputIt out) const
+    {
+      return table_.template find_many<const_iterator>(first, last, out);
+    }
+
+    template <class K, class T, class H, class P, class A>
+    bool unordered_multimap<K, T, H, P, A>::contains(const key_type& k) const
+    {
+      return table_.find_node(k) ? true : false;
+    }
+
     template <class K, class T, class H, class P, class A>
     typename unordered_multimap<K, T, H, P, A>::size_type
     unordered_multimap<K, T, H, P, A>::count(const key_type& k) const
@@ -2238,7 +2756,7 @@ namespace boost {
     {
       BOOST_ASSERT(table_.bucket_count_ != 0);
       return static_cast<float>(table_.size_) /
-             static_cast<float>(table_.bucket_count_);
+             static_cast<float>(table_.local_bucket_count());
     }
 
     template <class K, class T, class H, class P, class A>
@@ -2254,6 +2772,15 @@ namespace boost {
       table_.rehash(n);
     }
 
+#if defined(BOOST_UNORDERED_ENABLE_PARALLEL)
+    template <class K, class T, class H, class P, class A>
+    void unordered_multimap<K, T, H, P, A>::rehash_parallel(
+      size_type n, std::size_t threads)
+    {
+      table_.rehash_parallel(n, threads);
+    }
+#endif
+
     template <class K, class T, class H, class P, class A>
     void unordered_multimap<K, T, H, P, A>::reserve(size_type n)
     {
@@ -2301,6 +2828,121 @@ namespace boost {
       m1.swap(m2);
     }
 
+    // The result of looking up a key with 'unordered_map::entry'. If the key
+    // wasn't found, it can be inserted without hashing it or searching for
+    // it again. An rvalue key is moved into the entry, but an lvalue key is
+    // only referenced, and copied if it's inserted, so it must not be changed
+    // or destroyed while the entry is used. The entry is only valid until
+    // the container is modified by anything other than its own 'emplace'.
+    template <class Table> class map_entry
+    {
+      template <class K2, class T2, class H2, class P2, class A2>
+      friend class boost::unordered::unordered_map;
+
+      typedef typename Table::node_pointer node_pointer;
+      typedef typename Table::const_key_type const_key_type;
+
+    public:
+      typedef typename boost::remove_const<const_key_type>::type key_type;
+      typedef typename Table::value_type value_type;
+      typedef typename value_type::second_type mapped_type;
+      typedef typename Table::iterator iterator;
+
+    private:
+      Table* table_;
+      boost::unordered::detail::entry_key<key_type> key_;
+      std::size_t key_hash_;
+      node_pointer node_;
+
+      map_entry(Table& t, const_key_type& k)
+          : table_(&t), key_(k), key_hash_(t.hash(k)),
+            node_(t.find_node(key_hash_, k))
+      {
+      }
+
+      map_entry(Table& t, BOOST_RV_REF(key_type) k)
+          : table_(&t), key_(boost::move(k)), key_hash_(t.hash(key_.value())),
+            node_(t.find_node(key_hash_, key_.value()))
+      {
+      }
+
+    public:
+      bool found() const { return node_ ? true : false; }
+
+      // The element, or end() if the key wasn't found.
+      iterator position() const { return iterator(node_); }
+
+      // Once the key has been inserted, this is the element's key, as the
+      // entry's own copy might have been moved into it.
+      const_key_type& key() const
+      {
+        return node_ ? table_->get_key(node_) : key_.value();
+      }
+
+      mapped_type& mapped() const
+      {
+        BOOST_ASSERT(node_);
+        return node_->value().second;
+      }
+
+      // Insert the key, constructing the mapped value from the arguments.
+      // Like 'try_emplace', if the key was found, nothing is constructed and
+      // this returns the existing element.
+
+      iterator emplace()
+      {
+        if (!node_) {
+          node_ = key_.owned()
+                    ? table_->try_emplace_entry_unique(
+                        boost::move(key_.owned_value()), key_hash_)
+                    : table_->try_emplace_entry_unique(key_.value(), key_hash_);
+        }
+        return iterator(node_);
+      }
+
+#if !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+
+      template <class... Args> iterator emplace(BOOST_FWD_REF(Args)... args)
+      {
+        if (!node_) {
+          node_ = key_.owned()
+                    ? table_->try_emplace_entry_unique(
+                        boost::move(key_.owned_value()), key_hash_,
+                        boost::forward<Args>(args)...)
+                    : table_->try_emplace_entry_unique(
+                        key_.value(), key_hash_, boost::forward<Args>(args)...);
+        }
+        return iterator(node_);
+      }
+
+#else
+
+#define BOOST_UNORDERED_ENTRY_EMPLACE(z, n, _)                                 \
+                                                                               \
+  template <BOOST_PP_ENUM_PARAMS_Z(z, n, typename A)>                          \
+  iterator emplace(BOOST_PP_ENUM_##z(n, BOOST_UNORDERED_FWD_PARAM, a))         \
+  {                                                                            \
+    if (!node_) {                                                              \
+      node_ = key_.owned()                                                     \
+                ? table_->try_emplace_entry_unique(                            \
+                    boost::move(key_.owned_value()), key_hash_,                \
+                    boost::unordered::detail::create_emplace_args(             \
+                      BOOST_PP_ENUM_##z(n, BOOST_UNORDERED_CALL_FORWARD, a)))  \
+                : table_->try_emplace_entry_unique(key_.value(), key_hash_,    \
+                    boost::unordered::detail::create_emplace_args(             \
+                      BOOST_PP_ENUM_##z(n, BOOST_UNORDERED_CALL_FORWARD, a))); \
+    }                                                                          \
+    return iterator(node_);                                                    \
+  }
+
+      BOOST_PP_REPEAT_FROM_TO(1, BOOST_PP_INC(BOOST_UNORDERED_EMPLACE_LIMIT),
+        BOOST_UNORDERED_ENTRY_EMPLACE, _)
+
+#undef BOOST_UNORDERED_ENTRY_EMPLACE
+
+#endif
+    };
+
     template <typename N, class K, class T, class A> class node_handle_map
     {
       BOOST_MOVABLE_BUT_NOT_COPYABLE(node_handle_map)
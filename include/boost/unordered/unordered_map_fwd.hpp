@@ -52,6 +52,7 @@ namespace boost {
 
     template <class N, class K, class T, class A> class node_handle_map;
     template <class N, class K, class T, class A> struct insert_return_type_map;
+    template <class Table> class map_entry;
   }
 
   using boost::unordered::unordered_map;
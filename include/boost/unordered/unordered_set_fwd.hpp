@@ -50,6 +50,7 @@ namespace boost {
 
     template <class N, class T, class A> class node_handle_set;
     template <class N, class T, class A> struct insert_return_type_set;
+    template <class Table> class set_entry;
   }
 
   using boost::unordered::unordered_set;
@@ -0,0 +1,188 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// clang-format off
+#include "../helpers/prefix.hpp"
+#include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered/hash_traits.hpp>
+#if !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES) &&                             \
+  !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+#define BOOST_UNORDERED_TEST_FLAT 1
+#include <boost/unordered_flat_set.hpp>
+#include <boost/unordered_flat_map.hpp>
+#endif
+#include "../helpers/postfix.hpp"
+// clang-format on
+
+#include "../helpers/test.hpp"
+#include "../helpers/helpers.hpp"
+#include <boost/functional/hash.hpp>
+
+namespace bucket_policy_tests {
+  struct prime_hash : boost::hash<int>
+  {
+  };
+
+  struct pow2_hash : boost::hash<int>
+  {
+  };
+
+  struct fibonacci_hash : boost::hash<int>
+  {
+  };
+}
+
+namespace boost {
+  namespace unordered {
+    template <> struct bucket_policy<bucket_policy_tests::prime_hash>
+    {
+      typedef prime_bucket_policy type;
+    };
+
+    template <> struct bucket_policy<bucket_policy_tests::pow2_hash>
+    {
+      typedef pow2_bucket_policy type;
+    };
+
+    template <> struct bucket_policy<bucket_policy_tests::fibonacci_hash>
+    {
+      typedef fibonacci_bucket_policy type;
+    };
+  }
+}
+
+namespace bucket_policy_tests {
+  bool is_pow2(std::size_t x) { return x && !(x & (x - 1)); }
+
+  bool check_bucket_count(std::size_t count, prime_hash const&)
+  {
+    return boost::unordered::detail::next_prime(count) == count;
+  }
+
+  bool check_bucket_count(std::size_t count, pow2_hash const&)
+  {
+    return is_pow2(count);
+  }
+
+  bool check_bucket_count(std::size_t count, fibonacci_hash const&)
+  {
+    return is_pow2(count);
+  }
+
+  // The flat containers use the policy for their number of groups.
+  template <class X> std::size_t policy_count(X const& x)
+  {
+    return x.bucket_count();
+  }
+
+#if defined(BOOST_UNORDERED_TEST_FLAT)
+  template <class T, class H, class P, class A>
+  std::size_t policy_count(boost::unordered_flat_set<T, H, P, A> const& x)
+  {
+    return x.bucket_count() / 16;
+  }
+
+  template <class K, class M, class H, class P, class A>
+  std::size_t policy_count(boost::unordered_flat_map<K, M, H, P, A> const& x)
+  {
+    return x.bucket_count() / 16;
+  }
+#endif
+
+  int make_value(int x, int const*) { return x; }
+
+  std::pair<int const, int> make_value(int x, std::pair<int const, int> const*)
+  {
+    return std::pair<int const, int>(x, x * 2);
+  }
+
+  // The keys only differ in their high bits, which is the worst case for
+  // the power of 2 policy.
+  int make_key(int x) { return x << 16; }
+
+  template <class X> void bucket_policy_tests(X*)
+  {
+    typedef typename X::value_type value_type;
+
+    X x;
+    for (int i = 0; i < 2000; ++i) {
+      x.insert(make_value(make_key(i), (value_type const*)0));
+      x.insert(make_value(make_key(i / 2), (value_type const*)0));
+    }
+    BOOST_TEST(check_bucket_count(policy_count(x), x.hash_function()));
+
+    for (int i = 0; i < 2000; ++i) {
+      BOOST_TEST(x.find(make_key(i)) != x.end());
+      BOOST_TEST(x.find(make_key(i) + 1) == x.end());
+    }
+
+    x.rehash(x.bucket_count() * 3);
+    BOOST_TEST(check_bucket_count(policy_count(x), x.hash_function()));
+
+    for (int i = 0; i < 2000; i += 2) {
+      BOOST_TEST(x.erase(make_key(i)) > 0);
+    }
+    for (int i = 0; i < 2000; ++i) {
+      BOOST_TEST(i % 2 ? x.count(make_key(i)) > 0 : !x.count(make_key(i)));
+    }
+  }
+
+  // The bucket interface has to agree with the policy.
+  template <class X> void local_iterator_tests(X*)
+  {
+    typedef typename X::value_type value_type;
+
+    X x;
+    for (int i = 0; i < 1000; ++i) {
+      x.insert(make_value(make_key(i), (value_type const*)0));
+    }
+
+    std::size_t total = 0;
+    for (std::size_t b = 0; b < x.bucket_count(); ++b) {
+      for (typename X::const_local_iterator it = x.begin(b); it != x.end(b);
+           ++it) {
+        BOOST_TEST(x.bucket(test::get_key<X>(*it)) == b);
+        ++total;
+      }
+    }
+    BOOST_TEST(total == x.size());
+  }
+
+  boost::unordered_set<int, prime_hash>* test_prime_set;
+  boost::unordered_multimap<int, int, prime_hash>* test_prime_multimap;
+  boost::unordered_set<int, pow2_hash>* test_pow2_set;
+  boost::unordered_multiset<int, pow2_hash>* test_pow2_multiset;
+  boost::unordered_map<int, int, pow2_hash>* test_pow2_map;
+  boost::unordered_set<int, fibonacci_hash>* test_fibonacci_set;
+  boost::unordered_multiset<int, fibonacci_hash>* test_fibonacci_multiset;
+  boost::unordered_map<int, int, fibonacci_hash>* test_fibonacci_map;
+  boost::unordered_multimap<int, int, fibonacci_hash>*
+    test_fibonacci_multimap;
+
+  UNORDERED_TEST(bucket_policy_tests,
+    ((test_prime_set)(test_prime_multimap)(test_pow2_set)(
+      test_pow2_multiset)(test_pow2_map)(test_fibonacci_set)(
+      test_fibonacci_multiset)(test_fibonacci_map)(test_fibonacci_multimap)))
+
+  UNORDERED_TEST(local_iterator_tests,
+    ((test_prime_set)(test_prime_multimap)(test_pow2_set)(
+      test_pow2_multiset)(test_pow2_map)(test_fibonacci_set)(
+      test_fibonacci_multiset)(test_fibonacci_map)(test_fibonacci_multimap)))
+
+#if defined(BOOST_UNORDERED_TEST_FLAT)
+  boost::unordered_flat_set<int, prime_hash>* test_prime_flat_set;
+  boost::unordered_flat_map<int, int, pow2_hash>* test_pow2_flat_map;
+  boost::unordered_flat_set<int, fibonacci_hash>* test_fibonacci_flat_set;
+  boost::unordered_flat_map<int, int, fibonacci_hash>*
+    test_fibonacci_flat_map;
+
+  UNORDERED_TEST(bucket_policy_tests,
+    ((test_prime_flat_set)(test_pow2_flat_map)(test_fibonacci_flat_set)(
+      test_fibonacci_flat_map)))
+#endif
+}
+
+RUN_TESTS()
@@ -0,0 +1,223 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/config.hpp>
+#if !defined(BOOST_NO_CXX11_HDR_THREAD) && !defined(BOOST_NO_CXX11_LAMBDAS) && \
+  !defined(BOOST_NO_CXX11_RVALUE_REFERENCES) &&                                \
+  !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+#define BOOST_UNORDERED_ENABLE_PARALLEL
+#endif
+
+// clang-format off
+#include "../helpers/prefix.hpp"
+#include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered/hash_traits.hpp>
+#include <boost/unordered/node_traits.hpp>
+#include "../helpers/postfix.hpp"
+// clang-format on
+
+#include "../helpers/test.hpp"
+#include "../helpers/helpers.hpp"
+#include <boost/functional/hash.hpp>
+#include <vector>
+
+#if defined(BOOST_UNORDERED_ENABLE_PARALLEL)
+#include <atomic>
+#include <thread>
+#endif
+
+namespace bucket_range_tests {
+  struct incremental_hash : boost::hash<int>
+  {
+  };
+
+  struct pow2_hash : boost::hash<int>
+  {
+  };
+}
+
+namespace boost {
+  namespace unordered {
+    template <>
+    struct incremental_rehash<bucket_range_tests::incremental_hash>
+      : boost::true_type
+    {
+    };
+
+    template <>
+    struct doubly_linked<bucket_range_tests::incremental_hash>
+      : boost::true_type
+    {
+    };
+
+    template <> struct bucket_policy<bucket_range_tests::pow2_hash>
+    {
+      typedef pow2_bucket_policy type;
+    };
+  }
+}
+
+namespace bucket_range_tests {
+  int make_value(int x, int const*) { return x; }
+
+  std::pair<int const, int> make_value(int x, std::pair<int const, int> const*)
+  {
+    return std::pair<int const, int>(x, x * 2);
+  }
+
+  int get_int(int x) { return x; }
+  int get_int(std::pair<int const, int> const& x) { return x.first; }
+
+  // Check that splitting the container into 'count' ranges visits every
+  // element exactly once.
+  template <class X> void check_ranges(X const& x, std::size_t count)
+  {
+    std::vector<std::size_t> visits;
+    std::size_t total = 0;
+
+    for (std::size_t i = 0; i < count; ++i) {
+      typename X::const_range_iterator it = x.range_begin(i, count),
+                                       end = x.range_end(i, count);
+      for (; it != end; ++it) {
+        std::size_t key = static_cast<std::size_t>(get_int(*it));
+        if (key >= visits.size()) {
+          visits.resize(key + 1);
+        }
+        ++visits[key];
+        ++total;
+      }
+    }
+
+    BOOST_TEST(total == x.size());
+    for (std::size_t key = 0; key < visits.size(); ++key) {
+      BOOST_TEST(visits[key] == x.count(static_cast<int>(key)));
+    }
+  }
+
+  template <class X> void bucket_range_tests(X*)
+  {
+    typedef typename X::value_type value_type;
+    std::size_t const counts[] = {1, 2, 3, 7, 16, 1000};
+    std::size_t const num_counts = sizeof(counts) / sizeof(*counts);
+
+    X x;
+    for (std::size_t j = 0; j < num_counts; ++j) {
+      check_ranges(x, counts[j]);
+      BOOST_TEST(x.range_begin(0, counts[j]) == x.range_end(0, counts[j]));
+    }
+
+    // Check while growing, which for the incremental containers includes
+    // the times when some of the elements are still in the old buckets.
+    for (int i = 0; i < 5000; ++i) {
+      x.insert(make_value(i, (value_type const*)0));
+      x.insert(make_value(i / 4, (value_type const*)0));
+      if (i % 97 == 0) {
+        for (std::size_t j = 0; j < num_counts; ++j) {
+          check_ranges(x, counts[j]);
+        }
+      }
+    }
+
+    // More ranges than buckets.
+    X y;
+    y.insert(make_value(1, (value_type const*)0));
+    y.insert(make_value(2, (value_type const*)0));
+    check_ranges(y, y.bucket_count() * 3);
+
+    // A mutable range iterator converts to a const one.
+    typename X::range_iterator it = x.range_begin(0, 2);
+    typename X::const_range_iterator cit = it;
+    BOOST_TEST(cit == x.range_begin(0, 2));
+    BOOST_TEST(&*cit == &*it);
+  }
+
+#if defined(BOOST_UNORDERED_ENABLE_PARALLEL)
+  template <class X> void parallel_tests(X*)
+  {
+    typedef typename X::value_type value_type;
+
+    X x;
+    long long expected = 0;
+    for (int i = 0; i < 40000; ++i) {
+      x.insert(make_value(i % 30011, (value_type const*)0));
+    }
+    for (typename X::const_iterator it = x.begin(); it != x.end(); ++it) {
+      expected += get_int(*it);
+    }
+
+    std::size_t const threads[] = {0, 1, 2, 5};
+    for (std::size_t j = 0; j < sizeof(threads) / sizeof(*threads); ++j) {
+      std::atomic<long long> sum(0);
+      std::atomic<std::size_t> visited(0);
+      X const& cx = x;
+      cx.for_each_parallel(
+        [&sum, &visited](value_type const& v) {
+          sum += get_int(v);
+          ++visited;
+        },
+        threads[j]);
+      BOOST_TEST(visited == x.size());
+      BOOST_TEST(sum == expected);
+    }
+
+    // Aggregate using a thread for each range.
+    std::size_t const count = 4;
+    std::vector<long long> sums(count);
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < count; ++i) {
+      workers.push_back(std::thread([&x, &sums, i, count] {
+        typename X::const_range_iterator it = x.range_begin(i, count),
+                                         end = x.range_end(i, count);
+        for (; it != end; ++it) {
+          sums[i] += get_int(*it);
+        }
+      }));
+    }
+    long long total = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+      workers[i].join();
+      total += sums[i];
+    }
+    BOOST_TEST(total == expected);
+  }
+
+  // The mutable version can change the mapped values.
+  template <class X> void parallel_map_tests(X*)
+  {
+    X x;
+    for (int i = 0; i < 40000; ++i) {
+      x.insert(std::make_pair(i, i));
+    }
+    x.for_each_parallel(
+      [](typename X::value_type& v) { v.second = v.first * 3; }, 4);
+    for (int i = 0; i < 40000; ++i) {
+      BOOST_TEST(x.find(i)->second == i * 3);
+    }
+  }
+#endif
+
+  boost::unordered_set<int>* test_set;
+  boost::unordered_multiset<int>* test_multiset;
+  boost::unordered_map<int, int>* test_map;
+  boost::unordered_multimap<int, int>* test_multimap;
+  boost::unordered_set<int, incremental_hash>* test_incremental_set;
+  boost::unordered_multimap<int, int, incremental_hash>*
+    test_incremental_multimap;
+  boost::unordered_multiset<int, pow2_hash>* test_pow2_multiset;
+
+  UNORDERED_TEST(bucket_range_tests,
+    ((test_set)(test_multiset)(test_map)(test_multimap)(test_incremental_set)(
+      test_incremental_multimap)(test_pow2_multiset)))
+
+#if defined(BOOST_UNORDERED_ENABLE_PARALLEL)
+  UNORDERED_TEST(parallel_tests,
+    ((test_set)(test_multiset)(test_map)(test_multimap)(test_incremental_set)(
+      test_incremental_multimap)))
+  UNORDERED_TEST(parallel_map_tests, ((test_map)(test_incremental_multimap)))
+#endif
+}
+
+RUN_TESTS()
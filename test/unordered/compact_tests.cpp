@@ -0,0 +1,314 @@
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// clang-format off
+#include "../helpers/prefix.hpp"
+#include <boost/config.hpp>
+#if !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES) &&                             \
+  !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+#define BOOST_UNORDERED_TEST_COMPACT 1
+#include <boost/unordered_compact_map.hpp>
+#else
+#include <boost/unordered_map.hpp>
+#endif
+#include "../helpers/postfix.hpp"
+// clang-format on
+
+#include "../helpers/test.hpp"
+
+#if defined(BOOST_UNORDERED_TEST_COMPACT)
+
+#include "../objects/test.hpp"
+#include "../helpers/random_values.hpp"
+#include "../helpers/tracker.hpp"
+#include "../helpers/helpers.hpp"
+#include "../helpers/equivalent.hpp"
+#include <boost/cstdint.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace compact_tests {
+
+  test::seed_t initialize_seed(61843);
+
+  template <class X>
+  void insert_find_tests(X*, test::random_generator generator)
+  {
+    typedef typename X::iterator iterator;
+
+    test::check_instances check_;
+
+    test::random_values<X> v(1000, generator);
+    X x;
+    test::ordered<X> tracker = test::create_ordered(x);
+
+    for (typename test::random_values<X>::iterator it = v.begin();
+         it != v.end(); ++it) {
+      std::pair<iterator, bool> r = x.insert(*it);
+      std::pair<typename test::ordered<X>::iterator, bool> r2 =
+        tracker.insert(*it);
+      BOOST_TEST(r.second == r2.second);
+      BOOST_TEST(*r.first == *r2.first);
+      BOOST_TEST(x.load_factor() <= x.max_load_factor());
+    }
+
+    tracker.compare(x);
+
+    for (typename test::ordered<X>::const_iterator it = tracker.begin();
+         it != tracker.end(); ++it) {
+      typename X::key_type key = test::get_key<X>(*it);
+      iterator pos = x.find(key);
+      BOOST_TEST(pos != x.end() && *pos == *it);
+      BOOST_TEST(x.count(key) == 1);
+      BOOST_TEST(std::distance(x.equal_range(key).first,
+                   x.equal_range(key).second) == 1);
+    }
+
+    test::random_values<X> v2(500, generator);
+    for (typename test::random_values<X>::iterator it = v2.begin();
+         it != v2.end(); ++it) {
+      typename X::key_type key = test::get_key<X>(*it);
+      if (tracker.find(key) == tracker.end()) {
+        BOOST_TEST(x.find(key) == x.end());
+        BOOST_TEST(x.count(key) == 0);
+      }
+    }
+  }
+
+  template <class X> void erase_tests(X*, test::random_generator generator)
+  {
+    test::check_instances check_;
+
+    test::random_values<X> v(1000, generator);
+    X x(v.begin(), v.end());
+    test::ordered<X> tracker = test::create_ordered(x);
+    tracker.insert_range(v.begin(), v.end());
+
+    // Erase by key.
+    std::size_t count = 0;
+    for (typename test::random_values<X>::iterator it = v.begin();
+         it != v.end(); ++it) {
+      if (++count % 3) {
+        typename X::key_type key = test::get_key<X>(*it);
+        BOOST_TEST(x.erase(key) == tracker.erase(key));
+        BOOST_TEST(x.find(key) == x.end());
+      }
+    }
+    tracker.compare(x);
+
+    // Erase by iterator, checking the returned iterator.
+    typename X::size_type size = x.size();
+    typename X::iterator pos = x.begin();
+    while (pos != x.end()) {
+      tracker.erase(test::get_key<X>(*pos));
+      typename X::iterator next = pos;
+      ++next;
+      pos = x.erase(pos);
+      BOOST_TEST(pos == next);
+      --size;
+      BOOST_TEST(x.size() == size);
+      if (pos != x.end())
+        ++pos;
+    }
+    tracker.compare(x);
+
+    // Reinserting should reuse the erased nodes.
+    x.insert(v.begin(), v.end());
+    tracker.insert_range(v.begin(), v.end());
+    tracker.compare(x);
+
+    // Erase range.
+    BOOST_TEST(x.erase(x.begin(), x.end()) == x.end());
+    BOOST_TEST(x.empty());
+    BOOST_TEST(x.begin() == x.end());
+  }
+
+  template <class X> void copy_move_tests(X*, test::random_generator generator)
+  {
+    test::check_instances check_;
+
+    test::random_values<X> v(500, generator);
+    X x(v.begin(), v.end());
+
+    // Leave some erased nodes on the free list.
+    std::size_t count = 0;
+    for (typename test::random_values<X>::iterator it = v.begin();
+         it != v.end(); ++it) {
+      if (++count % 4 == 0)
+        x.erase(test::get_key<X>(*it));
+    }
+
+    test::unordered_equivalence_tester<X> equivalent(x);
+
+    {
+      X y(x);
+      BOOST_TEST(equivalent(y));
+      BOOST_TEST(y == x);
+      y.insert(v.begin(), v.end());
+      BOOST_TEST(y.size() >= x.size());
+    }
+
+    {
+      X y(x, x.get_allocator());
+      BOOST_TEST(equivalent(y));
+    }
+
+    {
+      X y;
+      y = x;
+      BOOST_TEST(equivalent(y));
+      y = y;
+      BOOST_TEST(equivalent(y));
+      X z(boost::move(y));
+      BOOST_TEST(equivalent(z));
+      BOOST_TEST(y.empty());
+      y = boost::move(z);
+      BOOST_TEST(equivalent(y));
+    }
+
+    {
+      X y, z(x);
+      y.swap(z);
+      BOOST_TEST(equivalent(y));
+      BOOST_TEST(z.empty());
+      boost::swap(y, z);
+      BOOST_TEST(equivalent(z));
+    }
+
+    {
+      X y(x);
+      y.rehash(0);
+      BOOST_TEST(equivalent(y));
+      y.rehash(y.bucket_count() * 4);
+      BOOST_TEST(equivalent(y));
+      BOOST_TEST(y.load_factor() <= y.max_load_factor() / 4);
+      y.reserve(2000);
+      BOOST_TEST(static_cast<float>(y.bucket_count()) * y.max_load_factor() >=
+                 2000);
+      BOOST_TEST(equivalent(y));
+      y.clear();
+      BOOST_TEST(y.empty());
+      BOOST_TEST(y.begin() == y.end());
+      BOOST_TEST(y != x);
+    }
+  }
+
+  boost::unordered_compact_map<test::object, test::object, test::hash,
+    test::equal_to, test::allocator1<test::object> >* test_map1;
+  boost::unordered_compact_map<test::object, test::object, test::hash,
+    test::equal_to, test::allocator2<test::object> >* test_map2;
+
+  using test::default_generator;
+  using test::generate_collisions;
+  using test::limited_range;
+
+  UNORDERED_TEST(insert_find_tests, ((test_map1)(test_map2))(
+                                      (default_generator)(generate_collisions)(
+                                        limited_range)))
+  UNORDERED_TEST(erase_tests, ((test_map1)(test_map2))(
+                                (default_generator)(generate_collisions)(
+                                  limited_range)))
+  UNORDERED_TEST(copy_move_tests, ((test_map1)(test_map2))(
+                                    (default_generator)(generate_collisions)(
+                                      limited_range)))
+
+  UNORDERED_AUTO_TEST(compact_map_api_tests)
+  {
+    boost::unordered_compact_map<std::string, int> x;
+
+    x["one"] = 1;
+    BOOST_TEST(x.at("one") == 1);
+    BOOST_TEST(x.try_emplace("one", 2).second == false);
+    BOOST_TEST(x.try_emplace("two", 2).second);
+    BOOST_TEST(x.insert_or_assign("one", 10).second == false);
+    BOOST_TEST(x.at("one") == 10);
+    BOOST_TEST(x.emplace("three", 3).second);
+    BOOST_TEST(x.emplace(std::make_pair("three", 4)).second == false);
+    BOOST_TEST(x.size() == 3);
+
+    bool caught = false;
+    try {
+      x.at("four");
+    } catch (std::out_of_range&) {
+      caught = true;
+    }
+    BOOST_TEST(caught);
+
+    x.max_load_factor(0.5f);
+    BOOST_TEST(x.max_load_factor() == 0.5f);
+    for (int i = 0; i < 1000; ++i) {
+      x.emplace(std::to_string(i), i);
+      BOOST_TEST(x.load_factor() <= x.max_load_factor());
+    }
+    BOOST_TEST(x.size() == 1003);
+    for (int i = 0; i < 1000; ++i) {
+      BOOST_TEST(x.at(std::to_string(i)) == i);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+      BOOST_TEST(x.erase(std::to_string(i)) == 1);
+    }
+    BOOST_TEST(x.size() == 503);
+    BOOST_TEST(x.count("10") == 0);
+    BOOST_TEST(x.count("11") == 1);
+
+    boost::unordered_compact_map<std::string, int> y = {{"a", 1}, {"b", 2}};
+    BOOST_TEST(y.size() == 2);
+    y = {{"c", 3}};
+    BOOST_TEST(y.size() == 1 && y.at("c") == 3);
+  }
+
+  UNORDERED_AUTO_TEST(compact_map_stability_tests)
+  {
+    typedef boost::unordered_compact_map<boost::uint32_t, boost::uint32_t>
+      map;
+
+    // The nodes don't move when the arena grows or the buckets are
+    // rehashed.
+    map x;
+    std::vector<map::value_type*> pointers;
+    for (boost::uint32_t i = 0; i < 10000; ++i) {
+      pointers.push_back(&*x.emplace(i, i * 2).first);
+    }
+    x.rehash(x.bucket_count() * 4);
+    for (boost::uint32_t i = 0; i < 10000; ++i) {
+      BOOST_TEST(&*x.find(i) == pointers[i]);
+      BOOST_TEST(pointers[i]->second == i * 2);
+    }
+    BOOST_TEST(static_cast<std::size_t>(std::distance(x.begin(), x.end())) ==
+               x.size());
+
+    // Erased nodes are reused before the arena grows.
+    for (boost::uint32_t i = 0; i < 10000; i += 2) {
+      BOOST_TEST(x.erase(i) == 1);
+    }
+    for (boost::uint32_t i = 10000; i < 15000; ++i) {
+      map::value_type* p = &*x.emplace(i, i * 2).first;
+      BOOST_TEST(std::find(pointers.begin(), pointers.end(), p) !=
+                 pointers.end());
+    }
+    BOOST_TEST(x.size() == 10000);
+
+    // Iterators stay valid when the container is swapped.
+    map::iterator it = x.find(1);
+    map y;
+    y.swap(x);
+    BOOST_TEST(it == y.find(1));
+    std::size_t count = 0;
+    for (; it != y.end(); ++it) {
+      ++count;
+    }
+    BOOST_TEST(count <= y.size());
+    BOOST_TEST(x.empty() && x.begin() == x.end());
+
+    y.clear();
+    BOOST_TEST(y.empty() && y.begin() == y.end());
+    BOOST_TEST(y.emplace(1, 2).second);
+    BOOST_TEST(y.size() == 1 && y.begin()->second == 2);
+  }
+}
+
+#endif
+
+RUN_TESTS()
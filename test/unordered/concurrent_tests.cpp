@@ -0,0 +1,230 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// clang-format off
+#include "../helpers/prefix.hpp"
+#include <boost/config.hpp>
+#if !defined(BOOST_NO_CXX11_HDR_THREAD) &&                                     \
+  !defined(BOOST_NO_CXX11_HDR_MUTEX) &&                                        \
+  !defined(BOOST_NO_CXX11_HDR_ATOMIC) && !defined(BOOST_NO_CXX11_LAMBDAS) &&   \
+  !defined(BOOST_NO_CXX11_RVALUE_REFERENCES) &&                                \
+  !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+#define BOOST_UNORDERED_TEST_CONCURRENT 1
+#include <boost/concurrent_unordered_map.hpp>
+#else
+#include <boost/unordered_map.hpp>
+#endif
+#include "../helpers/postfix.hpp"
+// clang-format on
+
+#include "../helpers/test.hpp"
+
+#if defined(BOOST_UNORDERED_TEST_CONCURRENT)
+
+#include "../objects/test.hpp"
+#include "../helpers/random_values.hpp"
+#include "../helpers/tracker.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace concurrent_tests {
+
+  test::seed_t initialize_seed(12743);
+
+  typedef boost::concurrent_unordered_map<test::object, test::object,
+    test::hash, test::equal_to, test::allocator1<test::object> >
+    object_map;
+
+  // Compare with an unordered_map built from the same values.
+  template <class X, class Y> void compare(X const& x, Y const& y)
+  {
+    BOOST_TEST(x.size() == y.size());
+    std::size_t visited = x.cvisit_all([&y](typename X::value_type const& v) {
+      typename Y::const_iterator it = y.find(v.first);
+      BOOST_TEST(it != y.end() && it->second == v.second);
+    });
+    BOOST_TEST(visited == y.size());
+  }
+
+  UNORDERED_AUTO_TEST(concurrent_insert_tests)
+  {
+    test::check_instances check_;
+
+    test::random_values<boost::unordered_map<test::object, test::object> > v(
+      1000, test::generate_collisions);
+    boost::unordered_map<test::object, test::object> expected;
+
+    object_map x;
+    for (typename test::random_values<boost::unordered_map<test::object,
+           test::object> >::iterator it = v.begin();
+         it != v.end(); ++it) {
+      BOOST_TEST(x.insert(*it) == expected.insert(*it).second);
+      BOOST_TEST(x.load_factor() <= x.max_load_factor());
+    }
+    compare(x, expected);
+
+    // The bucket count is a power of 2, so that each stripe covers a
+    // range of buckets.
+    std::size_t count = x.bucket_count();
+    BOOST_TEST(count && !(count & (count - 1)));
+
+    object_map y(x);
+    compare(y, expected);
+
+    x.rehash(count * 4);
+    BOOST_TEST(x.bucket_count() >= count * 4);
+    compare(x, expected);
+
+    x.clear();
+    BOOST_TEST(x.empty());
+    BOOST_TEST(x.count(v.begin()->first) == 0);
+    compare(y, expected);
+  }
+
+  UNORDERED_AUTO_TEST(concurrent_api_tests)
+  {
+    boost::concurrent_unordered_map<std::string, int> x;
+
+    BOOST_TEST(x.emplace("one", 1));
+    BOOST_TEST(!x.emplace(std::make_pair("one", 2)));
+    BOOST_TEST(x.try_emplace("two", 2));
+    BOOST_TEST(!x.try_emplace("two", 3));
+    BOOST_TEST(x.insert(std::make_pair(std::string("three"), 3)));
+    BOOST_TEST(!x.insert_or_assign("one", 10));
+    BOOST_TEST(x.insert_or_assign("four", 4));
+    BOOST_TEST(x.size() == 4);
+
+    int value = 0;
+    BOOST_TEST(x.visit("one", [&value](std::pair<const std::string, int>& v) {
+      value = v.second;
+      ++v.second;
+    }) == 1);
+    BOOST_TEST(value == 10);
+    BOOST_TEST(x.cvisit("one", [&value](
+                 std::pair<const std::string, int> const& v) {
+      value = v.second;
+    }) == 1);
+    BOOST_TEST(value == 11);
+    BOOST_TEST(x.visit("five", [](std::pair<const std::string, int>&) {
+      BOOST_ERROR("Visited a missing element.");
+    }) == 0);
+    BOOST_TEST(x.contains("two") && !x.contains("five"));
+
+    // An existing element is visited instead of inserted.
+    BOOST_TEST(!x.insert_or_visit(std::make_pair(std::string("two"), 20),
+      [](std::pair<const std::string, int>& v) { v.second *= 100; }));
+    BOOST_TEST(x.insert_or_cvisit(std::make_pair(std::string("five"), 5),
+      [](std::pair<const std::string, int> const&) {
+        BOOST_ERROR("Visited a new element.");
+      }));
+    x.cvisit("two", [&value](std::pair<const std::string, int> const& v) {
+      value = v.second;
+    });
+    BOOST_TEST(value == 200);
+
+    // Erase
+    BOOST_TEST(x.erase("three") == 1);
+    BOOST_TEST(x.erase("three") == 0);
+    BOOST_TEST(x.erase_if("four",
+                 [](std::pair<const std::string, int>& v) {
+                   return v.second > 100;
+                 }) == 0);
+    BOOST_TEST(x.contains("four"));
+    BOOST_TEST(x.erase_if("four",
+                 [](std::pair<const std::string, int>& v) {
+                   return v.second == 4;
+                 }) == 1);
+    BOOST_TEST(x.size() == 3);
+
+    for (int i = 0; i < 1000; ++i) {
+      x.emplace(std::to_string(i), i);
+    }
+    BOOST_TEST(x.size() == 1003);
+    BOOST_TEST(x.erase_if([](std::pair<const std::string, int>& v) {
+      return v.second % 2 == 0;
+    }) == 501);
+    BOOST_TEST(x.size() == 502);
+    BOOST_TEST(x.count("11") == 1 && x.count("10") == 0);
+
+    boost::concurrent_unordered_map<int, int> y = {{1, 2}, {3, 4}};
+    BOOST_TEST(y.size() == 2 && y.count(3) == 1);
+    BOOST_TEST(y.insert({{3, 5}, {5, 6}}) == 1);
+  }
+
+  // Every thread inserts its own keys, and also counts the shared keys
+  // using 'insert_or_visit'.
+  UNORDERED_AUTO_TEST(concurrent_thread_tests)
+  {
+    typedef boost::concurrent_unordered_map<int, int> map;
+
+    std::size_t const thread_count = 8;
+    int const per_thread = 20000;
+    int const shared_keys = 100;
+
+    map x;
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < thread_count; ++t) {
+      threads.push_back(std::thread([&x, t] {
+        int base = static_cast<int>(t + 1) * per_thread;
+        for (int i = 0; i < per_thread; ++i) {
+          x.emplace(base + i, i);
+          x.insert_or_visit(std::make_pair(i % shared_keys, 1),
+            [](map::value_type& v) { ++v.second; });
+          if (i % 3 == 0) {
+            BOOST_TEST(x.erase(base + i) == 1);
+          }
+          int found = -1;
+          x.cvisit(base + i / 2,
+            [&found](map::value_type const& v) { found = v.second; });
+          BOOST_TEST(found == -1 || found == i / 2);
+        }
+      }));
+    }
+    for (std::size_t t = 0; t < thread_count; ++t) {
+      threads[t].join();
+    }
+
+    std::size_t kept = static_cast<std::size_t>(per_thread - per_thread / 3 -
+                                                (per_thread % 3 ? 1 : 0));
+    BOOST_TEST(x.size() == thread_count * kept + shared_keys);
+
+    int total = 0;
+    x.cvisit_all([&total](map::value_type const& v) {
+      if (v.first < shared_keys) {
+        total += v.second;
+      }
+    });
+    BOOST_TEST(total == static_cast<int>(thread_count) * per_thread);
+
+    // Erase from several threads while others look up.
+    std::atomic<std::size_t> erased(0);
+    threads.clear();
+    for (std::size_t t = 0; t < thread_count; ++t) {
+      threads.push_back(std::thread([&x, &erased, t] {
+        if (t % 2) {
+          erased += x.erase_if([t](map::value_type const& v) {
+            return v.first >= shared_keys &&
+                   static_cast<std::size_t>(v.first / per_thread) == t;
+          });
+        } else {
+          for (int i = 0; i < shared_keys; ++i) {
+            BOOST_TEST(x.count(i) == 1);
+          }
+        }
+      }));
+    }
+    for (std::size_t t = 0; t < thread_count; ++t) {
+      threads[t].join();
+    }
+    BOOST_TEST(erased == (thread_count / 2) * kept);
+    BOOST_TEST(x.size() == thread_count * kept + shared_keys - erased);
+  }
+}
+
+#endif
+
+RUN_TESTS()
@@ -150,6 +150,74 @@ namespace copy_tests {
     }
   }
 
+  // When the source doesn't have too many buckets, the copy should have the
+  // same structure, with the elements in the same order.
+  template <class T>
+  void copy_structure_tests(T*, test::random_generator const& generator)
+  {
+    test::check_instances check_;
+
+    test::random_values<T> v(1000, generator);
+    T x;
+    for (typename test::random_values<T>::iterator it = v.begin();
+         it != v.end(); ++it) {
+      x.insert(*it);
+    }
+    T y(x);
+    BOOST_TEST(y.bucket_count() == x.bucket_count());
+    BOOST_TEST(std::equal(x.begin(), x.end(), y.begin()));
+    test::check_equivalent_keys(y);
+
+    T z(x, x.get_allocator());
+    BOOST_TEST(z.bucket_count() == x.bucket_count());
+    BOOST_TEST(std::equal(x.begin(), x.end(), z.begin()));
+    test::check_equivalent_keys(z);
+
+    // Erasing most of the elements leaves too many buckets, so the copy
+    // is rehashed into fewer buckets.
+    typename T::size_type count = 0;
+    for (typename T::iterator it = x.begin(); it != x.end();) {
+      if (++count % 8) {
+        it = x.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    if (x.size() > 10) {
+      T w(x);
+      BOOST_TEST(w.bucket_count() < x.bucket_count());
+      test::unordered_equivalence_tester<T> equivalent(x);
+      BOOST_TEST(equivalent(w));
+      test::check_equivalent_keys(w);
+    }
+  }
+
+  struct counting_hash
+  {
+    static int calls;
+
+    std::size_t operator()(int x) const
+    {
+      ++calls;
+      return boost::hash<int>()(x);
+    }
+  };
+
+  int counting_hash::calls = 0;
+
+  UNORDERED_AUTO_TEST(copy_without_hashing)
+  {
+    boost::unordered_multimap<int, int, counting_hash> x;
+    for (int i = 0; i < 1000; ++i) {
+      x.insert(std::make_pair(i % 300, i));
+    }
+
+    counting_hash::calls = 0;
+    boost::unordered_multimap<int, int, counting_hash> y(x);
+    BOOST_TEST(counting_hash::calls == 0);
+    BOOST_TEST(y == x);
+  }
+
   boost::unordered_set<test::object, test::hash, test::equal_to,
     test::allocator1<test::object> >* test_set;
   boost::unordered_multiset<test::object, test::hash, test::equal_to,
@@ -204,6 +272,11 @@ namespace copy_tests {
       test_multiset_no_select_copy)(test_map_no_select_copy)(
       test_multimap_no_select_copy))(
                    (default_generator)(generate_collisions)(limited_range)))
+
+  UNORDERED_TEST(copy_structure_tests,
+    ((test_set)(test_multiset)(test_map)(test_multimap)(test_set_select_copy)(
+      test_multimap_no_select_copy))(
+      (default_generator)(generate_collisions)(limited_range)))
 }
 
 RUN_TESTS()
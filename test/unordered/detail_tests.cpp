@@ -99,4 +99,30 @@ UNORDERED_AUTO_TEST(next_prime_test)
   }
 }
 
+UNORDERED_AUTO_TEST(prime_mod_test)
+{
+  // The constant divisors must give the same bucket positions as a
+  // runtime division, so that the iteration order doesn't change.
+  std::size_t const* primes = boost::unordered::detail::prime_list::value;
+  std::size_t length =
+    static_cast<std::size_t>(boost::unordered::detail::prime_list::length);
+
+  for (std::size_t i = 0; i < length; ++i) {
+    BOOST_TEST(boost::unordered::detail::prime_index(primes[i]) == i);
+
+    std::size_t hash = 0;
+    for (int j = 0; j < 1000; ++j) {
+      BOOST_TEST(boost::unordered::detail::prime_mod(hash, i) ==
+                 hash % primes[i]);
+      BOOST_TEST(boost::unordered::detail::prime_mod(~hash, i) ==
+                 ~hash % primes[i]);
+      hash = hash * 31 + static_cast<std::size_t>(j) * 97 + 1;
+    }
+
+    BOOST_TEST(boost::unordered::detail::prime_mod(primes[i], i) == 0);
+    BOOST_TEST(
+      boost::unordered::detail::prime_mod(primes[i] - 1, i) == primes[i] - 1);
+  }
+}
+
 RUN_TESTS()
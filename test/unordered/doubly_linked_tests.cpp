@@ -0,0 +1,180 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// clang-format off
+#include "../helpers/prefix.hpp"
+#include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered/node_traits.hpp>
+#include "../helpers/postfix.hpp"
+// clang-format on
+
+#include "../helpers/test.hpp"
+#include "../objects/test.hpp"
+#include "../helpers/random_values.hpp"
+#include "../helpers/tracker.hpp"
+#include "../helpers/equivalent.hpp"
+#include "../helpers/invariants.hpp"
+
+namespace doubly_linked_tests {
+  // test::hash, but with doubly linked nodes.
+  struct linked_hash : test::hash
+  {
+    linked_hash() {}
+    explicit linked_hash(int t) : test::hash(t) {}
+  };
+}
+
+namespace boost {
+  namespace unordered {
+    template <>
+    struct doubly_linked<doubly_linked_tests::linked_hash> : boost::true_type
+    {
+    };
+  }
+}
+
+namespace doubly_linked_tests {
+
+  test::seed_t initialize_seed(19372);
+
+  // Remove a single value from the tracker. There can be several
+  // elements with equivalent keys, so find the one with the same value.
+  template <class X, class Tracker>
+  void remove_value(Tracker& tracker, typename X::value_type const& v)
+  {
+    typename Tracker::iterator it =
+      tracker.lower_bound(test::get_key<X>(v));
+    while (!test::equivalent(*it, v)) {
+      ++it;
+    }
+    tracker.erase(it);
+  }
+
+  // Erase every other element by iterator, and check the remaining
+  // elements are still linked correctly.
+  template <class X> void erase_alternate(X& x)
+  {
+    test::ordered<X> tracker = test::create_ordered(x);
+    tracker.insert_range(x.begin(), x.end());
+
+    typename X::iterator pos = x.begin();
+    while (pos != x.end()) {
+      remove_value<X>(tracker, *pos);
+      pos = x.erase(pos);
+      if (pos != x.end()) {
+        ++pos;
+      }
+    }
+    tracker.compare(x);
+    test::check_equivalent_keys(x);
+  }
+
+  template <class X>
+  void doubly_linked_tests(X*, test::random_generator generator)
+  {
+    float const load_factors[] = {1.0f, 4.0f, 16.0f};
+
+    for (int i = 0; i < 3; ++i) {
+      test::check_instances check_;
+
+      test::random_values<X> v(1000, generator);
+      X x;
+      x.max_load_factor(load_factors[i]);
+      test::ordered<X> tracker = test::create_ordered(x);
+
+      for (typename test::random_values<X>::iterator it = v.begin();
+           it != v.end(); ++it) {
+        x.insert(*it);
+        tracker.insert(*it);
+      }
+      tracker.compare(x);
+      test::check_equivalent_keys(x);
+
+      // Rehashing moves the nodes between buckets, and copying links them
+      // into a new list.
+      x.rehash(x.bucket_count() * 2);
+      test::check_equivalent_keys(x);
+      X y(x);
+      test::check_equivalent_keys(y);
+      BOOST_TEST(x == y);
+
+      erase_alternate(x);
+      tracker = test::create_ordered(x);
+      tracker.insert_range(x.begin(), x.end());
+
+      // Extract elements from the start of the container, and insert them
+      // again.
+      for (int j = 0; j < 50 && !x.empty(); ++j) {
+        typename X::node_type n = x.extract(x.begin());
+        x.insert(boost::move(n));
+      }
+      tracker.compare(x);
+      test::check_equivalent_keys(x);
+
+      // Insert the original values again, then erase by key and range.
+      for (typename test::random_values<X>::iterator it = v.begin();
+           it != v.end(); ++it) {
+        x.insert(*it);
+        tracker.insert(*it);
+      }
+      tracker.compare(x);
+
+      std::size_t count = 0;
+      for (typename test::random_values<X>::iterator it = v.begin();
+           it != v.end(); ++it) {
+        if (++count % 3 == 0) {
+          BOOST_TEST(x.erase(test::get_key<X>(*it)) ==
+                     tracker.erase(test::get_key<X>(*it)));
+        }
+      }
+      tracker.compare(x);
+      test::check_equivalent_keys(x);
+
+      if (!x.empty()) {
+        typename X::iterator last = x.begin();
+        std::advance(last, x.size() / 2);
+        for (typename X::iterator it = x.begin(); it != last; ++it) {
+          remove_value<X>(tracker, *it);
+        }
+        x.erase(x.begin(), last);
+        tracker.compare(x);
+        test::check_equivalent_keys(x);
+      }
+
+      // Merging moves nodes from y into x.
+      typename X::size_type total = x.size() + y.size();
+      x.merge(y);
+      test::check_equivalent_keys(x);
+      test::check_equivalent_keys(y);
+      BOOST_TEST(x.size() + y.size() == total);
+
+      erase_alternate(y);
+
+      x.clear();
+      BOOST_TEST(x.empty());
+    }
+  }
+
+  boost::unordered_set<test::object, linked_hash, test::equal_to,
+    std::allocator<test::object> >* test_set;
+  boost::unordered_multiset<test::object, linked_hash, test::equal_to,
+    test::allocator2<test::object> >* test_multiset;
+  boost::unordered_map<test::object, test::object, linked_hash,
+    test::equal_to, test::allocator2<test::object> >* test_map;
+  boost::unordered_multimap<test::object, test::object, linked_hash,
+    test::equal_to, std::allocator<std::pair<test::object const,
+                      test::object> > >* test_multimap;
+
+  using test::default_generator;
+  using test::generate_collisions;
+  using test::limited_range;
+
+  UNORDERED_TEST(doubly_linked_tests,
+    ((test_set)(test_multiset)(test_map)(test_multimap))(
+      (default_generator)(generate_collisions)(limited_range)))
+}
+
+RUN_TESTS()
@@ -0,0 +1,210 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#define BOOST_UNORDERED_ENABLE_STATS
+
+// clang-format off
+#include "../helpers/prefix.hpp"
+#include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
+#include "../helpers/postfix.hpp"
+// clang-format on
+
+#include "../helpers/test.hpp"
+#include "../objects/test.hpp"
+#include <boost/functional/hash.hpp>
+#include <string>
+
+namespace entry_tests {
+  // An entry should hash the key once, even when inserting it.
+  template <class X> void single_hash_tests(X*)
+  {
+    X x;
+    for (int i = 0; i < 1000; ++i) {
+      x.insert(i * 2);
+    }
+
+    for (int i = 0; i < 2000; ++i) {
+      x.reset_stats();
+      typename X::entry_type e = x.entry(i);
+      BOOST_TEST(e.key() == i);
+      BOOST_TEST(e.found() == (i % 2 == 0));
+      if (!e.found()) {
+        BOOST_TEST(e.position() == x.end());
+        typename X::iterator it = e.insert();
+        BOOST_TEST(*it == i);
+        BOOST_TEST(e.found() && e.position() == it);
+      }
+
+      // Rehashing calls the hash function for the existing elements, so
+      // only check when the bucket count didn't change.
+      boost::unordered::stats s = x.get_stats();
+      BOOST_TEST(s.rehashes || s.hash_calls == 1);
+      BOOST_TEST(e.position() == x.find(i));
+    }
+
+    BOOST_TEST(x.size() == 2000);
+    for (int i = 0; i < 2000; ++i) {
+      BOOST_TEST(x.count(i) == 1);
+    }
+  }
+
+  template <class X> void map_tests(X*)
+  {
+    X x;
+    x.emplace(1, "one");
+
+    typename X::entry_type e1 = x.entry(1);
+    BOOST_TEST(e1.found());
+    BOOST_TEST(e1.mapped() == "one");
+    e1.mapped() = "uno";
+    BOOST_TEST(x[1] == "uno");
+
+    x.reset_stats();
+    int key = 2;
+    typename X::entry_type e2 = x.entry(key);
+    BOOST_TEST(!e2.found());
+    typename X::iterator it = e2.emplace(3u, 'x');
+    BOOST_TEST(it->first == 2 && it->second == "xxx");
+    BOOST_TEST(e2.mapped() == "xxx");
+    BOOST_TEST(x.get_stats().hash_calls == 1);
+
+    typename X::entry_type e3 = x.entry(3);
+    BOOST_TEST(!e3.found());
+    e3.emplace();
+    BOOST_TEST(x.size() == 3);
+    BOOST_TEST(x.at(3).empty());
+
+    // A typical find-or-insert loop.
+    X counts;
+    std::string words[] = {"a", "b", "a", "c", "a", "b"};
+    for (std::size_t i = 0; i < sizeof(words) / sizeof(*words); ++i) {
+      typename X::entry_type e = counts.entry(static_cast<int>(words[i][0]));
+      if (!e.found()) {
+        e.emplace();
+      }
+      e.mapped() += "*";
+    }
+    BOOST_TEST(counts.size() == 3);
+    BOOST_TEST(counts['a'] == "***");
+    BOOST_TEST(counts['b'] == "**");
+    BOOST_TEST(counts['c'] == "*");
+
+    // Emplacing a key that was found returns the existing element, without
+    // constructing anything.
+    typename X::entry_type e4 = x.entry(1);
+    BOOST_TEST(e4.found());
+    BOOST_TEST(e4.emplace(5u, 'y') == x.find(1));
+    BOOST_TEST(x.size() == 3 && x[1] == "uno");
+  }
+
+  // An rvalue key is moved into the entry, so it can outlive a temporary.
+  template <class X> void string_key_tests(X*)
+  {
+    X x;
+    x.insert(std::string("a"));
+
+    typename X::entry_type e1 = x.entry(std::string("a"));
+    BOOST_TEST(e1.found() && e1.key() == "a");
+    BOOST_TEST(e1.insert() == x.find("a"));
+    BOOST_TEST(x.size() == 1);
+
+    typename X::entry_type e2 = x.entry("b");
+    BOOST_TEST(!e2.found() && e2.key() == "b");
+    typename X::iterator it = e2.insert();
+    BOOST_TEST(*it == "b" && e2.key() == "b");
+    BOOST_TEST(e2.insert() == it);
+    BOOST_TEST(x.size() == 2);
+
+    std::string key = "c";
+    typename X::entry_type e3 = x.entry(key);
+    BOOST_TEST(e3.key() == "c");
+    e3.insert();
+    BOOST_TEST(x.count("c") == 1 && key == "c");
+  }
+
+  // An lvalue key is only copied when it's inserted.
+  template <class X> void key_copy_tests(X*)
+  {
+    X x;
+    x.insert(test::object(1, 1));
+
+    test::object k1(1, 1);
+    int constructions = test::global_object_count.constructions;
+    typename X::entry_type e1 = x.entry(k1);
+    BOOST_TEST(e1.found() && e1.key() == k1);
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+    BOOST_TEST_EQ(test::global_object_count.constructions, constructions);
+    BOOST_TEST(&e1.key() == &*x.find(k1));
+#endif
+    e1.insert();
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+    BOOST_TEST_EQ(test::global_object_count.constructions, constructions);
+#endif
+
+    test::object k2(2, 2);
+    constructions = test::global_object_count.constructions;
+    typename X::entry_type e2 = x.entry(k2);
+    BOOST_TEST(!e2.found());
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+    BOOST_TEST(&e2.key() == &k2);
+    BOOST_TEST_EQ(test::global_object_count.constructions, constructions);
+#endif
+    constructions = test::global_object_count.constructions;
+    e2.insert();
+    BOOST_TEST_EQ(test::global_object_count.constructions, constructions + 1);
+    BOOST_TEST(x.size() == 2 && x.count(k2) == 1);
+  }
+
+  template <class X> void key_copy_map_tests(X*)
+  {
+    X x;
+    x.emplace(test::object(1, 1), 1);
+
+    test::object k1(1, 1);
+    int constructions = test::global_object_count.constructions;
+    typename X::entry_type e1 = x.entry(k1);
+    BOOST_TEST(e1.found() && e1.mapped() == 1);
+    e1.emplace(2);
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+    BOOST_TEST_EQ(test::global_object_count.constructions, constructions);
+#endif
+
+    test::object k2(2, 2);
+    typename X::entry_type e2 = x.entry(k2);
+    constructions = test::global_object_count.constructions;
+    e2.emplace(2);
+    BOOST_TEST_EQ(test::global_object_count.constructions, constructions + 1);
+    BOOST_TEST(x.size() == 2 && x[k2] == 2);
+  }
+
+  template <class X> void string_map_tests(X*)
+  {
+    X x;
+    typename X::entry_type e = x.entry("a");
+    BOOST_TEST(!e.found() && e.key() == "a");
+    e.emplace(2u, 'x');
+    BOOST_TEST(e.key() == "a" && e.mapped() == "xx");
+    BOOST_TEST(x.size() == 1 && x["a"] == "xx");
+  }
+
+  boost::unordered_set<int>* test_set;
+  boost::unordered_map<int, std::string>* test_map;
+  boost::unordered_set<std::string>* test_string_set;
+  boost::unordered_map<std::string, std::string>* test_string_map;
+  boost::unordered_set<test::object, test::hash, test::equal_to>*
+    test_object_set;
+  boost::unordered_map<test::object, int, test::hash, test::equal_to>*
+    test_object_map;
+
+  UNORDERED_TEST(single_hash_tests, ((test_set)))
+  UNORDERED_TEST(map_tests, ((test_map)))
+  UNORDERED_TEST(string_key_tests, ((test_string_set)))
+  UNORDERED_TEST(string_map_tests, ((test_string_map)))
+  UNORDERED_TEST(key_copy_tests, ((test_object_set)))
+  UNORDERED_TEST(key_copy_map_tests, ((test_object_map)))
+}
+
+RUN_TESTS()
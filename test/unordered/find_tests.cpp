@@ -15,6 +15,7 @@
 #include "../helpers/random_values.hpp"
 #include "../helpers/tracker.hpp"
 #include "../helpers/helpers.hpp"
+#include <vector>
 
 namespace find_tests {
 
@@ -46,6 +47,7 @@ namespace find_tests {
         BOOST_TEST(pos != x.end() && x.key_eq()(key, test::get_key<X>(*pos)));
 
         BOOST_TEST(x.count(key) == tracker.count(key));
+        BOOST_TEST(x.contains(key) == (tracker.count(key) != 0));
 
         test::compare_pairs(x.equal_range(key), tracker.equal_range(key),
           (BOOST_DEDUCED_TYPENAME X::value_type*)0);
@@ -62,6 +64,7 @@ namespace find_tests {
           BOOST_TEST(x.find(key) == x.end());
           BOOST_TEST(x_const.find(key) == x_const.end());
           BOOST_TEST(x.count(key) == 0);
+          BOOST_TEST(!x.contains(key));
           std::pair<iterator, iterator> range = x.equal_range(key);
           BOOST_TEST(range.first == range.second);
         }
@@ -80,6 +83,7 @@ namespace find_tests {
         BOOST_DEDUCED_TYPENAME X::key_type key = test::get_key<X>(*it3);
         BOOST_TEST(x.find(key) == x.end());
         BOOST_TEST(x.count(key) == 0);
+        BOOST_TEST(!x.contains(key));
         std::pair<iterator, iterator> range = x.equal_range(key);
         BOOST_TEST(range.first == range.second);
       }
@@ -137,6 +141,58 @@ namespace find_tests {
     }
   }
 
+  template <class X>
+  void find_many_tests(X*, test::random_generator generator)
+  {
+    typedef BOOST_DEDUCED_TYPENAME X::key_type key_type;
+    typedef BOOST_DEDUCED_TYPENAME X::iterator iterator;
+    typedef BOOST_DEDUCED_TYPENAME X::const_iterator const_iterator;
+
+    test::random_values<X> v(500, generator);
+    test::random_values<X> v2(100, generator);
+
+    // Look up the existing keys, and some which might be missing, in a
+    // number that isn't a multiple of the batch size.
+    std::vector<key_type> keys;
+    for (BOOST_DEDUCED_TYPENAME test::random_values<X>::iterator it =
+           v.begin();
+         it != v.end(); ++it) {
+      keys.push_back(test::get_key<X>(*it));
+    }
+    for (BOOST_DEDUCED_TYPENAME test::random_values<X>::iterator it =
+           v2.begin();
+         it != v2.end(); ++it) {
+      keys.push_back(test::get_key<X>(*it));
+    }
+    keys.push_back(keys.front());
+
+    X x;
+    X const& x_const = x;
+    std::vector<iterator> found(keys.size());
+    std::vector<const_iterator> const_found(keys.size());
+
+    // An empty container.
+    BOOST_TEST(x.find_many(keys.begin(), keys.end(), found.begin()) ==
+               found.end());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      BOOST_TEST(found[i] == x.end());
+    }
+
+    x.insert(v.begin(), v.end());
+    BOOST_TEST(x.find_many(keys.begin(), keys.end(), found.begin()) ==
+               found.end());
+    BOOST_TEST(x_const.find_many(keys.begin(), keys.end(),
+                 const_found.begin()) == const_found.end());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      BOOST_TEST(found[i] == x.find(keys[i]));
+      BOOST_TEST(const_found[i] == x_const.find(keys[i]));
+    }
+
+    // Nothing is written for an empty range.
+    BOOST_TEST(x.find_many(keys.begin(), keys.begin(), found.begin()) ==
+               found.begin());
+  }
+
   boost::unordered_set<test::object, test::hash, test::equal_to,
     test::allocator2<test::object> >* test_set;
   boost::unordered_multiset<test::object, test::hash, test::equal_to,
@@ -156,6 +212,9 @@ namespace find_tests {
   UNORDERED_TEST(find_compatible_keys_test,
     ((test_set)(test_multiset)(test_map)(test_multimap))(
                    (default_generator)(generate_collisions)(limited_range)))
+  UNORDERED_TEST(find_many_tests,
+    ((test_set)(test_multiset)(test_map)(test_multimap))(
+      (default_generator)(generate_collisions)(limited_range)))
 }
 
 RUN_TESTS()
@@ -0,0 +1,367 @@
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// clang-format off
+#include "../helpers/prefix.hpp"
+#include <boost/config.hpp>
+#if !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES) &&                             \
+  !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+#define BOOST_UNORDERED_TEST_FLAT 1
+#include <boost/unordered_flat_set.hpp>
+#include <boost/unordered_flat_map.hpp>
+#else
+#include <boost/unordered_set.hpp>
+#endif
+#include "../helpers/postfix.hpp"
+// clang-format on
+
+#include "../helpers/test.hpp"
+#include <boost/unordered/hash_traits.hpp>
+
+#if defined(BOOST_UNORDERED_TEST_FLAT)
+
+#include "../objects/test.hpp"
+#include "../helpers/random_values.hpp"
+#include "../helpers/tracker.hpp"
+#include "../helpers/helpers.hpp"
+#include "../helpers/equivalent.hpp"
+#include <string>
+
+namespace flat_tests {
+  struct fibonacci_hash : boost::hash<int>
+  {
+  };
+}
+
+namespace boost {
+  namespace unordered {
+    template <> struct bucket_policy<flat_tests::fibonacci_hash>
+    {
+      typedef boost::unordered::fibonacci_bucket_policy type;
+    };
+  }
+}
+
+namespace flat_tests {
+
+  test::seed_t initialize_seed(48294);
+
+  template <class X>
+  void insert_find_tests(X*, test::random_generator generator)
+  {
+    typedef typename X::iterator iterator;
+
+    test::check_instances check_;
+
+    test::random_values<X> v(1000, generator);
+    X x;
+    test::ordered<X> tracker = test::create_ordered(x);
+
+    for (typename test::random_values<X>::iterator it = v.begin();
+         it != v.end(); ++it) {
+      std::pair<iterator, bool> r = x.insert(*it);
+      std::pair<typename test::ordered<X>::iterator, bool> r2 =
+        tracker.insert(*it);
+      BOOST_TEST(r.second == r2.second);
+      BOOST_TEST(*r.first == *r2.first);
+      BOOST_TEST(x.load_factor() <= x.max_load_factor());
+    }
+
+    tracker.compare(x);
+
+    for (typename test::ordered<X>::const_iterator it = tracker.begin();
+         it != tracker.end(); ++it) {
+      typename X::key_type key = test::get_key<X>(*it);
+      iterator pos = x.find(key);
+      BOOST_TEST(pos != x.end() && *pos == *it);
+      BOOST_TEST(x.count(key) == 1);
+      BOOST_TEST(std::distance(x.equal_range(key).first,
+                   x.equal_range(key).second) == 1);
+    }
+
+    test::random_values<X> v2(500, generator);
+    for (typename test::random_values<X>::iterator it = v2.begin();
+         it != v2.end(); ++it) {
+      typename X::key_type key = test::get_key<X>(*it);
+      if (tracker.find(key) == tracker.end()) {
+        BOOST_TEST(x.find(key) == x.end());
+        BOOST_TEST(x.count(key) == 0);
+      }
+    }
+  }
+
+  template <class X> void erase_tests(X*, test::random_generator generator)
+  {
+    test::check_instances check_;
+
+    test::random_values<X> v(1000, generator);
+    X x(v.begin(), v.end());
+    test::ordered<X> tracker = test::create_ordered(x);
+    tracker.insert_range(v.begin(), v.end());
+
+    // Erase by key.
+    std::size_t count = 0;
+    for (typename test::random_values<X>::iterator it = v.begin();
+         it != v.end(); ++it) {
+      if (++count % 3) {
+        typename X::key_type key = test::get_key<X>(*it);
+        BOOST_TEST(x.erase(key) == tracker.erase(key));
+        BOOST_TEST(x.find(key) == x.end());
+      }
+    }
+    tracker.compare(x);
+
+    // Erase by iterator, checking the returned iterator.
+    typename X::size_type size = x.size();
+    typename X::iterator pos = x.begin();
+    while (pos != x.end()) {
+      tracker.erase(test::get_key<X>(*pos));
+      typename X::iterator next = pos;
+      ++next;
+      pos = x.erase(pos);
+      BOOST_TEST(pos == next);
+      --size;
+      BOOST_TEST(x.size() == size);
+      if (pos != x.end())
+        ++pos;
+    }
+    tracker.compare(x);
+
+    // Reinserting should reuse deleted slots.
+    x.insert(v.begin(), v.end());
+    tracker.insert_range(v.begin(), v.end());
+    tracker.compare(x);
+
+    // Erase range.
+    BOOST_TEST(x.erase(x.begin(), x.end()) == x.end());
+    BOOST_TEST(x.empty());
+    BOOST_TEST(x.begin() == x.end());
+  }
+
+  template <class X> void copy_move_tests(X*, test::random_generator generator)
+  {
+    test::check_instances check_;
+
+    test::random_values<X> v(500, generator);
+    X x(v.begin(), v.end());
+
+    // Leave some deleted markers in the table.
+    std::size_t count = 0;
+    for (typename test::random_values<X>::iterator it = v.begin();
+         it != v.end(); ++it) {
+      if (++count % 4 == 0)
+        x.erase(test::get_key<X>(*it));
+    }
+
+    test::unordered_equivalence_tester<X> equivalent(x);
+
+    {
+      X y(x);
+      BOOST_TEST(equivalent(y));
+      BOOST_TEST(y == x);
+      y.insert(v.begin(), v.end());
+      BOOST_TEST(y.size() >= x.size());
+    }
+
+    {
+      X y(x, x.get_allocator());
+      BOOST_TEST(equivalent(y));
+    }
+
+    {
+      X y;
+      y = x;
+      BOOST_TEST(equivalent(y));
+      y = y;
+      BOOST_TEST(equivalent(y));
+      X z(boost::move(y));
+      BOOST_TEST(equivalent(z));
+      BOOST_TEST(y.empty());
+      y = boost::move(z);
+      BOOST_TEST(equivalent(y));
+    }
+
+    {
+      X y, z(x);
+      y.swap(z);
+      BOOST_TEST(equivalent(y));
+      BOOST_TEST(z.empty());
+      boost::swap(y, z);
+      BOOST_TEST(equivalent(z));
+    }
+
+    {
+      X y(x);
+      y.rehash(0);
+      BOOST_TEST(equivalent(y));
+      y.rehash(y.bucket_count() * 4);
+      BOOST_TEST(equivalent(y));
+      BOOST_TEST(y.load_factor() <= y.max_load_factor() / 4);
+      y.reserve(2000);
+      BOOST_TEST(static_cast<float>(y.bucket_count()) * y.max_load_factor() >=
+                 2000);
+      BOOST_TEST(equivalent(y));
+      y.clear();
+      BOOST_TEST(y.empty());
+      BOOST_TEST(y.begin() == y.end());
+      BOOST_TEST(y != x);
+    }
+  }
+
+  boost::unordered_flat_set<test::object, test::hash, test::equal_to,
+    test::allocator1<test::object> >* test_set;
+  boost::unordered_flat_map<test::object, test::object, test::hash,
+    test::equal_to, test::allocator2<test::object> >* test_map;
+
+  using test::default_generator;
+  using test::generate_collisions;
+  using test::limited_range;
+
+  UNORDERED_TEST(insert_find_tests, ((test_set)(test_map))(
+                                      (default_generator)(generate_collisions)(
+                                        limited_range)))
+  UNORDERED_TEST(erase_tests, ((test_set)(test_map))(
+                                (default_generator)(generate_collisions)(
+                                  limited_range)))
+  UNORDERED_TEST(copy_move_tests, ((test_set)(test_map))(
+                                    (default_generator)(generate_collisions)(
+                                      limited_range)))
+
+  UNORDERED_AUTO_TEST(flat_map_api_tests)
+  {
+    boost::unordered_flat_map<std::string, int> x;
+
+    x["one"] = 1;
+    BOOST_TEST(x.at("one") == 1);
+    BOOST_TEST(x.try_emplace("one", 2).second == false);
+    BOOST_TEST(x.try_emplace("two", 2).second);
+    BOOST_TEST(x.insert_or_assign("one", 10).second == false);
+    BOOST_TEST(x.at("one") == 10);
+    BOOST_TEST(x.emplace("three", 3).second);
+    BOOST_TEST(x.emplace(std::make_pair("three", 4)).second == false);
+    BOOST_TEST(x.size() == 3);
+
+    bool caught = false;
+    try {
+      x.at("four");
+    } catch (std::out_of_range&) {
+      caught = true;
+    }
+    BOOST_TEST(caught);
+
+    for (int i = 0; i < 1000; ++i) {
+      x.emplace(std::to_string(i), i);
+    }
+    BOOST_TEST(x.size() == 1003);
+    for (int i = 0; i < 1000; ++i) {
+      BOOST_TEST(x.at(std::to_string(i)) == i);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+      BOOST_TEST(x.erase(std::to_string(i)) == 1);
+    }
+    BOOST_TEST(x.size() == 503);
+    BOOST_TEST(x.count("10") == 0);
+    BOOST_TEST(x.count("11") == 1);
+
+    boost::unordered_flat_map<std::string, int> y = {{"a", 1}, {"b", 2}};
+    BOOST_TEST(y.size() == 2);
+    y = {{"c", 3}};
+    BOOST_TEST(y.size() == 1 && y.at("c") == 3);
+  }
+
+  UNORDERED_AUTO_TEST(flat_set_churn_tests)
+  {
+    // Repeated insert and erase shouldn't let deleted markers fill the
+    // table.
+    boost::unordered_flat_set<int> x;
+    for (int i = 0; i < 20000; ++i) {
+      x.insert(i);
+      if (i >= 10) {
+        BOOST_TEST(x.erase(i - 10) == 1);
+      }
+      BOOST_TEST(x.size() == (std::size_t)(i < 10 ? i + 1 : 10));
+    }
+    BOOST_TEST(x.bucket_count() < 1000);
+    for (int i = 19990; i < 20000; ++i) {
+      BOOST_TEST(x.count(i) == 1);
+    }
+  }
+
+  struct constant_hash
+  {
+    std::size_t operator()(int) const { return 7; }
+  };
+
+  UNORDERED_AUTO_TEST(flat_group_overflow_tests)
+  {
+    // Every element starts probing in the same group, so most are placed
+    // in later groups, and lookups have to continue past full groups.
+    boost::unordered_flat_set<int, constant_hash> x;
+    for (int i = 0; i < 100; ++i) {
+      BOOST_TEST(x.insert(i).second);
+    }
+    BOOST_TEST(x.size() == 100);
+    for (int i = 0; i < 100; ++i) {
+      BOOST_TEST(x.count(i) == 1);
+    }
+    BOOST_TEST(x.count(100) == 0);
+
+    // Erasing from the full groups leaves deleted markers, which mustn't
+    // stop the probe for the remaining elements.
+    for (int i = 0; i < 100; i += 2) {
+      BOOST_TEST(x.erase(i) == 1);
+    }
+    for (int i = 0; i < 100; ++i) {
+      BOOST_TEST(x.count(i) == static_cast<std::size_t>(i % 2));
+    }
+    for (int i = 0; i < 100; i += 2) {
+      BOOST_TEST(x.insert(i).second);
+    }
+    BOOST_TEST(x.size() == 100);
+    BOOST_TEST(std::distance(x.begin(), x.end()) == 100);
+  }
+
+  struct counting_equal
+  {
+    static std::size_t calls;
+
+    bool operator()(int x, int y) const
+    {
+      ++calls;
+      return x == y;
+    }
+  };
+
+  std::size_t counting_equal::calls = 0;
+
+  UNORDERED_AUTO_TEST(flat_fibonacci_fragment_tests)
+  {
+    // The Fibonacci policy picks the group from the high bits of the
+    // multiplied hash value, so the fragments have to come from other
+    // bits. Otherwise, with enough groups, every element in a group has
+    // the same fragment, and the equality predicate is called for all of
+    // them.
+    boost::unordered_flat_set<int, fibonacci_hash, counting_equal> x;
+    for (int i = 0; i < 20000; ++i) {
+      x.insert(i);
+    }
+    BOOST_TEST(x.bucket_count() >= 128 * 16);
+
+    counting_equal::calls = 0;
+    for (int i = 0; i < 20000; ++i) {
+      BOOST_TEST(x.count(i) == 1);
+    }
+    BOOST_TEST(counting_equal::calls < 22000);
+
+    counting_equal::calls = 0;
+    for (int i = 20000; i < 40000; ++i) {
+      BOOST_TEST(x.count(i) == 0);
+    }
+    BOOST_TEST(counting_equal::calls < 2000);
+  }
+}
+
+#endif
+
+RUN_TESTS()
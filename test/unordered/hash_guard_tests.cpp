@@ -0,0 +1,177 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// clang-format off
+#include "../helpers/prefix.hpp"
+#include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered/hash_traits.hpp>
+#include "../helpers/postfix.hpp"
+// clang-format on
+
+#include "../helpers/test.hpp"
+#include "../helpers/helpers.hpp"
+#include <boost/functional/hash.hpp>
+
+namespace hash_guard_tests {
+  // The hash function for std::size_t, which uses the prime policy.
+  struct guarded_hash : boost::hash<std::size_t>
+  {
+  };
+
+  // Also rehashing incrementally and storing the hash values.
+  struct guarded_incremental_hash : boost::hash<std::size_t>
+  {
+  };
+
+  struct unguarded_hash : boost::hash<std::size_t>
+  {
+  };
+}
+
+namespace boost {
+  namespace unordered {
+    template <>
+    struct hash_guard<hash_guard_tests::guarded_hash> : boost::true_type
+    {
+    };
+
+    template <>
+    struct hash_guard<hash_guard_tests::guarded_incremental_hash>
+      : boost::true_type
+    {
+    };
+
+    template <>
+    struct incremental_rehash<hash_guard_tests::guarded_incremental_hash>
+      : boost::true_type
+    {
+    };
+
+    template <>
+    struct store_hash<hash_guard_tests::guarded_incremental_hash>
+      : boost::true_type
+    {
+    };
+  }
+}
+
+namespace hash_guard_tests {
+  // A prime from the bucket count list. Keys which are multiples of it all
+  // go in the first bucket.
+  static const std::size_t prime = 1543;
+
+  std::size_t make_value(std::size_t x, std::size_t const*) { return x; }
+
+  std::pair<std::size_t const, int> make_value(
+    std::size_t x, std::pair<std::size_t const, int> const*)
+  {
+    return std::pair<std::size_t const, int>(x, static_cast<int>(x));
+  }
+
+  template <class X> std::size_t max_bucket_size(X const& x)
+  {
+    std::size_t result = 0;
+    for (std::size_t i = 0; i < x.bucket_count(); ++i) {
+      result = (std::max)(result, x.bucket_size(i));
+    }
+    return result;
+  }
+
+  template <class X> void insert_strided(X& x, std::size_t count)
+  {
+    typedef typename X::value_type value_type;
+    for (std::size_t i = 0; i < count; ++i) {
+      x.insert(make_value(i * prime, (value_type const*)0));
+    }
+  }
+
+  template <class X> void check_strided(X const& x, std::size_t count)
+  {
+    BOOST_TEST(x.size() >= count);
+    for (std::size_t i = 0; i < count; ++i) {
+      BOOST_TEST(x.find(i * prime) != x.end());
+      BOOST_TEST(x.find(i * prime + 1) == x.end());
+    }
+  }
+
+  template <class X> void unguarded_tests(X*)
+  {
+    // Check that the test does create a pathological bucket.
+    X x(prime);
+    BOOST_TEST(x.bucket_count() == prime);
+    insert_strided(x, 1000);
+    BOOST_TEST(x.bucket_count() == prime);
+    BOOST_TEST(x.bucket_size(0) == 1000);
+  }
+
+  template <class X> void hash_guard_tests(X*)
+  {
+    X x(prime);
+    insert_strided(x, 1000);
+    BOOST_TEST(x.bucket_count() == prime);
+    BOOST_TEST(max_bucket_size(x) < 20);
+    check_strided(x, 1000);
+
+    // Copies, swaps and rehashes keep the mixed hash values.
+    X y(x);
+    BOOST_TEST(max_bucket_size(y) < 20);
+    check_strided(y, 1000);
+
+    X z;
+    z.swap(y);
+    check_strided(z, 1000);
+    z.rehash(prime * 2);
+    check_strided(z, 1000);
+    BOOST_TEST(max_bucket_size(z) < 20);
+
+    // Continue growing after the switch.
+    insert_strided(x, 5000);
+    check_strided(x, 5000);
+    BOOST_TEST(max_bucket_size(x) < 20);
+
+    x.clear();
+    insert_strided(x, 100);
+    check_strided(x, 100);
+  }
+
+  // Lots of equivalent elements in a bucket don't count.
+  template <class X> void equivalent_tests(X*)
+  {
+    typedef typename X::value_type value_type;
+
+    X x(prime);
+    for (std::size_t i = 0; i < 700; ++i) {
+      x.insert(make_value(prime, (value_type const*)0));
+      x.insert(make_value(i + 1, (value_type const*)0));
+    }
+    x.insert(make_value(prime * 2, (value_type const*)0));
+
+    // The hash values weren't mixed, so the multiples of the prime are
+    // still in the first bucket.
+    BOOST_TEST(x.bucket_count() == prime);
+    BOOST_TEST(x.bucket(prime) == 0);
+    BOOST_TEST(x.bucket(prime * 2) == 0);
+    BOOST_TEST(x.count(prime) == 700);
+  }
+
+  boost::unordered_set<std::size_t, unguarded_hash>* test_unguarded_set;
+  boost::unordered_set<std::size_t, guarded_hash>* test_set;
+  boost::unordered_multiset<std::size_t, guarded_hash>* test_multiset;
+  boost::unordered_map<std::size_t, int, guarded_hash>* test_map;
+  boost::unordered_multimap<std::size_t, int, guarded_hash>* test_multimap;
+  boost::unordered_set<std::size_t, guarded_incremental_hash>*
+    test_incremental_set;
+  boost::unordered_multimap<std::size_t, int, guarded_incremental_hash>*
+    test_incremental_multimap;
+
+  UNORDERED_TEST(unguarded_tests, ((test_unguarded_set)))
+  UNORDERED_TEST(hash_guard_tests,
+    ((test_set)(test_multiset)(test_map)(test_multimap)(test_incremental_set)(
+      test_incremental_multimap)))
+  UNORDERED_TEST(equivalent_tests, ((test_multiset)(test_multimap)))
+}
+
+RUN_TESTS()
@@ -0,0 +1,229 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// clang-format off
+#include "../helpers/prefix.hpp"
+#include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered/hash_traits.hpp>
+#include "../helpers/postfix.hpp"
+// clang-format on
+
+#include "../helpers/test.hpp"
+#include "../objects/test.hpp"
+#include "../helpers/random_values.hpp"
+#include "../helpers/tracker.hpp"
+#include "../helpers/equivalent.hpp"
+#include "../helpers/invariants.hpp"
+#include <boost/functional/hash.hpp>
+
+namespace incremental_rehash_tests {
+  // test::hash, but rehashing incrementally.
+  struct incremental_hash : test::hash
+  {
+    incremental_hash() {}
+    explicit incremental_hash(int t) : test::hash(t) {}
+  };
+
+  // Counts the number of times that a hash function is called, to check
+  // how many elements are rehashed by each insert.
+  template <bool Incremental> struct counting_hash
+  {
+    static int calls;
+
+    std::size_t operator()(int x) const
+    {
+      ++calls;
+      return boost::hash<int>()(x);
+    }
+  };
+
+  template <bool Incremental> int counting_hash<Incremental>::calls = 0;
+}
+
+namespace boost {
+  namespace unordered {
+    template <>
+    struct incremental_rehash<incremental_rehash_tests::incremental_hash>
+      : boost::true_type
+    {
+    };
+
+    template <>
+    struct incremental_rehash<incremental_rehash_tests::counting_hash<true> >
+      : boost::true_type
+    {
+    };
+  }
+}
+
+namespace incremental_rehash_tests {
+
+  test::seed_t initialize_seed(48213);
+
+  // Check the elements, lookup and the bucket interface while the elements
+  // might be in either bucket array.
+  template <class X, class Tracker>
+  void check_rehashing(X const& x, Tracker& tracker)
+  {
+    tracker.compare(x);
+    for (typename Tracker::iterator it = tracker.begin();
+         it != tracker.end(); ++it) {
+      BOOST_TEST(x.find(test::get_key<X>(*it)) != x.end());
+      BOOST_TEST(
+        x.count(test::get_key<X>(*it)) == tracker.count(test::get_key<X>(*it)));
+    }
+    test::check_equivalent_keys(x);
+
+    typename X::size_type size = 0;
+    for (typename X::size_type i = 0; i < x.bucket_count(); ++i) {
+      size += x.bucket_size(i);
+    }
+    BOOST_TEST(size == x.size());
+  }
+
+  template <class X>
+  void incremental_rehash_tests(X*, test::random_generator generator)
+  {
+    test::check_instances check_;
+
+    test::random_values<X> v(1000, generator);
+    X x;
+    test::ordered<X> tracker = test::create_ordered(x);
+
+    std::size_t count = 0;
+    for (typename test::random_values<X>::iterator it = v.begin();
+         it != v.end(); ++it) {
+      x.insert(*it);
+      tracker.insert(*it);
+      if (++count % 97 == 0) {
+        check_rehashing(x, tracker);
+      }
+    }
+    check_rehashing(x, tracker);
+
+    // Erasing doesn't move any buckets, so the bucket count doesn't change.
+    count = 0;
+    typename X::size_type bucket_count = x.bucket_count();
+    for (typename test::random_values<X>::iterator it = v.begin();
+         it != v.end(); ++it) {
+      if (++count % 3 == 0) {
+        BOOST_TEST(x.erase(test::get_key<X>(*it)) ==
+                   tracker.erase(test::get_key<X>(*it)));
+      }
+    }
+    BOOST_TEST(x.bucket_count() == bucket_count);
+    check_rehashing(x, tracker);
+
+    // Copy, swap and move part way through a rehash.
+    {
+      X y;
+      typename X::size_type size = 0;
+      for (typename test::random_values<X>::iterator it = v.begin();
+           it != v.end() && y.bucket_count() == X().bucket_count(); ++it) {
+        y.insert(*it);
+        size = y.size();
+      }
+      test::ordered<X> tracker2 = test::create_ordered(y);
+      tracker2.insert_range(y.begin(), y.end());
+      BOOST_TEST(y.size() == size);
+
+      X z(y);
+      check_rehashing(z, tracker2);
+      z.swap(x);
+      check_rehashing(z, tracker);
+      check_rehashing(x, tracker2);
+      z.swap(x);
+
+      X w;
+      w = y;
+      check_rehashing(w, tracker2);
+
+#if defined(BOOST_UNORDERED_USE_MOVE) ||                                       \
+  !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+      X u(boost::move(y));
+      check_rehashing(u, tracker2);
+      u.insert(v.begin(), v.end());
+      tracker2.insert_range(v.begin(), v.end());
+      check_rehashing(u, tracker2);
+#endif
+    }
+
+    // Extract and insert nodes, and merge, while rehashing.
+    {
+      X y;
+      for (int j = 0; j < 50 && !x.empty(); ++j) {
+        typename X::node_type n = x.extract(x.begin());
+        y.insert(boost::move(n));
+      }
+      typename X::size_type total = x.size() + y.size();
+      x.merge(y);
+      BOOST_TEST(x.size() + y.size() == total);
+      test::check_equivalent_keys(y);
+      check_rehashing(x, tracker);
+    }
+
+    // Rehash finishes moving the elements.
+    x.rehash(0);
+    test::check_equivalent_keys(x);
+    tracker.compare(x);
+
+    x.clear();
+    BOOST_TEST(x.empty());
+    tracker = test::create_ordered(x);
+    x.insert(v.begin(), v.end());
+    tracker.insert_range(v.begin(), v.end());
+    check_rehashing(x, tracker);
+  }
+
+  // The most elements that any single insert rehashes.
+  template <class X> int max_hash_calls_per_insert(int count)
+  {
+    typedef typename X::hasher hasher;
+    X x;
+    int max_calls = 0;
+    for (int i = 0; i < count; ++i) {
+      hasher::calls = 0;
+      x.insert(i);
+      max_calls = (std::max)(max_calls, hasher::calls);
+    }
+    for (int i = 0; i < count; ++i) {
+      BOOST_TEST(x.count(i) == 1);
+    }
+    return max_calls;
+  }
+
+  UNORDERED_AUTO_TEST(rehash_latency_tests)
+  {
+    int full = max_hash_calls_per_insert<
+      boost::unordered_set<int, counting_hash<false> > >(10000);
+    int incremental = max_hash_calls_per_insert<
+      boost::unordered_set<int, counting_hash<true> > >(10000);
+
+    // A full rehash calls the hash function for every element.
+    BOOST_TEST(full > 5000);
+    BOOST_TEST(incremental < 20);
+  }
+
+  boost::unordered_set<test::object, incremental_hash, test::equal_to,
+    std::allocator<test::object> >* test_set;
+  boost::unordered_multiset<test::object, incremental_hash, test::equal_to,
+    test::allocator2<test::object> >* test_multiset;
+  boost::unordered_map<test::object, test::object, incremental_hash,
+    test::equal_to, test::allocator2<test::object> >* test_map;
+  boost::unordered_multimap<test::object, test::object, incremental_hash,
+    test::equal_to, std::allocator<std::pair<test::object const,
+                      test::object> > >* test_multimap;
+
+  using test::default_generator;
+  using test::generate_collisions;
+  using test::limited_range;
+
+  UNORDERED_TEST(incremental_rehash_tests,
+    ((test_set)(test_multiset)(test_map)(test_multimap))(
+      (default_generator)(generate_collisions)(limited_range)))
+}
+
+RUN_TESTS()
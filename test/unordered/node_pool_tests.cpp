@@ -0,0 +1,241 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// clang-format off
+#include "../helpers/prefix.hpp"
+#include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered/node_pool_allocator.hpp>
+#include "../helpers/postfix.hpp"
+// clang-format on
+
+#include "../helpers/test.hpp"
+#include "../objects/test.hpp"
+#include "../helpers/random_values.hpp"
+#include "../helpers/tracker.hpp"
+#include "../helpers/equivalent.hpp"
+#include "../helpers/invariants.hpp"
+#include <cstdlib>
+#include <new>
+
+// Count the live allocations from operator new, to check that the pool
+// releases its slabs.
+
+namespace node_pool_tests {
+  std::size_t live_allocations = 0;
+}
+
+#if defined(BOOST_NO_CXX11_NOEXCEPT)
+void* operator new(std::size_t n) throw(std::bad_alloc)
+#else
+void* operator new(std::size_t n)
+#endif
+{
+  void* p = std::malloc(n ? n : 1);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  ++node_pool_tests::live_allocations;
+  return p;
+}
+
+void operator delete(void* p) BOOST_NOEXCEPT
+{
+  if (p) {
+    --node_pool_tests::live_allocations;
+    std::free(p);
+  }
+}
+
+test::seed_t initialize_seed(72521);
+
+namespace node_pool_tests {
+
+  template <class X>
+  void node_pool_churn_tests(X*, test::random_generator generator)
+  {
+    test::check_instances check_;
+
+    test::random_values<X> v(1000, generator);
+    X x;
+    test::ordered<X> tracker = test::create_ordered(x);
+
+    // Insert and erase repeatedly, so that nodes are reused from the free
+    // list.
+    for (int round = 0; round < 3; ++round) {
+      for (typename test::random_values<X>::iterator it = v.begin();
+           it != v.end(); ++it) {
+        x.insert(*it);
+        tracker.insert(*it);
+      }
+      tracker.compare(x);
+      test::check_equivalent_keys(x);
+
+      std::size_t count = 0;
+      for (typename test::random_values<X>::iterator it = v.begin();
+           it != v.end(); ++it) {
+        if (++count % 2) {
+          BOOST_TEST(x.erase(test::get_key<X>(*it)) ==
+                     tracker.erase(test::get_key<X>(*it)));
+        }
+      }
+      tracker.compare(x);
+    }
+
+    // Copies get their own pool.
+    {
+      X y(x);
+      BOOST_TEST(y.get_allocator() != x.get_allocator());
+      tracker.compare(y);
+      y.insert(v.begin(), v.end());
+      tracker.compare(x);
+
+      X z;
+      z = y;
+      BOOST_TEST(z.get_allocator() != y.get_allocator());
+      BOOST_TEST(z == y);
+    }
+
+    // Moving and swapping take the pool with them.
+    {
+      X y(x);
+      typename X::allocator_type a = y.get_allocator();
+
+      X w;
+      w.swap(y);
+      BOOST_TEST(w.get_allocator() == a);
+      tracker.compare(w);
+
+#if defined(BOOST_UNORDERED_USE_MOVE) ||                                       \
+  !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+      X z(boost::move(w));
+      BOOST_TEST(z.get_allocator() == a);
+      tracker.compare(z);
+
+      y = boost::move(z);
+      BOOST_TEST(y.get_allocator() == a);
+      tracker.compare(y);
+#endif
+    }
+
+    // Node handles use the pool of the container they came from.
+    if (!x.empty()) {
+      typename X::node_type n = x.extract(x.begin());
+      BOOST_TEST(n.get_allocator() == x.get_allocator());
+      x.insert(boost::move(n));
+      tracker.compare(x);
+    }
+
+    // Clearing returns all the nodes, and the pool can be used again.
+    x.clear();
+    BOOST_TEST(x.empty());
+    x.insert(v.begin(), v.end());
+    BOOST_TEST(!x.empty());
+  }
+
+  UNORDERED_AUTO_TEST(node_pool_reuse_tests)
+  {
+    boost::unordered_set<int, boost::hash<int>, std::equal_to<int>,
+      boost::unordered::node_pool_allocator<int> >
+      x;
+
+    x.insert(1);
+    int const* p = &*x.insert(2).first;
+    x.erase(2);
+    BOOST_TEST(&*x.insert(3).first == p);
+    BOOST_TEST(x.size() == 2);
+
+    // Once the last node has been erased, the slabs are released.
+    x.erase(1);
+    x.erase(3);
+    BOOST_TEST(x.empty());
+    x.insert(4);
+    BOOST_TEST(x.size() == 1 && x.count(4) == 1);
+  }
+
+  // Clearing a large container releases all its slabs, leaving just the
+  // bucket array and the pool's size class for the nodes.
+  UNORDERED_AUTO_TEST(node_pool_clear_tests)
+  {
+    boost::unordered_set<int, boost::hash<int>, std::equal_to<int>,
+      boost::unordered::node_pool_allocator<int> >
+      x;
+
+    std::size_t before = live_allocations;
+    for (int i = 0; i < 10000; ++i) {
+      x.insert(i);
+    }
+    BOOST_TEST(live_allocations > before + 3);
+    x.clear();
+    BOOST_TEST(x.empty());
+    BOOST_TEST_EQ(live_allocations, before + 2);
+
+    for (int i = 0; i < 100; ++i) {
+      x.insert(i);
+    }
+    BOOST_TEST(x.size() == 100);
+    x.clear();
+    BOOST_TEST_EQ(live_allocations, before + 2);
+  }
+
+  // Allocators rebound to types of different sizes use separate free lists,
+  // whichever is allocated first.
+  UNORDERED_AUTO_TEST(node_pool_size_class_tests)
+  {
+    typedef boost::unordered::node_pool_allocator<char> char_allocator;
+    typedef char_allocator::rebind<double>::other double_allocator;
+
+    char_allocator a;
+    double_allocator b(a);
+    BOOST_TEST(a == char_allocator(b));
+
+    char* c1 = a.allocate(1);
+    double* d1 = b.allocate(1);
+    char* c2 = a.allocate(1);
+    *c1 = 'a';
+    *c2 = 'b';
+    *d1 = 1.5;
+    BOOST_TEST(static_cast<void*>(c1) != static_cast<void*>(d1));
+    BOOST_TEST(static_cast<void*>(c2) != static_cast<void*>(d1));
+
+    // Keep another double alive, so that deallocating 'd1' puts it on the
+    // free list rather than releasing the slab.
+    double* d0 = b.allocate(1);
+    b.deallocate(d1, 1);
+    double* d2 = b.allocate(1);
+    BOOST_TEST(d2 == d1);
+    char* c3 = char_allocator(b).allocate(1);
+    BOOST_TEST(static_cast<void*>(c3) != static_cast<void*>(d2));
+    BOOST_TEST(*c1 == 'a' && *c2 == 'b');
+
+    a.deallocate(c3, 1);
+    a.deallocate(c2, 1);
+    a.deallocate(c1, 1);
+    b.deallocate(d2, 1);
+    b.deallocate(d0, 1);
+  }
+
+  boost::unordered_set<test::object, test::hash, test::equal_to,
+    boost::unordered::node_pool_allocator<test::object> >* test_set;
+  boost::unordered_multiset<test::object, test::hash, test::equal_to,
+    boost::unordered::node_pool_allocator<test::object> >* test_multiset;
+  boost::unordered_map<test::object, test::object, test::hash, test::equal_to,
+    boost::unordered::node_pool_allocator<
+      std::pair<test::object const, test::object> > >* test_map;
+  boost::unordered_multimap<test::object, test::object, test::hash,
+    test::equal_to, boost::unordered::node_pool_allocator<
+                      std::pair<test::object const, test::object> > >*
+    test_multimap;
+
+  using test::default_generator;
+  using test::generate_collisions;
+  using test::limited_range;
+
+  UNORDERED_TEST(node_pool_churn_tests,
+    ((test_set)(test_multiset)(test_map)(test_multimap))(
+      (default_generator)(generate_collisions)(limited_range)))
+}
+
+RUN_TESTS()
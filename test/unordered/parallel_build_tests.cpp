@@ -0,0 +1,187 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/config.hpp>
+#if !defined(BOOST_NO_CXX11_HDR_THREAD) && !defined(BOOST_NO_CXX11_LAMBDAS) && \
+  !defined(BOOST_NO_CXX11_RVALUE_REFERENCES) &&                                \
+  !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+#define BOOST_UNORDERED_ENABLE_PARALLEL
+#endif
+
+// clang-format off
+#include "../helpers/prefix.hpp"
+#include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered/hash_traits.hpp>
+#include <boost/unordered/node_traits.hpp>
+#include "../helpers/postfix.hpp"
+// clang-format on
+
+#include "../helpers/test.hpp"
+#include "../helpers/helpers.hpp"
+#include <boost/functional/hash.hpp>
+#include <vector>
+
+#if defined(BOOST_UNORDERED_ENABLE_PARALLEL)
+
+namespace parallel_build_tests {
+  // Incremental rehashing, stored hash values and doubly linked nodes
+  // change the bucket and node layout.
+  struct incremental_hash : boost::hash<int>
+  {
+  };
+
+  // Throws when it sees the key 'bad_key'.
+  struct throwing_equal
+  {
+    static int bad_key;
+
+    bool operator()(int x, int y) const
+    {
+      if (x == bad_key) {
+        throw std::runtime_error("bad key");
+      }
+      return x == y;
+    }
+  };
+
+  int throwing_equal::bad_key = -1;
+}
+
+namespace boost {
+  namespace unordered {
+    template <>
+    struct incremental_rehash<parallel_build_tests::incremental_hash>
+      : boost::true_type
+    {
+    };
+
+    template <>
+    struct store_hash<parallel_build_tests::incremental_hash>
+      : boost::true_type
+    {
+    };
+
+    template <>
+    struct doubly_linked<parallel_build_tests::incremental_hash>
+      : boost::true_type
+    {
+    };
+  }
+}
+
+namespace parallel_build_tests {
+  int make_value(int x, int const*) { return x; }
+
+  std::pair<int, int> make_value(int x, std::pair<int const, int> const*)
+  {
+    return std::pair<int, int>(x, x * 2);
+  }
+
+  template <class X>
+  std::vector<typename X::value_type> make_values(std::size_t count)
+  {
+    typedef typename X::value_type value_type;
+    std::vector<value_type> values;
+    for (std::size_t i = 0; i < count; ++i) {
+      // Lots of duplicates, so that the unique containers have to drop
+      // some of them.
+      values.push_back(
+        make_value(static_cast<int>(i % 30011), (value_type const*)0));
+    }
+    return values;
+  }
+
+  // The bucket interface has to agree with the list of nodes.
+  template <class X> void check_buckets(X const& x)
+  {
+    std::size_t total = 0;
+    for (std::size_t b = 0; b < x.bucket_count(); ++b) {
+      for (typename X::const_local_iterator it = x.begin(b); it != x.end(b);
+           ++it) {
+        BOOST_TEST(x.bucket(test::get_key<X>(*it)) == b);
+        ++total;
+      }
+    }
+    BOOST_TEST(total == x.size());
+    BOOST_TEST(static_cast<std::size_t>(std::distance(x.begin(), x.end())) ==
+               x.size());
+  }
+
+  template <class X> void parallel_build_tests(X*)
+  {
+    std::size_t const sizes[] = {0, 100, 50000, 100000};
+    std::size_t const threads[] = {0, 1, 2, 3, 8};
+
+    for (std::size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); ++i) {
+      std::vector<typename X::value_type> values = make_values<X>(sizes[i]);
+      X expected(values.begin(), values.end());
+
+      for (std::size_t j = 0; j < sizeof(threads) / sizeof(*threads); ++j) {
+        X x;
+        x.insert_parallel(values.begin(), values.end(), threads[j]);
+        BOOST_TEST(x.size() == expected.size());
+        BOOST_TEST(x == expected);
+        BOOST_TEST(x.load_factor() <= x.max_load_factor());
+        check_buckets(x);
+
+        // Check that the container still works.
+        x.insert(values.begin(), values.begin() + values.size() / 2);
+        x.erase(values.empty() ? 0 : test::get_key<X>(values.front()));
+        x.rehash(x.bucket_count() * 2);
+        check_buckets(x);
+      }
+    }
+
+    // A container that isn't empty is built one element at a time.
+    std::vector<typename X::value_type> values = make_values<X>(50000);
+    X x(values.begin(), values.begin() + 1000);
+    X expected(x);
+    x.insert_parallel(values.begin(), values.end(), 4);
+    expected.insert(values.begin(), values.end());
+    BOOST_TEST(x == expected);
+  }
+
+  template <class X> void exception_tests(X*)
+  {
+    std::vector<typename X::value_type> values = make_values<X>(100000);
+
+    X x;
+    throwing_equal::bad_key = 20000;
+    try {
+      x.insert_parallel(values.begin(), values.end(), 4);
+      BOOST_ERROR("Exception not thrown.");
+    } catch (std::runtime_error&) {
+    }
+    throwing_equal::bad_key = -1;
+
+    BOOST_TEST(x.empty());
+    check_buckets(x);
+    x.insert_parallel(values.begin(), values.end(), 4);
+    BOOST_TEST(x == X(values.begin(), values.end()));
+  }
+
+  boost::unordered_set<int>* test_set;
+  boost::unordered_multiset<int>* test_multiset;
+  boost::unordered_map<int, int>* test_map;
+  boost::unordered_multimap<int, int>* test_multimap;
+  boost::unordered_set<int, incremental_hash>* test_incremental_set;
+  boost::unordered_multimap<int, int, incremental_hash>*
+    test_incremental_multimap;
+  boost::unordered_set<int, boost::hash<int>, throwing_equal>*
+    test_throwing_set;
+  boost::unordered_multimap<int, int, boost::hash<int>, throwing_equal>*
+    test_throwing_multimap;
+
+  UNORDERED_TEST(parallel_build_tests,
+    ((test_set)(test_multiset)(test_map)(test_multimap)(test_incremental_set)(
+      test_incremental_multimap)))
+  UNORDERED_TEST(
+    exception_tests, ((test_throwing_set)(test_throwing_multimap)))
+}
+
+#endif
+
+RUN_TESTS()
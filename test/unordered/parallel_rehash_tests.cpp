@@ -0,0 +1,225 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/config.hpp>
+#if !defined(BOOST_NO_CXX11_HDR_THREAD) && !defined(BOOST_NO_CXX11_LAMBDAS) && \
+  !defined(BOOST_NO_CXX11_RVALUE_REFERENCES) &&                                \
+  !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+#define BOOST_UNORDERED_ENABLE_PARALLEL
+#endif
+
+// clang-format off
+#include "../helpers/prefix.hpp"
+#include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered/hash_traits.hpp>
+#include <boost/unordered/node_traits.hpp>
+#include "../helpers/postfix.hpp"
+// clang-format on
+
+#include "../helpers/test.hpp"
+#include "../helpers/helpers.hpp"
+#include <boost/functional/hash.hpp>
+#include <stdexcept>
+
+#if defined(BOOST_UNORDERED_ENABLE_PARALLEL)
+
+namespace parallel_rehash_tests {
+  // Throws when 'fail' is set.
+  struct throwing_hash
+  {
+    static bool fail;
+
+    std::size_t operator()(int x) const
+    {
+      if (fail) {
+        throw std::runtime_error("hash failed");
+      }
+      return boost::hash<int>()(x);
+    }
+  };
+
+  bool throwing_hash::fail = false;
+
+  struct incremental_hash : boost::hash<int>
+  {
+  };
+
+  struct pow2_hash : boost::hash<int>
+  {
+  };
+
+  struct guarded_hash : boost::hash<int>
+  {
+  };
+}
+
+namespace boost {
+  namespace unordered {
+    template <>
+    struct incremental_rehash<parallel_rehash_tests::incremental_hash>
+      : boost::true_type
+    {
+    };
+
+    template <>
+    struct store_hash<parallel_rehash_tests::incremental_hash>
+      : boost::true_type
+    {
+    };
+
+    template <>
+    struct doubly_linked<parallel_rehash_tests::incremental_hash>
+      : boost::true_type
+    {
+    };
+
+    template <> struct bucket_policy<parallel_rehash_tests::pow2_hash>
+    {
+      typedef pow2_bucket_policy type;
+    };
+
+    template <>
+    struct hash_guard<parallel_rehash_tests::guarded_hash> : boost::true_type
+    {
+    };
+  }
+}
+
+namespace parallel_rehash_tests {
+  int make_value(int x, int const*) { return x; }
+
+  std::pair<int const, int> make_value(int x, std::pair<int const, int> const*)
+  {
+    return std::pair<int const, int>(x, x * 2);
+  }
+
+  template <class X> void fill(X& x, int count)
+  {
+    typedef typename X::value_type value_type;
+    for (int i = 0; i < count; ++i) {
+      x.insert(make_value(i % 20011, (value_type const*)0));
+    }
+  }
+
+  // The bucket interface has to agree with the list of nodes.
+  template <class X> void check_buckets(X const& x)
+  {
+    std::size_t total = 0;
+    for (std::size_t b = 0; b < x.bucket_count(); ++b) {
+      for (typename X::const_local_iterator it = x.begin(b); it != x.end(b);
+           ++it) {
+        BOOST_TEST(x.bucket(test::get_key<X>(*it)) == b);
+        ++total;
+      }
+    }
+    BOOST_TEST(total == x.size());
+    BOOST_TEST(static_cast<std::size_t>(std::distance(x.begin(), x.end())) ==
+               x.size());
+  }
+
+  template <class X> void parallel_rehash_tests(X*)
+  {
+    std::size_t const threads[] = {0, 1, 2, 3, 8};
+
+    for (std::size_t j = 0; j < sizeof(threads) / sizeof(*threads); ++j) {
+      X x;
+      fill(x, 50000);
+      X expected(x);
+
+      std::size_t bucket_count = x.bucket_count();
+      x.rehash_parallel(bucket_count * 3, threads[j]);
+      BOOST_TEST(x.bucket_count() >= bucket_count * 3);
+      BOOST_TEST(x == expected);
+      check_buckets(x);
+
+      // Shrink back down.
+      x.rehash_parallel(0, threads[j]);
+      BOOST_TEST(x.bucket_count() < bucket_count * 3);
+      BOOST_TEST(x.load_factor() <= x.max_load_factor());
+      BOOST_TEST(x == expected);
+      check_buckets(x);
+
+      // Check that the container still works.
+      fill(x, 30000);
+      expected.insert(x.begin(), x.end());
+      x.erase(test::get_key<X>(*x.begin()));
+      check_buckets(x);
+    }
+
+    // Small containers are rehashed by the current thread.
+    X y;
+    fill(y, 100);
+    X expected(y);
+    y.rehash_parallel(1000, 4);
+    BOOST_TEST(y.bucket_count() >= 1000);
+    BOOST_TEST(y == expected);
+    check_buckets(y);
+  }
+
+  template <class X> void exception_tests(X*)
+  {
+    X x;
+    fill(x, 50000);
+    X expected(x);
+    std::size_t bucket_count = x.bucket_count();
+
+    throwing_hash::fail = true;
+    try {
+      x.rehash_parallel(bucket_count * 2, 4);
+      BOOST_ERROR("Exception not thrown.");
+    } catch (std::runtime_error&) {
+    }
+    throwing_hash::fail = false;
+
+    // Nothing was changed.
+    BOOST_TEST(x.bucket_count() == bucket_count);
+    BOOST_TEST(x == expected);
+    check_buckets(x);
+  }
+
+  template <class X> void hash_guard_tests(X*)
+  {
+    // A prime from the bucket count list, multiples of it all go in the
+    // first bucket unless the hash values are mixed.
+    int const prime = 1543;
+
+    X x(prime);
+    for (int i = 0; i < 10000; ++i) {
+      x.insert(i * prime);
+    }
+    x.rehash_parallel(x.bucket_count() * 2, 4);
+    check_buckets(x);
+
+    std::size_t max_size = 0;
+    for (std::size_t b = 0; b < x.bucket_count(); ++b) {
+      max_size = (std::max)(max_size, x.bucket_size(b));
+    }
+    BOOST_TEST(max_size < 20);
+  }
+
+  boost::unordered_set<int>* test_set;
+  boost::unordered_multiset<int>* test_multiset;
+  boost::unordered_map<int, int>* test_map;
+  boost::unordered_multimap<int, int>* test_multimap;
+  boost::unordered_set<int, incremental_hash>* test_incremental_set;
+  boost::unordered_multimap<int, int, incremental_hash>*
+    test_incremental_multimap;
+  boost::unordered_multiset<int, pow2_hash>* test_pow2_multiset;
+  boost::unordered_set<int, throwing_hash>* test_throwing_set;
+  boost::unordered_multimap<int, int, throwing_hash>* test_throwing_multimap;
+  boost::unordered_set<int, guarded_hash>* test_guarded_set;
+
+  UNORDERED_TEST(parallel_rehash_tests,
+    ((test_set)(test_multiset)(test_map)(test_multimap)(test_incremental_set)(
+      test_incremental_multimap)(test_pow2_multiset)))
+  UNORDERED_TEST(
+    exception_tests, ((test_throwing_set)(test_throwing_multimap)))
+  UNORDERED_TEST(hash_guard_tests, ((test_guarded_set)))
+}
+
+#endif
+
+RUN_TESTS()
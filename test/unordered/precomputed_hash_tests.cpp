@@ -0,0 +1,121 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#define BOOST_UNORDERED_ENABLE_STATS
+
+// clang-format off
+#include "../helpers/prefix.hpp"
+#include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
+#include "../helpers/postfix.hpp"
+// clang-format on
+
+#include "../helpers/test.hpp"
+#include "../helpers/helpers.hpp"
+#include <boost/functional/hash.hpp>
+#include <string>
+
+namespace precomputed_hash_tests {
+  std::string make_key(int x, std::string const*)
+  {
+    std::string result;
+    do {
+      result += static_cast<char>('a' + x % 26);
+      x /= 26;
+    } while (x);
+    return result;
+  }
+
+  int make_key(int x, int const*) { return x * 7; }
+
+  template <class K> K const& make_value(K const& k, K const*) { return k; }
+
+  template <class K>
+  std::pair<K const, int> make_value(K const& k, std::pair<K const, int> const*)
+  {
+    return std::pair<K const, int>(k, 1);
+  }
+
+  template <class X> void precomputed_hash_tests(X*)
+  {
+    typedef typename X::key_type key_type;
+    typedef typename X::value_type value_type;
+    typedef typename X::hasher hasher;
+
+    X x;
+    x.rehash(1000);
+    hasher hf = x.hash_function();
+    std::size_t bucket_count = x.bucket_count();
+
+    // The container shouldn't call the hash function itself.
+    x.reset_stats();
+    for (int i = 0; i < 200; ++i) {
+      key_type k = make_key(i, (key_type const*)0);
+      x.emplace_with_hash(hf(k), make_value(k, (value_type const*)0));
+      x.emplace_with_hash(hf(k), make_value(k, (value_type const*)0));
+    }
+    BOOST_TEST(x.bucket_count() == bucket_count);
+    BOOST_TEST(x.get_stats().hash_calls == 0);
+
+    X const& cx = x;
+    for (int i = 0; i < 300; ++i) {
+      key_type k = make_key(i, (key_type const*)0);
+      BOOST_TEST(x.find(k, hf(k)) == x.find(k));
+      BOOST_TEST(cx.find(k, hf(k)) == cx.find(k));
+      BOOST_TEST((x.find(k, hf(k)) == x.end()) == (i >= 200));
+    }
+
+    // The elements can be found using the normal lookup, and vice versa.
+    x.reset_stats();
+    std::size_t count = x.size();
+    for (int i = 0; i < 300; i += 2) {
+      key_type k = make_key(i, (key_type const*)0);
+      count -= x.erase(k, hf(k));
+    }
+    BOOST_TEST(x.get_stats().hash_calls == 0);
+    BOOST_TEST(x.size() == count);
+
+    for (int i = 0; i < 200; ++i) {
+      key_type k = make_key(i, (key_type const*)0);
+      BOOST_TEST((x.count(k) > 0) == (i % 2 == 1));
+    }
+
+    // Check that the hash values are correct after a rehash.
+    x.rehash(x.bucket_count() * 4);
+    for (int i = 1; i < 200; i += 2) {
+      key_type k = make_key(i, (key_type const*)0);
+      BOOST_TEST(x.find(k, hf(k)) != x.end());
+    }
+  }
+
+  template <class X> void map_tests(X*)
+  {
+    typedef typename X::hasher hasher;
+
+    X x;
+    hasher hf = x.hash_function();
+    std::string one = make_key(1, (std::string const*)0);
+    BOOST_TEST(x.emplace_with_hash(hf(one), one, 10).second);
+    BOOST_TEST(!x.emplace_with_hash(hf(one), one, 20).second);
+    BOOST_TEST(x.find(one, hf(one))->second == 10);
+    BOOST_TEST(x.erase(one, hf(one)) == 1);
+    BOOST_TEST(x.erase(one, hf(one)) == 0);
+    BOOST_TEST(x.empty());
+  }
+
+  boost::unordered_set<std::string>* test_set;
+  boost::unordered_multiset<std::string>* test_multiset;
+  boost::unordered_map<std::string, int>* test_map;
+  boost::unordered_multimap<std::string, int>* test_multimap;
+  boost::unordered_set<int>* test_int_set;
+  boost::unordered_multimap<int, int>* test_int_multimap;
+
+  UNORDERED_TEST(precomputed_hash_tests,
+    ((test_set)(test_multiset)(test_map)(test_multimap)(test_int_set)(
+      test_int_multimap)))
+  UNORDERED_TEST(map_tests, ((test_map)))
+}
+
+RUN_TESTS()
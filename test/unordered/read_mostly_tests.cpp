@@ -0,0 +1,215 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// clang-format off
+#include "../helpers/prefix.hpp"
+#include <boost/config.hpp>
+#if !defined(BOOST_NO_CXX11_HDR_THREAD) &&                                     \
+  !defined(BOOST_NO_CXX11_HDR_MUTEX) &&                                        \
+  !defined(BOOST_NO_CXX11_HDR_ATOMIC) && !defined(BOOST_NO_CXX11_LAMBDAS) &&   \
+  !defined(BOOST_NO_CXX11_RVALUE_REFERENCES) &&                                \
+  !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+#define BOOST_UNORDERED_TEST_READ_MOSTLY 1
+#include <boost/read_mostly_unordered_map.hpp>
+#else
+#include <boost/unordered_map.hpp>
+#endif
+#include "../helpers/postfix.hpp"
+// clang-format on
+
+#include "../helpers/test.hpp"
+
+#if defined(BOOST_UNORDERED_TEST_READ_MOSTLY)
+
+#include "../objects/test.hpp"
+#include "../helpers/random_values.hpp"
+#include "../helpers/tracker.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace read_mostly_tests {
+
+  test::seed_t initialize_seed(37291);
+
+  typedef boost::read_mostly_unordered_map<test::object, test::object,
+    test::hash, test::equal_to, test::allocator1<test::object> >
+    object_map;
+
+  template <class X, class Y> void compare(X const& x, Y const& y)
+  {
+    BOOST_TEST(x.size() == y.size());
+    std::size_t visited = x.cvisit_all([&y](typename X::value_type const& v) {
+      typename Y::const_iterator it = y.find(v.first);
+      BOOST_TEST(it != y.end() && it->second == v.second);
+    });
+    BOOST_TEST(visited == y.size());
+  }
+
+  UNORDERED_AUTO_TEST(read_mostly_insert_tests)
+  {
+    test::check_instances check_;
+
+    test::random_values<boost::unordered_map<test::object, test::object> > v(
+      1000, test::generate_collisions);
+    boost::unordered_map<test::object, test::object> expected;
+
+    object_map x;
+    for (typename test::random_values<boost::unordered_map<test::object,
+           test::object> >::iterator it = v.begin();
+         it != v.end(); ++it) {
+      BOOST_TEST(x.insert(*it) == expected.insert(*it).second);
+      BOOST_TEST(x.load_factor() <= x.max_load_factor());
+    }
+    compare(x, expected);
+
+    object_map y(x);
+    boost::unordered_map<test::object, test::object> copied(expected);
+    compare(y, copied);
+
+    std::size_t count = x.bucket_count();
+    x.rehash(count * 4);
+    BOOST_TEST(x.bucket_count() >= count * 4);
+    compare(x, expected);
+
+    // Assigning replaces the element, the old one is reclaimed later.
+    int tag = 0;
+    for (typename boost::unordered_map<test::object,
+           test::object>::iterator it = expected.begin();
+         it != expected.end(); ++it) {
+      it->second = test::object(++tag, 0);
+      BOOST_TEST(!x.insert_or_assign(it->first, it->second));
+    }
+    compare(x, expected);
+
+    std::size_t erased = 0;
+    while (!expected.empty() && erased < 100) {
+      BOOST_TEST(x.erase(expected.begin()->first) == 1);
+      BOOST_TEST(x.erase(expected.begin()->first) == 0);
+      expected.erase(expected.begin());
+      ++erased;
+    }
+    compare(x, expected);
+
+    x.clear();
+    BOOST_TEST(x.empty());
+    BOOST_TEST(x.count(v.begin()->first) == 0);
+    compare(y, copied);
+  }
+
+  UNORDERED_AUTO_TEST(read_mostly_api_tests)
+  {
+    boost::read_mostly_unordered_map<std::string, int> x;
+
+    BOOST_TEST(x.emplace("one", 1));
+    BOOST_TEST(!x.emplace(std::make_pair("one", 2)));
+    BOOST_TEST(x.try_emplace("two", 2));
+    BOOST_TEST(!x.try_emplace("two", 3));
+    BOOST_TEST(x.insert(std::make_pair(std::string("three"), 3)));
+    BOOST_TEST(!x.insert_or_assign("one", 10));
+    BOOST_TEST(x.insert_or_assign("four", 4));
+    BOOST_TEST(x.size() == 4);
+
+    int value = 0;
+    BOOST_TEST(x.visit("one", [&value](
+                 std::pair<const std::string, int> const& v) {
+      value = v.second;
+    }) == 1);
+    BOOST_TEST(value == 10);
+    BOOST_TEST(x.cvisit("five", [](std::pair<const std::string, int> const&) {
+      BOOST_ERROR("Visited a missing element.");
+    }) == 0);
+    BOOST_TEST(x.contains("two") && !x.contains("five"));
+
+    BOOST_TEST(x.erase("three") == 1);
+    BOOST_TEST(x.erase("three") == 0);
+    BOOST_TEST(x.size() == 3);
+
+    for (int i = 0; i < 1000; ++i) {
+      x.emplace(std::to_string(i), i);
+    }
+    BOOST_TEST(x.size() == 1003);
+    BOOST_TEST(x.erase_if([](std::pair<const std::string, int> const& v) {
+      return v.second % 2 == 0;
+    }) == 503);
+    BOOST_TEST(x.size() == 500);
+    BOOST_TEST(x.count("11") == 1 && x.count("10") == 0);
+
+    boost::read_mostly_unordered_map<int, int> y = {{1, 2}, {3, 4}};
+    BOOST_TEST(y.size() == 2 && y.count(3) == 1);
+    BOOST_TEST(y.insert({{3, 5}, {5, 6}}) == 1);
+  }
+
+  // One thread keeps replacing, erasing and reinserting elements, and
+  // growing the map, while the others read it. Every value is its key plus
+  // a multiple of 'key_count', so a reader can check that it only ever sees
+  // complete elements.
+  UNORDERED_AUTO_TEST(read_mostly_thread_tests)
+  {
+    typedef boost::read_mostly_unordered_map<int, int> map;
+
+    std::size_t const reader_count = 7;
+    int const key_count = 1000;
+    int const generations = 20;
+
+    map x;
+    for (int i = 0; i < key_count; ++i) {
+      x.emplace(i, i);
+    }
+
+    std::atomic<bool> done(false);
+    std::atomic<std::size_t> visits(0);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < reader_count; ++t) {
+      threads.push_back(std::thread([&x, &done, &visits, t] {
+        std::size_t count = 0;
+        int i = static_cast<int>(t);
+        while (!done.load()) {
+          i = (i + 7) % key_count;
+          count += x.cvisit(i, [i](map::value_type const& v) {
+            BOOST_TEST(v.first == i);
+            BOOST_TEST(v.second % key_count == i);
+          });
+          if (i % 100 == 0) {
+            x.cvisit_all([](map::value_type const& v) {
+              BOOST_TEST(v.second % key_count == v.first);
+            });
+          }
+        }
+        visits += count;
+      }));
+    }
+
+    for (int g = 1; g <= generations; ++g) {
+      for (int i = 0; i < key_count; ++i) {
+        BOOST_TEST(!x.insert_or_assign(i, i + g * key_count));
+      }
+      BOOST_TEST(x.erase_if([](map::value_type const& v) {
+        return v.first % 2 == 1;
+      }) == static_cast<std::size_t>(key_count / 2));
+      for (int i = 1; i < key_count; i += 2) {
+        BOOST_TEST(x.emplace(i, i + g * key_count));
+      }
+      if (g % 5 == 0) {
+        x.rehash(x.bucket_count() * 2);
+      }
+    }
+    done = true;
+    for (std::size_t t = 0; t < reader_count; ++t) {
+      threads[t].join();
+    }
+
+    BOOST_TEST(x.size() == static_cast<std::size_t>(key_count));
+    BOOST_TEST(visits > 0);
+    for (int i = 0; i < key_count; ++i) {
+      BOOST_TEST(x.count(i) == 1);
+    }
+  }
+}
+
+#endif
+
+RUN_TESTS()
@@ -0,0 +1,307 @@
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// clang-format off
+#include "../helpers/prefix.hpp"
+#include <boost/config.hpp>
+#if !defined(BOOST_NO_CXX11_HDR_THREAD) &&                                     \
+  !defined(BOOST_NO_CXX11_HDR_MUTEX) &&                                        \
+  !defined(BOOST_NO_CXX11_HDR_ATOMIC) && !defined(BOOST_NO_CXX11_LAMBDAS) &&   \
+  !defined(BOOST_NO_CXX11_RVALUE_REFERENCES) &&                                \
+  !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+#define BOOST_UNORDERED_TEST_SEQLOCK 1
+#include <boost/seqlock_unordered_map.hpp>
+#else
+#include <boost/unordered_map.hpp>
+#endif
+#include "../helpers/postfix.hpp"
+// clang-format on
+
+#include "../helpers/test.hpp"
+
+#if defined(BOOST_UNORDERED_TEST_SEQLOCK)
+
+#include "../objects/test.hpp"
+#include "../helpers/random_values.hpp"
+#include "../helpers/tracker.hpp"
+#include <boost/unordered_map.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace seqlock_tests {
+
+  test::seed_t initialize_seed(83127);
+
+  typedef boost::seqlock_unordered_map<int, int, boost::hash<int>,
+    std::equal_to<int>, test::allocator1<std::pair<const int, int> > >
+    int_map;
+
+  template <class X, class Y> void compare(X const& x, Y const& y)
+  {
+    BOOST_TEST(x.size() == y.size());
+    std::size_t visited = x.cvisit_all([&y](typename X::value_type const& v) {
+      typename Y::const_iterator it = y.find(v.first);
+      BOOST_TEST(it != y.end() && it->second == v.second);
+    });
+    BOOST_TEST(visited == y.size());
+    for (typename Y::const_iterator it = y.begin(); it != y.end(); ++it) {
+      int value = -1;
+      BOOST_TEST(x.cvisit(it->first, [&value](
+                   typename X::value_type const& v) { value = v.second; }) ==
+                 1);
+      BOOST_TEST(value == it->second);
+    }
+  }
+
+  UNORDERED_AUTO_TEST(seqlock_insert_tests)
+  {
+    test::random_values<boost::unordered_map<int, int> > v(
+      1000, test::generate_collisions);
+    boost::unordered_map<int, int> expected;
+
+    int_map x;
+    for (test::random_values<boost::unordered_map<int, int> >::iterator it =
+           v.begin();
+         it != v.end(); ++it) {
+      BOOST_TEST(x.insert(*it) == expected.insert(*it).second);
+      BOOST_TEST(x.load_factor() <= x.max_load_factor());
+    }
+    compare(x, expected);
+
+    int_map y(x);
+    boost::unordered_map<int, int> copied(expected);
+    compare(y, copied);
+
+    std::size_t count = x.bucket_count();
+    x.rehash(count * 4);
+    BOOST_TEST(x.bucket_count() >= count * 4);
+    compare(x, expected);
+
+    // Assigning overwrites the value in place.
+    int tag = 0;
+    for (boost::unordered_map<int, int>::iterator it = expected.begin();
+         it != expected.end(); ++it) {
+      it->second = ++tag;
+      BOOST_TEST(!x.insert_or_assign(it->first, it->second));
+    }
+    compare(x, expected);
+
+    // Erased nodes are reused by the following inserts.
+    std::vector<std::pair<int, int> > erased;
+    while (!expected.empty() && erased.size() < 100) {
+      BOOST_TEST(x.erase(expected.begin()->first) == 1);
+      BOOST_TEST(x.erase(expected.begin()->first) == 0);
+      erased.push_back(*expected.begin());
+      expected.erase(expected.begin());
+    }
+    compare(x, expected);
+    for (std::size_t i = 0; i < erased.size(); ++i) {
+      BOOST_TEST(x.insert(erased[i]));
+      expected.insert(erased[i]);
+    }
+    compare(x, expected);
+
+    x.clear();
+    BOOST_TEST(x.empty());
+    BOOST_TEST(x.count(v.begin()->first) == 0);
+    compare(y, copied);
+  }
+
+  struct point
+  {
+    double x, y;
+  };
+
+  UNORDERED_AUTO_TEST(seqlock_api_tests)
+  {
+    boost::seqlock_unordered_map<int, point> x;
+
+    point p = {1, 2};
+    BOOST_TEST(x.emplace(1, p));
+    BOOST_TEST(!x.emplace(std::make_pair(1, p)));
+    BOOST_TEST(x.try_emplace(2, p));
+    BOOST_TEST(!x.try_emplace(2, p));
+    BOOST_TEST(x.insert(std::make_pair(3, p)));
+    p.x = 10;
+    BOOST_TEST(!x.insert_or_assign(1, p));
+    BOOST_TEST(x.insert_or_assign(4, p));
+    BOOST_TEST(x.size() == 4);
+
+    double value = 0;
+    BOOST_TEST(x.visit(1, [&value](std::pair<const int, point> const& v) {
+      value = v.second.x;
+    }) == 1);
+    BOOST_TEST(value == 10);
+    BOOST_TEST(x.cvisit(5, [](std::pair<const int, point> const&) {
+      BOOST_ERROR("Visited a missing element.");
+    }) == 0);
+    BOOST_TEST(x.contains(2) && !x.contains(5));
+
+    BOOST_TEST(x.erase(3) == 1);
+    BOOST_TEST(x.erase(3) == 0);
+    BOOST_TEST(x.size() == 3);
+
+    for (int i = 10; i < 1010; ++i) {
+      point q = {static_cast<double>(i), 0};
+      x.emplace(i, q);
+    }
+    BOOST_TEST(x.size() == 1003);
+    BOOST_TEST(x.erase_if([](std::pair<const int, point> const& v) {
+      return v.first % 2 == 0;
+    }) == 502);
+    BOOST_TEST(x.size() == 501);
+    BOOST_TEST(x.count(11) == 1 && x.count(10) == 0);
+
+    boost::seqlock_unordered_map<int, int> y = {{1, 2}, {3, 4}};
+    BOOST_TEST(y.size() == 2 && y.count(3) == 1);
+    BOOST_TEST(y.insert({{3, 5}, {5, 6}}) == 1);
+  }
+
+  // A value which is torn if 'b' isn't twice 'a'.
+  struct pair_value
+  {
+    std::size_t a, b;
+  };
+
+  // One thread keeps overwriting, erasing and reinserting elements, and
+  // growing the map, while the others read it. The readers check that they
+  // never see a value that was partly written.
+  UNORDERED_AUTO_TEST(seqlock_thread_tests)
+  {
+    typedef boost::seqlock_unordered_map<int, pair_value> map;
+
+    std::size_t const reader_count = 7;
+    int const key_count = 1000;
+    std::size_t const generations = 20;
+
+    map x;
+    for (int i = 0; i < key_count; ++i) {
+      pair_value v = {0, 0};
+      x.emplace(i, v);
+    }
+
+    std::atomic<bool> done(false);
+    std::atomic<std::size_t> visits(0);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < reader_count; ++t) {
+      threads.push_back(std::thread([&x, &done, &visits, t] {
+        std::size_t count = 0;
+        int i = static_cast<int>(t);
+        while (!done.load()) {
+          i = (i + 7) % key_count;
+          count += x.cvisit(i, [i](map::value_type const& v) {
+            BOOST_TEST(v.first == i);
+            BOOST_TEST(v.second.b == v.second.a * 2);
+          });
+        }
+        visits += count;
+      }));
+    }
+
+    for (std::size_t g = 1; g <= generations; ++g) {
+      for (int i = 0; i < key_count; ++i) {
+        pair_value v = {g, g * 2};
+        BOOST_TEST(!x.insert_or_assign(i, v));
+      }
+      BOOST_TEST(x.erase_if([](map::value_type const& v) {
+        return v.first % 2 == 1;
+      }) == static_cast<std::size_t>(key_count / 2));
+      for (int i = 1; i < key_count; i += 2) {
+        pair_value v = {g + 1, (g + 1) * 2};
+        BOOST_TEST(x.emplace(i, v));
+      }
+      if (g % 5 == 0) {
+        x.rehash(x.bucket_count() * 2);
+      }
+    }
+    done = true;
+    for (std::size_t t = 0; t < reader_count; ++t) {
+      threads[t].join();
+    }
+
+    BOOST_TEST(x.size() == static_cast<std::size_t>(key_count));
+    BOOST_TEST(visits > 0);
+    for (int i = 0; i < key_count; ++i) {
+      BOOST_TEST(x.count(i) == 1);
+    }
+  }
+
+  // A key which is torn if 'b' isn't twice 'a'. Every key has the same hash
+  // value, so the stored hash values don't stop a torn key from reaching
+  // the predicate.
+  struct pair_key
+  {
+    std::size_t a, b;
+  };
+
+  pair_key make_pair_key(std::size_t a)
+  {
+    pair_key k = {a, a * 2};
+    return k;
+  }
+
+  struct pair_key_hash
+  {
+    std::size_t operator()(pair_key const&) const { return 0; }
+  };
+
+  struct pair_key_equal
+  {
+    bool operator()(pair_key const& x, pair_key const& y) const
+    {
+      BOOST_TEST(x.b == x.a * 2 && y.b == y.a * 2);
+      return x.a == y.a;
+    }
+  };
+
+  // The writer keeps erasing and reinserting keys, so that the readers see
+  // nodes being reused for different keys.
+  UNORDERED_AUTO_TEST(seqlock_key_eq_tests)
+  {
+    typedef boost::seqlock_unordered_map<pair_key, int, pair_key_hash,
+      pair_key_equal>
+      map;
+
+    std::size_t const reader_count = 3;
+    std::size_t const key_count = 32;
+    std::size_t const rounds = 2000;
+
+    map x;
+    for (std::size_t i = 0; i < key_count; ++i) {
+      x.emplace(make_pair_key(i), 0);
+    }
+
+    std::atomic<bool> done(false);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < reader_count; ++t) {
+      threads.push_back(std::thread([&x, &done, t] {
+        std::size_t i = t;
+        while (!done.load()) {
+          i = (i + 5) % (key_count * 2);
+          x.contains(make_pair_key(i));
+        }
+      }));
+    }
+
+    // Each round moves a key between [0, key_count) and
+    // [key_count, key_count * 2).
+    for (std::size_t r = 0; r < rounds; ++r) {
+      std::size_t from = r % key_count + (r / key_count % 2) * key_count;
+      std::size_t to = from < key_count ? from + key_count : from - key_count;
+      BOOST_TEST(x.erase(make_pair_key(from)) == 1);
+      BOOST_TEST(x.emplace(make_pair_key(to), static_cast<int>(r)));
+    }
+    done = true;
+    for (std::size_t t = 0; t < reader_count; ++t) {
+      threads[t].join();
+    }
+
+    BOOST_TEST(x.size() == key_count);
+  }
+}
+
+#endif
+
+RUN_TESTS()
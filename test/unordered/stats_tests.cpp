@@ -0,0 +1,205 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#define BOOST_UNORDERED_ENABLE_STATS
+
+// clang-format off
+#include "../helpers/prefix.hpp"
+#include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered/hash_traits.hpp>
+#include "../helpers/postfix.hpp"
+// clang-format on
+
+#include "../helpers/test.hpp"
+#include <boost/functional/hash.hpp>
+
+#if !defined(BOOST_NO_CXX11_HDR_THREAD) && !defined(BOOST_NO_CXX11_LAMBDAS)
+#include <thread>
+#include <vector>
+#endif
+
+namespace stats_tests {
+  // Count the calls, to check that the statistics match.
+  struct counting_hash
+  {
+    static std::size_t calls;
+
+    std::size_t operator()(int x) const
+    {
+      ++calls;
+      return boost::hash<int>()(x);
+    }
+  };
+
+  std::size_t counting_hash::calls = 0;
+
+  struct counting_equal
+  {
+    static std::size_t calls;
+
+    bool operator()(int x, int y) const
+    {
+      ++calls;
+      return x == y;
+    }
+  };
+
+  std::size_t counting_equal::calls = 0;
+
+  // Rehashes incrementally, to check the statistics part way through.
+  struct incremental_counting_hash : counting_hash
+  {
+  };
+}
+
+namespace boost {
+  namespace unordered {
+    template <>
+    struct incremental_rehash<stats_tests::incremental_counting_hash>
+      : boost::true_type
+    {
+    };
+  }
+}
+
+namespace stats_tests {
+
+  int make_value(int x, int const*) { return x; }
+
+  std::pair<int const, int> make_value(int x, std::pair<int const, int> const*)
+  {
+    return std::pair<int const, int>(x, x * 2);
+  }
+
+  // Check the bucket statistics against the bucket interface.
+  template <class X> void check_buckets(X const& x)
+  {
+    boost::unordered::stats s = x.get_stats();
+    BOOST_TEST(s.size == x.size());
+    BOOST_TEST(s.bucket_count == x.bucket_count());
+
+    std::vector<std::size_t> chain_lengths(1);
+    std::size_t used = 0;
+    for (std::size_t i = 0; i < x.bucket_count(); ++i) {
+      std::size_t length = x.bucket_size(i);
+      if (length >= chain_lengths.size()) {
+        chain_lengths.resize(length + 1);
+      }
+      ++chain_lengths[length];
+      used += length ? 1 : 0;
+    }
+
+    BOOST_TEST(s.used_buckets == used);
+    BOOST_TEST(s.chain_lengths == chain_lengths);
+  }
+
+  template <class X> void stats_tests(X*)
+  {
+    typedef typename X::value_type value_type;
+
+    counting_hash::calls = 0;
+    counting_equal::calls = 0;
+
+    X x;
+    BOOST_TEST(x.get_stats().hash_calls == 0);
+    check_buckets(x);
+
+    for (int i = 0; i < 1000; ++i) {
+      x.insert(make_value(i, (value_type const*)0));
+      x.insert(make_value(i / 3, (value_type const*)0));
+      if (i % 97 == 0) {
+        check_buckets(x);
+      }
+    }
+    x.insert(x.begin(), make_value(5, (value_type const*)0));
+    for (int i = 0; i < 1200; ++i) {
+      x.find(i);
+      x.count(i);
+    }
+    x.erase(7);
+
+    boost::unordered::stats s = x.get_stats();
+    BOOST_TEST(s.hash_calls == counting_hash::calls);
+    BOOST_TEST(s.key_eq_calls == counting_equal::calls);
+    BOOST_TEST(s.rehashes > 0);
+    BOOST_TEST(s.rehashed_nodes > 0);
+    check_buckets(x);
+
+    // The hash values aren't stored, so rehashing calls the hash function
+    // for every group of equivalent elements.
+    x.reset_stats();
+    s = x.get_stats();
+    BOOST_TEST(s.hash_calls == 0 && s.key_eq_calls == 0 && s.rehashes == 0);
+
+    x.rehash(x.bucket_count() * 2);
+    s = x.get_stats();
+    BOOST_TEST(s.rehashes == 1);
+    BOOST_TEST(s.rehashed_nodes == x.size());
+    BOOST_TEST(s.hash_calls > 0 && s.hash_calls <= x.size());
+    check_buckets(x);
+
+    // Copies have their own counters.
+    X y(x);
+    BOOST_TEST(y.get_stats().rehashes == 0);
+    BOOST_TEST(x.get_stats().rehashes == 1);
+    check_buckets(y);
+
+    x.clear();
+    s = x.get_stats();
+    BOOST_TEST(s.used_buckets == 0);
+    BOOST_TEST(s.chain_lengths.size() == 1);
+    BOOST_TEST(s.chain_lengths[0] == x.bucket_count());
+  }
+
+  boost::unordered_set<int, counting_hash, counting_equal>* test_set;
+  boost::unordered_multiset<int, counting_hash, counting_equal>* test_multiset;
+  boost::unordered_map<int, int, counting_hash, counting_equal>* test_map;
+  boost::unordered_multimap<int, int, counting_hash, counting_equal>*
+    test_multimap;
+  boost::unordered_set<int, incremental_counting_hash, counting_equal>*
+    test_incremental_set;
+
+  UNORDERED_TEST(stats_tests, ((test_set)(test_multiset)(test_map)(
+                                test_multimap)(test_incremental_set)))
+
+#if !defined(BOOST_NO_CXX11_HDR_THREAD) && !defined(BOOST_NO_CXX11_LAMBDAS)
+  // Lookups are still safe from several threads at once, and they're all
+  // counted.
+  UNORDERED_AUTO_TEST(concurrent_find_stats_tests)
+  {
+    boost::unordered_set<int> x;
+    for (int i = 0; i < 1000; ++i) {
+      x.insert(i);
+    }
+
+    boost::unordered_set<int> const& cx = x;
+    x.reset_stats();
+    for (int i = 0; i < 1000; ++i) {
+      BOOST_TEST(cx.find(i) != cx.end());
+    }
+    boost::unordered::stats s = x.get_stats();
+    x.reset_stats();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.push_back(std::thread([&cx] {
+        for (int i = 0; i < 1000; ++i) {
+          BOOST_TEST(cx.find(i) != cx.end());
+        }
+      }));
+    }
+    for (std::size_t t = 0; t < threads.size(); ++t) {
+      threads[t].join();
+    }
+
+    boost::unordered::stats s2 = x.get_stats();
+    BOOST_TEST(s2.hash_calls == 4 * s.hash_calls);
+    BOOST_TEST(s2.key_eq_calls == 4 * s.key_eq_calls);
+  }
+#endif
+}
+
+RUN_TESTS()
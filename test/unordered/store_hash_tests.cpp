@@ -0,0 +1,236 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// clang-format off
+#include "../helpers/prefix.hpp"
+#include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered/hash_traits.hpp>
+#include "../helpers/postfix.hpp"
+// clang-format on
+
+#include "../helpers/test.hpp"
+#include "../objects/test.hpp"
+#include <boost/functional/hash.hpp>
+
+namespace store_hash_tests {
+  // Counts the number of times that a hash function is called, to check
+  // that the stored hash values are used instead.
+  struct counting_hash
+  {
+    static int calls;
+
+    std::size_t operator()(int x) const
+    {
+      ++calls;
+      return boost::hash<int>()(x);
+    }
+  };
+
+  int counting_hash::calls = 0;
+
+  // The same hash function, but without stored hash values.
+  struct plain_hash
+  {
+    std::size_t operator()(int x) const { return boost::hash<int>()(x); }
+  };
+
+  struct counting_equal
+  {
+    static int calls;
+
+    bool operator()(int x, int y) const
+    {
+      ++calls;
+      return x == y;
+    }
+  };
+
+  int counting_equal::calls = 0;
+
+  // A hash function with a seed, so different objects give different hash
+  // values for the same key.
+  struct seeded_hash
+  {
+    std::size_t seed;
+
+    explicit seeded_hash(std::size_t s = 0) : seed(s) {}
+
+    std::size_t operator()(int x) const
+    {
+      std::size_t h = seed;
+      boost::hash_combine(h, x);
+      return h;
+    }
+  };
+}
+
+namespace boost {
+  namespace unordered {
+    template <>
+    struct store_hash<store_hash_tests::counting_hash> : boost::true_type
+    {
+    };
+
+    template <>
+    struct store_hash<store_hash_tests::seeded_hash> : boost::true_type
+    {
+    };
+  }
+}
+
+namespace store_hash_tests {
+  int make_value(int x, int const*) { return x; }
+
+  std::pair<int const, int> make_value(int x, std::pair<int const, int> const*)
+  {
+    return std::pair<int const, int>(x, x * 2);
+  }
+
+  template <class X> void insert_values(X& x, int start, int end)
+  {
+    typedef typename X::value_type value_type;
+    for (int i = start; i < end; ++i) {
+      x.insert(make_value(i, (value_type const*)0));
+      x.insert(make_value(i / 2, (value_type const*)0));
+    }
+  }
+
+  template <class X> void store_hash_tests(X*)
+  {
+    X x;
+    insert_values(x, 0, 1000);
+    typename X::size_type size = x.size();
+
+    counting_hash::calls = 0;
+
+    x.rehash(x.bucket_count() * 4);
+    BOOST_TEST(x.size() == size);
+    BOOST_TEST(counting_hash::calls == 0);
+
+    X y(x);
+    BOOST_TEST(y.size() == size);
+    BOOST_TEST(x == y);
+    BOOST_TEST(counting_hash::calls == 0);
+
+    X z(x.get_allocator());
+    insert_values(z, 1000, 1100);
+    counting_hash::calls = 0;
+    z = x;
+    BOOST_TEST(z.size() == size);
+    BOOST_TEST(z == x);
+    z.rehash(0);
+    BOOST_TEST(z == x);
+    BOOST_TEST(counting_hash::calls == 0);
+
+    // Lookup still calls the hash function, for the key.
+    for (int i = 0; i < 1000; ++i) {
+      BOOST_TEST(z.count(i) == x.count(i));
+      BOOST_TEST(z.find(i) != z.end());
+    }
+    BOOST_TEST(z.find(1000) == z.end());
+  }
+
+  template <class X> void store_hash_merge_tests(X*)
+  {
+    X x, y;
+    insert_values(x, 0, 500);
+    insert_values(y, 250, 1000);
+
+    counting_hash::calls = 0;
+    x.merge(y);
+    BOOST_TEST(counting_hash::calls == 0);
+
+    for (int i = 0; i < 1000; ++i) {
+      BOOST_TEST(x.count(i) == 1);
+    }
+    BOOST_TEST(x.size() + y.size() == 1375);
+  }
+
+  // Merging from a container with a differently seeded hash function has to
+  // hash the elements again.
+  UNORDERED_AUTO_TEST(store_hash_seeded_merge_tests)
+  {
+    typedef boost::unordered_map<int, int, seeded_hash> map;
+
+    map x(0, seeded_hash(1)), y(0, seeded_hash(2));
+    insert_values(x, 0, 500);
+    insert_values(y, 250, 1000);
+
+    x.merge(y);
+    BOOST_TEST(x.size() + y.size() == 1375);
+    for (int i = 0; i < 1000; ++i) {
+      BOOST_TEST(x.count(i) == 1);
+      BOOST_TEST(x.find(i) != x.end() && x.find(i)->second == i * 2);
+    }
+    x.rehash(x.bucket_count() * 2);
+    for (int i = 0; i < 1000; ++i) {
+      BOOST_TEST(x.count(i) == 1);
+    }
+  }
+
+  // Count the calls to the equality predicate when there are a lot of
+  // elements in each bucket. When the hash value is stored, it should only
+  // be called for the elements that are found.
+  template <class X> int count_equal_calls(int* found, int* erased)
+  {
+    X x;
+    x.max_load_factor(4);
+    for (int i = 0; i < 1000; ++i) {
+      x.insert(i * 3);
+    }
+
+    *found = 0;
+    *erased = 0;
+    counting_equal::calls = 0;
+    for (int i = 0; i < 3000; ++i) {
+      *found += static_cast<int>(x.find(i) != x.end());
+    }
+    for (int i = 0; i < 3000; i += 2) {
+      *erased += static_cast<int>(x.erase(i));
+    }
+    return counting_equal::calls;
+  }
+
+  UNORDERED_AUTO_TEST(hash_check_tests)
+  {
+    int found, erased, plain_found, plain_erased;
+
+    int stored_calls =
+      count_equal_calls<boost::unordered_set<int, counting_hash,
+        counting_equal> >(&found, &erased);
+    int plain_calls =
+      count_equal_calls<boost::unordered_set<int, plain_hash,
+        counting_equal> >(&plain_found, &plain_erased);
+
+    BOOST_TEST(found == 1000 && erased == 500);
+    BOOST_TEST(plain_found == found && plain_erased == erased);
+    BOOST_TEST(stored_calls == found + erased);
+    BOOST_TEST(plain_calls > stored_calls);
+
+    stored_calls =
+      count_equal_calls<boost::unordered_multiset<int, counting_hash,
+        counting_equal> >(&found, &erased);
+    BOOST_TEST(found == 1000 && erased == 500);
+    BOOST_TEST(stored_calls == found + erased);
+  }
+
+  boost::unordered_set<int, counting_hash>* test_set;
+  boost::unordered_multiset<int, counting_hash>* test_multiset;
+  boost::unordered_map<int, int, counting_hash>* test_map;
+  boost::unordered_multimap<int, int, counting_hash>* test_multimap;
+
+  boost::unordered_set<int, counting_hash, std::equal_to<int>,
+    test::allocator2<int> >* test_set_fancy;
+  boost::unordered_multimap<int, int, counting_hash, std::equal_to<int>,
+    test::allocator2<std::pair<int const, int> > >* test_multimap_fancy;
+
+  UNORDERED_TEST(store_hash_tests,
+    ((test_set)(test_multiset)(test_map)(test_multimap)(test_set_fancy)(
+      test_multimap_fancy)))
+  UNORDERED_TEST(store_hash_merge_tests, ((test_set)(test_map)))
+}
+
+RUN_TESTS()
@@ -0,0 +1,211 @@
+
+// Copyright 2017 Daniel James.
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// clang-format off
+#include "../helpers/prefix.hpp"
+#include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
+#include "../helpers/postfix.hpp"
+// clang-format on
+
+#include "../helpers/test.hpp"
+#include "../helpers/metafunctions.hpp"
+#include <boost/functional/hash.hpp>
+#include <stdexcept>
+
+namespace transparent_tests {
+  // A key which counts how many times it's constructed, so that the tests
+  // can check that heterogeneous lookup doesn't create temporary keys.
+  struct key
+  {
+    static int count;
+
+    int x_;
+
+    key(int x) : x_(x) { ++count; }
+    key(key const& k) : x_(k.x_) { ++count; }
+  };
+
+  int key::count = 0;
+
+  struct transparent_hash
+  {
+    typedef void is_transparent;
+
+    std::size_t operator()(key const& k) const
+    {
+      return boost::hash<int>()(k.x_);
+    }
+
+    std::size_t operator()(int x) const { return boost::hash<int>()(x); }
+  };
+
+  struct transparent_equal
+  {
+    typedef void is_transparent;
+
+    bool operator()(key const& k1, key const& k2) const
+    {
+      return k1.x_ == k2.x_;
+    }
+
+    bool operator()(int x, key const& k) const { return x == k.x_; }
+  };
+
+  // Only the hash function is transparent, so lookup converts to the key
+  // type.
+  struct plain_equal
+  {
+    bool operator()(key const& k1, key const& k2) const
+    {
+      return k1.x_ == k2.x_;
+    }
+  };
+
+  template <class X> void insert_values(X& x, key const*)
+  {
+    for (int i = 0; i < 100; ++i) {
+      x.insert(key(i));
+      x.insert(key(i / 2));
+    }
+  }
+
+  template <class X> void insert_values(X& x, std::pair<key const, int> const*)
+  {
+    typedef typename X::value_type value_type;
+    for (int i = 0; i < 100; ++i) {
+      x.insert(value_type(key(i), i));
+      x.insert(value_type(key(i / 2), i));
+    }
+  }
+
+  template <class X> void transparent_lookup_tests(X*)
+  {
+    typedef typename X::value_type value_type;
+    typedef typename X::iterator iterator;
+    typedef typename X::const_iterator const_iterator;
+
+    X x;
+    insert_values(x, (value_type const*)0);
+    X const& cx = x;
+    typename X::size_type size = x.size();
+
+    key::count = 0;
+
+    for (int i = 0; i < 100; ++i) {
+      std::size_t expected =
+        test::has_unique_keys<X>::value ? 1 : (i < 50 ? 3 : 1);
+
+      iterator it = x.find(i);
+      const_iterator cit = cx.find(i);
+      BOOST_TEST(it != x.end() && it == cit);
+      BOOST_TEST(x.contains(i));
+      BOOST_TEST(x.count(i) == expected);
+
+      std::pair<iterator, iterator> r = x.equal_range(i);
+      std::pair<const_iterator, const_iterator> cr = cx.equal_range(i);
+      BOOST_TEST(r.first == it && r.first == cr.first);
+      BOOST_TEST(r.second == cr.second);
+      BOOST_TEST(
+        static_cast<std::size_t>(std::distance(r.first, r.second)) == expected);
+    }
+
+    BOOST_TEST(x.find(100) == x.end());
+    BOOST_TEST(cx.find(100) == cx.end());
+    BOOST_TEST(!x.contains(100));
+    BOOST_TEST(x.count(100) == 0);
+    BOOST_TEST(x.equal_range(100).first == x.end());
+
+    BOOST_TEST(x.erase(100) == 0);
+    std::size_t erased = test::has_unique_keys<X>::value ? 1 : 3;
+    BOOST_TEST(x.erase(0) == erased);
+    BOOST_TEST(x.size() == size - erased);
+    BOOST_TEST(!x.contains(0));
+
+    BOOST_TEST(key::count == 0);
+
+    // Erasing by iterator still works.
+    typename X::size_type size2 = x.size();
+    iterator next = x.erase(x.begin());
+    BOOST_TEST(x.size() == size2 - 1);
+    BOOST_TEST(next == x.begin());
+    x.erase(cx.begin());
+    BOOST_TEST(x.size() == size2 - 2);
+  }
+
+  // Lookup with the key type still uses the normal overloads.
+  UNORDERED_AUTO_TEST(key_type_lookup_tests)
+  {
+    boost::unordered_set<key, transparent_hash, transparent_equal> x;
+    x.insert(key(1));
+    x.insert(key(2));
+    BOOST_TEST(x.count(key(1)) == 1);
+    BOOST_TEST(x.count(key(3)) == 0);
+    BOOST_TEST(x.erase(key(1)) == 1);
+    BOOST_TEST(x.size() == 1);
+  }
+
+  UNORDERED_AUTO_TEST(transparent_at_tests)
+  {
+    boost::unordered_map<key, int, transparent_hash, transparent_equal> x;
+    boost::unordered_map<key, int, transparent_hash, transparent_equal> const&
+      cx = x;
+
+    try {
+      x.at(1);
+      BOOST_ERROR("Should have thrown.");
+    } catch (std::out_of_range) {
+    }
+
+    x.insert(std::make_pair(key(1), 10));
+    x.insert(std::make_pair(key(2), 20));
+
+    key::count = 0;
+    BOOST_TEST(x.at(1) == 10);
+    BOOST_TEST(cx.at(2) == 20);
+    x.at(1) = 15;
+    BOOST_TEST(cx.at(1) == 15);
+
+    try {
+      x.at(3);
+      BOOST_ERROR("Should have thrown.");
+    } catch (std::out_of_range) {
+    }
+
+    try {
+      cx.at(3);
+      BOOST_ERROR("Should have thrown.");
+    } catch (std::out_of_range) {
+    }
+
+    BOOST_TEST(key::count == 0);
+  }
+
+  UNORDERED_AUTO_TEST(non_transparent_tests)
+  {
+    // The predicate isn't transparent, so the argument is converted.
+    boost::unordered_set<key, transparent_hash, plain_equal> x;
+    x.insert(key(1));
+
+    key::count = 0;
+    BOOST_TEST(x.find(1) != x.end());
+    BOOST_TEST(x.count(2) == 0);
+    BOOST_TEST(x.contains(1));
+    BOOST_TEST(key::count == 3);
+  }
+
+  boost::unordered_set<key, transparent_hash, transparent_equal>* test_set;
+  boost::unordered_multiset<key, transparent_hash, transparent_equal>*
+    test_multiset;
+  boost::unordered_map<key, int, transparent_hash, transparent_equal>*
+    test_map;
+  boost::unordered_multimap<key, int, transparent_hash, transparent_equal>*
+    test_multimap;
+
+  UNORDERED_TEST(transparent_lookup_tests,
+    ((test_set)(test_multiset)(test_map)(test_multimap)))
+}
+
+RUN_TESTS()